@@ -0,0 +1,271 @@
+/* Alarm engine against synthetic sample series
+ * Runs AlarmEngine (lib/alarmEngine) with the default rule of config.hpp
+ * (ALARM_*_DEFAULT, ALARM_RATE_WINDOW_MS) on one sensor sampled every
+ * SAMPLE_INTERVAL_DEFAULT ms, the way onTemperatureSample() feeds it.
+ * Cases:
+ *   high:       slow rise past the high limit, back down inside it
+ *   hysteresis: back below the limit but not by the hysteresis, then out
+ *   low:        slow fall past the low limit, back up
+ *   spike:      single samples past the limits, shorter than the debounce
+ *   chatter:    alternating across the limit every sample
+ *   rate:       ramp faster than the rate trigger, then level
+ *   slow:       ramp below the rate trigger
+ *   dht11:      slow ramp quantised to the 1 °C of the DHT11
+ *   nan:        failed readings (NaN) inside a crossing, rate alarm off
+ *   wrap:       fast ramp across the 32-bit micros() wrap
+ * Each case checks which alarms are raised and cleared, on which sample
+ * (limit crossing + debounce) and with which value, and that every alarm
+ * raised is cleared again.
+ *
+ * Build and run:
+ *   pio run -e native_alarm_engine
+ *   .pio/build/native_alarm_engine/program
+ */
+#include <math.h>
+#include <stdio.h>
+#include <vector>
+
+#include <config.hpp>
+
+#include "alarmEngine.hpp"
+#include "check.h"
+
+static constexpr uint32_t PERIOD_US = SAMPLE_INTERVAL_DEFAULT * 1000;
+static constexpr uint32_t SAMPLES_PER_MINUTE = 60000 / SAMPLE_INTERVAL_DEFAULT;
+
+struct Event
+{
+  uint32_t sample; // Index of the sample that changed the state
+  AlarmKind kind;
+  bool isActive;
+  float value;
+};
+
+struct Run
+{
+  std::vector<Event> events;
+  uint8_t activeAtEnd;
+  AlarmStats stats;
+};
+
+static std::vector<AlarmEvent> handled;
+
+static void onAlarm(const AlarmEvent &event)
+{
+  handled.push_back(event);
+}
+
+static Run simulate(const std::vector<float> &samples, uint32_t baseUs = 0, float rate = ALARM_RATE_DEFAULT)
+{
+  AlarmEngine engine;
+  AlarmRule rule = {ALARM_HIGH_DEFAULT, ALARM_LOW_DEFAULT, ALARM_HYSTERESIS_DEFAULT, rate, ALARM_DEBOUNCE_DEFAULT};
+  engine.setRule(0, rule);
+  engine.setRateWindow(ALARM_RATE_WINDOW_MS * 1000);
+  engine.setHandler(onAlarm);
+  handled.clear();
+
+  Run run = {};
+  for (uint32_t i = 0; i < samples.size(); i++)
+  {
+    engine.evaluate(0, samples[i], baseUs + i * PERIOD_US);
+  }
+  for (const AlarmEvent &event : handled)
+  {
+    run.events.push_back({(event.sampleUs - baseUs) / PERIOD_US, event.kind, event.isActive, event.value});
+  }
+  run.activeAtEnd = engine.activeCount();
+  run.stats = engine.getStats();
+  return run;
+}
+
+static bool isEvent(const Run &run, size_t index, AlarmKind kind, bool isActive, uint32_t sample)
+{
+  if (index >= run.events.size())
+  {
+    return false;
+  }
+  const Event &event = run.events[index];
+  return event.kind == kind && event.isActive == isActive && event.sample == sample;
+}
+
+// count samples from `from` to `to` in equal steps (both included when count > 1)
+static void ramp(std::vector<float> &samples, float from, float to, uint32_t count)
+{
+  for (uint32_t i = 0; i < count; i++)
+  {
+    samples.push_back(count > 1 ? from + (to - from) * i / (count - 1) : to);
+  }
+}
+
+static void hold(std::vector<float> &samples, float value, uint32_t count)
+{
+  samples.insert(samples.end(), count, value);
+}
+
+// First sample past `limit` in the given direction, from `start`
+static uint32_t firstPast(const std::vector<float> &samples, uint32_t start, float limit, bool isAbove)
+{
+  for (uint32_t i = start; i < samples.size(); i++)
+  {
+    if (isAbove ? samples[i] > limit : samples[i] < limit)
+    {
+      return i;
+    }
+  }
+  return UINT32_MAX;
+}
+
+static void print(const char *name, const Run &run)
+{
+  printf("%-11s %7lu %6lu %7lu %6u", name, (unsigned long)run.stats.samples, (unsigned long)run.stats.raised,
+         (unsigned long)run.stats.cleared, (unsigned)run.activeAtEnd);
+  static const char *const KINDS[] = {"high", "low", "rate"};
+  for (const Event &event : run.events)
+  {
+    printf("  %s%s@%lu", event.isActive ? "+" : "-", KINDS[event.kind], (unsigned long)event.sample);
+  }
+  printf("\n");
+}
+
+int main()
+{
+  const uint32_t debounce = ALARM_DEBOUNCE_DEFAULT;
+  const float high = ALARM_HIGH_DEFAULT;
+  const float low = ALARM_LOW_DEFAULT;
+  const float hysteresis = ALARM_HYSTERESIS_DEFAULT;
+  const uint32_t window = ALARM_RATE_WINDOW_MS / SAMPLE_INTERVAL_DEFAULT; // Samples per rate baseline
+
+  printf("high %.1f, low %.1f, hysteresis %.1f °C, rate %.1f °C/min, debounce %u, sample %lu ms, window %lu ms\n",
+         high, low, hysteresis, ALARM_RATE_DEFAULT, (unsigned)debounce, (unsigned long)SAMPLE_INTERVAL_DEFAULT,
+         (unsigned long)ALARM_RATE_WINDOW_MS);
+  printf("%-11s %7s %6s %7s %6s  events (sample)\n", "case", "samples", "raised", "cleared", "active");
+
+  // Rise and fall at 0.5 °C/min, well below the rate trigger
+  const float slope = 0.5f / SAMPLES_PER_MINUTE;
+  std::vector<float> samples;
+  ramp(samples, high - 2, high + 1, (uint32_t)(3 / slope) + 1);
+  hold(samples, high + 1, 30);
+  ramp(samples, high + 1, high - 2, (uint32_t)(3 / slope) + 1);
+  Run rise = simulate(samples);
+  print("high", rise);
+  uint32_t raiseAt = firstPast(samples, 0, high, true) + debounce - 1;
+  uint32_t clearAt = firstPast(samples, raiseAt, high - hysteresis, false) + debounce - 1;
+  check(rise.events.size() == 2 && isEvent(rise, 0, ALARM_HIGH, true, raiseAt) &&
+            isEvent(rise, 1, ALARM_HIGH, false, clearAt),
+        "high: raised debounce samples past the limit, cleared hysteresis inside it");
+  check(rise.events.size() == 2 && rise.events[0].value > high && rise.events[1].value < high - hysteresis,
+        "high: event values past the enter and exit thresholds");
+
+  samples.clear();
+  hold(samples, high + 0.5f, 10);
+  hold(samples, high - hysteresis / 2, 60); // Below the limit, inside the hysteresis
+  hold(samples, high - hysteresis - 0.1f, 10);
+  Run band = simulate(samples);
+  print("hysteresis", band);
+  check(band.events.size() == 2 && isEvent(band, 0, ALARM_HIGH, true, debounce - 1) &&
+            isEvent(band, 1, ALARM_HIGH, false, 70 + debounce - 1),
+        "hysteresis: stays raised until hysteresis inside the limit");
+
+  samples.clear();
+  ramp(samples, low + 2, low - 1, (uint32_t)(3 / slope) + 1);
+  hold(samples, low - 1, 30);
+  ramp(samples, low - 1, low + 2, (uint32_t)(3 / slope) + 1);
+  Run fall = simulate(samples);
+  print("low", fall);
+  raiseAt = firstPast(samples, 0, low, false) + debounce - 1;
+  clearAt = firstPast(samples, raiseAt, low + hysteresis, true) + debounce - 1;
+  check(fall.events.size() == 2 && isEvent(fall, 0, ALARM_LOW, true, raiseAt) &&
+            isEvent(fall, 1, ALARM_LOW, false, clearAt),
+        "low: raised past the limit, cleared hysteresis inside it");
+
+  samples.clear();
+  hold(samples, 20, 40);
+  for (uint32_t i = 0; i < 5; i++)
+  {
+    samples[5 + i * 7] = high + 5;
+    samples[8 + i * 7] = low - 5;
+  }
+  Run spike = simulate(samples);
+  print("spike", spike);
+  check(debounce < 2 || spike.events.empty(), "spike: single samples past the limits ignored");
+
+  samples.clear();
+  for (uint32_t i = 0; i < 60; i++)
+  {
+    samples.push_back(i % 2 == 0 ? high + 0.2f : high - 0.2f);
+  }
+  Run chatter = simulate(samples);
+  print("chatter", chatter);
+  check(debounce < 2 || chatter.events.empty(), "chatter: no alarm while crossing every sample");
+
+  // 4 °C/min for two minutes, then level
+  samples.clear();
+  hold(samples, 20, 2 * window);
+  ramp(samples, 20, 28, 2 * SAMPLES_PER_MINUTE + 1);
+  hold(samples, 28, 3 * window);
+  Run fast = simulate(samples);
+  print("rate", fast);
+  bool isRateRaised = fast.events.size() == 2 && fast.events[0].kind == ALARM_RATE && fast.events[0].isActive &&
+                      fast.events[1].kind == ALARM_RATE && !fast.events[1].isActive;
+  check(isRateRaised, "rate: raised on the ramp, cleared once level");
+  check(isRateRaised && fast.events[0].sample > 2 * window && fast.events[0].sample <= 2 * window + window + debounce,
+        "rate: raised within a window of the ramp start");
+  check(isRateRaised && fabsf(fast.events[0].value) > ALARM_RATE_DEFAULT &&
+            fabsf(fast.events[1].value) < ALARM_RATE_DEFAULT * ALARM_RATE_CLEAR_RATIO,
+        "rate: event values past the trigger and the clear ratio");
+
+  samples.clear();
+  hold(samples, 20, 2 * window);
+  ramp(samples, 20, 20 + 0.75f * ALARM_RATE_DEFAULT * 3, 3 * SAMPLES_PER_MINUTE + 1);
+  hold(samples, 20 + 0.75f * ALARM_RATE_DEFAULT * 3, 2 * window);
+  Run slow = simulate(samples);
+  print("slow", slow);
+  check(slow.events.empty(), "slow: ramp below the rate trigger raises nothing");
+
+  // 1 °C/min seen through 1 °C steps: a step is not a rate
+  samples.clear();
+  ramp(samples, 15, 25, 10 * SAMPLES_PER_MINUTE + 1);
+  for (float &value : samples)
+  {
+    value = roundf(value);
+  }
+  Run coarse = simulate(samples);
+  print("dht11", coarse);
+  check(coarse.events.empty(), "dht11: resolution steps raise no rate alarm");
+
+  samples.clear();
+  hold(samples, 20, 10);
+  samples.push_back(high + 1);
+  samples.push_back(NAN);
+  samples.push_back(NAN);
+  hold(samples, high + 1, 10);
+  samples.push_back(high - hysteresis - 1);
+  samples.push_back(NAN);
+  hold(samples, high - hysteresis - 1, 10);
+  Run failed = simulate(samples, 0, 0); // Steps this large are also a rate: limits only
+  print("nan", failed);
+  check(failed.stats.samples == samples.size() - 3, "nan: failed readings not evaluated");
+  check(failed.events.size() == 2 && isEvent(failed, 0, ALARM_HIGH, true, 10 + 3 + debounce - 2) &&
+            isEvent(failed, 1, ALARM_HIGH, false, 23 + 2 + debounce - 2),
+        "nan: debounce counts across failed readings");
+
+  // Same fast ramp with micros() wrapping in the middle of it
+  samples.clear();
+  hold(samples, 20, 2 * window);
+  ramp(samples, 20, 28, 2 * SAMPLES_PER_MINUTE + 1);
+  hold(samples, 28, 3 * window);
+  const uint32_t base = 0xFFFFFFFFUL - (2 * window + SAMPLES_PER_MINUTE) * PERIOD_US;
+  Run wrap = simulate(samples, base);
+  print("wrap", wrap);
+  check(wrap.events.size() == fast.events.size() && wrap.events.size() == 2 &&
+            wrap.events[0].sample == fast.events[0].sample && wrap.events[1].sample == fast.events[1].sample,
+        "wrap: rate alarm unchanged across the micros() wrap");
+
+  const Run *const runs[] = {&rise, &band, &fall, &spike, &chatter, &fast, &slow, &coarse, &failed, &wrap};
+  for (const Run *run : runs)
+  {
+    check(run->activeAtEnd == 0 && run->stats.raised == run->stats.cleared, "every alarm raised is cleared");
+  }
+
+  return finish();
+}
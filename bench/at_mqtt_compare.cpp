@@ -0,0 +1,476 @@
+/* UART cost of the two MQTT transports, against the scripted fake modem
+ * - CIPSEND: MQTT packets built on the STM32 (PubSubClient / OutboundQueue
+ *   wire format) and carried by WiFiEspAT's TCP commands in passive mode
+ * - AT+MQTT: AtMqttClient, the modem frames the packets itself
+ * Reports UART bytes per message in each direction, AT round trips and the
+ * UART time they cost at 115200 and 921600 baud (bits on the wire plus a
+ * modem turnaround per command). Network time is the same on both paths
+ * and is left out. Also checks AtMqttClient against injected URCs.
+ *
+ * Build and run:
+ *   pio run -e native_at_mqtt_bench
+ *   .pio/build/native_at_mqtt_bench/program [messages=100] [payload=5] [turnaround_us=500] [script=file]
+ */
+#include <Arduino.h>
+#include <Client.h>
+
+#include "FakeModem.h"
+#include "atMqtt.hpp"
+
+static const char *TELEMETRY_TOPIC = "sensor1/temp";
+static const char *COMMAND_TOPIC = "sala_maquinas/controlo/intervalo";
+static const char *COMMAND_PAYLOAD = "5000";
+
+/// CipClient
+/// @brief The TCP path of WiFiEspAT's WiFiClient, reduced to the AT traffic
+/// it generates in passive receive mode: one AT+CIPSEND per write and one
+/// AT+CIPRECVDATA per +IPD notification. Connection polling (AT+CIPSTATUS)
+/// is not modelled, so its figures are a lower bound.
+///
+class CipClient : public Client
+{
+public:
+  CipClient(Stream &serial) : serial(serial) {}
+
+  int connect(IPAddress, uint16_t) override { return 0; }
+
+  int connect(const char *host, uint16_t port) override
+  {
+    serial.printf("AT+CIPSTART=0,\"TCP\",\"%s\",%u\r\n", host, port);
+    isOpen = waitFor("OK");
+    return isOpen;
+  }
+
+  size_t write(uint8_t b) override { return write(&b, 1); }
+
+  size_t write(const uint8_t *buffer, size_t size) override
+  {
+    serial.printf("AT+CIPSEND=0,%u\r\n", (unsigned)size);
+    if (!waitFor(">"))
+    {
+      return 0;
+    }
+    serial.write(buffer, size);
+    return waitFor("SEND OK") ? size : 0;
+  }
+
+  int available() override
+  {
+    if (rxStart == rxEnd)
+    {
+      waitFor(nullptr); // Collect +IPD notifications
+      if (pending > 0)
+      {
+        serial.printf("AT+CIPRECVDATA=0,%u\r\n", (unsigned)min(pending, sizeof(rxBuffer)));
+        waitFor("OK");
+      }
+    }
+    return (int)(rxEnd - rxStart);
+  }
+
+  int read() override { return available() > 0 ? rxBuffer[rxStart++] : -1; }
+
+  int read(uint8_t *buffer, size_t size) override
+  {
+    size_t n = 0;
+    while (n < size && available() > 0)
+    {
+      buffer[n++] = rxBuffer[rxStart++];
+    }
+    return n > 0 ? (int)n : -1;
+  }
+
+  int peek() override { return available() > 0 ? rxBuffer[rxStart] : -1; }
+  void flush() override {}
+
+  void stop() override
+  {
+    serial.print("AT+CIPCLOSE=0\r\n");
+    waitFor("OK");
+    isOpen = false;
+  }
+
+  uint8_t connected() override { return isOpen; }
+  operator bool() override { return isOpen; }
+  using Print::write;
+
+private:
+  // Reads modem output until the token line (or '>' prompt); nullptr only
+  // drains what is already there. +CIPRECVDATA data is stored in rxBuffer.
+  bool waitFor(const char *token)
+  {
+    char line[96];
+    size_t length = 0;
+    while (serial.available() > 0)
+    {
+      char c = (char)serial.read();
+      if (c == '>' && length == 0 && token && strcmp(token, ">") == 0)
+      {
+        return true;
+      }
+      if (c == '\r')
+      {
+        continue;
+      }
+      if (c != '\n')
+      {
+        if (length < sizeof(line) - 1)
+        {
+          line[length++] = c;
+        }
+        line[length] = '\0';
+        unsigned count;
+        if (c == ',' && sscanf(line, "+CIPRECVDATA:%u,", &count) == 1)
+        {
+          rxStart = 0;
+          rxEnd = 0;
+          while (rxEnd < count && serial.available() > 0)
+          {
+            rxBuffer[rxEnd++] = (uint8_t)serial.read();
+          }
+          pending -= min(pending, (size_t)count);
+          length = 0;
+        }
+        continue;
+      }
+
+      line[length] = '\0';
+      length = 0;
+      unsigned count;
+      if (sscanf(line, "+IPD,0,%u", &count) == 1)
+      {
+        pending += count;
+      }
+      else if (strcmp(line, "0,CLOSED") == 0)
+      {
+        isOpen = false;
+      }
+      else if (token && strcmp(line, token) == 0)
+      {
+        return true;
+      }
+      else if (token && strcmp(line, "ERROR") == 0)
+      {
+        return false;
+      }
+    }
+    return token == nullptr;
+  }
+
+  Stream &serial;
+  uint8_t rxBuffer[256];
+  size_t rxStart = 0;
+  size_t rxEnd = 0;
+  size_t pending = 0; // Announced by +IPD, not yet fetched
+  bool isOpen = false;
+};
+
+// MQTT fixed header with the remaining length in 7-bit groups
+static size_t encodeHeader(uint8_t *out, uint8_t type, uint32_t length)
+{
+  size_t n = 0;
+  out[n++] = type;
+  do
+  {
+    uint8_t digit = length & 0x7F;
+    length >>= 7;
+    out[n++] = length ? (digit | 0x80) : digit;
+  } while (length);
+  return n;
+}
+
+static size_t encodeString(uint8_t *out, const char *text)
+{
+  size_t length = strlen(text);
+  out[0] = length >> 8;
+  out[1] = length & 0xFF;
+  memcpy(out + 2, text, length);
+  return 2 + length;
+}
+
+// Reads one whole MQTT packet (what PubSubClient::loop() does per call)
+static bool readPacket(Client &client, uint8_t *type)
+{
+  int header = client.read();
+  if (header < 0)
+  {
+    return false;
+  }
+  *type = (uint8_t)header & 0xF0;
+
+  uint32_t remaining = 0;
+  uint8_t shift = 0;
+  int b;
+  do
+  {
+    b = client.read();
+    if (b < 0)
+    {
+      return false;
+    }
+    remaining |= (uint32_t)(b & 0x7F) << shift;
+    shift += 7;
+  } while (b & 0x80);
+
+  while (remaining-- > 0)
+  {
+    if (client.read() < 0)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+struct Cost
+{
+  double hostToModem; // STM32 TX bytes per message
+  double modemToHost; // STM32 RX bytes per message
+  double commands;    // AT round trips per message
+};
+
+static Cost costSince(const FakeModemStats &before, const FakeModemStats &after, uint32_t messages)
+{
+  Cost cost;
+  cost.hostToModem = (double)(after.hostToModem - before.hostToModem) / messages;
+  cost.modemToHost = (double)(after.modemToHost - before.modemToHost) / messages;
+  cost.commands = (double)(after.commands - before.commands) / messages;
+  return cost;
+}
+
+static double uartMicros(const Cost &cost, uint32_t baud, uint32_t turnaroundUs)
+{
+  // 8N1: 10 bits per byte; both directions share the command round trips
+  return (cost.hostToModem + cost.modemToHost) * 10.0 * 1e6 / baud + cost.commands * turnaroundUs;
+}
+
+static void printCost(const char *name, const Cost &cost, uint32_t turnaroundUs)
+{
+  printf("%-24s %9.1f %9.1f %7.2f %12.0f %12.0f\n", name, cost.hostToModem, cost.modemToHost, cost.commands,
+         uartMicros(cost, 115200, turnaroundUs), uartMicros(cost, 921600, turnaroundUs));
+}
+
+static uint32_t acks = 0;
+static uint32_t commandsReceived = 0;
+
+static void onAck(uint16_t)
+{
+  acks++;
+}
+
+static void onMessage(char *topic, uint8_t *payload, unsigned int length)
+{
+  if (strcmp(topic, COMMAND_TOPIC) == 0 && length == strlen(COMMAND_PAYLOAD) &&
+      memcmp(payload, COMMAND_PAYLOAD, length) == 0)
+  {
+    commandsReceived++;
+  }
+}
+
+static bool option(const char *argument, const char *name, const char **value)
+{
+  size_t length = strlen(name);
+  if (strncmp(argument, name, length) != 0 || argument[length] != '=')
+  {
+    return false;
+  }
+  *value = argument + length + 1;
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t messages = 100;
+  size_t payloadSize = 5;
+  uint32_t turnaroundUs = 500;
+  const char *script = nullptr;
+  for (int i = 1; i < argc; i++)
+  {
+    const char *value;
+    if (option(argv[i], "messages", &value))
+    {
+      messages = (uint32_t)atol(value);
+    }
+    else if (option(argv[i], "payload", &value))
+    {
+      payloadSize = (size_t)atoi(value);
+    }
+    else if (option(argv[i], "turnaround_us", &value))
+    {
+      turnaroundUs = (uint32_t)atol(value);
+    }
+    else if (option(argv[i], "script", &value))
+    {
+      script = value;
+    }
+    else
+    {
+      fprintf(stderr, "usage: %s [messages=100] [payload=5] [turnaround_us=500] [script=file]\n", argv[0]);
+      return 2;
+    }
+  }
+  messages = messages > 0 ? messages : 1;
+  payloadSize = min(payloadSize, (size_t)128);
+
+  uint8_t payload[128];
+  for (size_t i = 0; i < payloadSize; i++)
+  {
+    payload[i] = '0' + i % 10;
+  }
+
+  // ---------- CIPSEND: packets framed on the STM32 ----------
+  FakeModem tcpModem;
+  CipClient tcp(tcpModem);
+  uint8_t packet[256];
+  uint8_t type;
+  size_t n;
+
+  if (!tcp.connect("192.168.1.178", 1883))
+  {
+    fprintf(stderr, "CIPSEND: no TCP link\n");
+    return 1;
+  }
+  uint8_t connectBody[64];
+  size_t bodyLength = encodeString(connectBody, "MQTT");
+  connectBody[bodyLength++] = 4;    // Protocol level 3.1.1
+  connectBody[bodyLength++] = 0x02; // Clean session
+  connectBody[bodyLength++] = 0;
+  connectBody[bodyLength++] = AT_MQTT_KEEPALIVE;
+  bodyLength += encodeString(connectBody + bodyLength, "bench");
+  n = encodeHeader(packet, 0x10, bodyLength);
+  memcpy(packet + n, connectBody, bodyLength);
+  tcp.write(packet, n + bodyLength);
+  readPacket(tcp, &type);
+
+  n = encodeHeader(packet, 0x82, 2 + 2 + strlen(COMMAND_TOPIC) + 1);
+  packet[n++] = 0;
+  packet[n++] = 1;
+  n += encodeString(packet + n, COMMAND_TOPIC);
+  packet[n++] = 0;
+  tcp.write(packet, n);
+  readPacket(tcp, &type);
+
+  FakeModemStats before = tcpModem.getStats();
+  uint32_t tcpAcks = 0;
+  for (uint32_t i = 0; i < messages; i++)
+  {
+    n = encodeHeader(packet, 0x32, 2 + strlen(TELEMETRY_TOPIC) + 2 + payloadSize);
+    n += encodeString(packet + n, TELEMETRY_TOPIC);
+    packet[n++] = (i + 1) >> 8;
+    packet[n++] = (i + 1) & 0xFF;
+    memcpy(packet + n, payload, payloadSize);
+    tcp.write(packet, n + payloadSize);
+    if (readPacket(tcp, &type) && type == 0x40)
+    {
+      tcpAcks++;
+    }
+  }
+  Cost tcpPublish = costSince(before, tcpModem.getStats(), messages);
+
+  before = tcpModem.getStats();
+  uint32_t tcpCommands = 0;
+  for (uint32_t i = 0; i < messages; i++)
+  {
+    tcpModem.deliver(COMMAND_TOPIC, COMMAND_PAYLOAD);
+    if (readPacket(tcp, &type) && type == 0x30)
+    {
+      tcpCommands++;
+    }
+  }
+  Cost tcpInbound = costSince(before, tcpModem.getStats(), messages);
+
+  before = tcpModem.getStats();
+  packet[0] = 0xC0;
+  packet[1] = 0;
+  tcp.write(packet, 2);
+  readPacket(tcp, &type);
+  Cost tcpKeepalive = costSince(before, tcpModem.getStats(), 1);
+
+  // ---------- AT+MQTT: packets framed by the modem ----------
+  FakeModem atModem;
+  if (script && !atModem.loadScript(script))
+  {
+    fprintf(stderr, "%s: cannot load script\n", script);
+    return 1;
+  }
+  AtMqttClient mqtt(atModem);
+  mqtt.setServer("192.168.1.178", 1883).setCallback(onMessage).setSocketTimeout(1);
+  mqtt.setAckHandler(onAck);
+
+  if (!mqtt.connect("bench"))
+  {
+    fprintf(stderr, "AT+MQTT: connect failed, state %d\n", mqtt.state());
+    return 1;
+  }
+  mqtt.subscribe(COMMAND_TOPIC);
+
+  before = atModem.getStats();
+  for (uint32_t i = 0; i < messages; i++)
+  {
+    mqtt.publish(TELEMETRY_TOPIC, payload, payloadSize, false, 1, (uint16_t)(i + 1));
+    mqtt.loop();
+  }
+  Cost atPublish = costSince(before, atModem.getStats(), messages);
+
+  before = atModem.getStats();
+  for (uint32_t i = 0; i < messages; i++)
+  {
+    atModem.deliver(COMMAND_TOPIC, COMMAND_PAYLOAD);
+    mqtt.loop();
+  }
+  Cost atInbound = costSince(before, atModem.getStats(), messages);
+
+  // ---------- Report ----------
+  printf("%u messages, %u-byte payload on \"%s\", turnaround %u us per AT command\n\n", (unsigned)messages,
+         (unsigned)payloadSize, TELEMETRY_TOPIC, (unsigned)turnaroundUs);
+  printf("%-24s %9s %9s %7s %12s %12s\n", "per message", "STM32 TX", "STM32 RX", "AT cmd", "us @115200",
+         "us @921600");
+  printCost("publish QoS1, CIPSEND", tcpPublish, turnaroundUs);
+  printCost("publish QoS1, AT+MQTT", atPublish, turnaroundUs);
+  printCost("command in, CIPSEND", tcpInbound, turnaroundUs);
+  printCost("command in, AT+MQTT", atInbound, turnaroundUs);
+  printCost("keepalive, CIPSEND", tcpKeepalive, turnaroundUs);
+  printf("%-24s %9s %9s %7s %12s %12s\n", "keepalive, AT+MQTT", "0", "0", "0", "0", "0");
+
+  // ---------- Checks ----------
+  bool isPassing = true;
+  if (tcpAcks != messages || tcpCommands != messages)
+  {
+    printf("FAIL: CIPSEND path acked %u, received %u of %u\n", (unsigned)tcpAcks, (unsigned)tcpCommands,
+           (unsigned)messages);
+    isPassing = false;
+  }
+  if (acks != messages || commandsReceived != messages)
+  {
+    printf("FAIL: AT+MQTT path handed over %u, received %u of %u\n", (unsigned)acks,
+           (unsigned)commandsReceived, (unsigned)messages);
+    isPassing = false;
+  }
+
+  // Payload with a line ending must reach the callback unchanged
+  atModem.deliver(COMMAND_TOPIC, "50\r\n0");
+  uint32_t receivedBefore = mqtt.getStats().received;
+  mqtt.loop();
+  if (mqtt.getStats().received != receivedBefore + 1)
+  {
+    printf("FAIL: binary payload not delivered\n");
+    isPassing = false;
+  }
+
+  atModem.inject("+MQTTDISCONNECTED:0\r\n");
+  mqtt.loop();
+  if (mqtt.connected() || mqtt.state() != AT_MQTT_CONNECTION_LOST)
+  {
+    printf("FAIL: +MQTTDISCONNECTED not detected (state %d)\n", mqtt.state());
+    isPassing = false;
+  }
+  if (mqtt.publish(TELEMETRY_TOPIC, "1"))
+  {
+    printf("FAIL: publish accepted while disconnected\n");
+    isPassing = false;
+  }
+
+  printf("\nAtMqttClient: %u commands, %u failures; checks %s\n", (unsigned)mqtt.getStats().commands,
+         (unsigned)mqtt.getStats().failures, isPassing ? "passed" : "FAILED");
+  return isPassing ? 0 : 1;
+}
@@ -0,0 +1,214 @@
+/* Button debounce state machine against synthetic edge timings
+ * Runs ButtonDebouncer (lib/buttonInput) the way the firmware does: every
+ * edge is reported as by the EXTI interrupt and starts the debounce timer
+ * (BUTTON_TICK_US), which stops again once no button is settling or held.
+ * Time moves in 1 ms steps and loop() drains the queue every step. Cases:
+ *   clean:      one press and release without bounce
+ *   bouncy:     contact bounce on the press and on the release
+ *   glitch:     3 ms spike that settles back released
+ *   chatter:    edges 20 ms apart for 200 ms, below the debounce time
+ *   long:       held past BUTTON_LONG_PRESS_MS, released later
+ *   two:        two buttons pressed at overlapping times
+ *   wrap:       a press across the 32-bit millis() wrap
+ *   overflow:   ten presses with loop() not draining the queue
+ *   late edge:  an edge stamped after the tick read millis() and the level
+ * Each case checks the events, their timestamps and durations, the
+ * latency from the settled edge to the queue and that the timer stops.
+ *
+ * Build and run:
+ *   pio run -e native_button_debounce
+ *   .pio/build/native_button_debounce/program
+ */
+#include <stdio.h>
+#include <vector>
+
+#include <config.hpp>
+
+#include "buttonInput.hpp"
+#include "check.h"
+
+static constexpr uint32_t TICK_MS = BUTTON_TICK_US / 1000;
+
+struct Edge
+{
+  uint32_t ms; // From the start of the case
+  uint8_t button;
+  bool isPressed; // Level after the edge
+};
+
+struct Run
+{
+  std::vector<ButtonEvent> events;
+  uint32_t ticks;        // Timer interrupts
+  uint32_t maxLatencyMs; // Release + debounce time (or long press time) to queued
+  bool isTimerStopped;   // At the end of the case
+  ButtonStats stats;
+};
+
+static Run simulate(const std::vector<Edge> &edges, uint32_t untilMs, uint32_t baseMs = 0, bool isDraining = true)
+{
+  ButtonDebouncer debouncer;
+  debouncer.configure(BUTTON_DEBOUNCE_DELAY, BUTTON_LONG_PRESS_MS);
+  Run run = {};
+  uint8_t pressedMask = 0;
+  bool isRunning = false;
+  uint32_t nextTick = 0;
+  size_t next = 0;
+
+  for (uint32_t t = 0; t <= untilMs; t++)
+  {
+    uint32_t now = baseMs + t;
+    for (; next < edges.size() && edges[next].ms == t; next++)
+    {
+      const Edge &edge = edges[next];
+      pressedMask = edge.isPressed ? pressedMask | (1 << edge.button) : pressedMask & ~(1 << edge.button);
+      debouncer.edge(edge.button, now); // EXTI interrupt
+      if (!isRunning)
+      {
+        isRunning = true;
+        nextTick = t + TICK_MS;
+      }
+    }
+    if (isRunning && t == nextTick)
+    {
+      run.ticks++;
+      isRunning = debouncer.tick(now, pressedMask) || debouncer.isActive();
+      nextTick += TICK_MS;
+    }
+    ButtonEvent event;
+    while (isDraining && debouncer.pop(event))
+    {
+      // Time the event is based on: the release, or the long press time
+      uint32_t dueMs = event.pressedMs + event.durationMs;
+      uint32_t latencyMs = now - dueMs;
+      if (event.type == BUTTON_SHORT_PRESS)
+      {
+        latencyMs -= BUTTON_DEBOUNCE_DELAY; // A release cannot be trusted before this
+      }
+      run.maxLatencyMs = latencyMs > run.maxLatencyMs ? latencyMs : run.maxLatencyMs;
+      run.events.push_back(event);
+    }
+  }
+  ButtonEvent event;
+  while (!isDraining && debouncer.pop(event))
+  {
+    run.events.push_back(event);
+  }
+  run.isTimerStopped = !isRunning;
+  run.stats = debouncer.getStats();
+  return run;
+}
+
+static bool isEvent(const Run &run, size_t index, uint8_t button, ButtonEventType type, uint32_t pressedMs,
+                    uint32_t durationMs)
+{
+  if (index >= run.events.size())
+  {
+    return false;
+  }
+  const ButtonEvent &event = run.events[index];
+  return event.button == button && event.type == type && event.pressedMs == pressedMs &&
+         event.durationMs == durationMs;
+}
+
+// Press (or release) with the level flipping at each offset after startMs
+static void bounce(std::vector<Edge> &edges, uint8_t button, uint32_t startMs, bool isPressed,
+                   std::initializer_list<uint32_t> offsets)
+{
+  bool level = isPressed;
+  for (uint32_t offset : offsets)
+  {
+    edges.push_back({startMs + offset, button, level});
+    level = !level;
+  }
+}
+
+static void print(const char *name, const Run &run)
+{
+  printf("%-9s %6zu %6lu %6lu %8lu %6lu %8lu %7s\n", name, run.events.size(), (unsigned long)run.stats.edges,
+         (unsigned long)run.stats.glitches, (unsigned long)run.stats.dropped, (unsigned long)run.ticks,
+         (unsigned long)run.maxLatencyMs, run.isTimerStopped ? "yes" : "no");
+}
+
+int main()
+{
+  printf("debounce %lu ms, long press %lu ms, tick %lu ms\n", (unsigned long)BUTTON_DEBOUNCE_DELAY,
+         (unsigned long)BUTTON_LONG_PRESS_MS, (unsigned long)TICK_MS);
+  printf("%-9s %6s %6s %6s %8s %6s %8s %7s\n", "case", "events", "edges", "glitch", "dropped", "ticks", "late ms",
+         "stopped");
+
+  Run clean = simulate({{100, 0, true}, {400, 0, false}}, 1000);
+  print("clean", clean);
+  check(clean.events.size() == 1 && isEvent(clean, 0, 0, BUTTON_SHORT_PRESS, 100, 300), "clean: one short press");
+
+  std::vector<Edge> edges;
+  bounce(edges, 0, 100, true, {0, 1, 2, 4, 7});
+  bounce(edges, 0, 600, false, {0, 1, 3});
+  Run bouncy = simulate(edges, 1200);
+  print("bouncy", bouncy);
+  check(bouncy.events.size() == 1 && isEvent(bouncy, 0, 0, BUTTON_SHORT_PRESS, 100, 500),
+        "bouncy: one short press timed from the first edges");
+
+  Run glitch = simulate({{100, 0, true}, {103, 0, false}}, 500);
+  print("glitch", glitch);
+  check(glitch.events.empty() && glitch.stats.glitches == 1, "glitch: no event");
+
+  edges.clear();
+  bounce(edges, 0, 100, true, {0, 20, 40, 60, 80, 100, 120, 140, 160, 180, 200});
+  edges.push_back({700, 0, false});
+  Run chatter = simulate(edges, 1200);
+  print("chatter", chatter);
+  check(chatter.events.size() == 1 && isEvent(chatter, 0, 0, BUTTON_SHORT_PRESS, 100, 600), "chatter: one press");
+
+  Run held = simulate({{100, 0, true}, {3000, 0, false}}, 4000);
+  print("long", held);
+  check(held.events.size() == 1 && isEvent(held, 0, 0, BUTTON_LONG_PRESS, 100, BUTTON_LONG_PRESS_MS),
+        "long: one long press, nothing on the release");
+
+  edges.clear();
+  edges = {{100, 0, true}, {150, 1, true}, {300, 0, false}, {2500, 1, false}};
+  Run two = simulate(edges, 3000);
+  print("two", two);
+  check(two.events.size() == 2 && isEvent(two, 0, 0, BUTTON_SHORT_PRESS, 100, 200) &&
+            isEvent(two, 1, 1, BUTTON_LONG_PRESS, 150, BUTTON_LONG_PRESS_MS),
+        "two: independent buttons, in time order");
+
+  const uint32_t base = 0xFFFFFFFFUL - 150;
+  Run wrap = simulate({{100, 0, true}, {400, 0, false}}, 1000, base);
+  print("wrap", wrap);
+  check(wrap.events.size() == 1 && isEvent(wrap, 0, 0, BUTTON_SHORT_PRESS, base + 100, 300),
+        "wrap: press across the millis() wrap");
+
+  edges.clear();
+  for (uint32_t i = 0; i < 10; i++)
+  {
+    edges.push_back({100 + i * 300, 0, true});
+    edges.push_back({200 + i * 300, 0, false});
+  }
+  Run overflow = simulate(edges, 4000, 0, false);
+  print("overflow", overflow);
+  check(overflow.events.size() == BUTTON_QUEUE_SIZE - 1 && overflow.stats.dropped == 10 - (BUTTON_QUEUE_SIZE - 1),
+        "overflow: full queue drops and counts the newest");
+  check(isEvent(overflow, 0, 0, BUTTON_SHORT_PRESS, 100, 100), "overflow: oldest events kept");
+
+  // EXTI edge landing after buttonTick() read millis(): still settling, not settled by the wrap
+  ButtonDebouncer late;
+  late.configure(BUTTON_DEBOUNCE_DELAY, BUTTON_LONG_PRESS_MS);
+  late.edge(0, 1001);
+  bool isLateSettled = !late.tick(1000, 1) || late.isPressed(0);
+  late.tick(1001 + BUTTON_DEBOUNCE_DELAY, 1);
+  check(!isLateSettled && late.isPressed(0), "late edge: settles after the debounce time, not at once");
+
+  const Run *const runs[] = {&clean, &bouncy, &glitch, &chatter, &held, &two, &wrap, &overflow};
+  for (const Run *run : runs)
+  {
+    check(run->isTimerStopped, "timer stops once every button is idle");
+    check(run->maxLatencyMs <= TICK_MS, "event queued within one tick of being due");
+  }
+  // Timer only runs while settling or until the long press: not for the rest of a hold
+  check(glitch.ticks <= BUTTON_DEBOUNCE_DELAY / TICK_MS + 1, "glitch: timer stops after one settle");
+  check(held.ticks <= (BUTTON_LONG_PRESS_MS + 2 * BUTTON_DEBOUNCE_DELAY) / TICK_MS + 2,
+        "long: timer idle while held after the long press");
+
+  return finish();
+}
@@ -0,0 +1,27 @@
+#ifndef BENCH_CHECK_H
+#define BENCH_CHECK_H
+
+// Pass/fail reporting shared by the benches: every failed check prints a
+// FAIL line and is counted, finish() prints the verdict and gives the exit
+// code of the program. One bench per program, so the state can be static.
+
+#include <stdio.h>
+
+static int failures = 0;
+
+static void check(bool isOk, const char *what)
+{
+  if (!isOk)
+  {
+    printf("FAIL: %s\n", what);
+    failures++;
+  }
+}
+
+static int finish()
+{
+  printf(failures == 0 ? "OK\n" : "%d FAILED\n", failures);
+  return failures == 0 ? 0 : 1;
+}
+
+#endif // BENCH_CHECK_H
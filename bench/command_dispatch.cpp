@@ -0,0 +1,195 @@
+/* MQTT command dispatch: hashed index against a strcmp chain
+ * Runs CommandDispatcher (lib/commandDispatch) over tables of 1 to
+ * COMMAND_INDEX_SIZE / 2 commands, the most the index takes: the command
+ * topics of the firmware first, then made-up ones under the same
+ * TOPIC_CONTROL_BASE prefix, so every compare walks the long shared
+ * prefix as on the device. Each table
+ * is timed for
+ *   hit:   every topic of the table in turn
+ *   miss:  a topic that is not in the table
+ * through dispatch() and through the strcmp chain it replaced (one
+ * compare per command until the match, as in test/main_backup.cpp).
+ * Checks that every topic reaches its own handler with the payload
+ * untouched, that unknown topics reach none, and that the hashed cost
+ * stays flat as commands are added while the chain grows. The hashed
+ * cost is one FNV-1a pass over the topic plus one strcmp; on the host a
+ * vectorised strcmp keeps the chain cheaper for tables this small, so
+ * the absolute numbers here do not carry over to the Cortex-M4.
+ *
+ * Build and run:
+ *   pio run -e native_command_dispatch
+ *   .pio/build/native_command_dispatch/program
+ */
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <utility>
+
+#include <config.hpp>
+
+#include "commandDispatch.hpp"
+#include "check.h"
+
+static constexpr uint8_t MAX_COMMANDS = COMMAND_INDEX_SIZE / 2; // Index kept at most half full
+static constexpr uint32_t ROUNDS = 200000; // Dispatches per topic and case
+static constexpr int REPEATS = 5;          // Best of, against host noise
+
+static const char *const FIRMWARE_TOPICS[] = {
+    TOPIC_SETPOINT_MIN, TOPIC_SETPOINT_MAX, TOPIC_INTERVAL, TOPIC_MODE,
+    TOPIC_EMERGENCY,    TOPIC_ACTUATOR_CMD, TOPIC_STRATEGY, TOPIC_HISTORY_QUERY,
+};
+static constexpr uint8_t FIRMWARE_COMMANDS = sizeof(FIRMWARE_TOPICS) / sizeof(FIRMWARE_TOPICS[0]);
+
+static const char MISS_TOPIC[] = TOPIC_CONTROL_BASE "desconhecido";
+static const uint8_t PAYLOAD[] = {'2', '4', '.', '5'};
+
+static char extraTopics[MAX_COMMANDS][OUTBOUND_TOPIC_SIZE];
+static const char *topics[MAX_COMMANDS];
+
+// Every handler records which command ran and what it was given
+static volatile int lastCommand = -1;
+static const uint8_t *lastData = nullptr;
+static size_t lastLength = 0;
+
+template <int N>
+static void handler(const PayloadView &payload)
+{
+  lastCommand = N;
+  lastData = payload.data;
+  lastLength = payload.length;
+}
+
+template <int... N>
+static constexpr CommandHandler handlerAt(int i, std::integer_sequence<int, N...>)
+{
+  constexpr CommandHandler HANDLERS[] = {handler<N>...};
+  return HANDLERS[i];
+}
+
+static CommandHandler handlerFor(int i)
+{
+  return handlerAt(i, std::make_integer_sequence<int, MAX_COMMANDS>());
+}
+
+// The dispatch it replaced: one strcmp per command until the match
+static bool dispatchChain(const CommandEntry *table, uint8_t count, const char *topic, const uint8_t *payload,
+                          unsigned int length)
+{
+  for (uint8_t i = 0; i < count; i++)
+  {
+    if (strcmp(topic, table[i].topic) == 0)
+    {
+      PayloadView view = {payload, length};
+      table[i].handler(view);
+      return true;
+    }
+  }
+  return false;
+}
+
+static double nowNs()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return now.tv_sec * 1e9 + now.tv_nsec;
+}
+
+// ns per dispatch, best of REPEATS, for the topics in turn
+template <typename Dispatch>
+static double timeDispatch(Dispatch dispatch, const char *const *cases, uint8_t caseCount)
+{
+  double best = 0;
+  for (int r = 0; r < REPEATS; r++)
+  {
+    double start = nowNs();
+    for (uint32_t i = 0; i < ROUNDS; i++)
+    {
+      for (uint8_t c = 0; c < caseCount; c++)
+      {
+        dispatch(cases[c]);
+      }
+    }
+    double ns = (nowNs() - start) / ((double)ROUNDS * caseCount);
+    best = r == 0 || ns < best ? ns : best;
+  }
+  return best;
+}
+
+int main()
+{
+  for (uint8_t i = 0; i < MAX_COMMANDS; i++)
+  {
+    if (i < FIRMWARE_COMMANDS)
+    {
+      topics[i] = FIRMWARE_TOPICS[i];
+    }
+    else
+    {
+      snprintf(extraTopics[i], sizeof(extraTopics[i]), TOPIC_CONTROL_BASE "extra%u", (unsigned)i);
+      topics[i] = extraTopics[i];
+    }
+  }
+
+  CommandEntry table[MAX_COMMANDS];
+  for (uint8_t i = 0; i < MAX_COMMANDS; i++)
+  {
+    table[i] = {topicHash(topics[i]), topics[i], handlerFor(i)};
+  }
+  static_assert(topicHash(TOPIC_MODE) != topicHash(TOPIC_INTERVAL), "topicHash must run at compile time");
+
+  printf("index %u slots, %u rounds, best of %d\n", (unsigned)COMMAND_INDEX_SIZE, (unsigned)ROUNDS, REPEATS);
+  printf("%8s %10s %10s %10s %10s\n", "commands", "hash hit", "chain hit", "hash miss", "chain miss");
+
+  const uint8_t sizes[] = {1, 2, 4, MAX_COMMANDS * 3 / 4, MAX_COMMANDS};
+  double hashHitNs[sizeof(sizes)] = {};
+  double chainMissNs[sizeof(sizes)] = {};
+  for (size_t s = 0; s < sizeof(sizes); s++)
+  {
+    uint8_t count = sizes[s];
+    CommandDispatcher dispatcher(table, count);
+    dispatcher.begin();
+
+    bool isRouted = true;
+    for (uint8_t i = 0; i < count; i++)
+    {
+      lastCommand = -1;
+      isRouted &= dispatcher.dispatch(topics[i], PAYLOAD, sizeof(PAYLOAD)) && lastCommand == i &&
+                  lastData == PAYLOAD && lastLength == sizeof(PAYLOAD);
+      lastCommand = -1;
+      isRouted &= dispatchChain(table, count, topics[i], PAYLOAD, sizeof(PAYLOAD)) && lastCommand == i;
+    }
+    check(isRouted, "every topic reaches its own handler, payload not copied");
+    lastCommand = -1;
+    check(!dispatcher.dispatch(MISS_TOPIC, PAYLOAD, sizeof(PAYLOAD)) && lastCommand == -1,
+          "unknown topic reaches no handler");
+    if (count < MAX_COMMANDS)
+    {
+      lastCommand = -1;
+      check(!dispatcher.dispatch(topics[count], PAYLOAD, sizeof(PAYLOAD)) && lastCommand == -1,
+            "topic outside the table reaches no handler");
+    }
+
+    const char *const misses[] = {MISS_TOPIC};
+    auto hashed = [&](const char *topic) { dispatcher.dispatch(topic, PAYLOAD, sizeof(PAYLOAD)); };
+    auto chain = [&](const char *topic) { dispatchChain(table, count, topic, PAYLOAD, sizeof(PAYLOAD)); };
+    hashHitNs[s] = timeDispatch(hashed, topics, count);
+    double chainHitNs = timeDispatch(chain, topics, count);
+    double hashMissNs = timeDispatch(hashed, misses, 1);
+    chainMissNs[s] = timeDispatch(chain, misses, 1);
+    printf("%8u %10.1f %10.1f %10.1f %10.1f\n", (unsigned)count, hashHitNs[s], chainHitNs, hashMissNs,
+           chainMissNs[s]);
+  }
+  printf("ns per dispatch (host)\n");
+
+  double fastest = hashHitNs[0];
+  double slowest = hashHitNs[0];
+  for (size_t s = 1; s < sizeof(sizes); s++)
+  {
+    fastest = hashHitNs[s] < fastest ? hashHitNs[s] : fastest;
+    slowest = hashHitNs[s] > slowest ? hashHitNs[s] : slowest;
+  }
+  check(slowest < fastest * 2, "hashed dispatch cost flat from 1 command to a half-full index");
+  check(chainMissNs[sizeof(sizes) - 1] > chainMissNs[0] * 3, "chain cost grows with the commands");
+
+  return finish();
+}
@@ -0,0 +1,301 @@
+/* Config parser checks and boot-time config load benchmark
+ * ConfigParser (lib/configParser) is fed documents from memory: nested and
+ * flat JSON, escapes, the old CSV line, syntax errors (with their line),
+ * and values that must be rejected rather than truncated or clamped. The
+ * same document fed one byte at a time must give the same result.
+ * DeviceConfig (lib/deviceConfig) then runs against the file-backed fake
+ * card of native/SdFat.h through every source: created, snapshot, edited,
+ * broken with a snapshot to fall back on, and corrupted snapshot.
+ * Finally, parse throughput and the load time of each path are reported.
+ *
+ * Build and run:
+ *   pio run -e native_config_parse
+ *   .pio/build/native_config_parse/program [root=sdcard] [iterations=20000]
+ */
+#include <Arduino.h>
+#include <SdFat.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "configParser.hpp"
+#include "deviceConfig.hpp"
+#include "check.h"
+
+SdFat sd;
+configData config_data;
+
+/// Print into memory, for writeConfigJson()
+class BufferPrint : public Print
+{
+public:
+  size_t write(uint8_t b) override
+  {
+    if (length >= sizeof(text) - 1)
+    {
+      return 0;
+    }
+    text[length++] = (char)b;
+    text[length] = '\0';
+    return 1;
+  }
+
+  char text[2048] = {0};
+  size_t length = 0;
+};
+
+static bool parse(ConfigParser &parser, configData &config, const char *text, bool isByteByByte = false)
+{
+  parser.begin(config);
+  size_t length = strlen(text);
+  bool isValid = true;
+  if (isByteByByte)
+  {
+    for (size_t i = 0; i < length && isValid; i++)
+    {
+      isValid = parser.feed(text + i, 1);
+    }
+  }
+  else
+  {
+    isValid = parser.feed(text, length);
+  }
+  return parser.end() && isValid;
+}
+
+static void writeHostFile(const char *name, const char *text)
+{
+  FILE *out = fopen(FakeCard::path(name).c_str(), "wb");
+  fwrite(text, 1, strlen(text), out);
+  fclose(out);
+}
+
+static void flipHostByte(const char *name, long offset)
+{
+  FILE *file = fopen(FakeCard::path(name).c_str(), "r+b");
+  fseek(file, offset, SEEK_SET);
+  int c = fgetc(file);
+  fseek(file, offset, SEEK_SET);
+  fputc(c ^ 0x01, file);
+  fclose(file);
+}
+
+static const char NESTED[] = "{\n"
+                             "  \"asn\": \"ASN042\", \"sn\": \"SN-7\", \"hw\": \"rev C\", \"fw\": \"2.4.1\",\n"
+                             "  \"wifi\": {\"ssid\": \"Sala \\\"B\\\" \\u00e9\", \"password\": \"a\\\\b/c\"},\n"
+                             "  \"mqtt\": {\"host\": \"10.0.0.5\", \"port\": 8883, \"client_id\": \"frio-1\"},\n"
+                             "  \"sample_interval_ms\": 5000,\n"
+                             "  \"heartbeat_ms\": 60000,\n"
+                             "  \"flush_interval_ms\": 20000,\n"
+                             "  \"deadband\": {\"temperature\": [0.5, 0.125, 1, 2.5e-1]},\n"
+                             "  \"setpoint\": {\"min\": 18.5, \"max\": 24},\n"
+                             "  \"alarm\": {\"low\": [-12.5, 0, 5, 8], \"debounce\": [1, 2, 3, 4]},\n"
+                             "  \"comment\": null\n"
+                             "}\n";
+
+static void checkParser()
+{
+  ConfigParser parser;
+  configData config;
+  configData defaults;
+  loadConfigDefaults(defaults);
+
+  // ---------- Round trip of the defaults ----------
+  BufferPrint out;
+  check(writeConfigJson(out, defaults), "defaults written");
+  check(parse(parser, config, out.text), "defaults parsed");
+  check(memcmp(&config, &defaults, sizeof(config)) == 0, "defaults read back unchanged");
+  check(parser.getRejected() == 0 && parser.getUnknown() == 0, "defaults all accepted");
+
+  // ---------- Nested document ----------
+  check(parse(parser, config, NESTED), "nested parsed");
+  check(strcmp(config.asn, "ASN042") == 0 && strcmp(config.fw, "2.4.1") == 0, "identity");
+  check(strcmp(config.ssid, "Sala \"B\" \xc3\xa9") == 0, "escapes and \\u in the SSID");
+  check(strcmp(config.password, "a\\b/c") == 0, "escapes in the password");
+  check(strcmp(config.brokerHost, "10.0.0.5") == 0 && config.brokerPort == 8883, "broker");
+  check(strcmp(config.clientId, "frio-1") == 0, "client id");
+  check(config.sampleIntervalMs == 5000 && config.heartbeatMs == 60000 && config.flushIntervalMs == 20000,
+        "intervals");
+  check(config.deadband[TELEMETRY_TEMPERATURE][0] == 0.5f && config.deadband[TELEMETRY_TEMPERATURE][1] == 0.125f &&
+            config.deadband[TELEMETRY_TEMPERATURE][2] == 1.0f && config.deadband[TELEMETRY_TEMPERATURE][3] == 0.25f,
+        "temperature deadbands");
+  check(config.setpointMin == 18.5f && config.setpointMax == 24.0f, "setpoints");
+  check(config.alarmLow[0] == -12.5f, "negative value");
+  check(config.alarmDebounce[0] == 1 && config.alarmDebounce[3] == 4, "integer array");
+  check(parser.getApplied() == 26 && parser.getRejected() == 0 && parser.getUnknown() == 0, "nested counters");
+
+  // Streaming: one byte at a time gives the same configuration
+  configData streamed;
+  check(parse(parser, streamed, NESTED, true), "nested parsed byte by byte");
+  check(memcmp(&config, &streamed, sizeof(config)) == 0, "byte by byte equal to one chunk");
+
+  // Flat dotted keys land in the same fields
+  check(parse(parser, config, "{\"mqtt.port\": 1884, \"deadband.temperature.2\": 7.5}"), "flat keys parsed");
+  check(config.brokerPort == 1884 && config.deadband[TELEMETRY_TEMPERATURE][2] == 7.5f, "flat keys applied");
+
+  // ---------- Old CSV file ----------
+  check(parse(parser, config, "ASN009, SN009 ,v2.0,v3.1\r\n"), "legacy parsed");
+  check(parser.isLegacy(), "legacy detected");
+  check(strcmp(config.asn, "ASN009") == 0 && strcmp(config.sn, "SN009") == 0 && strcmp(config.hw, "v2.0") == 0 &&
+            strcmp(config.fw, "v3.1") == 0,
+        "legacy fields");
+  check(config.sampleIntervalMs == SAMPLE_INTERVAL_DEFAULT, "legacy keeps the default tunables");
+  check(parse(parser, config, "ASN009,SN009,a-hardware-revision-too-long,v3.1"), "legacy with a long field");
+  check(strcmp(config.hw, defaults.hw) == 0 && parser.getRejected() == 1, "legacy long field rejected, not cut");
+
+  // ---------- Values rejected, file still valid ----------
+  check(parse(parser, config,
+              "{\"sample_interval_ms\": 10, \"hw\": \"a-hardware-revision-too-long\", \"mqtt\": {\"port\": \"1883\"},"
+              " \"colour\": \"blue\", \"deadband\": {\"temperature\": [1, 2, 3, 4, 5]}, \"heartbeat_ms\": 12.5,"
+              " \"setpoint\": {\"min\": 30, \"max\": 20}}"),
+        "document with bad values parsed");
+  check(config.sampleIntervalMs == SAMPLE_INTERVAL_DEFAULT, "interval below the minimum rejected");
+  check(strcmp(config.hw, defaults.hw) == 0, "long text rejected, not cut");
+  check(config.brokerPort == SERVER_PORT, "quoted number rejected");
+  check(config.heartbeatMs == PUBLISH_HEARTBEAT, "fraction for an integer rejected");
+  check(config.deadband[TELEMETRY_TEMPERATURE][3] == 4.0f, "table elements in range applied");
+  check(config.setpointMin == TEMP_SETPOINT_MIN_DEFAULT && config.setpointMax == TEMP_SETPOINT_MAX_DEFAULT,
+        "setpoint min above max rejected");
+  check(parser.getRejected() == 5 && parser.getUnknown() == 2, "rejected and unknown counted");
+
+  // ---------- Syntax errors: the whole file is refused ----------
+  struct Broken
+  {
+    const char *text;
+    uint16_t line;
+    const char *what;
+  };
+  const Broken broken[] = {
+      {"{\n  \"asn\": \"X\"\n  \"sn\": \"Y\"\n}", 3, "missing comma"},
+      {"{\"asn\": \"X\",}", 1, "trailing comma"},
+      {"{\"asn\": \"X\"", 1, "unterminated object"},
+      {"{\"asn\": \"X}", 1, "unterminated string"},
+      {"{\"asn\": \"X\"} x", 1, "text after the document"},
+      {"{\"asn\": [1, 2}", 1, "mismatched bracket"},
+      {"{\"asn\": tru}", 1, "bad literal"},
+      {"{\"asn\": \"a\\qb\"}", 1, "bad escape"},
+      {"{\"asn\": \"line\nbreak\"}", 1, "control character in a string"},
+      {"{\"a\": {\"b\": {\"c\": {\"d\": {\"e\": 1}}}}}", 1, "nested too deep"},
+      {"{\"this.key.is.much.longer.than.the.key.buffer.can.hold\": 1}", 1, "key too long"},
+      {"{\"wifi\": {\"password\": \"0123456789012345678901234567890123456789012345678901234567890123456789"
+       "01234567890123456789\"}}",
+       1, "value too long"},
+      {"", 1, "empty file"},
+  };
+  for (const Broken &document : broken)
+  {
+    config.sampleIntervalMs = 1; // Must be reset to the default
+    bool isValid = parse(parser, config, document.text);
+    check(!isValid, document.what);
+    check(parser.getError()[0] != '\0', "error reported");
+    check(config.sampleIntervalMs == SAMPLE_INTERVAL_DEFAULT, "defaults restored after a syntax error");
+    if (parser.getLine() != document.line)
+    {
+      printf("FAIL: %s reported on line %u, expected %u\n", document.what, parser.getLine(), document.line);
+      failures++;
+    }
+  }
+}
+
+static void checkDeviceConfig()
+{
+  sd.remove(CONFIG_FILENAME);
+  sd.remove(CONFIG_SNAPSHOT_FILENAME);
+
+  check(deviceConfig.load() == CONFIG_CREATED, "missing config.json created");
+  check(sd.exists(CONFIG_FILENAME) && sd.exists(CONFIG_SNAPSHOT_FILENAME), "both files written");
+  check(deviceConfig.load() == CONFIG_FROM_SNAPSHOT, "unchanged config.json uses the snapshot");
+  check(config_data.sampleIntervalMs == SAMPLE_INTERVAL_DEFAULT, "snapshot holds the defaults");
+
+  writeHostFile(CONFIG_FILENAME, "{\"sample_interval_ms\": 5000}\n");
+  check(deviceConfig.load() == CONFIG_FROM_FILE, "edited config.json parsed");
+  check(config_data.sampleIntervalMs == 5000, "edited value applied");
+  check(deviceConfig.load() == CONFIG_FROM_SNAPSHOT, "new snapshot used next boot");
+  check(config_data.sampleIntervalMs == 5000, "new snapshot holds the edited value");
+
+  writeHostFile(CONFIG_FILENAME, "{\"sample_interval_ms\": 7000,,}\n");
+  check(deviceConfig.load() == CONFIG_FROM_OLD_SNAPSHOT, "broken config.json falls back to the snapshot");
+  check(config_data.sampleIntervalMs == 5000, "last good value kept");
+
+  flipHostByte(CONFIG_SNAPSHOT_FILENAME, sizeof(ConfigSnapshotHeader) + 2);
+  check(deviceConfig.load() == CONFIG_DEFAULTS, "broken config.json and corrupt snapshot give the defaults");
+  check(config_data.sampleIntervalMs == SAMPLE_INTERVAL_DEFAULT, "defaults after a corrupt snapshot");
+
+  writeHostFile(CONFIG_FILENAME, "{\"sample_interval_ms\": 3000}\n");
+  check(deviceConfig.load() == CONFIG_FROM_FILE, "fixed config.json parsed");
+  flipHostByte(CONFIG_SNAPSHOT_FILENAME, 5); // Header
+  check(deviceConfig.load() == CONFIG_FROM_FILE, "corrupt snapshot header parsed again");
+  check(config_data.sampleIntervalMs == 3000, "value after a corrupt header");
+
+  sd.remove(CONFIG_SNAPSHOT_FILENAME);
+  writeHostFile(CONFIG_FILENAME, "{\"sample_interval_ms\": 7000,}\n");
+  check(deviceConfig.load() == CONFIG_DEFAULTS, "broken config.json without a snapshot gives the defaults");
+  check(config_data.sampleIntervalMs == SAMPLE_INTERVAL_DEFAULT, "nothing of a broken config.json applied");
+}
+
+static void benchmark(uint32_t iterations)
+{
+  ConfigParser parser;
+  configData config;
+  configData defaults;
+  loadConfigDefaults(defaults);
+  BufferPrint out;
+  writeConfigJson(out, defaults);
+
+  const char *const names[] = {"defaults", "nested"};
+  const char *const documents[] = {out.text, NESTED};
+  printf("\n%-10s %6s %10s %8s\n", "document", "bytes", "us/parse", "MB/s");
+  for (uint8_t d = 0; d < 2; d++)
+  {
+    size_t length = strlen(documents[d]);
+    uint32_t started = micros();
+    for (uint32_t i = 0; i < iterations; i++)
+    {
+      parse(parser, config, documents[d]);
+    }
+    uint32_t elapsed = micros() - started;
+    double usPerParse = (double)elapsed / iterations;
+    printf("%-10s %6zu %10.2f %8.1f\n", names[d], length, usPerParse, length / usPerParse);
+  }
+
+  // Boot path on a class 10 card: snapshot read against parse + snapshot rewrite
+  FakeCardModel model;
+  model.commandUs = 60;
+  model.sectorReadUs = 130;
+  model.sectorWriteUs = 400;
+  model.burstSectorUs = 20;
+  FakeCard::setModel(model);
+
+  writeHostFile(CONFIG_FILENAME, NESTED);
+  FakeCard::resetStats();
+  deviceConfig.load();
+  uint32_t parsedUs = deviceConfig.getLoadUs();
+  uint32_t parsedSectors = FakeCard::stats().sectorsRead;
+  FakeCard::resetStats();
+  deviceConfig.load();
+  uint32_t snapshotUs = deviceConfig.getLoadUs();
+  uint32_t snapshotSectors = FakeCard::stats().sectorsRead;
+
+  printf("\n%-22s %8s %12s\n", "boot load", "us", "sectors read");
+  printf("%-22s %8lu %12lu\n", "config.json parsed", (unsigned long)parsedUs, (unsigned long)parsedSectors);
+  printf("%-22s %8lu %12lu\n", "config.bin snapshot", (unsigned long)snapshotUs, (unsigned long)snapshotSectors);
+  check(deviceConfig.getSource() == CONFIG_FROM_SNAPSHOT, "benchmark snapshot used");
+  check(snapshotUs < parsedUs, "snapshot load faster than a parse");
+}
+
+int main(int argc, char **argv)
+{
+  FakeCard::setRoot(argc > 1 ? argv[1] : "sdcard");
+  uint32_t iterations = argc > 2 ? (uint32_t)atol(argv[2]) : 20000;
+
+  if (!sd.begin(SdSpiConfig(uSD_CS_PIN, DEDICATED_SPI, SD_SCK_MHZ(SD_SPI_MHZ))))
+  {
+    printf("FAIL: mount\n");
+    return 1;
+  }
+
+  checkParser();
+  checkDeviceConfig();
+  benchmark(iterations);
+
+  return finish();
+}
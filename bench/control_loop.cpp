@@ -0,0 +1,259 @@
+/* Cooling control loop against a simulated room
+ * Runs CoolingController (lib/coolingControl) at the firmware's fixed
+ * control period, with the relay window of the firmware and a sensor
+ * that is sampled every SAMPLE_INTERVAL_DEFAULT ms and quantised, on the
+ * first-order room of native/RoomModel.h. Each case is run for the
+ * hysteresis and PI strategies and reports band entry time, error,
+ * relay switching and output:
+ *   pull_down: 30 °C room, 22..26 °C band
+ *   load_step: +8 °C of equipment heat once settled
+ *   overload:  heat beyond the cooling capacity for 1 h, then removed;
+ *              a PI without anti-windup is run alongside for comparison
+ *   manual:    30 min of manual 50 %, then back to automatic
+ *   dht11:     pull_down with the 1 °C resolution of the DHT11
+ * and checks the results, that no case switches the relay faster than its
+ * minimum on and off times allow, and that two runs give the same trace
+ * bit for bit.
+ *
+ * Build and run:
+ *   pio run -e native_control_loop
+ *   .pio/build/native_control_loop/program
+ */
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <config.hpp>
+
+#include "RoomModel.h"
+#include "coolingControl.hpp"
+#include "check.h"
+
+static constexpr float PERIOD_S = CONTROL_PERIOD_US / 1e6f;
+static constexpr uint32_t STEPS_PER_SAMPLE = SAMPLE_INTERVAL_DEFAULT * 1000 / CONTROL_PERIOD_US;
+static constexpr uint32_t STEPS_PER_HOUR = 3600000000UL / CONTROL_PERIOD_US;
+
+/// PI without anti-windup, for the overload case
+struct NaivePi
+{
+  float integral = 0;
+
+  float update(float temperature, float target, float periodS)
+  {
+    float error = temperature - target;
+    integral += CONTROL_KI_DEFAULT * error * periodS;
+    float output = CONTROL_KP_DEFAULT * error + integral;
+    return output < 0 ? 0 : (output > 1 ? 1 : output);
+  }
+};
+
+struct Scenario
+{
+  const char *name;
+  float resolution;      // Sensor quantisation (°C)
+  uint32_t hours;
+  float loadStep;        // Heat added at loadAtHour (°C)
+  uint32_t loadAtHour;
+  uint32_t loadForHours; // 0 = stays
+  bool hasManual;        // 30 min of manual 50 % at hour 2
+  bool isNaive;          // PI without anti-windup instead of CoolingController
+};
+
+struct Result
+{
+  float enterBandS;    // First time inside the band
+  float meanError;     // Mean of temperature - target over the last hour
+  float maxAbsError;   // Over the last hour
+  float minTemp;       // After the load is removed (overload case)
+  float maxTemp;       // Over the last hour
+  uint32_t switches;   // Relay transitions per hour
+  float meanOutput;    // Last hour
+  float bumpAfterManual; // |output change| at the return to automatic
+  uint64_t traceHash;  // FNV-1a of every temperature and output
+};
+
+static void hash(uint64_t &state, const void *data, size_t size)
+{
+  const uint8_t *bytes = (const uint8_t *)data;
+  for (size_t i = 0; i < size; i++)
+  {
+    state = (state ^ bytes[i]) * 1099511628211ULL;
+  }
+}
+
+static Result run(const Scenario &scenario, ControlStrategy strategy)
+{
+  RoomModel room;
+  CoolingController controller;
+  RelayWindow relay(CONTROL_PERIOD_US, CONTROL_OUTPUT_WINDOW_MS * 1000, CONTROL_RELAY_MIN_ON_MS * 1000,
+                    CONTROL_RELAY_MIN_OFF_MS * 1000);
+  NaivePi naive;
+  controller.setGains(CONTROL_KP_DEFAULT, CONTROL_KI_DEFAULT);
+  controller.setSetpoints(TEMP_SETPOINT_MIN_DEFAULT, TEMP_SETPOINT_MAX_DEFAULT);
+  controller.setStrategy(strategy);
+  const float target = (TEMP_SETPOINT_MIN_DEFAULT + TEMP_SETPOINT_MAX_DEFAULT) / 2;
+
+  Result result = {};
+  result.enterBandS = -1;
+  result.minTemp = INFINITY;
+  result.maxTemp = -INFINITY;
+  result.traceHash = 1469598103934665603ULL;
+
+  uint32_t totalSteps = scenario.hours * STEPS_PER_HOUR;
+  uint32_t lastHour = totalSteps - STEPS_PER_HOUR;
+  uint32_t manualFrom = 2 * STEPS_PER_HOUR;
+  uint32_t manualTo = manualFrom + STEPS_PER_HOUR / 2;
+  uint32_t loadFrom = scenario.loadAtHour * STEPS_PER_HOUR;
+  uint32_t loadTo = scenario.loadForHours > 0 ? loadFrom + scenario.loadForHours * STEPS_PER_HOUR : totalSteps;
+  float measured = NAN;
+  bool wasOn = false;
+  double errorSum = 0;
+  double outputSum = 0;
+
+  for (uint32_t step = 0; step < totalSteps; step++)
+  {
+    room.load = step >= loadFrom && step < loadTo ? scenario.loadStep : 0;
+    if (step % STEPS_PER_SAMPLE == 0)
+    {
+      measured = roundf(room.temperature / scenario.resolution) * scenario.resolution;
+    }
+
+    float output;
+    bool isManual = scenario.hasManual && step >= manualFrom && step < manualTo;
+    if (isManual)
+    {
+      controller.track(0.5f, measured);
+      output = controller.getOutput();
+    }
+    else if (scenario.isNaive)
+    {
+      output = naive.update(measured, target, PERIOD_S);
+    }
+    else
+    {
+      float before = controller.getOutput();
+      output = controller.update(measured, PERIOD_S);
+      if (scenario.hasManual && step == manualTo)
+      {
+        result.bumpAfterManual = fabsf(output - before);
+      }
+    }
+
+    bool isOn = relay.next(output);
+    room.step(PERIOD_S, isOn ? 1 : 0);
+    hash(result.traceHash, &room.temperature, sizeof(room.temperature));
+    hash(result.traceHash, &output, sizeof(output));
+
+    if (result.enterBandS < 0 && room.temperature <= TEMP_SETPOINT_MAX_DEFAULT)
+    {
+      result.enterBandS = step * PERIOD_S;
+    }
+    if (scenario.loadForHours > 0 && step >= loadTo)
+    {
+      result.minTemp = fminf(result.minTemp, room.temperature);
+    }
+    if (step >= lastHour)
+    {
+      float error = room.temperature - target;
+      errorSum += error;
+      outputSum += output;
+      result.maxAbsError = fmaxf(result.maxAbsError, fabsf(error));
+      result.maxTemp = fmaxf(result.maxTemp, room.temperature);
+      result.switches += isOn != wasOn ? 1 : 0;
+    }
+    wasOn = isOn;
+  }
+  result.meanError = errorSum / STEPS_PER_HOUR;
+  result.meanOutput = outputSum / STEPS_PER_HOUR;
+  return result;
+}
+
+static void print(const Scenario &scenario, const char *strategy, const Result &result)
+{
+  printf("%-10s %-10s %9.0f %8.2f %8.2f %8.2f %8lu %7.0f%%\n", scenario.name, strategy, result.enterBandS, result.meanError,
+         result.maxAbsError, isinf(result.minTemp) ? result.maxTemp : result.minTemp, (unsigned long)result.switches,
+         result.meanOutput * 100);
+}
+
+int main()
+{
+  const Scenario pullDown = {"pull_down", 0.1f, 6, 0, 0, 0, false, false};
+  const Scenario loadStep = {"load_step", 0.1f, 8, 8, 4, 0, false, false};
+  const Scenario overload = {"overload", 0.1f, 8, 20, 3, 1, false, false};
+  const Scenario manual = {"manual", 0.1f, 6, 0, 0, 0, true, false};
+  const Scenario dht11 = {"dht11", 1.0f, 6, 0, 0, 0, false, false};
+  Scenario overloadNaive = overload;
+  overloadNaive.isNaive = true;
+
+  printf("period %lu ms, relay window %lu ms, min on/off %lu/%lu ms, sample %lu ms, kp %.3f, ki %.4f\n",
+         (unsigned long)(CONTROL_PERIOD_US / 1000), (unsigned long)CONTROL_OUTPUT_WINDOW_MS,
+         (unsigned long)CONTROL_RELAY_MIN_ON_MS, (unsigned long)CONTROL_RELAY_MIN_OFF_MS,
+         (unsigned long)SAMPLE_INTERVAL_DEFAULT, CONTROL_KP_DEFAULT, CONTROL_KI_DEFAULT);
+  printf("%-10s %-10s %9s %8s %8s %8s %8s %8s\n", "case", "strategy", "band s", "mean e", "max |e|", "T min/max",
+         "sw/h", "output");
+
+  Result hysteresis = run(pullDown, CONTROL_HYSTERESIS);
+  Result pi = run(pullDown, CONTROL_PI);
+  print(pullDown, "hysteresis", hysteresis);
+  print(pullDown, "pi", pi);
+  check(hysteresis.enterBandS >= 0 && pi.enterBandS >= 0, "pull_down reaches the band");
+  check(hysteresis.maxTemp <= TEMP_SETPOINT_MAX_DEFAULT + 0.5f, "hysteresis stays in the band");
+  check(fabsf(pi.meanError) < 0.2f && pi.maxAbsError < 0.5f, "PI settles on the target");
+
+  Result loaded = run(loadStep, CONTROL_PI);
+  print(loadStep, "hysteresis", run(loadStep, CONTROL_HYSTERESIS));
+  print(loadStep, "pi", loaded);
+  // Near full output the minimum off time leaves a ~1 °C ripple, and the
+  // integral is held on its warm half while P saturates: a small offset
+  check(fabsf(loaded.meanError) < 0.3f, "PI rejects the load step");
+
+  Result windup = run(overload, CONTROL_PI);
+  Result naiveWindup = run(overloadNaive, CONTROL_PI);
+  print(overload, "hysteresis", run(overload, CONTROL_HYSTERESIS));
+  print(overload, "pi", windup);
+  print(overload, "pi_naive", naiveWindup);
+  const float target = (TEMP_SETPOINT_MIN_DEFAULT + TEMP_SETPOINT_MAX_DEFAULT) / 2;
+  check(windup.minTemp > target - 1.0f, "anti-windup: undershoot under 1 °C after the overload");
+  check(naiveWindup.minTemp < windup.minTemp, "anti-windup: less undershoot than without it");
+
+  Result manualRun = run(manual, CONTROL_PI);
+  print(manual, "pi", manualRun);
+  // Manual 50 % cools the room to ~22.4 °C, where track() clamps the integral at 1
+  check(manualRun.bumpAfterManual < 0.15f, "bumpless return from manual");
+
+  Result coarse = run(dht11, CONTROL_PI);
+  print(dht11, "hysteresis", run(dht11, CONTROL_HYSTERESIS));
+  print(dht11, "pi", coarse);
+  check(fabsf(coarse.meanError) < 0.6f, "PI with the 1 °C DHT11 resolution");
+
+  // One on and one off stretch per minimum cycle, plus one partial cycle in the hour
+  const uint32_t maxSwitches = 2 * (3600000 / (CONTROL_RELAY_MIN_ON_MS + CONTROL_RELAY_MIN_OFF_MS) + 1);
+  const Result *const piRuns[] = {&pi, &loaded, &windup, &naiveWindup, &manualRun, &coarse};
+  for (const Result *result : piRuns)
+  {
+    check(result->switches <= maxSwitches, "relay minimum on/off times hold");
+  }
+
+  check(run(loadStep, CONTROL_PI).traceHash == loaded.traceHash, "deterministic: same trace twice");
+
+  // Cost of one update on this host
+  CoolingController controller;
+  controller.setGains(CONTROL_KP_DEFAULT, CONTROL_KI_DEFAULT);
+  controller.setSetpoints(TEMP_SETPOINT_MIN_DEFAULT, TEMP_SETPOINT_MAX_DEFAULT);
+  controller.setStrategy(CONTROL_PI);
+  const uint32_t updates = 10000000;
+  struct timespec start, end;
+  volatile float sink = 0;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (uint32_t i = 0; i < updates; i++)
+  {
+    sink = controller.update(24.0f + (i & 15) * 0.1f, PERIOD_S);
+  }
+  clock_gettime(CLOCK_MONOTONIC, &end);
+  double ns = (end.tv_sec - start.tv_sec) * 1e9 + (end.tv_nsec - start.tv_nsec);
+  printf("update: %.1f ns (host)\n", ns / updates);
+  (void)sink;
+
+  return finish();
+}
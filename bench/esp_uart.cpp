@@ -0,0 +1,337 @@
+/* ESP-AT UART transport over a pseudo-terminal pair
+ * DmaSerial (lib/espUart) and AtMqttClient (lib/atMqtt) run unchanged on
+ * the slave side of a PTY. A child process bridges the master side to
+ * FakeModem, which also accepts AT+UART_CUR. The bridge paces both
+ * directions at the current baud (8N1, 10 bits per byte) and adds a modem
+ * turnaround per command line, so the figures follow the wire rate.
+ * At SERIAL_BAUD_RATE, then at ESP_UART_BAUD_HIGH after negotiateBaud(),
+ * QoS1 publishes are sent one after the other and it reports
+ *   bytes/s:      UART bytes in both directions over the run
+ *   publishes/s:  AT+MQTTPUBRAW publishes accepted by the modem
+ *   latency:      publish() call to the modem's answer, average and max
+ * Checks the negotiation, that every publish is accepted and handed over,
+ * and the speed-up at the high rate. On the host DmaSerial takes the
+ * plain HardwareSerial path: the DMA ring itself only runs on the board.
+ *
+ * Build and run:
+ *   pio run -e native_esp_uart
+ *   .pio/build/native_esp_uart/program [messages=200] [payload=32] [turnaround_us=500]
+ */
+#include <Arduino.h>
+
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <sys/wait.h>
+#include <termios.h>
+#include <unistd.h>
+
+#include <string>
+
+#include "FakeModem.h"
+#include "atMqtt.hpp"
+#include "espUart.hpp"
+#include "check.h"
+
+static const char *TELEMETRY_TOPIC = "sensor1/temp";
+
+static bool option(const char *argument, const char *name, const char **value)
+{
+  size_t length = strlen(name);
+  if (strncmp(argument, name, length) != 0 || argument[length] != '=')
+  {
+    return false;
+  }
+  *value = argument + length + 1;
+  return true;
+}
+
+/// PtyStream
+/// @brief Non-blocking Stream over the slave side of the PTY, the peer of
+/// the DmaSerial port. Counts the bytes in each direction.
+///
+class PtyStream : public Stream
+{
+public:
+  PtyStream(int fd) : fd(fd) {}
+
+  int available() override { return fill() ? (int)(end - start) : 0; }
+  int read() override { return fill() ? buffer[start++] : -1; }
+  int peek() override { return fill() ? buffer[start] : -1; }
+  size_t write(uint8_t b) override { return write(&b, 1); }
+
+  size_t write(const uint8_t *data, size_t size) override
+  {
+    size_t written = 0;
+    while (written < size)
+    {
+      ssize_t n = ::write(fd, data + written, size - written);
+      if (n > 0)
+      {
+        written += n;
+      }
+      else if (n < 0 && errno != EAGAIN && errno != EINTR)
+      {
+        break;
+      }
+    }
+    txBytes += written;
+    return written;
+  }
+
+  using Print::write;
+
+  uint32_t txBytes = 0;
+  uint32_t rxBytes = 0;
+
+private:
+  bool fill()
+  {
+    if (start < end)
+    {
+      return true;
+    }
+    ssize_t n = ::read(fd, buffer, sizeof(buffer));
+    start = 0;
+    end = n > 0 ? n : 0;
+    rxBytes += end;
+    return end > 0;
+  }
+
+  int fd;
+  uint8_t buffer[256];
+  size_t start = 0;
+  size_t end = 0;
+};
+
+// Wire time of count bytes at baud, 8N1
+static void pace(size_t count, unsigned long baud)
+{
+  usleep((useconds_t)(count * 10ULL * 1000000 / baud));
+}
+
+// Child process: FakeModem on the master side of the PTY, until it closes
+static void runModem(int fd, uint32_t turnaroundUs)
+{
+  FakeModem modem;
+  modem.addRule("AT+UART_CUR=", "\r\nOK\r\n");
+  unsigned long baud = SERIAL_BAUD_RATE;
+  unsigned long nextBaud = 0; // AT+UART_CUR applies after its OK is sent
+  std::string line;
+  uint8_t buffer[256];
+
+  for (;;)
+  {
+    struct pollfd input = {fd, POLLIN, 0};
+    if (poll(&input, 1, 1) < 0 && errno != EINTR)
+    {
+      return;
+    }
+    if (input.revents & POLLIN)
+    {
+      ssize_t n = ::read(fd, buffer, sizeof(buffer));
+      if (n <= 0)
+      {
+        return; // The bench closed the slave side
+      }
+      pace(n, baud);
+      for (ssize_t i = 0; i < n; i++)
+      {
+        modem.write(buffer[i]);
+        if (buffer[i] != '\n')
+        {
+          line += (char)buffer[i];
+          continue;
+        }
+        // Raw publish data has no line ending and ends up before the command
+        size_t at = line.find("AT+UART_CUR=");
+        if (at != std::string::npos)
+        {
+          nextBaud = strtoul(line.c_str() + at + 12, nullptr, 10);
+        }
+        line.clear();
+        usleep(turnaroundUs);
+      }
+    }
+    else if (input.revents & (POLLHUP | POLLERR))
+    {
+      return;
+    }
+
+    size_t count = 0;
+    while (count < sizeof(buffer) && modem.available() > 0)
+    {
+      buffer[count++] = (uint8_t)modem.read();
+    }
+    if (count > 0)
+    {
+      pace(count, baud);
+      if (::write(fd, buffer, count) != (ssize_t)count)
+      {
+        return;
+      }
+    }
+    if (nextBaud != 0 && modem.available() == 0)
+    {
+      baud = nextBaud;
+      nextBaud = 0;
+    }
+  }
+}
+
+static uint32_t acks = 0;
+
+static void onAck(uint16_t)
+{
+  acks++;
+}
+
+struct Run
+{
+  unsigned long baud;
+  uint32_t accepted;
+  double seconds;
+  double bytesPerSecond;
+  double publishesPerSecond;
+  uint32_t avgLatencyUs;
+  uint32_t maxLatencyUs;
+};
+
+static Run publishAll(AtMqttClient &mqtt, DmaSerial &esp, PtyStream &pty, uint32_t messages, const uint8_t *payload,
+                      size_t payloadSize, uint16_t firstId)
+{
+  Run run = {};
+  run.baud = esp.getBaud();
+  uint32_t bytesBefore = pty.txBytes + pty.rxBytes;
+  uint64_t totalLatencyUs = 0;
+  uint32_t started = micros();
+  for (uint32_t i = 0; i < messages; i++)
+  {
+    uint32_t publishStart = micros();
+    if (mqtt.publish(TELEMETRY_TOPIC, payload, payloadSize, false, 1, (uint16_t)(firstId + i)))
+    {
+      run.accepted++;
+    }
+    uint32_t latencyUs = micros() - publishStart;
+    totalLatencyUs += latencyUs;
+    run.maxLatencyUs = latencyUs > run.maxLatencyUs ? latencyUs : run.maxLatencyUs;
+    mqtt.loop();
+  }
+  run.seconds = (micros() - started) / 1e6;
+  run.bytesPerSecond = (pty.txBytes + pty.rxBytes - bytesBefore) / run.seconds;
+  run.publishesPerSecond = run.accepted / run.seconds;
+  run.avgLatencyUs = (uint32_t)(totalLatencyUs / messages);
+  return run;
+}
+
+static void print(const Run &run)
+{
+  printf("%8lu %10.0f %12.1f %10lu %10lu %9.2f\n", run.baud, run.bytesPerSecond, run.publishesPerSecond,
+         (unsigned long)run.avgLatencyUs, (unsigned long)run.maxLatencyUs, run.seconds);
+}
+
+int main(int argc, char **argv)
+{
+  uint32_t messages = 200;
+  size_t payloadSize = 32;
+  uint32_t turnaroundUs = 500;
+  for (int i = 1; i < argc; i++)
+  {
+    const char *value;
+    if (option(argv[i], "messages", &value))
+    {
+      messages = (uint32_t)atol(value);
+    }
+    else if (option(argv[i], "payload", &value))
+    {
+      payloadSize = (size_t)atoi(value);
+    }
+    else if (option(argv[i], "turnaround_us", &value))
+    {
+      turnaroundUs = (uint32_t)atol(value);
+    }
+    else
+    {
+      fprintf(stderr, "usage: %s [messages=200] [payload=32] [turnaround_us=500]\n", argv[0]);
+      return 2;
+    }
+  }
+  messages = messages > 0 ? messages : 1;
+  payloadSize = min(payloadSize, (size_t)128);
+
+  uint8_t payload[128];
+  for (size_t i = 0; i < payloadSize; i++)
+  {
+    payload[i] = '0' + i % 10;
+  }
+
+  int master;
+  int slave;
+  if (openpty(&master, &slave, nullptr, nullptr, nullptr) != 0)
+  {
+    perror("openpty");
+    return 1;
+  }
+  struct termios raw;
+  tcgetattr(slave, &raw);
+  cfmakeraw(&raw); // Bytes through untouched: no echo, no CR/LF mapping
+  tcsetattr(slave, TCSANOW, &raw);
+
+  pid_t modemPid = fork();
+  if (modemPid < 0)
+  {
+    perror("fork");
+    return 1;
+  }
+  if (modemPid == 0)
+  {
+    close(slave);
+    runModem(master, turnaroundUs);
+    _exit(0);
+  }
+  close(master);
+  fcntl(slave, F_SETFL, fcntl(slave, F_GETFL) | O_NONBLOCK);
+
+  PtyStream pty(slave);
+  DmaSerial esp(PA10, PA9);
+  esp.setPeer(&pty);
+  esp.begin(SERIAL_BAUD_RATE);
+
+  AtMqttClient mqtt(esp);
+  mqtt.setServer("192.168.1.178", 1883).setSocketTimeout(1);
+  mqtt.setAckHandler(onAck);
+  bool isConnected = mqtt.connect("bench");
+  check(isConnected, "AT+MQTT connect over the PTY");
+
+  Run low = {};
+  Run high = {};
+  bool isNegotiated = false;
+  if (isConnected)
+  {
+    low = publishAll(mqtt, esp, pty, messages, payload, payloadSize, 1);
+    isNegotiated = esp.negotiateBaud(ESP_UART_BAUD_HIGH, false);
+    high = publishAll(mqtt, esp, pty, messages, payload, payloadSize, (uint16_t)(messages + 1));
+    for (int i = 0; i < 10; i++)
+    {
+      mqtt.loop(); // Last hand-overs
+    }
+  }
+  close(slave);
+  int status = 0;
+  waitpid(modemPid, &status, 0);
+
+  printf("%u QoS1 publishes of %u bytes on \"%s\" per rate, turnaround %u us per AT command\n",
+         (unsigned)messages, (unsigned)payloadSize, TELEMETRY_TOPIC, (unsigned)turnaroundUs);
+  printf("%8s %10s %12s %10s %10s %9s\n", "baud", "bytes/s", "publishes/s", "avg us", "max us", "seconds");
+  print(low);
+  print(high);
+
+  check(isNegotiated && esp.getBaud() == ESP_UART_BAUD_HIGH, "AT+UART_CUR negotiated and checked with AT");
+  check(low.accepted == messages && high.accepted == messages, "every publish accepted by the modem");
+  check(acks == 2 * messages, "every QoS1 publish handed over");
+  check(high.publishesPerSecond > low.publishesPerSecond * 2, "high rate at least twice the publishes/s");
+  check(low.bytesPerSecond <= SERIAL_BAUD_RATE / 10.0 * 2, "115200 run bounded by the wire rate");
+  check(WIFEXITED(status) && WEXITSTATUS(status) == 0, "modem process ends with the PTY");
+
+  return finish();
+}
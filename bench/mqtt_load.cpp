@@ -0,0 +1,210 @@
+/* MQTT load benchmark of the host network layer
+ * PubSubClient over PosixClient against a broker on localhost (e.g. mosquitto).
+ * Reports publishes/s, end-to-end latency percentiles (the client subscribes
+ * to its own topic) and the time to recover after the socket is dropped.
+ *
+ * Build and run:
+ *   pio run -e native_mqtt_bench
+ *   .pio/build/native_mqtt_bench/program [host=127.0.0.1] [port=1883] [messages=10000] [payload=32] [drops=10]
+ */
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <unistd.h>
+#include <algorithm>
+
+#include "PosixClient.h"
+
+static constexpr uint32_t MAX_MESSAGES = 200000;
+static constexpr uint32_t DRAIN_TIMEOUT_MS = 5000;
+
+static PosixClient socketClient;
+static PubSubClient mqtt(socketClient);
+
+static char topic[64];
+static char clientId[32];
+static uint32_t latencies[MAX_MESSAGES];
+static uint32_t received = 0;
+static uint32_t lastSequence = 0;
+
+// Payload: "<sequence>;<micros at publish>;<padding>"
+static void onMessage(char *, uint8_t *payload, unsigned int length)
+{
+  char text[32];
+  unsigned int n = length < sizeof(text) - 1 ? length : sizeof(text) - 1;
+  memcpy(text, payload, n);
+  text[n] = '\0';
+
+  unsigned long sequence, sentAt;
+  if (sscanf(text, "%lu;%lu", &sequence, &sentAt) == 2 && received < MAX_MESSAGES)
+  {
+    latencies[received++] = micros() - (uint32_t)sentAt;
+    lastSequence = sequence;
+  }
+}
+
+static bool connectAndSubscribe()
+{
+  return mqtt.connect(clientId) && mqtt.subscribe(topic);
+}
+
+static bool publishProbe(uint32_t sequence, uint16_t payloadSize)
+{
+  char payload[512];
+  int n = snprintf(payload, sizeof(payload), "%lu;%lu;", (unsigned long)sequence, (unsigned long)micros());
+  while (n < payloadSize && n < (int)sizeof(payload) - 1)
+  {
+    payload[n++] = 'x';
+  }
+  return mqtt.publish(topic, (const uint8_t *)payload, n);
+}
+
+static uint32_t percentile(uint32_t *values, uint32_t count, double fraction)
+{
+  if (count == 0)
+  {
+    return 0;
+  }
+  uint32_t index = (uint32_t)(fraction * (count - 1));
+  std::nth_element(values, values + index, values + count);
+  return values[index];
+}
+
+static bool option(const char *argument, const char *name, const char **value)
+{
+  size_t length = strlen(name);
+  if (strncmp(argument, name, length) != 0 || argument[length] != '=')
+  {
+    return false;
+  }
+  *value = argument + length + 1;
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  const char *host = "127.0.0.1";
+  uint16_t port = 1883;
+  uint32_t messages = 10000;
+  uint16_t payloadSize = 32;
+  uint32_t drops = 10;
+  for (int i = 1; i < argc; i++)
+  {
+    const char *value;
+    if (option(argv[i], "host", &value))
+    {
+      host = value;
+    }
+    else if (option(argv[i], "port", &value))
+    {
+      port = (uint16_t)atoi(value);
+    }
+    else if (option(argv[i], "messages", &value))
+    {
+      messages = (uint32_t)atol(value);
+    }
+    else if (option(argv[i], "payload", &value))
+    {
+      payloadSize = (uint16_t)atoi(value);
+    }
+    else if (option(argv[i], "drops", &value))
+    {
+      drops = (uint32_t)atol(value);
+    }
+    else
+    {
+      fprintf(stderr, "usage: %s [host=127.0.0.1] [port=1883] [messages=10000] [payload=32] [drops=10]\n", argv[0]);
+      return 2;
+    }
+  }
+  messages = min(messages, MAX_MESSAGES);
+  payloadSize = min(payloadSize, (uint16_t)480);
+
+  snprintf(clientId, sizeof(clientId), "bench_%d", (int)getpid());
+  snprintf(topic, sizeof(topic), "bench/%s/echo", clientId);
+
+  mqtt.setServer(host, port);
+  mqtt.setCallback(onMessage);
+  mqtt.setBufferSize(payloadSize + 128);
+
+  if (!connectAndSubscribe())
+  {
+    fprintf(stderr, "cannot connect to %s:%u (state %d)\n", host, port, mqtt.state());
+    return 1;
+  }
+
+  // ---- Throughput and end-to-end latency ----
+  uint32_t start = micros();
+  for (uint32_t i = 0; i < messages; i++)
+  {
+    while (!publishProbe(i, payloadSize))
+    {
+      if (!mqtt.connected())
+      {
+        fprintf(stderr, "connection lost during the run\n");
+        return 1;
+      }
+      mqtt.loop();
+    }
+    mqtt.loop(); // Drain echoes so the socket buffers never fill
+  }
+  uint32_t publishUs = micros() - start;
+
+  uint32_t drainStart = millis();
+  while (received < messages && millis() - drainStart < DRAIN_TIMEOUT_MS)
+  {
+    mqtt.loop();
+  }
+  uint32_t totalUs = micros() - start;
+
+  printf("messages:        %lu x %u bytes\n", (unsigned long)messages, payloadSize);
+  printf("publishes/s:     %.0f\n", messages * 1e6 / publishUs);
+  printf("round trips/s:   %.0f\n", received * 1e6 / totalUs);
+  printf("received:        %lu (%.2f%% lost)\n", (unsigned long)received,
+         100.0 * (messages - received) / messages);
+  printf("latency p50:     %lu us\n", (unsigned long)percentile(latencies, received, 0.50));
+  printf("latency p90:     %lu us\n", (unsigned long)percentile(latencies, received, 0.90));
+  printf("latency p99:     %lu us\n", (unsigned long)percentile(latencies, received, 0.99));
+  printf("latency max:     %lu us\n", (unsigned long)percentile(latencies, received, 1.0));
+
+  // ---- Reconnect recovery: drop the socket, time until an echo comes back ----
+  uint64_t recoverySum = 0;
+  uint32_t recoveryMax = 0;
+  uint32_t recovered = 0;
+  for (uint32_t r = 0; r < drops; r++)
+  {
+    socketClient.stop();
+    uint32_t dropAt = micros();
+
+    while (!connectAndSubscribe())
+    {
+      delay(10);
+    }
+
+    uint32_t expected = received + 1;
+    uint32_t probeStart = millis();
+    publishProbe(messages + r, payloadSize);
+    while (received < expected && millis() - probeStart < DRAIN_TIMEOUT_MS)
+    {
+      mqtt.loop();
+    }
+    if (received < expected)
+    {
+      continue;
+    }
+
+    uint32_t recovery = micros() - dropAt;
+    recoverySum += recovery;
+    recoveryMax = max(recoveryMax, recovery);
+    recovered++;
+  }
+
+  if (recovered > 0)
+  {
+    printf("recovery mean:   %lu us (%lu/%lu drops)\n", (unsigned long)(recoverySum / recovered),
+           (unsigned long)recovered, (unsigned long)drops);
+    printf("recovery max:    %lu us\n", (unsigned long)recoveryMax);
+  }
+
+  mqtt.disconnect();
+  return 0;
+}
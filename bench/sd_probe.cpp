@@ -0,0 +1,115 @@
+/* Boot-time SD probe against fake cards with different latency
+ * Runs SdProbe (lib/sdProbe) on the file-backed fake card of native/SdFat.h
+ * with the latency model of a few kinds of card, and checks the profile
+ * it picks: the tier, and a buffer that holds every line sampled during
+ * the worst stall measured. chooseSdProfile() is also checked on its own
+ * at the tier boundaries.
+ *
+ * Build and run:
+ *   pio run -e native_sd_probe
+ *   .pio/build/native_sd_probe/program [root=sdcard]
+ */
+#include <Arduino.h>
+#include <SdFat.h>
+
+#include "sdProbe.hpp"
+#include "check.h"
+
+SdFat sd;
+
+static const char *const TIER_NAMES[SD_TIERS] = {"fast", "medium", "slow"};
+
+struct Card
+{
+  const char *name;
+  FakeCardModel model;
+  SdCardTier expected;
+};
+
+static FakeCardModel makeModel(uint32_t commandUs, uint32_t writeUs, uint32_t burstUs, uint32_t stallEvery,
+                               uint32_t stallUs)
+{
+  FakeCardModel model;
+  model.commandUs = commandUs;
+  model.sectorReadUs = writeUs / 3;
+  model.sectorWriteUs = writeUs;
+  model.burstSectorUs = burstUs;
+  model.stallEvery = stallEvery;
+  model.stallUs = stallUs;
+  return model;
+}
+
+static void probe(const Card &card, uint32_t sampleIntervalMs)
+{
+  FakeCard::setModel(card.model);
+  sd.end();
+  if (!sd.begin(SdSpiConfig(uSD_CS_PIN, DEDICATED_SPI, SD_SCK_MHZ(SD_SPI_MHZ))))
+  {
+    check(false, "mount");
+    return;
+  }
+
+  uint32_t started = millis();
+  bool isProbed = sdProbe.run(sampleIntervalMs);
+  uint32_t elapsedMs = millis() - started;
+  const SdProbeResult &result = sdProbe.getResult();
+  const SdProfile &profile = sdProbe.getProfile();
+
+  printf("%-12s %6lu %8lu %9lu %-7s %6u %7lu %8lu %6lu\n", card.name, (unsigned long)result.sequentialKBps,
+         (unsigned long)result.appendP50Us, (unsigned long)result.appendMaxUs, TIER_NAMES[profile.tier],
+         profile.bufferSize, (unsigned long)profile.flushIntervalMs, (unsigned long)profile.preallocBytes,
+         (unsigned long)elapsedMs);
+
+  check(isProbed, "probe ran");
+  check(profile.tier == card.expected, card.name);
+
+  // Every sample taken while the card stalls must fit the buffer
+  uint32_t stalledSamples = result.appendMaxUs / (sampleIntervalMs * 1000) + 1;
+  check(profile.bufferSize >= SD_WRITE_BUFFER_MAX || profile.bufferSize >= stalledSamples * SD_BYTES_PER_SAMPLE,
+        "buffer covers the worst stall");
+  check(profile.bufferSize <= SD_WRITE_BUFFER_MAX, "buffer within SD_WRITE_BUFFER_MAX");
+  check(!sd.exists("sdprobe.tmp"), "scratch file removed");
+}
+
+int main(int argc, char **argv)
+{
+  FakeCard::setRoot(argc > 1 ? argv[1] : "sdcard");
+
+  // ---------- Fake cards ----------
+  const Card cards[] = {
+      {"industrial", makeModel(40, 150, 10, 0, 0), SD_TIER_FAST},
+      {"class10", makeModel(60, 400, 20, 2048, 40000), SD_TIER_FAST},
+      {"medium", makeModel(100, 800, 150, 50, 20000), SD_TIER_MEDIUM},
+      {"cheap", makeModel(150, 1500, 300, 40, 200000), SD_TIER_SLOW},
+      {"worn", makeModel(400, 6000, 3000, 0, 0), SD_TIER_SLOW},
+  };
+
+  printf("%-12s %6s %8s %9s %-7s %6s %7s %8s %6s\n", "card", "KB/s", "p50 us", "max us", "tier", "buffer", "flush",
+         "prealloc", "ms");
+  for (const Card &card : cards)
+  {
+    probe(card, SAMPLE_INTERVAL_DEFAULT);
+  }
+
+  // ---------- chooseSdProfile() alone ----------
+  SdProbeResult result = {5000, 800, SD_PROBE_FAST_STALL_US - 1};
+  check(chooseSdProfile(result, 1000).tier == SD_TIER_FAST, "just below the fast stall limit");
+  result.appendMaxUs = SD_PROBE_FAST_STALL_US;
+  check(chooseSdProfile(result, 1000).tier == SD_TIER_MEDIUM, "at the fast stall limit");
+  result.appendMaxUs = SD_PROBE_SLOW_STALL_US;
+  check(chooseSdProfile(result, 1000).tier == SD_TIER_SLOW, "at the slow stall limit");
+  result = {SD_PROBE_SLOW_KBPS - 1, 800, 1000};
+  check(chooseSdProfile(result, 1000).tier == SD_TIER_SLOW, "below the slow throughput");
+
+  // A fast card sampled often still needs room for the lines of a stall
+  result = {5000, 800, 9000};
+  SdProfile profile = chooseSdProfile(result, 2);
+  check(profile.tier == SD_TIER_FAST, "fast at a short interval");
+  check(profile.bufferSize == 4096, "buffer grown for 6 samples per stall");
+
+  // Clamped even for a stall longer than anything the buffer can hold
+  result.appendMaxUs = 10000000;
+  check(chooseSdProfile(result, 1000).bufferSize == SD_WRITE_BUFFER_MAX, "buffer clamped");
+
+  return finish();
+}
@@ -0,0 +1,284 @@
+/* SD card storage benchmark
+ * Appends fixed-size records with the write patterns ExtMEM can use and
+ * reports, per record size and pattern: sequential MB/s, append latency
+ * p50/p99 and the worst stall.
+ *   open-append-close  open, write, close per record (ExtMEM before the buffer)
+ *   kept-open          file kept open, one write per record
+ *   buffer-512         records gathered into one sector, written when full
+ *   buffer-4096        8-sector buffer into a preallocated (contiguous) file
+ * Each set runs on a shared SPI bus at 10 MHz and on a dedicated bus at
+ * SD_SPI_MHZ.
+ *
+ * On the board:
+ *   pio run -e nucleo_l476rg_storage_bench -t upload && pio device monitor
+ * On Linux, against a file-backed fake card (native/SdFat.h) with the
+ * latency of a typical class 10 card:
+ *   pio run -e native_storage_bench
+ *   .pio/build/native_storage_bench/program [root=sdcard] [kib=128] [stall_us=40000]
+ */
+#include <Arduino.h>
+#include <SdFat.h>
+#include <stdarg.h>
+
+#include <config.hpp>
+
+static constexpr uint16_t RECORD_SIZES[] = {32, 64, 128, 256};
+static constexpr uint16_t SECTOR_SIZE = 512;
+static constexpr uint16_t MAX_BUFFER = 4096;
+static const char *const BENCH_FILENAME = "bench.dat";
+
+// Log-linear latency histogram: 8 sub-buckets per power of two, ~12% error
+static constexpr uint8_t SUB_BUCKETS = 8;
+static constexpr uint8_t POWERS = 24; // Up to ~16 s
+
+enum Pattern : uint8_t
+{
+  OPEN_APPEND_CLOSE,
+  KEPT_OPEN,
+  BUFFER_512,
+  BUFFER_4096,
+  PATTERNS
+};
+
+static const char *const PATTERN_NAMES[PATTERNS] = {"open-append-close", "kept-open", "buffer-512", "buffer-4096"};
+
+static SdFat sd;
+static SdFile benchFile;
+static uint8_t buffer[MAX_BUFFER];
+static uint8_t record[256];
+static uint16_t histogram[POWERS * SUB_BUCKETS];
+static uint32_t totalKiB = 128;
+
+static void report(const char *format, ...)
+{
+  char text[160];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+#ifdef ARDUINO
+  Serial.print(text);
+#else
+  fputs(text, stdout);
+  fflush(stdout);
+#endif
+}
+
+static uint16_t bucketOf(uint32_t us)
+{
+  if (us < SUB_BUCKETS)
+  {
+    return us;
+  }
+  uint8_t power = 31 - __builtin_clz(us); // >= 3
+  uint8_t sub = (us >> (power - 3)) & (SUB_BUCKETS - 1);
+  uint16_t bucket = (power - 2) * SUB_BUCKETS + sub;
+  return bucket < POWERS * SUB_BUCKETS ? bucket : POWERS * SUB_BUCKETS - 1;
+}
+
+// Upper bound of a bucket (us)
+static uint32_t bucketLimit(uint16_t bucket)
+{
+  if (bucket < SUB_BUCKETS)
+  {
+    return bucket;
+  }
+  uint8_t power = bucket / SUB_BUCKETS + 2;
+  uint32_t sub = bucket % SUB_BUCKETS;
+  return ((SUB_BUCKETS + sub + 1) << (power - 3)) - 1;
+}
+
+static uint32_t percentile(uint32_t count, uint8_t percent, uint32_t worst)
+{
+  uint32_t rank = (count * percent + 99) / 100;
+  uint32_t seen = 0;
+  for (uint16_t b = 0; b < POWERS * SUB_BUCKETS; b++)
+  {
+    seen += histogram[b];
+    if (seen >= rank && seen > 0)
+    {
+      return bucketLimit(b) < worst ? bucketLimit(b) : worst;
+    }
+  }
+  return 0;
+}
+
+/// run
+/// @brief Writes totalKiB of records with one pattern and prints a result line
+///
+/// @param[in] pattern: Write pattern
+/// @param[in] size: Record size (bytes)
+///
+/// @return false if the card failed
+///
+static bool run(Pattern pattern, uint16_t size)
+{
+  uint32_t total = totalKiB * 1024;
+  uint32_t records = total / size;
+  uint16_t bufferSize = pattern == BUFFER_4096 ? MAX_BUFFER : SECTOR_SIZE;
+  uint16_t buffered = 0;
+  uint32_t worst = 0;
+  memset(histogram, 0, sizeof(histogram));
+
+  sd.remove(BENCH_FILENAME);
+  if (pattern != OPEN_APPEND_CLOSE)
+  {
+    if (!benchFile.open(BENCH_FILENAME, O_RDWR | O_CREAT | O_TRUNC))
+    {
+      return false;
+    }
+    if (pattern == BUFFER_4096 && benchFile.preAllocate(total))
+    {
+      benchFile.seekSet(0); // Preallocation sets the size; write from the start
+    }
+  }
+
+#ifndef ARDUINO
+  FakeCard::resetStats();
+#endif
+  uint32_t started = micros();
+  for (uint32_t r = 0; r < records; r++)
+  {
+    record[0] = (uint8_t)r;
+    uint32_t before = micros();
+    bool isWritten = true;
+
+    switch (pattern)
+    {
+    case OPEN_APPEND_CLOSE:
+      isWritten = benchFile.open(BENCH_FILENAME, O_RDWR | O_CREAT | O_APPEND) &&
+                  benchFile.write(record, size) == size && benchFile.close();
+      break;
+    case KEPT_OPEN:
+      isWritten = benchFile.write(record, size) == size;
+      break;
+    case BUFFER_512:
+    case BUFFER_4096:
+      memcpy(buffer + buffered, record, size);
+      buffered += size;
+      if (buffered == bufferSize)
+      {
+        isWritten = benchFile.write(buffer, buffered) == buffered;
+        buffered = 0;
+      }
+      break;
+    default:
+      break;
+    }
+
+    uint32_t elapsed = micros() - before;
+    histogram[bucketOf(elapsed)]++;
+    worst = elapsed > worst ? elapsed : worst;
+    if (!isWritten)
+    {
+      benchFile.close();
+      return false;
+    }
+  }
+
+  if (pattern != OPEN_APPEND_CLOSE)
+  {
+    if (buffered > 0)
+    {
+      benchFile.write(buffer, buffered);
+    }
+    if (pattern == BUFFER_4096)
+    {
+      benchFile.truncate(); // Drop the unused part of the preallocation
+    }
+    benchFile.close();
+  }
+  uint32_t elapsedUs = micros() - started;
+
+  double mbps = elapsedUs > 0 ? (double)total / elapsedUs : 0;
+  report("%-18s %5u %8.3f %8lu %8lu %9lu", PATTERN_NAMES[pattern], size, mbps,
+         (unsigned long)percentile(records, 50, worst), (unsigned long)percentile(records, 99, worst),
+         (unsigned long)worst);
+#ifndef ARDUINO
+  const FakeCardStats &stats = FakeCard::stats();
+  report(" %8lu %8lu %8lu %6lu", (unsigned long)stats.commands, (unsigned long)stats.sectorsWritten,
+         (unsigned long)stats.partialWrites, (unsigned long)stats.stalls);
+#endif
+  report("\n");
+  return true;
+}
+
+static void runAll(bool isDedicated, uint32_t mhz)
+{
+  sd.end();
+  SdSpiConfig spiConfig(uSD_CS_PIN, isDedicated ? DEDICATED_SPI : SHARED_SPI, SD_SCK_MHZ(mhz));
+  if (!sd.begin(spiConfig))
+  {
+    report("[ERROR] uSD initialization failed (%s SPI, %lu MHz)\n", isDedicated ? "dedicated" : "shared",
+           (unsigned long)mhz);
+    return;
+  }
+
+  report("\n%s SPI, %lu MHz, %lu KiB per run\n", isDedicated ? "dedicated" : "shared", (unsigned long)mhz,
+         (unsigned long)totalKiB);
+  report("%-18s %5s %8s %8s %8s %9s", "pattern", "rec", "MB/s", "p50 us", "p99 us", "worst us");
+#ifndef ARDUINO
+  report(" %8s %8s %8s %6s", "cmds", "sectors", "partial", "stalls");
+#endif
+  report("\n");
+
+  for (uint16_t size : RECORD_SIZES)
+  {
+    for (uint8_t p = 0; p < PATTERNS; p++)
+    {
+      if (!run((Pattern)p, size))
+      {
+        report("[ERROR] %s, %u bytes: write failed\n", PATTERN_NAMES[p], size);
+      }
+    }
+  }
+  sd.remove(BENCH_FILENAME);
+}
+
+static void benchmark()
+{
+  for (uint16_t i = 0; i < sizeof(record); i++)
+  {
+    record[i] = 'a' + i % 26;
+  }
+  runAll(false, 10);
+  runAll(true, SD_SPI_MHZ);
+}
+
+#ifdef ARDUINO
+
+void setup()
+{
+  Serial.begin(SERIAL_BAUD_RATE);
+  delay(2000);
+  benchmark();
+  report("\nfim\n");
+}
+
+void loop()
+{
+}
+
+#else
+
+int main(int argc, char **argv)
+{
+  FakeCard::setRoot(argc > 1 ? argv[1] : "sdcard");
+  totalKiB = argc > 2 ? atoi(argv[2]) : 128;
+
+  // Typical class 10 card: ~0.4 ms per single-block write, multi-block
+  // sectors at the bus rate, a garbage-collection stall every 1 MB
+  FakeCardModel model;
+  model.commandUs = 60;
+  model.sectorReadUs = 150;
+  model.sectorWriteUs = 400;
+  model.burstSectorUs = 20;
+  model.stallEvery = 2048;
+  model.stallUs = argc > 3 ? atoi(argv[3]) : 40000;
+  FakeCard::setModel(model);
+
+  benchmark();
+  return 0;
+}
+
+#endif
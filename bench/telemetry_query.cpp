@@ -0,0 +1,294 @@
+/* Time-range queries over a synthetic year of telemetry
+ * Builds a year of rows (4 sensors, one row per minute) the way
+ * TelemetryFile writes them: 512-byte blocks in files of MAX_FILE_SIZE,
+ * one index entry per block, millis() restarting at every reboot, power
+ * cuts of a few hours and ~1% failed readings. One block is corrupted to
+ * check that it is skipped. Random queries are compared sample by sample
+ * with a brute-force filter of the same data, and the storage reads of
+ * each query are checked against O(log n + k). A block written at a
+ * 5-minute interval, and across an hour's gap, must still fill to capacity
+ * and give back every timestamp.
+ *
+ * Build and run:
+ *   pio run -e native_telemetry_query
+ *   .pio/build/native_telemetry_query/program [queries=2000] [seed=1]
+ */
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <map>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "telemetryIndex.hpp"
+#include "check.h"
+
+static constexpr uint8_t SENSORS = 4;
+static constexpr uint32_t PERIOD_MS = 60000;
+static constexpr uint32_t YEAR_S = 365u * 24 * 3600;
+static constexpr uint32_t START_EPOCH = 1735689600; // 2025-01-01
+static constexpr uint32_t BLOCKS_PER_FILE = 1048576 / TELEMETRY_BLOCK_SIZE; // MAX_FILE_SIZE
+
+/// MemoryStorage
+/// @brief Index and telemetria<N>.bin files kept in memory, counting reads
+///
+class MemoryStorage : public TelemetryStorage
+{
+public:
+  std::vector<TelemetryIndexEntry> index;
+  std::map<uint16_t, std::vector<uint8_t>> files;
+
+  uint32_t entries() override
+  {
+    return index.size();
+  }
+
+  bool readEntry(uint32_t position, TelemetryIndexEntry &entry) override
+  {
+    if (position >= index.size())
+    {
+      return false;
+    }
+    entry = index[position];
+    return true;
+  }
+
+  bool readBlock(uint16_t file, uint16_t block, uint8_t *sector) override
+  {
+    auto it = files.find(file);
+    size_t offset = (size_t)block * TELEMETRY_BLOCK_SIZE;
+    if (it == files.end() || offset + TELEMETRY_BLOCK_SIZE > it->second.size())
+    {
+      return false;
+    }
+    memcpy(sector, it->second.data() + offset, TELEMETRY_BLOCK_SIZE);
+    return true;
+  }
+};
+
+/// Writer
+/// @brief TelemetryFile without the card: same block and index rules
+///
+struct Writer
+{
+  MemoryStorage &storage;
+  TelemetryBlock block;
+  uint16_t file = 0;
+  uint16_t blockNumber = 0;
+  uint32_t sequence = 0;
+
+  explicit Writer(MemoryStorage &storage) : storage(storage)
+  {
+    block.begin(0, SENSORS);
+  }
+
+  void store()
+  {
+    block.seal();
+    std::vector<uint8_t> &data = storage.files[file];
+    data.resize((size_t)(blockNumber + 1) * TELEMETRY_BLOCK_SIZE);
+    memcpy(data.data() + (size_t)blockNumber * TELEMETRY_BLOCK_SIZE, block.data(), TELEMETRY_BLOCK_SIZE);
+  }
+
+  void next()
+  {
+    if (++blockNumber >= BLOCKS_PER_FILE)
+    {
+      file++;
+      blockNumber = 0;
+      sequence = 0;
+    }
+    block.begin(++sequence, SENSORS);
+  }
+
+  void append(uint32_t epoch, uint32_t millis, const int16_t *row)
+  {
+    if (!block.append(millis, row))
+    {
+      store();
+      next();
+      block.append(millis, row);
+    }
+    if (block.rows() == 1)
+    {
+      storage.index.push_back({epoch, millis, file, blockNumber});
+    }
+    if (block.isFull())
+    {
+      store();
+      next();
+    }
+  }
+
+  // A reboot starts a new file, as TelemetryFile::init() does
+  void reboot()
+  {
+    if (block.rows() > 0)
+    {
+      store();
+    }
+    file++;
+    blockNumber = 0;
+    sequence = 0;
+    block.begin(0, SENSORS);
+  }
+};
+
+int main(int argc, char **argv)
+{
+  int queries = argc > 1 ? atoi(argv[1]) : 2000;
+  unsigned seed = argc > 2 ? atoi(argv[2]) : 1;
+  std::mt19937 random(seed);
+
+  MemoryStorage storage;
+  Writer writer(storage);
+  std::vector<TelemetrySample> truth;
+
+  // ---------- A year of data ----------
+  uint32_t epoch = START_EPOCH;
+  uint32_t millis = 0;
+  while (epoch < START_EPOCH + YEAR_S)
+  {
+    if (random() % 20000 == 0)
+    {
+      epoch += 3600 + random() % (6 * 3600); // Power cut, then reboot
+      millis = 0;
+      writer.reboot();
+    }
+
+    int16_t row[SENSORS];
+    for (uint8_t s = 0; s < SENSORS; s++)
+    {
+      double daily = sin((epoch % 86400) * 2 * M_PI / 86400);
+      row[s] = random() % 100 == 0 ? TELEMETRY_MISSING : (int16_t)(2200 + 300 * daily + 50 * s + random() % 20);
+      if (row[s] != TELEMETRY_MISSING)
+      {
+        truth.push_back({epoch, (uint8_t)(s + 1), row[s]});
+      }
+    }
+    writer.append(epoch, millis, row);
+    epoch += PERIOD_MS / 1000;
+    millis += PERIOD_MS;
+  }
+  writer.store();
+
+  // Torn block: must be skipped, its samples disappear from the answer
+  const TelemetryIndexEntry &torn = storage.index[storage.index.size() / 3];
+  storage.files[torn.file][(size_t)torn.block * TELEMETRY_BLOCK_SIZE + 100] ^= 0xFF;
+  TelemetryBlock tornBlock;
+  uint8_t sector[TELEMETRY_BLOCK_SIZE];
+  storage.readBlock(torn.file, torn.block, sector);
+  sector[100] ^= 0xFF;
+  tornBlock.load(sector);
+  uint32_t tornFrom = torn.epoch;
+  uint32_t tornTo = torn.epoch + (tornBlock.timestamp(tornBlock.rows() - 1) - torn.timestamp) / 1000;
+  truth.erase(std::remove_if(truth.begin(), truth.end(),
+                             [&](const TelemetrySample &s) { return s.epoch >= tornFrom && s.epoch <= tornTo; }),
+              truth.end());
+
+  uint32_t entries = storage.index.size();
+  printf("rows: %lu samples, %u blocks in %zu files, index %lu bytes\n", (unsigned long)truth.size(), entries,
+         storage.files.size(), (unsigned long)entries * sizeof(TelemetryIndexEntry));
+
+  // ---------- Long intervals ----------
+  // Gaps past 65 s once forced a block per row
+  TelemetryBlock sparse;
+  sparse.begin(0, SENSORS);
+  int16_t sparseRow[SENSORS] = {2200, 2250, 2300, 2350};
+  std::vector<uint32_t> sparseTimes;
+  uint32_t sparseMillis = 4000000000u; // Runs across the millis() wrap
+  while (sparse.append(sparseMillis, sparseRow))
+  {
+    sparseTimes.push_back(sparseMillis);
+    sparseMillis += sparseTimes.size() == 10 ? 3600000 : 300000;
+  }
+  sparse.seal();
+  TelemetryBlock sparseLoaded;
+  bool isSparseOk = sparse.rows() == TelemetryBlock::capacity(SENSORS) && sparseLoaded.load(sparse.data());
+  for (uint8_t r = 0; isSparseOk && r < sparseLoaded.rows(); r++)
+  {
+    isSparseOk = sparseLoaded.timestamp(r) == sparseTimes[r];
+  }
+  printf("sparse:  %u rows per block at 5 min, %u capacity\n", (unsigned)sparse.rows(),
+         (unsigned)TelemetryBlock::capacity(SENSORS));
+  check(isSparseOk, "5-minute rows fill one block with exact timestamps");
+
+  // ---------- Queries ----------
+  TelemetryQuery query(storage);
+  double logN = std::log2((double)entries);
+  unsigned long totalReads = 0;
+  unsigned long totalSamples = 0;
+  unsigned long worstExcess = 0;
+  auto started = std::chrono::steady_clock::now();
+
+  for (int q = 0; q < queries; q++)
+  {
+    // Mostly short ranges (an hour), some days, a few weeks
+    uint32_t span = q % 10 == 9 ? 7 * 86400 : (q % 3 == 2 ? 86400 : 3600);
+    uint32_t from = START_EPOCH + random() % (YEAR_S - span);
+    uint32_t to = from + span;
+    uint8_t sensor = random() % (SENSORS + 1);
+
+    std::vector<TelemetrySample> expected;
+    auto first = std::lower_bound(truth.begin(), truth.end(), from,
+                                  [](const TelemetrySample &s, uint32_t e) { return s.epoch < e; });
+    for (auto it = first; it != truth.end() && it->epoch <= to; ++it)
+    {
+      if (sensor == 0 || it->sensor == sensor)
+      {
+        expected.push_back(*it);
+      }
+    }
+
+    std::vector<TelemetrySample> found;
+    TelemetrySample sample;
+    query.begin(from, to, sensor);
+    while (query.next(sample))
+    {
+      found.push_back(sample);
+    }
+
+    bool isSame = found.size() == expected.size();
+    for (size_t i = 0; isSame && i < found.size(); i++)
+    {
+      isSame = found[i].epoch == expected[i].epoch && found[i].sensor == expected[i].sensor &&
+               found[i].value == expected[i].value;
+    }
+    if (!isSame)
+    {
+      failures++;
+      fprintf(stderr, "query %d [%u, %u] sensor %u: %zu samples, expected %zu\n", q, from, to, sensor, found.size(),
+              expected.size());
+    }
+
+    // Binary search, then two reads per block touched (entry + block):
+    // the span covers k rows, plus the block before the range and the one
+    // after it
+    uint8_t perRow = sensor == 0 ? SENSORS : 1;
+    uint32_t rows = (expected.size() + perRow - 1) / perRow;
+    uint32_t bound = (uint32_t)ceil(logN) + 1 + 2 * (rows / TelemetryBlock::capacity(SENSORS) + 3) +
+                     2 * (span / (TelemetryBlock::capacity(SENSORS) * PERIOD_MS / 1000) + 1);
+    if (query.getReads() > bound)
+    {
+      worstExcess = std::max(worstExcess, (unsigned long)(query.getReads() - bound));
+    }
+    totalReads += query.getReads();
+    totalSamples += found.size();
+  }
+
+  double elapsedUs =
+      std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count();
+  printf("queries: %d, %lu samples, %.1f samples/query\n", queries, totalSamples, (double)totalSamples / queries);
+  printf("reads:   %.1f per query (log2 n = %.1f), full scan = %u\n", (double)totalReads / queries, logN,
+         2 * entries);
+  printf("time:    %.1f us per query (host)\n", elapsedUs / queries);
+  if (worstExcess > 0)
+  {
+    printf("reads above O(log n + k) bound by up to %lu\n", worstExcess);
+  }
+  check(worstExcess == 0, "reads within O(log n + k)");
+  return finish();
+}
@@ -0,0 +1,533 @@
+/* Microbenchmarks of the TIM3 tick hot paths
+ * Each path of sendTemperature() is timed on its own, in batches, until a
+ * run lasts at least MIN_RUN_MS; REPETITIONS runs are made and the median
+ * is reported:
+ *   log_info             logs.info(): RTC read, timestamp, line, buffer (+ Serial echo)
+ *   log_flush_line       logs.service(): buffered lines written to the card, per line
+ *   csv_line_build       CSV line of sendTemperature() built in a StrBuilder
+ *   format_fixed_2dp     formatFixed(value, 2), used for every temperature
+ *   dtostrf_2dp          dtostrf(value, 1, 2), the call formatFixed() replaced
+ *   string_concat        the same log line with Arduino String (board only)
+ *   sensor_average       sensor.getTemperatureAverage(), DHT reading cached
+ *   rtc_datetime_format  get_rtc_datetime() and the timestamp of a log line
+ *   mqtt_publish_qos0    PubSubClient::publish() serialised into a sink client
+ * Output is JSON in the Google Benchmark layout (name, iterations,
+ * real_time, cpu_time, time_unit), so its tools/compare.py diffs two runs.
+ * On the board times come from the DWT cycle counter and each entry also
+ * has "cycles"; on Linux they are CLOCK_MONOTONIC and only show relative
+ * changes (the SD card and the DHT11 are fakes there).
+ *
+ * On the board (JSON after the "--- json ---" line):
+ *   pio run -e nucleo_l476rg_tick_bench -t upload && pio device monitor
+ * On Linux (JSON on stdout, table on stderr):
+ *   pio run -e native_tick_bench
+ *   .pio/build/native_tick_bench/program [root=sdcard] [min_run_ms=100] > tick.json
+ */
+#include <Arduino.h>
+#include <PubSubClient.h>
+#include <SdFat.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#ifndef ARDUINO
+#include <time.h>
+#include <unistd.h>
+#endif
+
+#include <config.hpp>
+#include "format.hpp"
+#include "logs.hpp"
+#include "sensorEvent.hpp"
+#include "set_rtc.hpp"
+
+static constexpr uint8_t REPETITIONS = 5;
+static constexpr uint8_t LOG_BATCH = 8;  // Lines per batch, well under the log buffer
+static constexpr uint8_t MAX_CASES = 12;
+
+ExtMEM logs;
+sensorEvent sensor;
+extern struct sensorData sensor_data;
+
+static uint32_t minRunMs = 100;
+#ifndef ARDUINO
+static FILE *jsonOut = nullptr; // stdout saved before Serial is muted
+#endif
+
+// ========== Timing ==========
+// Ticks are CPU cycles on the board, nanoseconds on Linux
+
+static uint64_t elapsedTicks = 0;
+#ifdef ARDUINO
+static uint32_t startTick = 0;
+#else
+static uint64_t startNs = 0;
+#endif
+
+static void enableTimer()
+{
+#ifdef ARDUINO
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CYCCNT = 0;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+#endif
+}
+
+static inline void timerStart()
+{
+#ifdef ARDUINO
+  startTick = DWT->CYCCNT;
+#else
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  startNs = (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec;
+#endif
+}
+
+static inline void timerStop()
+{
+#ifdef ARDUINO
+  elapsedTicks += DWT->CYCCNT - startTick; // 32-bit difference: batches stay far below 53 s
+#else
+  timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  elapsedTicks += (uint64_t)now.tv_sec * 1000000000ULL + now.tv_nsec - startNs;
+#endif
+}
+
+static double ticksToNs(double ticks)
+{
+#ifdef ARDUINO
+  return ticks * 1e9 / SystemCoreClock;
+#else
+  return ticks;
+#endif
+}
+
+// ========== Output ==========
+
+static void report(const char *format, ...)
+{
+  char text[160];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+#ifdef ARDUINO
+  Serial.print(text);
+#else
+  fputs(text, stderr);
+#endif
+}
+
+static void json(const char *format, ...)
+{
+  char text[200];
+  va_list args;
+  va_start(args, format);
+  vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+#ifdef ARDUINO
+  Serial.print(text);
+#else
+  fputs(text, jsonOut);
+#endif
+}
+
+// ========== Cases ==========
+// Each runs `iterations` operations and times only the part under test
+
+// Varying input so no case is folded into a constant
+static const float VALUES[] = {21.5f, -3.25f, 18.04f, 24.996f, 0.0f, 19.875f, 22.125f, 35.5f};
+static constexpr uint8_t VALUE_COUNT = sizeof(VALUES) / sizeof(VALUES[0]);
+static volatile uint32_t sink = 0;
+
+static void caseLogInfo(uint32_t iterations)
+{
+  for (uint32_t done = 0; done < iterations; done += LOG_BATCH)
+  {
+    uint32_t batch = iterations - done < LOG_BATCH ? iterations - done : LOG_BATCH;
+    timerStart();
+    for (uint32_t i = 0; i < batch; i++)
+    {
+      logs.info("Sensor 1 temperatura: 21.50C");
+    }
+    timerStop();
+    logs.service(UINT32_MAX); // Empty the buffer outside the timed part
+  }
+}
+
+static void caseLogFlush(uint32_t iterations)
+{
+  for (uint32_t done = 0; done < iterations; done += LOG_BATCH)
+  {
+    uint32_t batch = iterations - done < LOG_BATCH ? iterations - done : LOG_BATCH;
+    for (uint32_t i = 0; i < batch; i++)
+    {
+      logs.info("Sensor 1 temperatura: 21.50C");
+    }
+    timerStart();
+    logs.service(UINT32_MAX);
+    timerStop();
+  }
+}
+
+static void caseCsvLine(uint32_t iterations)
+{
+  StrBuilder<80> line;
+  char tempStr[FORMAT_FIXED_MAX + 1];
+  tempStr[formatFixed(tempStr, VALUES[0], 2)] = '\0';
+  timerStart();
+  for (uint32_t i = 0; i < iterations; i++)
+  {
+    line.clear().appendUInt(millis()).append(';').appendUInt(i % NUMBER_OF_SENSORS + 1).append(";OK;").append(tempStr);
+    sink = sink + line.length();
+  }
+  timerStop();
+}
+
+static void caseFormatFixed(uint32_t iterations)
+{
+  char text[FORMAT_FIXED_MAX + 1];
+  timerStart();
+  for (uint32_t i = 0; i < iterations; i++)
+  {
+    sink = sink + formatFixed(text, VALUES[i % VALUE_COUNT], 2);
+  }
+  timerStop();
+}
+
+static void caseDtostrf(uint32_t iterations)
+{
+  char text[FORMAT_FIXED_MAX + 1];
+  timerStart();
+  for (uint32_t i = 0; i < iterations; i++)
+  {
+    dtostrf(VALUES[i % VALUE_COUNT], 1, 2, text);
+    sink = sink + text[0];
+  }
+  timerStop();
+}
+
+#ifdef ARDUINO
+static void caseStringConcat(uint32_t iterations)
+{
+  timerStart();
+  for (uint32_t i = 0; i < iterations; i++)
+  {
+    String line = "Sensor " + String(i % NUMBER_OF_SENSORS + 1) + " temperatura: " +
+                  String(VALUES[i % VALUE_COUNT], 2) + "C";
+    sink = sink + line.length();
+  }
+  timerStop();
+}
+#endif
+
+static void caseSensorAverage(uint32_t iterations)
+{
+  timerStart();
+  for (uint32_t i = 0; i < iterations; i++)
+  {
+    sensor.getTemperatureAverage();
+  }
+  timerStop();
+  sink = sink + (uint32_t)sensor_data.temperatureAverageSensors[0];
+}
+
+static void caseRtcDateTime(uint32_t iterations)
+{
+  char dateTime[20];
+  timerStart();
+  for (uint32_t i = 0; i < iterations; i++)
+  {
+    // Same conversion as ExtMEM::logLine()
+    DateTime now = get_rtc_datetime();
+    snprintf(dateTime, sizeof(dateTime), "%02u/%02u/%04u %02u:%02u:%02u", (unsigned)now.day % 100,
+             (unsigned)now.month % 100, (unsigned)now.year % 10000, (unsigned)now.hours % 100,
+             (unsigned)now.minutes % 100, (unsigned)now.seconds % 100);
+    sink = sink + dateTime[0];
+  }
+  timerStop();
+}
+
+/// Accepts any MQTT packet and answers CONNECT with a CONNACK, so
+/// PubSubClient reaches the connected state with nothing on the wire
+class SinkClient : public Client
+{
+public:
+  int connect(IPAddress ip, uint16_t port) override
+  {
+    (void)ip;
+    (void)port;
+    isOpen = true;
+    return 1;
+  }
+  int connect(const char *host, uint16_t port) override
+  {
+    (void)host;
+    return connect(IPAddress(), port);
+  }
+  size_t write(uint8_t b) override
+  {
+    return write(&b, 1);
+  }
+  size_t write(const uint8_t *buffer, size_t size) override
+  {
+    if (size > 0 && (buffer[0] & 0xF0) == 0x10)
+    {
+      pending = 4; // CONNACK, accepted
+    }
+    bytes += size;
+    return size;
+  }
+  int available() override
+  {
+    return pending;
+  }
+  int read() override
+  {
+    if (pending == 0)
+    {
+      return -1;
+    }
+    static const uint8_t CONNACK[] = {0x20, 0x02, 0x00, 0x00};
+    return CONNACK[4 - pending--];
+  }
+  int read(uint8_t *buffer, size_t size) override
+  {
+    size_t n = 0;
+    while (n < size && pending > 0)
+    {
+      buffer[n++] = (uint8_t)read();
+    }
+    return (int)n;
+  }
+  int peek() override
+  {
+    return pending > 0 ? 0x20 : -1;
+  }
+  void flush() override
+  {
+  }
+  void stop() override
+  {
+    isOpen = false;
+  }
+  uint8_t connected() override
+  {
+    return isOpen;
+  }
+  operator bool() override
+  {
+    return isOpen;
+  }
+  using Print::write;
+
+  uint64_t bytes = 0;
+
+private:
+  bool isOpen = false;
+  uint8_t pending = 0;
+};
+
+static SinkClient sinkClient;
+static PubSubClient mqttClient(sinkClient);
+
+static void caseMqttPublish(uint32_t iterations)
+{
+  char payload[FORMAT_FIXED_MAX + 1];
+  timerStart();
+  for (uint32_t i = 0; i < iterations; i++)
+  {
+    payload[formatFixed(payload, VALUES[i % VALUE_COUNT], 2)] = '\0';
+    sink = sink + mqttClient.publish("sensor1/temp", payload);
+  }
+  timerStop();
+}
+
+struct Case
+{
+  const char *name;
+  void (*run)(uint32_t iterations);
+};
+
+static const Case CASES[] = {
+    {"log_info", caseLogInfo},
+    {"log_flush_line", caseLogFlush},
+    {"csv_line_build", caseCsvLine},
+    {"format_fixed_2dp", caseFormatFixed},
+    {"dtostrf_2dp", caseDtostrf},
+#ifdef ARDUINO
+    {"string_concat", caseStringConcat},
+#endif
+    {"sensor_average", caseSensorAverage},
+    {"rtc_datetime_format", caseRtcDateTime},
+    {"mqtt_publish_qos0", caseMqttPublish},
+};
+static constexpr uint8_t CASE_COUNT = sizeof(CASES) / sizeof(CASES[0]);
+static_assert(CASE_COUNT <= MAX_CASES, "Too many cases");
+
+struct Result
+{
+  uint32_t iterations;
+  double medianTicks; // Per operation
+  double minTicks;
+};
+
+static Result results[MAX_CASES];
+
+static uint32_t runTicks(const Case &benchCase, uint32_t iterations)
+{
+  elapsedTicks = 0;
+  benchCase.run(iterations);
+  return (uint32_t)(elapsedTicks < UINT32_MAX ? elapsedTicks : UINT32_MAX);
+}
+
+static Result measure(const Case &benchCase)
+{
+  // Iterations doubled until one run takes MIN_RUN_MS of timed work
+  double minTicks = minRunMs * 1e6 / ticksToNs(1);
+  uint32_t iterations = 1;
+  benchCase.run(1); // Warm-up: first DHT read, file opened, caches
+  while (iterations < (1UL << 24) && runTicks(benchCase, iterations) < minTicks)
+  {
+    iterations *= 2;
+  }
+
+  double perOperation[REPETITIONS];
+  for (uint8_t r = 0; r < REPETITIONS; r++)
+  {
+    perOperation[r] = (double)runTicks(benchCase, iterations) / iterations;
+  }
+  for (uint8_t i = 1; i < REPETITIONS; i++) // Insertion sort, 5 values
+  {
+    double value = perOperation[i];
+    int8_t j = i - 1;
+    for (; j >= 0 && perOperation[j] > value; j--)
+    {
+      perOperation[j + 1] = perOperation[j];
+    }
+    perOperation[j + 1] = value;
+  }
+  return {iterations, perOperation[REPETITIONS / 2], perOperation[0]};
+}
+
+static void printJson()
+{
+  json("{\n  \"context\": {\n");
+#ifdef ARDUINO
+  json("    \"host_name\": \"nucleo_l476rg\",\n    \"num_cpus\": 1,\n    \"mhz_per_cpu\": %lu,\n",
+       (unsigned long)(SystemCoreClock / 1000000));
+  json("    \"timer\": \"DWT_CYCCNT\",\n");
+#else
+  json("    \"host_name\": \"native\",\n    \"num_cpus\": 1,\n    \"mhz_per_cpu\": 0,\n");
+  json("    \"timer\": \"CLOCK_MONOTONIC\",\n");
+#endif
+  json("    \"library_build_type\": \"release\",\n    \"repetitions\": %u,\n    \"min_run_ms\": %lu\n  },\n",
+       REPETITIONS, (unsigned long)minRunMs);
+  json("  \"benchmarks\": [\n");
+  for (uint8_t i = 0; i < CASE_COUNT; i++)
+  {
+    const Result &result = results[i];
+    double ns = ticksToNs(result.medianTicks);
+    json("    {\"name\": \"%s\", \"run_name\": \"%s\", \"run_type\": \"iteration\", \"iterations\": %lu, ",
+         CASES[i].name, CASES[i].name, (unsigned long)result.iterations);
+    json("\"real_time\": %.1f, \"cpu_time\": %.1f, \"min_time\": %.1f, \"time_unit\": \"ns\"", ns, ns,
+         ticksToNs(result.minTicks));
+#ifdef ARDUINO
+    json(", \"cycles\": %.1f", result.medianTicks);
+#endif
+    json("}%s\n", i + 1 < CASE_COUNT ? "," : "");
+  }
+  json("  ]\n}\n");
+}
+
+static void benchmark()
+{
+  enableTimer();
+  initRTC();
+  if (!logs.initExtMem() || !logs.initFile("log"))
+  {
+    report("[ERROR] uSD initialization failed\n");
+  }
+  sensor.initSensor();
+  mqttClient.setServer("sink", 1883);
+  if (!mqttClient.connect("tick-bench"))
+  {
+    report("[ERROR] MQTT sink did not connect\n");
+  }
+
+  report("%-20s %10s %12s %12s\n", "case", "iterations", "median ns", "min ns");
+  for (uint8_t i = 0; i < CASE_COUNT; i++)
+  {
+    results[i] = measure(CASES[i]);
+    report("%-20s %10lu %12.1f %12.1f\n", CASES[i].name, (unsigned long)results[i].iterations,
+           ticksToNs(results[i].medianTicks), ticksToNs(results[i].minTicks));
+  }
+}
+
+#ifdef ARDUINO
+
+void setup()
+{
+  Serial.begin(SERIAL_BAUD_RATE);
+  delay(2000);
+  benchmark();
+  report("\n--- json ---\n");
+  printJson();
+}
+
+void loop()
+{
+}
+
+#else
+
+static bool option(const char *argument, const char *name, const char **value)
+{
+  size_t length = strlen(name);
+  if (strncmp(argument, name, length) != 0 || argument[length] != '=')
+  {
+    return false;
+  }
+  *value = argument + length + 1;
+  return true;
+}
+
+int main(int argc, char **argv)
+{
+  const char *root = "sdcard";
+  minRunMs = 100;
+  for (int i = 1; i < argc; i++)
+  {
+    const char *value;
+    if (option(argv[i], "root", &value))
+    {
+      root = value;
+    }
+    else if (option(argv[i], "min_run_ms", &value) && atoi(value) > 0)
+    {
+      minRunMs = atoi(value);
+    }
+    else
+    {
+      fprintf(stderr, "usage: %s [root=sdcard] [min_run_ms=100]\n", argv[0]);
+      return 2;
+    }
+  }
+  FakeCard::setRoot(root);
+
+  // Serial (the log echo) goes to /dev/null so stdout carries only the JSON
+  jsonOut = fdopen(dup(STDOUT_FILENO), "w");
+  if (!jsonOut || !freopen("/dev/null", "w", stdout))
+  {
+    fprintf(stderr, "cannot redirect stdout\n");
+    return 1;
+  }
+
+  benchmark();
+  printJson();
+  fclose(jsonOut);
+  return 0;
+}
+
+#endif
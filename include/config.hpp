@@ -3,7 +3,6 @@
 
 // Setup Libraries
 #include <Arduino.h>
-#include <string>
 
 // Forward declarations
 class ExtMEM;
@@ -19,6 +18,13 @@ class ExtMEM;
 #define LED_WIFI PB0                // LED estado WiFi
 #define LED_SD PB1                  // LED estado SD
 
+// Atuadores
+#define COOLING_PIN PC8             // Relé do arrefecimento (ativo a 1)
+
+// Botões (ativos a 0): B1 da Nucleo e um botão externo de PC10 para o GND
+static constexpr uint32_t BUTTON_PINS[] = {USER_BTN, PC10};
+static constexpr uint8_t BUTTON_COUNT = sizeof(BUTTON_PINS) / sizeof(BUTTON_PINS[0]);
+
 // SPI for SD Card
 static constexpr int SCK_PIN = PA5;
 static constexpr int MISO_PIN = PA6;
@@ -27,7 +33,16 @@ static constexpr int uSD_CS_PIN = PB6;
 
 // ========== COMMUNICATION ==========
 #define SERIAL_BAUD_RATE 115200
-#define BUTTON_DEBOUNCE_DELAY 50    // milliseconds
+
+// ESP8266 link (USART1, DMA)
+static constexpr unsigned long ESP_UART_BAUD_HIGH = 921600; // Taxa negociada com AT+UART_CUR
+static constexpr bool ESP_UART_FLOW_CONTROL = false;        // RTS/CTS (requer ligação de PA11/PA12)
+static constexpr int ESP_UART_RTS_PIN = PA12;
+static constexpr int ESP_UART_CTS_PIN = PA11;
+static constexpr uint16_t ESP_UART_RX_DMA_SIZE = 1024;      // Anel de receção DMA
+static constexpr uint16_t ESP_UART_TX_SIZE = 256;           // Cada um dos dois buffers de envio
+static constexpr uint32_t ESP_UART_AT_TIMEOUT = 1000;       // Espera pela resposta OK (ms)
+static constexpr uint32_t ESP_UART_SWITCH_DELAY = 20;       // Tempo para o ESP mudar de taxa (ms)
 
 // ========== SYSTEM PARAMETERS ==========
 // Sensor variables
@@ -35,14 +50,18 @@ static const int SAMPLES_AVERAGE = 10;    // Number of samples for average calcu
 static const int NUMBER_OF_SENSORS = 4;   // Number of sensors
 static const float THIRTY_DEGREES = 30.0; // Thirty degrees Celsius
 
-// Delays
-static const int DELAY_WIFI_CONNECTION = 5000; // Delay for WiFi connection
-static const int DELAY_MQTT_CONNECTION = 2000; // Delay for MQTT connection
-static const int DELAY_TO_STABILIZE = 2000;    // Delay to stabilize
+// Telemetry quantities (index of the deadband tables and TelemetryRecord::quantity)
+// Only temperature is sampled and published; a new quantity gets its index here
+static constexpr uint8_t TELEMETRY_TEMPERATURE = 0;
+static constexpr uint8_t TELEMETRY_QUANTITIES = 1;
 
-// Timer properties
-static constexpr uint32_t TIMER3_PRESCALE = 7200;  // Prescale factor
-static constexpr uint32_t TIMER3_OVERFLOW = 20000; // Overflow value
+// Connection manager (milliseconds)
+static constexpr uint32_t CONNECTION_BACKOFF_MIN = 1000;   // First retry delay
+static constexpr uint32_t CONNECTION_BACKOFF_MAX = 60000;  // Backoff ceiling
+static constexpr uint32_t CONNECTION_POLL_INTERVAL = 500;  // Link health check period
+static constexpr uint32_t WIFI_ASSOCIATE_TIMEOUT = 15000;  // Max time to join the AP
+static constexpr uint16_t MQTT_SOCKET_TIMEOUT_S = 2;       // PubSubClient socket timeout (s)
+static constexpr uint32_t LED_BLINK_INTERVAL = 500;        // Alarm LED toggle period
 
 // ========== WIFI & MQTT ==========
 #define SERVER_SSID "NOS_Internet_E345"
@@ -51,6 +70,13 @@ static constexpr uint32_t TIMER3_OVERFLOW = 20000; // Overflow value
 #define SERVER_PORT 1883
 #define MQTT_CLIENT_ID "STM32_Cooling_System"
 
+// Transporte MQTT, escolhido na compilação (-D MQTT_TRANSPORT=...)
+#define MQTT_TRANSPORT_PUBSUB 0 // PubSubClient no STM32, pacotes por AT+CIPSEND
+#define MQTT_TRANSPORT_AT 1     // Cliente MQTT do firmware ESP-AT (AT+MQTTPUBRAW)
+#ifndef MQTT_TRANSPORT
+#define MQTT_TRANSPORT MQTT_TRANSPORT_PUBSUB
+#endif
+
 // MQTT Topics - Publicação
 #define TOPIC_BASE "sala_maquinas/"
 #define TOPIC_TEMP_PREFIX TOPIC_BASE "sensor"
@@ -61,38 +87,203 @@ static constexpr uint32_t TIMER3_OVERFLOW = 20000; // Overflow value
 #define TOPIC_SD_STATUS TOPIC_BASE "memoria/estado"
 #define TOPIC_SYSTEM_LOG TOPIC_BASE "sistema/log"
 
-// Tópicos de controlo removidos
+// MQTT Topics - Subscrição (comandos)
+#define TOPIC_CONTROL_BASE TOPIC_BASE "controlo/"
+#define TOPIC_SETPOINT_MIN TOPIC_CONTROL_BASE "setpoint_min"  // °C
+#define TOPIC_SETPOINT_MAX TOPIC_CONTROL_BASE "setpoint_max"  // °C
+#define TOPIC_INTERVAL TOPIC_CONTROL_BASE "intervalo"         // ms entre leituras
+#define TOPIC_MODE TOPIC_CONTROL_BASE "modo"                  // AUTO | MANUAL
+#define TOPIC_EMERGENCY TOPIC_CONTROL_BASE "emergencia"       // 1 | 0
+#define TOPIC_ACTUATOR_CMD TOPIC_CONTROL_BASE "atuador"       // ON | OFF | 0..100 % (modo manual)
+#define TOPIC_STRATEGY TOPIC_CONTROL_BASE "estrategia"        // HISTERESE | PI
+#define TOPIC_HISTORY_QUERY TOPIC_CONTROL_BASE "consulta"     // de;até[;sensor] (epoch s)
+#define TOPIC_HISTORY TOPIC_BASE "historico"                  // Respostas da consulta, em blocos
+#define TOPIC_ROLLUP_MINUTE TOPIC_BASE "agregados/minuto"     // início,sensor,n,min,média,max,desvio
+#define TOPIC_ROLLUP_HOUR TOPIC_BASE "agregados/hora"
+#define TOPIC_BOOT TOPIC_BASE "sistema/arranque"             // ms por fase: reset,rtc,sd,ficheiros,sensores,leitura,rede,total
+#define TOPIC_MEMORY TOPIC_BASE "sistema/memoria"            // bytes: pilha máx. total,pilha máx. ISR,heap livre,folga da pilha
+#define TOPIC_CONTROL_STATE TOPIC_BASE "atuador/estado"      // saída %,temperatura,jitter máx us,latência máx us,períodos perdidos
+#define TOPIC_ALARM_PREFIX TOPIC_BASE "alarmes/sensor"       // + N + /alta|/baixa|/variacao, retido: estado;valor;epoch;latência us
+
+static constexpr uint8_t COMMAND_INDEX_SIZE = 16; // Índice de dispatch (potência de 2, >= 2x comandos)
 
 // ========== FILES & LOGS ==========
-static const std::string CONFIG_FILENAME = "config.json";
-static const std::string CONFIG_PATH = "/";
-static const std::string LOG_FILENAME = "system";
-static const std::string CSV_FILENAME = "temperatura";
-static const char *CSV_HEADER = "timestamp;device;status;temperature";
-static const std::string LOG_PATH = "";
+static constexpr char CONFIG_FILENAME[] = "config.json";          // Configuração editável (JSON)
+static constexpr char CONFIG_SNAPSHOT_FILENAME[] = "config.bin";  // Cópia validada com CRC, lida no arranque
+static constexpr uint16_t CONFIG_SNAPSHOT_VERSION = 3;             // Mudar quando configData mudar
+static constexpr char CONFIG_PATH[] = "/";
+static constexpr char LOG_FILENAME[] = "system";
+static constexpr char CSV_FILENAME[] = "temperatura";
+static constexpr char CSV_HEADER[] = "timestamp;device;status;temperature";
+static constexpr char LOG_PATH[] = "";
 static constexpr bool IS_RTC_ENABLED = true;
 static constexpr bool IS_SERIAL_PRINT = true;
 static constexpr bool IS_DEBUG_LOG = true;
 static constexpr uint32_t MAX_FILE_SIZE = 1048576; // 1MB
+static constexpr size_t LOG_LINE_SIZE = 160;       // Linha de log com data e nível (mais longa é cortada)
+
+// Débito do cartão SD
+static constexpr bool IS_SD_DEDICATED_SPI = true;      // SPI1 só para o cartão: escrita multi-bloco sem libertar o barramento
+static constexpr uint32_t SD_SPI_MHZ = 40;             // Máximo do SPI1 no L476 (80 MHz / 2)
+static constexpr uint16_t SD_WRITE_BUFFER_SIZE = 1024; // Buffer de linhas por ficheiro, escrito em setores inteiros (0 = escrita direta)
+static constexpr uint16_t SD_WRITE_BUFFER_MAX = 4096;  // Maior buffer que o perfil do cartão pode escolher
+static constexpr uint32_t SD_FLUSH_INTERVAL = 5000;    // Tempo máximo que uma linha fica só em RAM (ms)
+
+// Medição do cartão no arranque e perfil de escrita (rápido, médio, lento)
+static constexpr uint16_t SD_PROBE_SEQUENTIAL_KB = 16;      // Escrita sequencial medida
+static constexpr uint8_t SD_PROBE_APPENDS = 32;             // Escritas pequenas com sync medidas
+static constexpr uint32_t SD_PROBE_FAST_STALL_US = 10000;   // Pior escrita pequena de um cartão rápido
+static constexpr uint32_t SD_PROBE_SLOW_STALL_US = 50000;   // A partir daqui o cartão é lento
+static constexpr uint32_t SD_PROBE_FAST_KBPS = 1000;        // Débito sequencial mínimo de um cartão rápido
+static constexpr uint32_t SD_PROBE_SLOW_KBPS = 200;         // Abaixo disto o cartão é lento
+static constexpr uint16_t SD_BYTES_PER_SAMPLE = 512;        // Linhas de log e CSV por leitura (estimativa)
+static constexpr uint16_t SD_PROFILE_BUFFER_SIZE[3] = {1024, 2048, 4096};
+static constexpr uint32_t SD_PROFILE_FLUSH_INTERVAL[3] = {5000, 15000, 30000}; // ms
+static constexpr uint32_t SD_PROFILE_PREALLOCATION[3] = {0, 262144, MAX_FILE_SIZE}; // telemetria<N>.bin contígua
+
+// Telemetria binária (blocos de 512 bytes) em vez do CSV
+static constexpr bool IS_TELEMETRY_BINARY = true;
+static constexpr char TELEMETRY_FILENAME[] = "telemetria";
+static constexpr char TELEMETRY_EXTENSION[] = "bin";
+static constexpr uint8_t TELEMETRY_SYNC_ROWS = 8; // Reescrever o bloco parcial a cada N linhas
+static constexpr char TELEMETRY_INDEX_FILENAME[] = "telemetria.idx"; // Uma entrada (hora -> ficheiro, bloco) por bloco
+
+// Agregados por minuto e por hora (RollupRecord de 16 bytes)
+static constexpr char ROLLUP_FILENAME[] = "agregados";
+static constexpr char ROLLUP_EXTENSION[] = "bin";
+
+// Compressão dos segmentos fechados (system<N>.log, temperatura<N>.csv) no tempo livre
+static constexpr bool IS_COMPRESSION_ENABLED = true;
+static constexpr char COMPRESSED_EXTENSION[] = "lz";          // system3.log -> system3.log.lz
+static constexpr char COMPRESSING_EXTENSION[] = "lzt";        // Ficheiro ainda em escrita
+static constexpr uint32_t COMPRESSION_SCAN_INTERVAL = 60000;   // Procurar segmentos fechados (ms)
+static constexpr uint8_t COMPRESSION_SCAN_ENTRIES = 8;          // Entradas do diretório por passagem
+
+// Trabalho com SD no loop() só no tempo livre até à próxima leitura (TIM3)
+static constexpr uint32_t IDLE_GUARD_US = 2000;         // Margem antes da próxima leitura (us)
+static constexpr uint32_t IDLE_STEP_ESTIMATE_US = 5000; // Pior passo assumido até ser medido (us)
+
+// ========== BACKLOG (STORE-AND-FORWARD) ==========
+static constexpr char BACKLOG_FILENAME[] = "backlog.seg";        // Registos por enviar
+static constexpr char BACKLOG_CURSOR_FILENAME[] = "backlog.cur"; // Cursor de reposição
+static constexpr uint32_t BACKLOG_MAX_SIZE = MAX_FILE_SIZE;       // Tamanho máximo do segmento
+static const int BACKLOG_REPLAY_PER_TICK = 8;                      // Registos antigos enviados por período
+
+// ========== REPORT BY EXCEPTION ==========
+// Minimum change that publishes a value, per quantity and per sensor
+static const float PUBLISH_DEADBAND[TELEMETRY_QUANTITIES][NUMBER_OF_SENSORS] = {
+    {0.25, 0.25, 0.25, 0.25}, // °C
+};
+static constexpr uint32_t PUBLISH_HEARTBEAT = 300000; // Publicar pelo menos a cada 5 min
+
+// ========== OUTBOUND QUEUE (QoS1) ==========
+static constexpr uint8_t OUTBOUND_POOL_SIZE = 16;       // Mensagens em RAM
+static constexpr uint8_t OUTBOUND_WINDOW = 4;           // Mensagens QoS1 em voo sem PUBACK
+static constexpr uint32_t OUTBOUND_ACK_TIMEOUT = 5000;  // Retransmissão sem PUBACK (ms)
+static constexpr size_t OUTBOUND_TOPIC_SIZE = 40;       // Tamanho máximo do tópico
+static constexpr size_t OUTBOUND_PAYLOAD_SIZE = 48;     // Tamanho máximo do payload
+static constexpr char OUTBOUND_SPILL_FILENAME[] = "outbox.spl"; // Excesso da fila em SD
+static constexpr uint32_t OUTBOUND_SPILL_MAX_SIZE = 262144;       // 256KB
+
+// ========== MEMÓRIA ==========
+static constexpr size_t TICK_ARENA_SIZE = 256; // Memória temporária de cada leitura (reposta a cada leitura)
+static constexpr uint8_t READING_QUEUE_SIZE = 16;  // Leituras do TIM3 à espera do loop() (potência de 2, cobre o arranque da rede)
+static constexpr uint8_t ALARM_QUEUE_SIZE = 8;     // Alarmes à espera de publicação no loop() (potência de 2)
+static constexpr size_t STACK_ISR_WINDOW = 2048;   // Pilha pintada abaixo da ISR do TIM3 a cada período
+static constexpr uint32_t MEMORY_REPORT_INTERVAL = 60000; // Publicar pilha/heap a cada minuto (ms)
+
+// ========== CONSULTA DE HISTÓRICO ==========
+static constexpr uint8_t HISTORY_MIN_FREE_SLOTS = 8;  // Lugares da fila deixados à telemetria atual
+static constexpr size_t HISTORY_LINE_SIZE = 48;       // Pedido pela série: "consulta de;até[;sensor]"
 
 // ========== THRESHOLDS ==========
 #define TEMP_WARNING_HIGH 30.0      // °C - aviso de temperatura alta
 
+// ========== ALARMES ==========
+// Avaliados em cada leitura real do DHT, por sensor, fora da publicação periódica
+static constexpr float ALARM_HIGH_DEFAULT = TEMP_WARNING_HIGH; // °C
+static constexpr float ALARM_LOW_DEFAULT = 10.0;               // °C
+static constexpr float ALARM_HYSTERESIS_DEFAULT = 1.0;         // °C para desativar alta/baixa
+static constexpr float ALARM_RATE_DEFAULT = 2.0;               // °C/min, 0 = sem alarme de variação
+static constexpr uint16_t ALARM_DEBOUNCE_DEFAULT = 2;          // Leituras seguidas para ativar ou desativar
+static constexpr uint32_t ALARM_RATE_WINDOW_MS = 60000;        // Base da variação (a resolução do DHT11 é 1 °C)
+static constexpr uint32_t DHT_MIN_INTERVAL_MS = 2000;          // Leituras mais próximas repetem a anterior (driver)
+
+// ========== CONTROL ==========
+static constexpr float TEMP_SETPOINT_MIN_DEFAULT = 22.0;     // °C
+static constexpr float TEMP_SETPOINT_MAX_DEFAULT = 26.0;     // °C
+static constexpr float TEMP_SETPOINT_LIMIT_LOW = 5.0;        // °C - menor setpoint aceite
+static constexpr float TEMP_SETPOINT_LIMIT_HIGH = 45.0;      // °C - maior setpoint aceite
+static constexpr uint32_t SAMPLE_INTERVAL_DEFAULT = 2000;    // ms entre leituras (TIM3)
+static constexpr uint32_t SAMPLE_INTERVAL_MIN = 1000;        // ms
+static constexpr uint32_t SAMPLE_INTERVAL_MAX = 3600000;     // ms
+static constexpr uint32_t SAMPLE_TIMER_MAX_MS = 30000;       // Maior período do TIM3 (16 bits; ciclos do período em 32 bits a 80 MHz)
+
+// Controlo do atuador a ritmo fixo (TIM6), separado das leituras (TIM3)
+static constexpr uint32_t CONTROL_PERIOD_US = 250000;        // Período do controlo
+static constexpr uint32_t CONTROL_OUTPUT_WINDOW_MS = 60000;  // Janela da saída proporcional no tempo
+static constexpr uint32_t CONTROL_RELAY_MIN_ON_MS = 60000;   // Tempo mínimo ligado do compressor (alonga o ciclo)
+static constexpr uint32_t CONTROL_RELAY_MIN_OFF_MS = 60000;  // Tempo mínimo desligado (no máx. 60 comutações/h)
+static constexpr uint32_t CONTROL_IRQ_PRIORITY = 13;         // Acima do TIM3 (14); a leitura do DHT ainda atrasa o controlo ~5 ms (desliga as interrupções)
+static constexpr uint16_t CONTROL_STRATEGY_DEFAULT = 1;      // 0 = histerese, 1 = PI
+static constexpr float CONTROL_KP_DEFAULT = 0.4;             // Saída (0..1) por °C acima do alvo
+static constexpr float CONTROL_KI_DEFAULT = 0.002;           // Saída por °C·s
+static constexpr uint32_t CONTROL_REPORT_INTERVAL = 60000;   // Publicar saída e jitter (ms)
+
+// Botões: a EXTI só regista o instante, o TIM7 confirma o nível e só corre enquanto há um botão a estabilizar ou premido
+#define BUTTON_DEBOUNCE_DELAY 50    // milliseconds sem flancos até o nível ser aceite
+static constexpr uint32_t BUTTON_TICK_US = 5000;             // Período do TIM7 enquanto ativo
+static constexpr uint32_t BUTTON_LONG_PRESS_MS = 2000;       // Pressão longa (enviada ainda com o botão premido)
+static constexpr uint32_t BUTTON_IRQ_PRIORITY = 15;          // Abaixo das leituras (14) e do controlo (13)
+
+enum controlMode : uint8_t {
+    MODE_AUTOMATIC,
+    MODE_MANUAL
+};
+
 // ========== RTC ==========
-static constexpr bool SET_RTC_BOOT = true;
+static constexpr bool SET_RTC_BOOT = false; // true só para acertar a hora num arranque (depois voltar a false)
 
 // ========== GLOBAL OBJECTS DECLARATIONS ==========
 // Estas declarações devem estar no main.cpp ou num ficheiro separado
 extern ExtMEM logs;
 extern ExtMEM csv;
-extern ExtMEM asn;
+
+// Identificação por omissão (config.json em falta)
+#define CONFIG_DEFAULT_ASN "ASN001"
+#define CONFIG_DEFAULT_SN "SN001"
+#define CONFIG_DEFAULT_HW "v1.0"
+#define CONFIG_DEFAULT_FW "v1.0"
 
 // Estruturas de dados
-struct configData {
-    char asn[15];
-    char sn[15];
-    char hw[5];
-    char fw[5];
+struct configData { // Lida de config.json (ou config.bin); os valores por omissão são os deste ficheiro
+    // Identificação
+    char asn[16];
+    char sn[16];
+    char hw[16];
+    char fw[16];
+    // Rede
+    char ssid[33];
+    char password[65];
+    char brokerHost[40];
+    char clientId[32];
+    uint16_t brokerPort;
+    // Parâmetros de funcionamento (alterar sem reprogramar)
+    uint32_t sampleIntervalMs;  // Intervalo de leitura (TIM3)
+    uint32_t heartbeatMs;       // Publicar pelo menos a cada N ms
+    uint32_t flushIntervalMs;   // Sync dos logs/CSV, 0 = perfil do cartão SD
+    float deadband[TELEMETRY_QUANTITIES][NUMBER_OF_SENSORS];
+    float setpointMin;          // °C
+    float setpointMax;          // °C
+    uint16_t controlStrategy;   // 0 = histerese, 1 = PI
+    float controlKp;            // Saída por °C
+    float controlKi;            // Saída por °C·s
+    // Alarmes por sensor (LED a piscar e TOPIC_ALARM_PREFIX)
+    float alarmHigh[NUMBER_OF_SENSORS];         // °C
+    float alarmLow[NUMBER_OF_SENSORS];          // °C
+    float alarmHysteresis[NUMBER_OF_SENSORS];   // °C
+    float alarmRate[NUMBER_OF_SENSORS];         // °C/min, 0 = desligado
+    uint16_t alarmDebounce[NUMBER_OF_SENSORS];  // Leituras seguidas
 };
 
 struct sensorData // Structure to hold sensor data
@@ -103,8 +294,20 @@ struct sensorData // Structure to hold sensor data
     float humidityAverageSensors[4];    // Average humidity reading
 };
 
+struct controlData // Estado de controlo alterado por comandos MQTT
+{
+    float tempMin;             // Setpoint mínimo (°C)
+    float tempMax;             // Setpoint máximo (°C)
+    uint32_t sampleIntervalMs; // Intervalo de leitura pedido
+    uint8_t mode;              // MODE_AUTOMATIC | MODE_MANUAL
+    bool emergency;            // Emergência ativa: atuador desligado
+    float manualOutput;        // Saída pedida em modo manual (0..1)
+    uint8_t strategy;          // 0 = histerese, 1 = PI (ControlStrategy)
+};
+
 extern configData config_data;
 extern sensorData sensor_data;
+extern controlData control_data;
 
 // DateTime is now defined in set_rtc.hpp
 
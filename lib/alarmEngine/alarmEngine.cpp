@@ -0,0 +1,161 @@
+// Local Includes
+#include "alarmEngine.hpp"
+
+// Framework libs
+#include <math.h>
+#include <string.h>
+
+static constexpr float US_PER_MINUTE = 60e6f;
+
+AlarmEngine::AlarmEngine()
+{
+  memset(sensors, 0, sizeof(sensors));
+  for (uint8_t i = 0; i < ALARM_MAX_SENSORS; i++)
+  {
+    sensors[i].rule.high = INFINITY;
+    sensors[i].rule.low = -INFINITY;
+  }
+  rateWindowUs = 60000000;
+  handler = nullptr;
+  memset(&stats, 0, sizeof(stats));
+  active = 0;
+}
+
+void AlarmEngine::setRule(uint8_t sensor, const AlarmRule &rule)
+{
+  if (sensor < ALARM_MAX_SENSORS)
+  {
+    sensors[sensor].rule = rule;
+  }
+}
+
+void AlarmEngine::setRateWindow(uint32_t windowUs)
+{
+  rateWindowUs = windowUs > 0 ? windowUs : 1;
+}
+
+void AlarmEngine::setHandler(void (*newHandler)(const AlarmEvent &event))
+{
+  handler = newHandler;
+}
+
+uint8_t AlarmEngine::evaluate(uint8_t sensor, float value, uint32_t sampleUs, uint32_t (*clock)())
+{
+  if (sensor >= ALARM_MAX_SENSORS || isnan(value))
+  {
+    return 0;
+  }
+
+  stats.samples++;
+  Sensor &state = sensors[sensor];
+  const AlarmRule &rule = state.rule;
+  uint8_t changes = 0;
+
+  // Limits: raised past the limit, cleared only hysteresis inside it
+  bool isHigh = state.isActive[ALARM_HIGH] ? value > rule.high - rule.hysteresis : value > rule.high;
+  if (debounce(state, ALARM_HIGH, isHigh != state.isActive[ALARM_HIGH]))
+  {
+    notify(sensor, ALARM_HIGH, isHigh, value, sampleUs, clock);
+    changes++;
+  }
+  bool isLow = state.isActive[ALARM_LOW] ? value < rule.low + rule.hysteresis : value < rule.low;
+  if (debounce(state, ALARM_LOW, isLow != state.isActive[ALARM_LOW]))
+  {
+    notify(sensor, ALARM_LOW, isLow, value, sampleUs, clock);
+    changes++;
+  }
+
+  // Rate: only once the reference is old enough to give a meaningful baseline
+  if (!state.hasReference)
+  {
+    state.referenceValue = value;
+    state.referenceUs = sampleUs;
+    state.hasReference = true;
+    return changes;
+  }
+  uint32_t elapsedUs = sampleUs - state.referenceUs;
+  if (elapsedUs < rateWindowUs / 2)
+  {
+    return changes;
+  }
+  float rate = (value - state.referenceValue) * US_PER_MINUTE / elapsedUs;
+  if (elapsedUs >= rateWindowUs)
+  {
+    state.referenceValue = value;
+    state.referenceUs = sampleUs;
+  }
+  if (rule.rate > 0 || state.isActive[ALARM_RATE])
+  {
+    float limit = state.isActive[ALARM_RATE] ? rule.rate * ALARM_RATE_CLEAR_RATIO : rule.rate;
+    bool isFast = rule.rate > 0 && fabsf(rate) > limit;
+    if (debounce(state, ALARM_RATE, isFast != state.isActive[ALARM_RATE]))
+    {
+      notify(sensor, ALARM_RATE, isFast, rate, sampleUs, clock);
+      changes++;
+    }
+  }
+  return changes;
+}
+
+bool AlarmEngine::isActive(uint8_t sensor, AlarmKind kind) const
+{
+  return sensor < ALARM_MAX_SENSORS && kind < ALARM_KINDS && sensors[sensor].isActive[kind];
+}
+
+uint8_t AlarmEngine::activeCount() const
+{
+  return active;
+}
+
+const AlarmStats &AlarmEngine::getStats() const
+{
+  return stats;
+}
+
+bool AlarmEngine::debounce(Sensor &state, AlarmKind kind, bool isAgainst)
+{
+  if (!isAgainst)
+  {
+    state.pending[kind] = 0; // A sample that agrees restarts the count
+    return false;
+  }
+  uint16_t needed = state.rule.debounce > 0 ? state.rule.debounce : 1;
+  if (++state.pending[kind] < needed)
+  {
+    return false;
+  }
+  state.pending[kind] = 0;
+  state.isActive[kind] = !state.isActive[kind];
+  return true;
+}
+
+void AlarmEngine::notify(uint8_t sensor, AlarmKind kind, bool isActive, float value, uint32_t sampleUs,
+                         uint32_t (*clock)())
+{
+  if (isActive)
+  {
+    active++;
+    stats.raised++;
+  }
+  else
+  {
+    active--;
+    stats.cleared++;
+  }
+
+  if (handler)
+  {
+    AlarmEvent event = {sensor, kind, isActive, value, sampleUs};
+    handler(event);
+  }
+  if (clock)
+  {
+    uint32_t latencyUs = clock() - sampleUs;
+    stats.latencyLastUs = latencyUs;
+    stats.latencySumUs += latencyUs;
+    if (latencyUs > stats.latencyMaxUs)
+    {
+      stats.latencyMaxUs = latencyUs;
+    }
+  }
+}
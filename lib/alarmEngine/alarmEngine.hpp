@@ -0,0 +1,152 @@
+#ifndef ALARMENGINE_HPP
+#define ALARMENGINE_HPP
+
+// Framework libs
+#include <stdint.h>
+
+// Sensors tracked by one engine
+static constexpr uint8_t ALARM_MAX_SENSORS = 8;
+
+// The rate alarm clears once |rate| falls below this fraction of the trigger
+static constexpr float ALARM_RATE_CLEAR_RATIO = 0.5f;
+
+enum AlarmKind : uint8_t
+{
+  ALARM_HIGH, // Above the high threshold
+  ALARM_LOW,  // Below the low threshold
+  ALARM_RATE, // Rising or falling faster than the rate trigger
+  ALARM_KINDS
+};
+
+/// AlarmRule
+/// @brief Limits of one sensor
+///
+struct AlarmRule
+{
+  float high;        // Raised above this value
+  float low;         // Raised below this value
+  float hysteresis;  // High/low clear once back inside the limit by this much
+  float rate;        // |change per minute| that raises the rate alarm, 0 disables it
+  uint16_t debounce; // Consecutive samples needed to raise or clear (0 counts as 1)
+};
+
+/// AlarmEvent
+/// @brief State change passed to the handler
+///
+struct AlarmEvent
+{
+  uint8_t sensor;    // Sensor index
+  AlarmKind kind;
+  bool isActive;     // Raised (true) or cleared (false)
+  float value;       // Sample that changed the state (change per minute for ALARM_RATE)
+  uint32_t sampleUs; // Time of that sample
+};
+
+/// Counters and sample-to-handler latency
+struct AlarmStats
+{
+  uint32_t samples;       // Samples evaluated (NaN excluded)
+  uint32_t raised;
+  uint32_t cleared;
+  uint32_t latencyLastUs; // Sample time to the end of the last handler call
+  uint32_t latencyMaxUs;
+  uint32_t latencySumUs;  // Over events, average is latencySumUs / (raised + cleared)
+};
+
+/// AlarmEngine
+/// @brief Threshold alarms evaluated on every raw sample: high and low
+/// limits with hysteresis, a rate-of-change trigger and a debounce count
+/// per sensor. A state change calls the handler at once, from the context
+/// of evaluate(). Times are in microseconds; the caller passes the clock
+/// so the engine has no Arduino dependencies and runs on the host as is.
+///
+class AlarmEngine
+{
+public:
+  /// AlarmEngine
+  /// @brief Class constructor, every sensor starts with no alarm raised
+  ///        and rules that never fire
+  ///
+  /// @param[in] none
+  ///
+  /// @return none
+  ///
+  AlarmEngine();
+
+  /// setRule
+  /// @brief Limits of a sensor, its current state is kept
+  ///
+  /// @param[in] sensor: Sensor index (< ALARM_MAX_SENSORS)
+  /// @param[in] rule: Limits
+  ///
+  /// @return none
+  ///
+  void setRule(uint8_t sensor, const AlarmRule &rule);
+
+  /// setRateWindow
+  /// @brief Baseline of the rate of change. The rate is the change since a
+  ///        reference sample between half and one window old; shorter
+  ///        baselines only measure the sensor resolution.
+  ///
+  /// @param[in] windowUs: Window in microseconds
+  ///
+  /// @return none
+  ///
+  void setRateWindow(uint32_t windowUs);
+
+  /// setHandler
+  /// @brief Function called on each raise and clear
+  ///
+  /// @param[in] handler: Function to call, nullptr to disable
+  ///
+  /// @return none
+  ///
+  void setHandler(void (*handler)(const AlarmEvent &event));
+
+  /// evaluate
+  /// @brief Updates the alarms of a sensor with a raw sample
+  ///
+  /// @param[in] sensor: Sensor index
+  /// @param[in] value: Sample (NaN is ignored and leaves the state as is)
+  /// @param[in] sampleUs: Time the sample was taken
+  /// @param[in] clock: Current time source, for the latency (nullptr skips it)
+  ///
+  /// @return Number of state changes
+  ///
+  uint8_t evaluate(uint8_t sensor, float value, uint32_t sampleUs, uint32_t (*clock)() = nullptr);
+
+  /// isActive
+  /// @brief Whether an alarm of a sensor is raised
+  bool isActive(uint8_t sensor, AlarmKind kind) const;
+
+  /// activeCount
+  /// @brief Number of alarms raised, all sensors
+  uint8_t activeCount() const;
+
+  /// getStats
+  /// @brief Counters since boot
+  const AlarmStats &getStats() const;
+
+private:
+  struct Sensor
+  {
+    AlarmRule rule;
+    float referenceValue;         // Rate baseline
+    uint32_t referenceUs;
+    bool hasReference;
+    bool isActive[ALARM_KINDS];
+    uint16_t pending[ALARM_KINDS]; // Consecutive samples against the current state
+  };
+
+  bool debounce(Sensor &state, AlarmKind kind, bool isAgainst);
+  void notify(uint8_t sensor, AlarmKind kind, bool isActive, float value, uint32_t sampleUs,
+              uint32_t (*clock)());
+
+  Sensor sensors[ALARM_MAX_SENSORS];
+  uint32_t rateWindowUs;
+  void (*handler)(const AlarmEvent &event);
+  AlarmStats stats;
+  uint8_t active;
+};
+
+#endif // ALARMENGINE_HPP
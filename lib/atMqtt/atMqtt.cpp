@@ -0,0 +1,423 @@
+// Local Includes
+#include "atMqtt.hpp"
+
+// Link id of the modem's MQTT client (ESP-AT supports only 0)
+#define AT_MQTT_LINK "0"
+
+static bool startsWith(const char *text, const char *prefix)
+{
+  return strncmp(text, prefix, strlen(prefix)) == 0;
+}
+
+AtMqttClient::AtMqttClient(Stream &serial) : serial(serial)
+{
+  host = nullptr;
+  port = 1883;
+  socketTimeout = 15;
+  callback = nullptr;
+  ackHandler = nullptr;
+  isConnected = false;
+  mqttState = AT_MQTT_DISCONNECTED;
+  response = RESPONSE_NONE;
+  publishResponse = RESPONSE_NONE;
+  isPromptSeen = false;
+  lineLength = 0;
+  commas = 0;
+  isQuoted = false;
+  isRawData = false;
+  dataRemaining = 0;
+  topic[0] = '\0';
+  payloadLength = 0;
+  pendingCount = 0;
+  memset(&stats, 0, sizeof(stats));
+}
+
+AtMqttClient &AtMqttClient::setServer(const char *host, uint16_t port)
+{
+  this->host = host;
+  this->port = port;
+  return *this;
+}
+
+AtMqttClient &AtMqttClient::setCallback(void (*callback)(char *, uint8_t *, unsigned int))
+{
+  this->callback = callback;
+  return *this;
+}
+
+AtMqttClient &AtMqttClient::setSocketTimeout(uint16_t timeout)
+{
+  socketTimeout = timeout;
+  return *this;
+}
+
+void AtMqttClient::setAckHandler(void (*handler)(uint16_t packetId))
+{
+  ackHandler = handler;
+}
+
+bool AtMqttClient::connect(const char *id)
+{
+  if (host == nullptr)
+  {
+    return false;
+  }
+
+  // A previous session may still hold the link
+  beginCommand("AT+MQTTCLEAN=" AT_MQTT_LINK "\r\n");
+  await(response, AT_MQTT_COMMAND_TIMEOUT);
+  isConnected = false;
+  pendingCount = 0;
+
+  // Scheme 1 (TCP), no user/password/path
+  beginCommand("AT+MQTTUSERCFG=" AT_MQTT_LINK ",1,");
+  sendQuoted(id);
+  send(",\"\",\"\",0,0,\"\"\r\n");
+  if (!await(response, AT_MQTT_COMMAND_TIMEOUT))
+  {
+    mqttState = AT_MQTT_CONNECT_FAILED;
+    return false;
+  }
+
+  // Keepalive answered by the modem, clean session, no last will
+  beginCommand("AT+MQTTCONNCFG=" AT_MQTT_LINK ",");
+  sendUInt(AT_MQTT_KEEPALIVE);
+  send(",1,\"\",\"\",0,0\r\n");
+  if (!await(response, AT_MQTT_COMMAND_TIMEOUT))
+  {
+    mqttState = AT_MQTT_CONNECT_FAILED;
+    return false;
+  }
+
+  // No automatic reconnection, ConnectionManager owns the retry policy
+  beginCommand("AT+MQTTCONN=" AT_MQTT_LINK ",");
+  sendQuoted(host);
+  send(",");
+  sendUInt(port);
+  send(",0\r\n");
+  bool isAnswered = await(response, (uint32_t)socketTimeout * 1000 + AT_MQTT_COMMAND_TIMEOUT);
+
+  if (isAnswered && isConnected)
+  {
+    mqttState = AT_MQTT_CONNECTED;
+    return true;
+  }
+  mqttState = response == RESPONSE_NONE ? AT_MQTT_CONNECTION_TIMEOUT : AT_MQTT_CONNECT_FAILED;
+  isConnected = false;
+  return false;
+}
+
+void AtMqttClient::disconnect()
+{
+  beginCommand("AT+MQTTCLEAN=" AT_MQTT_LINK "\r\n");
+  await(response, AT_MQTT_COMMAND_TIMEOUT);
+  isConnected = false;
+  mqttState = AT_MQTT_DISCONNECTED;
+  pendingCount = 0;
+}
+
+bool AtMqttClient::publish(const char *topic, const uint8_t *payload, unsigned int length, bool retained,
+                           uint8_t qos, uint16_t packetId)
+{
+  if (!isConnected || (qos > 0 && pendingCount == AT_MQTT_PENDING_ACKS))
+  {
+    return false;
+  }
+
+  // The modem answers OK, then '>' and waits for exactly length bytes
+  beginCommand("AT+MQTTPUBRAW=" AT_MQTT_LINK ",");
+  sendQuoted(topic);
+  send(",");
+  sendUInt(length);
+  send(qos > 0 ? ",1," : ",0,");
+  send(retained ? "1\r\n" : "0\r\n");
+  if (!awaitPrompt(AT_MQTT_COMMAND_TIMEOUT))
+  {
+    return false;
+  }
+
+  publishResponse = RESPONSE_NONE;
+  stats.txBytes += serial.write(payload, length);
+  if (!await(publishResponse, AT_MQTT_COMMAND_TIMEOUT))
+  {
+    return false;
+  }
+
+  stats.published++;
+  if (qos > 0)
+  {
+    pendingAcks[pendingCount++] = packetId;
+  }
+  return true;
+}
+
+bool AtMqttClient::publish(const char *topic, const char *payload)
+{
+  return publish(topic, (const uint8_t *)payload, strlen(payload), false);
+}
+
+bool AtMqttClient::subscribe(const char *topic, uint8_t qos)
+{
+  if (!isConnected)
+  {
+    return false;
+  }
+
+  beginCommand("AT+MQTTSUB=" AT_MQTT_LINK ",");
+  sendQuoted(topic);
+  send(qos > 0 ? ",1\r\n" : ",0\r\n");
+  return await(response, AT_MQTT_COMMAND_TIMEOUT);
+}
+
+bool AtMqttClient::loop()
+{
+  poll();
+
+  // Reported here rather than in publish(), so the caller has already
+  // marked the message as in flight when its id comes back
+  for (uint8_t i = 0; i < pendingCount; i++)
+  {
+    if (ackHandler)
+    {
+      ackHandler(pendingAcks[i]);
+    }
+  }
+  pendingCount = 0;
+
+  return isConnected;
+}
+
+bool AtMqttClient::connected()
+{
+  return isConnected;
+}
+
+int AtMqttClient::state()
+{
+  return mqttState;
+}
+
+const AtMqttStats &AtMqttClient::getStats() const
+{
+  return stats;
+}
+
+void AtMqttClient::beginCommand(const char *command)
+{
+  poll(); // URCs already waiting belong to no command
+  response = RESPONSE_NONE;
+  isPromptSeen = false;
+  stats.commands++;
+  send(command);
+}
+
+void AtMqttClient::send(const char *text)
+{
+  stats.txBytes += serial.write((const uint8_t *)text, strlen(text));
+}
+
+void AtMqttClient::sendQuoted(const char *text)
+{
+  // ESP-AT string parameters escape '"', ',' and '\' with a backslash
+  stats.txBytes += serial.write('"');
+  for (const char *c = text; *c; c++)
+  {
+    if (*c == '"' || *c == ',' || *c == '\\')
+    {
+      stats.txBytes += serial.write('\\');
+    }
+    stats.txBytes += serial.write((uint8_t)*c);
+  }
+  stats.txBytes += serial.write('"');
+}
+
+void AtMqttClient::sendUInt(uint32_t value)
+{
+  char digits[11];
+  snprintf(digits, sizeof(digits), "%lu", (unsigned long)value);
+  send(digits);
+}
+
+bool AtMqttClient::await(const Response &result, uint32_t timeoutMs)
+{
+  unsigned long start = millis();
+  while (result == RESPONSE_NONE && response != RESPONSE_ERROR)
+  {
+    if (millis() - start >= timeoutMs)
+    {
+      stats.failures++;
+      return false;
+    }
+    poll();
+    yield();
+  }
+
+  if (result != RESPONSE_OK)
+  {
+    stats.failures++;
+    return false;
+  }
+  return true;
+}
+
+bool AtMqttClient::awaitPrompt(uint32_t timeoutMs)
+{
+  unsigned long start = millis();
+  while (!isPromptSeen)
+  {
+    if (response == RESPONSE_ERROR || millis() - start >= timeoutMs)
+    {
+      stats.failures++;
+      return false;
+    }
+    poll();
+    yield();
+  }
+  return true;
+}
+
+void AtMqttClient::poll()
+{
+  while (serial.available() > 0)
+  {
+    int c = serial.read();
+    if (c < 0)
+    {
+      break;
+    }
+    stats.rxBytes++;
+    pollByte((uint8_t)c);
+  }
+}
+
+void AtMqttClient::pollByte(uint8_t c)
+{
+  if (isRawData)
+  {
+    if (payloadLength < sizeof(payload))
+    {
+      payload[payloadLength++] = c;
+    }
+    if (--dataRemaining == 0)
+    {
+      deliverMessage();
+    }
+    return;
+  }
+
+  if (c == '\n')
+  {
+    line[lineLength] = '\0';
+    if (lineLength > 0)
+    {
+      handleLine();
+    }
+    lineLength = 0;
+    commas = 0;
+    isQuoted = false;
+    return;
+  }
+  if (c == '\r')
+  {
+    return;
+  }
+  if (c == '>' && lineLength == 0)
+  {
+    isPromptSeen = true; // The prompt has no line ending
+    return;
+  }
+
+  if (lineLength < sizeof(line) - 1)
+  {
+    line[lineLength++] = (char)c;
+  }
+
+  // +MQTTSUBRECV:<link>,"<topic>",<length>,<data>: the data is raw and may
+  // contain line endings, so switch to counting bytes after the 3rd comma
+  if (c == '"')
+  {
+    isQuoted = !isQuoted;
+  }
+  else if (c == ',' && !isQuoted && ++commas == 3)
+  {
+    line[lineLength] = '\0';
+    if (startsWith(line, "+MQTTSUBRECV:"))
+    {
+      beginMessage();
+    }
+  }
+}
+
+void AtMqttClient::handleLine()
+{
+  if (strcmp(line, "OK") == 0)
+  {
+    response = RESPONSE_OK;
+  }
+  else if (strcmp(line, "ERROR") == 0 || strcmp(line, "FAIL") == 0)
+  {
+    response = RESPONSE_ERROR;
+  }
+  else if (startsWith(line, "+MQTTPUB:"))
+  {
+    publishResponse = strcmp(line + 9, "OK") == 0 ? RESPONSE_OK : RESPONSE_ERROR;
+  }
+  else if (startsWith(line, "+MQTTCONNECTED:"))
+  {
+    isConnected = true;
+  }
+  else if (startsWith(line, "+MQTTDISCONNECTED:"))
+  {
+    if (isConnected)
+    {
+      mqttState = AT_MQTT_CONNECTION_LOST;
+    }
+    isConnected = false;
+    pendingCount = 0; // Not handed over, the queue retransmits after reconnect
+  }
+}
+
+void AtMqttClient::beginMessage()
+{
+  // line holds +MQTTSUBRECV:0,"topic",length,
+  const char *start = strchr(line, '"');
+  const char *end = start ? strrchr(line, '"') : nullptr;
+  if (!start || end == start)
+  {
+    lineLength = 0;
+    return;
+  }
+
+  size_t length = end - start - 1;
+  if (length >= sizeof(topic))
+  {
+    length = sizeof(topic) - 1;
+  }
+  memcpy(topic, start + 1, length);
+  topic[length] = '\0';
+
+  dataRemaining = strtoul(end + 2, nullptr, 10);
+  payloadLength = 0;
+  lineLength = 0;
+  commas = 0;
+  isRawData = dataRemaining > 0;
+  if (!isRawData)
+  {
+    deliverMessage();
+  }
+}
+
+void AtMqttClient::deliverMessage()
+{
+  isRawData = false;
+  stats.received++;
+  if (callback)
+  {
+    // Null-terminated for handlers that parse text, length excludes it
+    if (payloadLength < sizeof(payload))
+    {
+      payload[payloadLength] = '\0';
+    }
+    callback(topic, payload, payloadLength);
+  }
+}
@@ -0,0 +1,233 @@
+#ifndef ATMQTT_HPP
+#define ATMQTT_HPP
+
+// Framework libs
+#include <Arduino.h>
+#include <Stream.h>
+
+// Buffers of the AT reader (the ESP-AT MQTT client keeps its own)
+static constexpr uint8_t AT_MQTT_LINE_SIZE = 96;       // Response or URC line
+static constexpr uint8_t AT_MQTT_TOPIC_SIZE = 64;      // Topic of a received message
+static constexpr uint8_t AT_MQTT_PAYLOAD_SIZE = 128;   // Payload of a received message
+static constexpr uint8_t AT_MQTT_PENDING_ACKS = 8;     // QoS1 ids waiting to be reported
+static constexpr uint16_t AT_MQTT_KEEPALIVE = 15;      // Keepalive kept by the modem (s)
+static constexpr uint32_t AT_MQTT_COMMAND_TIMEOUT = 1000; // Wait for OK/ERROR (ms)
+
+// Same codes as PubSubClient::state()
+static constexpr int AT_MQTT_CONNECTION_TIMEOUT = -4;
+static constexpr int AT_MQTT_CONNECTION_LOST = -3;
+static constexpr int AT_MQTT_CONNECT_FAILED = -2;
+static constexpr int AT_MQTT_DISCONNECTED = -1;
+static constexpr int AT_MQTT_CONNECTED = 0;
+
+/// Traffic counters of the AT link, used for the bytes/message comparison
+struct AtMqttStats
+{
+  uint32_t commands;  // AT commands sent
+  uint32_t txBytes;   // Bytes written to the modem
+  uint32_t rxBytes;   // Bytes read from the modem
+  uint32_t published; // Publications accepted by the modem
+  uint32_t received;  // +MQTTSUBRECV messages delivered
+  uint32_t failures;  // Commands answered with ERROR/FAIL or timed out
+};
+
+/// AtMqttClient
+/// @brief MQTT client that hands the protocol to the ESP-AT firmware
+/// (AT+MQTTCONN, AT+MQTTPUBRAW, AT+MQTTSUB): the modem owns framing,
+/// keepalives and the QoS1 session, the STM32 only sends topic and payload.
+/// Offers the subset of the PubSubClient API used by the firmware so the
+/// transport is chosen at build time with MQTT_TRANSPORT.
+///
+class AtMqttClient
+{
+public:
+  /// AtMqttClient
+  /// @brief Class constructor
+  ///
+  /// @param[in] serial: Port connected to the ESP-AT modem
+  ///
+  /// @return none
+  ///
+  AtMqttClient(Stream &serial);
+
+  /// setServer
+  /// @brief Broker address used by connect()
+  ///
+  /// @param[in] host: Host name or dotted IP (kept by pointer)
+  /// @param[in] port: TCP port
+  ///
+  /// @return reference to this client
+  ///
+  AtMqttClient &setServer(const char *host, uint16_t port);
+
+  /// setCallback
+  /// @brief Function called for each message received on a subscription
+  ///
+  /// @param[in] callback: Function receiving topic, payload and length
+  ///
+  /// @return reference to this client
+  ///
+  AtMqttClient &setCallback(void (*callback)(char *, uint8_t *, unsigned int));
+
+  /// setSocketTimeout
+  /// @brief Maximum wait for the broker in connect()
+  ///
+  /// @param[in] timeout: Timeout in seconds
+  ///
+  /// @return reference to this client
+  ///
+  AtMqttClient &setSocketTimeout(uint16_t timeout);
+
+  /// setAckHandler
+  /// @brief Function called with the packet id of each QoS1 publication
+  ///        the modem has taken over, from loop()
+  ///
+  /// @param[in] handler: Function to call, nullptr to disable
+  ///
+  /// @return none
+  ///
+  void setAckHandler(void (*handler)(uint16_t packetId));
+
+  /// connect
+  /// @brief Configures the modem's MQTT client and opens the session
+  ///
+  /// @param[in] id: Client identifier
+  ///
+  /// @return true if the broker accepted the connection
+  ///
+  bool connect(const char *id);
+
+  /// disconnect
+  /// @brief Closes the session and releases the modem's MQTT link
+  ///
+  /// @param none
+  ///
+  /// @return none
+  ///
+  void disconnect();
+
+  /// publish
+  /// @brief Publishes a message through AT+MQTTPUBRAW (binary safe)
+  ///
+  /// @param[in] topic: Topic
+  /// @param[in] payload: Payload bytes
+  /// @param[in] length: Payload length
+  /// @param[in] retained: Retain flag
+  /// @param[in] qos: 0 or 1, QoS1 is retransmitted by the modem
+  /// @param[in] packetId: Id reported to the ack handler for QoS1
+  ///
+  /// @return true if the modem accepted the publication
+  ///
+  bool publish(const char *topic, const uint8_t *payload, unsigned int length, bool retained,
+               uint8_t qos = 0, uint16_t packetId = 0);
+
+  /// publish
+  /// @brief Publishes a text message at QoS0
+  ///
+  /// @param[in] topic: Topic
+  /// @param[in] payload: Null-terminated payload
+  ///
+  /// @return true if the modem accepted the publication
+  ///
+  bool publish(const char *topic, const char *payload);
+
+  /// subscribe
+  /// @brief Subscribes a topic, messages arrive through the callback
+  ///
+  /// @param[in] topic: Topic filter
+  /// @param[in] qos: Requested QoS (0 or 1)
+  ///
+  /// @return true if the modem answered OK
+  ///
+  bool subscribe(const char *topic, uint8_t qos = 0);
+
+  /// loop
+  /// @brief Reads pending URCs (messages, disconnections) without blocking
+  ///        and reports QoS1 hand-overs. Call from loop().
+  ///
+  /// @param none
+  ///
+  /// @return true while connected
+  ///
+  bool loop();
+
+  /// connected
+  /// @brief Session state as last reported by the modem
+  ///
+  /// @param none
+  ///
+  /// @return true while connected
+  ///
+  bool connected();
+
+  /// state
+  /// @brief Last connection result, same codes as PubSubClient::state()
+  ///
+  /// @param none
+  ///
+  /// @return state code
+  ///
+  int state();
+
+  /// getStats
+  /// @brief Traffic counters of the AT link
+  ///
+  /// @param none
+  ///
+  /// @return reference to the counters
+  ///
+  const AtMqttStats &getStats() const;
+
+private:
+  enum Response : uint8_t
+  {
+    RESPONSE_NONE,
+    RESPONSE_OK,
+    RESPONSE_ERROR
+  };
+
+  // Private methods
+  void beginCommand(const char *command);
+  void send(const char *text);
+  void sendQuoted(const char *text);
+  void sendUInt(uint32_t value);
+  bool await(const Response &result, uint32_t timeoutMs);
+  bool awaitPrompt(uint32_t timeoutMs);
+  void poll();
+  void pollByte(uint8_t c);
+  void handleLine();
+  void beginMessage();
+  void deliverMessage();
+
+  // Private attributes
+  Stream &serial;
+  const char *host;
+  uint16_t port;
+  uint16_t socketTimeout;
+  void (*callback)(char *, uint8_t *, unsigned int);
+  void (*ackHandler)(uint16_t packetId);
+  bool isConnected;
+  int mqttState;
+  Response response;                 // Final result of the current command
+  Response publishResponse;          // +MQTTPUB:OK / +MQTTPUB:FAIL
+  bool isPromptSeen;                 // '>' before raw data
+
+  // Reader
+  char line[AT_MQTT_LINE_SIZE];
+  uint8_t lineLength;
+  uint8_t commas;     // Commas outside quotes in a +MQTTSUBRECV header
+  bool isQuoted;
+  bool isRawData;     // Reading the payload of +MQTTSUBRECV
+  uint32_t dataRemaining;
+  char topic[AT_MQTT_TOPIC_SIZE];
+  uint8_t payload[AT_MQTT_PAYLOAD_SIZE];
+  unsigned int payloadLength;
+
+  // QoS1 hand-overs reported from loop()
+  uint16_t pendingAcks[AT_MQTT_PENDING_ACKS];
+  uint8_t pendingCount;
+
+  AtMqttStats stats;
+};
+
+#endif // ATMQTT_HPP
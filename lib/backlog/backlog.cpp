@@ -0,0 +1,179 @@
+// Local Includes
+#include "backlog.hpp"
+#include "logs.hpp"
+
+// The cursor is stored next to its complement so that a torn or stale write
+// is detected and replay restarts from the beginning of the segment
+static constexpr uint32_t CURSOR_CHECK = 0xA5A5A5A5;
+
+Backlog::Backlog()
+{
+  readOffset = 0;
+  writeOffset = 0;
+  droppedRecords = 0;
+  isReady = false;
+}
+
+bool Backlog::init()
+{
+  isReady = false;
+
+  if (!segmentFile.open(BACKLOG_FILENAME, O_RDWR | O_CREAT))
+  {
+    logs.error("Backlog: falha ao abrir segmento!");
+    return false;
+  }
+
+  // Ignore a partially written record left by a power loss
+  writeOffset = segmentFile.fileSize() - (segmentFile.fileSize() % sizeof(TelemetryRecord));
+  segmentFile.close();
+
+  if (!loadCursor() || readOffset > writeOffset)
+  {
+    readOffset = 0;
+  }
+
+  isReady = true;
+
+  if (pending() > 0)
+  {
+    char msg[60];
+    snprintf(msg, sizeof(msg), "Backlog: %lu registos por enviar", (unsigned long)pending());
+    logs.info(msg);
+  }
+  return true;
+}
+
+bool Backlog::push(const TelemetryRecord &record)
+{
+  if (!isReady)
+  {
+    return false;
+  }
+
+  if (writeOffset + sizeof(TelemetryRecord) > BACKLOG_MAX_SIZE)
+  {
+    droppedRecords++;
+    return false;
+  }
+
+  if (!segmentFile.open(BACKLOG_FILENAME, O_RDWR | O_CREAT))
+  {
+    droppedRecords++;
+    return false;
+  }
+
+  segmentFile.seekSet(writeOffset);
+  bool isWritten = segmentFile.write(&record, sizeof(record)) == sizeof(record);
+  segmentFile.close();
+
+  if (!isWritten)
+  {
+    droppedRecords++;
+    return false;
+  }
+
+  writeOffset += sizeof(TelemetryRecord);
+  return true;
+}
+
+uint16_t Backlog::replay(uint16_t maxRecords, BacklogPublisher publish)
+{
+  if (!isReady || readOffset >= writeOffset || maxRecords == 0)
+  {
+    return 0;
+  }
+
+  if (!segmentFile.open(BACKLOG_FILENAME, O_RDONLY))
+  {
+    return 0;
+  }
+
+  segmentFile.seekSet(readOffset);
+
+  uint16_t sent = 0;
+  TelemetryRecord record;
+  while (sent < maxRecords && readOffset < writeOffset)
+  {
+    if (segmentFile.read(&record, sizeof(record)) != sizeof(record))
+    {
+      break;
+    }
+    if (!publish(record))
+    {
+      break;
+    }
+    readOffset += sizeof(TelemetryRecord);
+    sent++;
+  }
+
+  segmentFile.close();
+
+  if (readOffset >= writeOffset)
+  {
+    // Everything was delivered, start a fresh segment
+    reset();
+    logs.info("Backlog: reposição concluída");
+  }
+  else if (sent > 0)
+  {
+    saveCursor();
+  }
+
+  return sent;
+}
+
+uint32_t Backlog::pending() const
+{
+  return (writeOffset - readOffset) / sizeof(TelemetryRecord);
+}
+
+uint32_t Backlog::dropped() const
+{
+  return droppedRecords;
+}
+
+bool Backlog::loadCursor()
+{
+  if (!cursorFile.open(BACKLOG_CURSOR_FILENAME, O_RDONLY))
+  {
+    return false;
+  }
+
+  uint32_t stored[2];
+  bool isValid = cursorFile.read(stored, sizeof(stored)) == sizeof(stored) &&
+                 (stored[0] ^ CURSOR_CHECK) == stored[1] &&
+                 stored[0] % sizeof(TelemetryRecord) == 0;
+  cursorFile.close();
+
+  if (isValid)
+  {
+    readOffset = stored[0];
+  }
+  return isValid;
+}
+
+bool Backlog::saveCursor()
+{
+  if (!cursorFile.open(BACKLOG_CURSOR_FILENAME, O_WRONLY | O_CREAT | O_TRUNC))
+  {
+    return false;
+  }
+
+  uint32_t stored[2] = {readOffset, readOffset ^ CURSOR_CHECK};
+  bool isWritten = cursorFile.write(stored, sizeof(stored)) == sizeof(stored);
+  cursorFile.close();
+  return isWritten;
+}
+
+void Backlog::reset()
+{
+  if (segmentFile.open(BACKLOG_FILENAME, O_RDWR))
+  {
+    segmentFile.truncate(0);
+    segmentFile.close();
+  }
+  readOffset = 0;
+  writeOffset = 0;
+  saveCursor();
+}
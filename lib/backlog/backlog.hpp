@@ -0,0 +1,108 @@
+#ifndef BACKLOG_HPP
+#define BACKLOG_HPP
+
+// Framework libs
+#include <SdFat.h>
+
+// Local Includes
+#include <config.hpp>
+
+/// TelemetryRecord
+/// @brief Compact fixed-size telemetry sample kept on the SD card while
+/// the link to the broker is down
+///
+struct TelemetryRecord
+{
+  uint32_t timestamp; // RTC epoch (s) at sample time; millis() if !IS_RTC_ENABLED
+  uint8_t sensor;     // Sensor number (1..NUMBER_OF_SENSORS)
+  uint8_t quantity;   // TELEMETRY_TEMPERATURE (index into the deadband tables)
+  int16_t value;      // Value in hundredths (2345 = 23.45)
+};
+
+static_assert(sizeof(TelemetryRecord) == 8, "TelemetryRecord must stay 8 bytes on disk");
+
+/// Callback used to publish one replayed record, returns false if the
+/// record could not be sent (replay stops and retries it later)
+typedef bool (*BacklogPublisher)(const TelemetryRecord &record);
+
+/// Backlog
+/// @brief Store-and-forward queue of unsent telemetry. Records are appended
+/// to a segment file while offline and replayed oldest-first after reconnect.
+/// The read cursor is persisted so replay resumes after a reboot.
+///
+class Backlog
+{
+public:
+  /// Backlog
+  /// @brief Class constructor
+  ///
+  /// @param[in] none
+  ///
+  /// @return none
+  ///
+  Backlog();
+
+  /// init
+  /// @brief Recovers the segment size and the persisted replay cursor.
+  ///        Must be called after the SD card is mounted.
+  ///
+  /// @param none
+  ///
+  /// @return true or false in case of success/fail
+  ///
+  bool init();
+
+  /// push
+  /// @brief Appends a record to the end of the segment
+  ///
+  /// @param[in] record: Record to store
+  ///
+  /// @return true or false if the record was stored/dropped
+  ///
+  bool push(const TelemetryRecord &record);
+
+  /// replay
+  /// @brief Sends up to maxRecords of the oldest pending records and
+  ///        persists the cursor once for the whole batch
+  ///
+  /// @param[in] maxRecords: Maximum records to send in this call
+  /// @param[in] publish: Function that sends one record
+  ///
+  /// @return number of records sent
+  ///
+  uint16_t replay(uint16_t maxRecords, BacklogPublisher publish);
+
+  /// pending
+  /// @brief Number of records still waiting to be replayed
+  ///
+  /// @param none
+  ///
+  /// @return pending record count
+  ///
+  uint32_t pending() const;
+
+  /// dropped
+  /// @brief Number of records lost because the segment was full
+  ///
+  /// @param none
+  ///
+  /// @return dropped record count
+  ///
+  uint32_t dropped() const;
+
+private:
+  // Private methods
+  bool loadCursor();
+  bool saveCursor();
+  void reset();
+
+  // Private attributes
+  SdFile segmentFile;
+  SdFile cursorFile;
+  uint32_t readOffset;  // Offset of the oldest unsent record
+  uint32_t writeOffset; // Offset where the next record is appended
+  uint32_t droppedRecords;
+  bool isReady;
+};
+
+#endif // BACKLOG_HPP
@@ -0,0 +1,49 @@
+// Local Includes
+#include "bootTimeline.hpp"
+
+BootTimeline bootTimeline;
+
+BootTimeline::BootTimeline()
+{
+  stages = 0;
+  lastUs = 0;
+}
+
+void BootTimeline::begin()
+{
+  stages = 0;
+  lastUs = 0; // micros() counts from reset
+  mark("reset");
+}
+
+void BootTimeline::mark(const char *stage)
+{
+  uint32_t now = micros();
+  if (stages < BOOT_MAX_STAGES)
+  {
+    names[stages] = stage;
+    durationsUs[stages] = now - lastUs;
+    stages++;
+  }
+  lastUs = now;
+}
+
+uint8_t BootTimeline::getStages() const
+{
+  return stages;
+}
+
+const char *BootTimeline::getName(uint8_t stage) const
+{
+  return stage < stages ? names[stage] : "";
+}
+
+uint32_t BootTimeline::getMs(uint8_t stage) const
+{
+  return stage < stages ? (durationsUs[stage] + 500) / 1000 : 0;
+}
+
+uint32_t BootTimeline::getTotalMs() const
+{
+  return (lastUs + 500) / 1000;
+}
@@ -0,0 +1,62 @@
+#ifndef BOOTTIMELINE_HPP
+#define BOOTTIMELINE_HPP
+
+// Framework libs
+#include <Arduino.h>
+
+static constexpr uint8_t BOOT_MAX_STAGES = 10;
+
+/// BootTimeline
+/// @brief Duration of each stage of setup(), for the boot-time breakdown.
+/// The first stage, "reset", is the time from reset to setup() (clocks,
+/// static constructors).
+///
+class BootTimeline
+{
+public:
+  /// BootTimeline
+  /// @brief Class constructor
+  ///
+  /// @param[in] none
+  ///
+  /// @return none
+  ///
+  BootTimeline();
+
+  /// begin
+  /// @brief Starts the timeline; call first thing in setup()
+  ///
+  /// @param none
+  ///
+  /// @return none
+  ///
+  void begin();
+
+  /// mark
+  /// @brief Closes the stage that just ended
+  ///
+  /// @param[in] stage: Name of the stage (string literal, kept by pointer)
+  ///
+  /// @return none
+  ///
+  void mark(const char *stage);
+
+  /// Recorded stages, in order
+  uint8_t getStages() const;
+  const char *getName(uint8_t stage) const;
+  uint32_t getMs(uint8_t stage) const;
+
+  /// getTotalMs
+  /// @brief Time from reset to the last mark
+  uint32_t getTotalMs() const;
+
+private:
+  const char *names[BOOT_MAX_STAGES];
+  uint32_t durationsUs[BOOT_MAX_STAGES];
+  uint8_t stages;
+  uint32_t lastUs;
+};
+
+extern BootTimeline bootTimeline;
+
+#endif // BOOTTIMELINE_HPP
@@ -0,0 +1,138 @@
+// Local Includes
+#include "buttonInput.hpp"
+
+// Framework libs
+#include <Arduino.h>
+#include <string.h>
+
+ButtonDebouncer::ButtonDebouncer()
+{
+  memset(buttons, 0, sizeof(buttons));
+  debounceMs = 50;
+  longPressMs = 2000;
+  memset(&stats, 0, sizeof(stats));
+}
+
+void ButtonDebouncer::configure(uint32_t newDebounceMs, uint32_t newLongPressMs)
+{
+  debounceMs = newDebounceMs;
+  longPressMs = newLongPressMs;
+}
+
+void ButtonDebouncer::edge(uint8_t button, uint32_t nowMs)
+{
+  if (button >= BUTTON_MAX)
+  {
+    return;
+  }
+  Button &state = buttons[button];
+  if (!state.isSettling)
+  {
+    state.firstEdgeMs = nowMs; // Start of a burst: the real press or release time
+    state.isSettling = true;
+  }
+  state.lastEdgeMs = nowMs;
+  stats.edges++;
+}
+
+bool ButtonDebouncer::tick(uint32_t nowMs, uint8_t pressedMask)
+{
+  bool isNeeded = false;
+  for (uint8_t i = 0; i < BUTTON_MAX; i++)
+  {
+    Button &state = buttons[i];
+
+    // Level trusted only after debounceMs without edges. edge() pre-empts
+    // this interrupt, so the burst is taken and closed with it masked; an
+    // edge newer than nowMs (after the level was read) is still settling
+    noInterrupts();
+    bool isSettled = state.isSettling && (int32_t)(nowMs - state.lastEdgeMs) >= (int32_t)debounceMs;
+    uint32_t firstEdgeMs = state.firstEdgeMs;
+    if (isSettled)
+    {
+      state.isSettling = false;
+    }
+    interrupts();
+
+    if (isSettled)
+    {
+      bool isPressed = (pressedMask >> i) & 1;
+      if (isPressed == state.isPressed)
+      {
+        stats.glitches++; // Bounced back: nothing happened
+      }
+      else if (isPressed)
+      {
+        state.isPressed = true;
+        state.pressedMs = firstEdgeMs;
+        state.isLongSent = false;
+      }
+      else
+      {
+        state.isPressed = false;
+        if (!state.isLongSent)
+        {
+          push(i, BUTTON_SHORT_PRESS, state.pressedMs, firstEdgeMs - state.pressedMs);
+        }
+      }
+    }
+
+    // Long press sent while still held, so the action does not wait for the release
+    if (state.isPressed && !state.isLongSent && nowMs - state.pressedMs >= longPressMs)
+    {
+      state.isLongSent = true;
+      push(i, BUTTON_LONG_PRESS, state.pressedMs, longPressMs);
+    }
+    isNeeded |= isTimerNeeded(state);
+  }
+  return isNeeded;
+}
+
+bool ButtonDebouncer::pop(ButtonEvent &event)
+{
+  return events.pop(event);
+}
+
+bool ButtonDebouncer::isActive() const
+{
+  for (uint8_t i = 0; i < BUTTON_MAX; i++)
+  {
+    if (isTimerNeeded(buttons[i]))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool ButtonDebouncer::isPressed(uint8_t button) const
+{
+  return button < BUTTON_MAX && buttons[button].isPressed;
+}
+
+ButtonStats ButtonDebouncer::getStats() const
+{
+  ButtonStats counters = stats;
+  counters.dropped = events.getDropped();
+  return counters;
+}
+
+bool ButtonDebouncer::isTimerNeeded(const Button &state) const
+{
+  return state.isSettling || (state.isPressed && !state.isLongSent);
+}
+
+void ButtonDebouncer::push(uint8_t button, ButtonEventType type, uint32_t pressedMs, uint32_t durationMs)
+{
+  if (type == BUTTON_SHORT_PRESS)
+  {
+    stats.shortPresses++;
+  }
+  else
+  {
+    stats.longPresses++;
+  }
+
+  ButtonEvent event = {button, type, pressedMs, durationMs};
+  events.push(event); // Full queue: dropped and counted by the queue
+}
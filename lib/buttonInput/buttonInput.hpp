@@ -0,0 +1,138 @@
+#ifndef BUTTONINPUT_HPP
+#define BUTTONINPUT_HPP
+
+// Framework libs
+#include <stdint.h>
+
+// Local Includes
+#include "memPool.hpp"
+
+// Buttons handled by one debouncer
+static constexpr uint8_t BUTTON_MAX = 4;
+
+// Debounced events waiting for loop() (power of 2)
+static constexpr uint8_t BUTTON_QUEUE_SIZE = 8;
+
+enum ButtonEventType : uint8_t
+{
+  BUTTON_SHORT_PRESS, // Released before the long press time
+  BUTTON_LONG_PRESS   // Held for the long press time (sent while still held)
+};
+
+/// ButtonEvent
+/// @brief Debounced press, as queued for loop()
+///
+struct ButtonEvent
+{
+  uint8_t button;
+  ButtonEventType type;
+  uint32_t pressedMs;  // First edge of the press, before the bounce settled
+  uint32_t durationMs; // Held time: to the release, or the long press time
+};
+
+/// Counters since boot
+struct ButtonStats
+{
+  uint32_t edges;    // Edges reported by the interrupts (bounces included)
+  uint32_t glitches; // Edge bursts that settled back at the previous level
+  uint32_t shortPresses;
+  uint32_t longPresses;
+  uint32_t dropped; // Events lost with the queue full
+};
+
+/// ButtonDebouncer
+/// @brief Debounce state machine for buttons on edge interrupts. The edge
+/// interrupt only notes the time (edge()); a periodic timer, running only
+/// while some button is settling or held, samples the level once it has
+/// been quiet for the debounce time (tick()) and queues short and long
+/// presses. loop() takes them with pop(), so an idle button costs nothing.
+/// Times are in milliseconds and passed in by the caller, so the same code
+/// runs against synthetic edge timings on the host.
+///
+class ButtonDebouncer
+{
+public:
+  /// ButtonDebouncer
+  /// @brief Class constructor, every button released
+  ///
+  /// @param[in] none
+  ///
+  /// @return none
+  ///
+  ButtonDebouncer();
+
+  /// configure
+  /// @brief Timing shared by all buttons
+  ///
+  /// @param[in] debounceMs: Quiet time after the last edge before the level is trusted
+  /// @param[in] longPressMs: Held time that makes a long press
+  ///
+  /// @return none
+  ///
+  void configure(uint32_t debounceMs, uint32_t longPressMs);
+
+  /// edge
+  /// @brief Called from the edge interrupt of a button
+  ///
+  /// @param[in] button: Button index (< BUTTON_MAX)
+  /// @param[in] nowMs: Current time
+  ///
+  /// @return none
+  ///
+  void edge(uint8_t button, uint32_t nowMs);
+
+  /// tick
+  /// @brief Called from the debounce timer: settles the buttons that have
+  ///        been quiet for the debounce time and detects long presses
+  ///
+  /// @param[in] nowMs: Current time
+  /// @param[in] pressedMask: Current level, bit N set while button N is pressed
+  ///
+  /// @return true while the timer is still needed (settling or held)
+  ///
+  bool tick(uint32_t nowMs, uint8_t pressedMask);
+
+  /// isActive
+  /// @brief true while some button is settling or held short of a long
+  ///        press, i.e. while tick() still has work to do
+  bool isActive() const;
+
+  /// pop
+  /// @brief Oldest queued event, for loop()
+  ///
+  /// @param[out] event: Event taken from the queue
+  ///
+  /// @return false if the queue is empty
+  ///
+  bool pop(ButtonEvent &event);
+
+  /// isPressed
+  /// @brief Debounced level of a button
+  bool isPressed(uint8_t button) const;
+
+  /// getStats
+  /// @brief Counters since boot
+  ButtonStats getStats() const;
+
+private:
+  struct Button
+  {
+    uint32_t firstEdgeMs; // First edge of the current burst
+    uint32_t lastEdgeMs;  // Most recent edge
+    uint32_t pressedMs;   // Debounced press start
+    bool isSettling;      // Edges seen, level not trusted yet
+    bool isPressed;       // Debounced level
+    bool isLongSent;      // Long press already queued for this press
+  };
+
+  bool isTimerNeeded(const Button &state) const;
+  void push(uint8_t button, ButtonEventType type, uint32_t pressedMs, uint32_t durationMs);
+
+  Button buttons[BUTTON_MAX];
+  uint32_t debounceMs;
+  uint32_t longPressMs;
+  RingQueue<ButtonEvent, BUTTON_QUEUE_SIZE> events; // tick() -> loop()
+  ButtonStats stats;                                // dropped is kept by the queue
+};
+
+#endif // BUTTONINPUT_HPP
@@ -0,0 +1,121 @@
+// Local Includes
+#include "commandDispatch.hpp"
+
+// Framework libs
+#include <string.h>
+
+// ========== PayloadView ==========
+
+bool PayloadView::equals(const char *text) const
+{
+  size_t textLength = strlen(text);
+  return textLength == length && memcmp(data, text, length) == 0;
+}
+
+bool PayloadView::toFloat(float &value) const
+{
+  size_t i = 0;
+  bool isNegative = false;
+  if (i < length && data[i] == '-')
+  {
+    isNegative = true;
+    i++;
+  }
+
+  float result = 0;
+  float scale = 0; // 0 while in the integer part
+  bool hasDigits = false;
+  for (; i < length; i++)
+  {
+    uint8_t c = data[i];
+    if (c >= '0' && c <= '9')
+    {
+      if (scale == 0)
+      {
+        result = result * 10 + (c - '0');
+      }
+      else
+      {
+        result += (c - '0') * scale;
+        scale /= 10;
+      }
+      hasDigits = true;
+    }
+    else if (c == '.' && scale == 0)
+    {
+      scale = 0.1f;
+    }
+    else
+    {
+      return false;
+    }
+  }
+
+  if (!hasDigits)
+  {
+    return false;
+  }
+  value = isNegative ? -result : result;
+  return true;
+}
+
+bool PayloadView::toUInt(uint32_t &value) const
+{
+  if (length == 0 || length > 9) // 9 digits never overflow
+  {
+    return false;
+  }
+
+  uint32_t result = 0;
+  for (size_t i = 0; i < length; i++)
+  {
+    if (data[i] < '0' || data[i] > '9')
+    {
+      return false;
+    }
+    result = result * 10 + (data[i] - '0');
+  }
+  value = result;
+  return true;
+}
+
+// ========== CommandDispatcher ==========
+
+CommandDispatcher::CommandDispatcher(const CommandEntry *table, uint8_t count) : table(table), count(count)
+{
+  memset(index, 0, sizeof(index));
+}
+
+void CommandDispatcher::begin()
+{
+  memset(index, 0, sizeof(index));
+  for (uint8_t i = 0; i < count; i++)
+  {
+    // Linear probing, the index is kept under half full
+    uint8_t slot = table[i].hash & (COMMAND_INDEX_SIZE - 1);
+    while (index[slot] != 0)
+    {
+      slot = (slot + 1) & (COMMAND_INDEX_SIZE - 1);
+    }
+    index[slot] = i + 1;
+  }
+}
+
+bool CommandDispatcher::dispatch(const char *topic, const uint8_t *payload, unsigned int length)
+{
+  uint32_t hash = topicHash(topic);
+  uint8_t slot = hash & (COMMAND_INDEX_SIZE - 1);
+
+  while (index[slot] != 0)
+  {
+    const CommandEntry &entry = table[index[slot] - 1];
+    if (entry.hash == hash && strcmp(entry.topic, topic) == 0)
+    {
+      PayloadView view = {payload, length};
+      entry.handler(view);
+      return true;
+    }
+    slot = (slot + 1) & (COMMAND_INDEX_SIZE - 1);
+  }
+  return false;
+}
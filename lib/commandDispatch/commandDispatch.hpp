@@ -0,0 +1,136 @@
+#ifndef COMMANDDISPATCH_HPP
+#define COMMANDDISPATCH_HPP
+
+// Local Includes
+#include <config.hpp>
+
+/// topicHash
+/// @brief FNV-1a hash of a topic, evaluated at compile time for the
+///        command table and at run time for incoming topics
+///
+/// @param[in] topic: NUL-terminated topic
+///
+/// @return 32-bit hash
+///
+constexpr uint32_t topicHash(const char *topic)
+{
+  uint32_t hash = 2166136261u;
+  while (*topic)
+  {
+    hash = (hash ^ (uint8_t)*topic++) * 16777619u;
+  }
+  return hash;
+}
+
+/// PayloadView
+/// @brief Non-owning view of an MQTT payload inside PubSubClient's buffer.
+/// The payload is not NUL-terminated, so every accessor is length-bounded.
+///
+struct PayloadView
+{
+  const uint8_t *data;
+  size_t length;
+
+  /// equals
+  /// @brief Exact, case-sensitive comparison with a literal
+  ///
+  /// @param[in] text: NUL-terminated literal
+  ///
+  /// @return true if the payload is exactly text
+  ///
+  bool equals(const char *text) const;
+
+  /// toFloat
+  /// @brief Parses [-]digits[.digits], rejects anything else
+  ///
+  /// @param[out] value: Parsed value
+  ///
+  /// @return true if the whole payload is a number
+  ///
+  bool toFloat(float &value) const;
+
+  /// toUInt
+  /// @brief Parses decimal digits only, rejects anything else
+  ///
+  /// @param[out] value: Parsed value
+  ///
+  /// @return true if the whole payload is an unsigned integer
+  ///
+  bool toUInt(uint32_t &value) const;
+};
+
+/// Command handler, receives the view of the payload
+typedef void (*CommandHandler)(const PayloadView &payload);
+
+/// CommandEntry
+/// @brief Row of the command table, the hash is computed at compile time
+struct CommandEntry
+{
+  uint32_t hash;
+  const char *topic;
+  CommandHandler handler;
+};
+
+/// CommandDispatcher
+/// @brief Dispatches incoming MQTT messages through an open-addressing index
+/// over the command table, so the cost of a message is one hash of its topic
+/// plus (normally) one string compare, however many commands exist.
+///
+class CommandDispatcher
+{
+public:
+  /// CommandDispatcher
+  /// @brief Class constructor
+  ///
+  /// @param[in] table: Command table
+  /// @param[in] count: Number of entries (<= COMMAND_INDEX_SIZE / 2)
+  ///
+  /// @return none
+  ///
+  CommandDispatcher(const CommandEntry *table, uint8_t count);
+
+  /// begin
+  /// @brief Builds the hash index, call once at boot
+  ///
+  /// @param none
+  ///
+  /// @return none
+  ///
+  void begin();
+
+  /// subscribeAll
+  /// @brief Subscribes every topic of the table, call after each connect
+  ///
+  /// @param[in] client: Connected MQTT client
+  ///
+  /// @return true if every subscription was sent
+  ///
+  template <typename Client>
+  bool subscribeAll(Client &client)
+  {
+    bool isSubscribed = true;
+    for (uint8_t i = 0; i < count; i++)
+    {
+      isSubscribed &= client.subscribe(table[i].topic);
+    }
+    return isSubscribed;
+  }
+
+  /// dispatch
+  /// @brief Runs the handler registered for topic, if any
+  ///
+  /// @param[in] topic: Topic of the message
+  /// @param[in] payload: Payload bytes (not copied)
+  /// @param[in] length: Payload length
+  ///
+  /// @return true if a handler was found
+  ///
+  bool dispatch(const char *topic, const uint8_t *payload, unsigned int length);
+
+private:
+  const CommandEntry *table;
+  uint8_t count;
+  uint8_t index[COMMAND_INDEX_SIZE]; // Table position + 1, 0 = empty
+};
+
+#endif // COMMANDDISPATCH_HPP
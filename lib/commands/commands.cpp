@@ -0,0 +1,187 @@
+// Local Includes
+#include "commands.hpp"
+#include "history.hpp"
+#include "logs.hpp"
+#include "coolingControl.hpp"
+
+// Estado de controlo alterado pelos comandos MQTT
+struct controlData control_data = {
+    TEMP_SETPOINT_MIN_DEFAULT,
+    TEMP_SETPOINT_MAX_DEFAULT,
+    SAMPLE_INTERVAL_DEFAULT,
+    MODE_AUTOMATIC,
+    false,
+    0,
+    CONTROL_STRATEGY_DEFAULT,
+};
+
+// ========== Handlers ==========
+
+static void rejectCommand(const char *topic)
+{
+  char msg[80];
+  snprintf(msg, sizeof(msg), "Comando inválido em %s", topic);
+  logs.warning(msg);
+}
+
+static void onSetpointMin(const PayloadView &payload)
+{
+  float value;
+  if (!payload.toFloat(value) || value < TEMP_SETPOINT_LIMIT_LOW || value >= control_data.tempMax)
+  {
+    rejectCommand(TOPIC_SETPOINT_MIN);
+    return;
+  }
+  control_data.tempMin = value;
+  logs.info("Setpoint mínimo alterado");
+}
+
+static void onSetpointMax(const PayloadView &payload)
+{
+  float value;
+  if (!payload.toFloat(value) || value > TEMP_SETPOINT_LIMIT_HIGH || value <= control_data.tempMin)
+  {
+    rejectCommand(TOPIC_SETPOINT_MAX);
+    return;
+  }
+  control_data.tempMax = value;
+  logs.info("Setpoint máximo alterado");
+}
+
+static void onInterval(const PayloadView &payload)
+{
+  uint32_t value;
+  if (!payload.toUInt(value) || value < SAMPLE_INTERVAL_MIN || value > SAMPLE_INTERVAL_MAX)
+  {
+    rejectCommand(TOPIC_INTERVAL);
+    return;
+  }
+  control_data.sampleIntervalMs = value; // Aplicado ao TIM3 no loop()
+  logs.info("Intervalo de leitura alterado");
+}
+
+static void onMode(const PayloadView &payload)
+{
+  if (payload.equals("AUTO"))
+  {
+    control_data.mode = MODE_AUTOMATIC;
+  }
+  else if (payload.equals("MANUAL"))
+  {
+    control_data.mode = MODE_MANUAL;
+  }
+  else
+  {
+    rejectCommand(TOPIC_MODE);
+    return;
+  }
+  logs.info(control_data.mode == MODE_AUTOMATIC ? "Modo automático" : "Modo manual");
+}
+
+static void onEmergency(const PayloadView &payload)
+{
+  if (!payload.equals("1") && !payload.equals("0"))
+  {
+    rejectCommand(TOPIC_EMERGENCY);
+    return;
+  }
+  control_data.emergency = payload.data[0] == '1';
+  if (control_data.emergency)
+  {
+    logs.warning("EMERGÊNCIA ativada");
+  }
+  else
+  {
+    logs.info("Emergência desativada");
+  }
+}
+
+static void onActuator(const PayloadView &payload)
+{
+  if (control_data.mode != MODE_MANUAL)
+  {
+    logs.warning("Comando de atuador ignorado em modo automático");
+    return;
+  }
+  uint32_t percent;
+  if (payload.equals("ON"))
+  {
+    control_data.manualOutput = 1;
+  }
+  else if (payload.equals("OFF"))
+  {
+    control_data.manualOutput = 0;
+  }
+  else if (payload.toUInt(percent) && percent <= 100)
+  {
+    control_data.manualOutput = percent / 100.0f; // Proporcional no tempo (CONTROL_OUTPUT_WINDOW_MS)
+  }
+  else
+  {
+    rejectCommand(TOPIC_ACTUATOR_CMD);
+  }
+}
+
+static void onStrategy(const PayloadView &payload)
+{
+  if (payload.equals("HISTERESE"))
+  {
+    control_data.strategy = CONTROL_HYSTERESIS;
+  }
+  else if (payload.equals("PI"))
+  {
+    control_data.strategy = CONTROL_PI;
+  }
+  else
+  {
+    rejectCommand(TOPIC_STRATEGY);
+    return;
+  }
+  logs.info(control_data.strategy == CONTROL_PI ? "Controlo PI" : "Controlo por histerese");
+}
+
+static void onHistoryQuery(const PayloadView &payload)
+{
+  // Answered in chunks on TOPIC_HISTORY from loop()
+  if (!history.request(payload.data, payload.length, HISTORY_MQTT))
+  {
+    rejectCommand(TOPIC_HISTORY_QUERY);
+  }
+}
+
+// ========== Tabela de comandos ==========
+
+static constexpr CommandEntry COMMAND_TABLE[] = {
+    {topicHash(TOPIC_SETPOINT_MIN), TOPIC_SETPOINT_MIN, onSetpointMin},
+    {topicHash(TOPIC_SETPOINT_MAX), TOPIC_SETPOINT_MAX, onSetpointMax},
+    {topicHash(TOPIC_INTERVAL), TOPIC_INTERVAL, onInterval},
+    {topicHash(TOPIC_MODE), TOPIC_MODE, onMode},
+    {topicHash(TOPIC_EMERGENCY), TOPIC_EMERGENCY, onEmergency},
+    {topicHash(TOPIC_ACTUATOR_CMD), TOPIC_ACTUATOR_CMD, onActuator},
+    {topicHash(TOPIC_STRATEGY), TOPIC_STRATEGY, onStrategy},
+    {topicHash(TOPIC_HISTORY_QUERY), TOPIC_HISTORY_QUERY, onHistoryQuery},
+};
+
+static constexpr uint8_t COMMAND_COUNT = sizeof(COMMAND_TABLE) / sizeof(COMMAND_TABLE[0]);
+
+// Two topics with the same hash would make one of them unreachable
+static constexpr bool hasUniqueHashes()
+{
+  for (uint8_t i = 0; i < COMMAND_COUNT; i++)
+  {
+    for (uint8_t j = i + 1; j < COMMAND_COUNT; j++)
+    {
+      if (COMMAND_TABLE[i].hash == COMMAND_TABLE[j].hash)
+      {
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+static_assert(hasUniqueHashes(), "Command topics collide, rename one of them");
+static_assert(2 * COMMAND_COUNT <= COMMAND_INDEX_SIZE, "COMMAND_INDEX_SIZE must be at least twice the command table");
+static_assert((COMMAND_INDEX_SIZE & (COMMAND_INDEX_SIZE - 1)) == 0, "COMMAND_INDEX_SIZE must be a power of two");
+
+CommandDispatcher commands(COMMAND_TABLE, COMMAND_COUNT);
@@ -0,0 +1,10 @@
+#ifndef COMMANDS_HPP
+#define COMMANDS_HPP
+
+// Local Includes
+#include <config.hpp>
+#include "commandDispatch.hpp"
+
+extern CommandDispatcher commands;
+
+#endif // COMMANDS_HPP
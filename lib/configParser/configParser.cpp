@@ -0,0 +1,882 @@
+// Framework libs
+#include <stddef.h>
+#include <string.h>
+
+// Local Includes
+#include "configParser.hpp"
+#include "format.hpp"
+#include "coolingControl.hpp"
+
+enum SettingType : uint8_t
+{
+  SETTING_TEXT,
+  SETTING_U16,
+  SETTING_U32,
+  SETTING_FLOAT
+};
+
+/// Setting
+/// @brief One key of the file and where its value goes in configData
+///
+struct Setting
+{
+  const char *key;
+  SettingType type;
+  uint16_t offset;
+  uint16_t size;  // Text: field size with the NUL; numbers: elements (key.0 .. key.N-1 when > 1)
+  float min;
+  float max;
+};
+
+#define TEXT_SETTING(key, field) {key, SETTING_TEXT, offsetof(configData, field), sizeof(configData::field), 0, 0}
+
+static const Setting SETTINGS[] = {
+    TEXT_SETTING("asn", asn),
+    TEXT_SETTING("sn", sn),
+    TEXT_SETTING("hw", hw),
+    TEXT_SETTING("fw", fw),
+    TEXT_SETTING("wifi.ssid", ssid),
+    TEXT_SETTING("wifi.password", password),
+    TEXT_SETTING("mqtt.host", brokerHost),
+    {"mqtt.port", SETTING_U16, offsetof(configData, brokerPort), 1, 1, 65535},
+    TEXT_SETTING("mqtt.client_id", clientId),
+    {"sample_interval_ms", SETTING_U32, offsetof(configData, sampleIntervalMs), 1, SAMPLE_INTERVAL_MIN,
+     SAMPLE_INTERVAL_MAX},
+    {"heartbeat_ms", SETTING_U32, offsetof(configData, heartbeatMs), 1, 1000, 86400000},
+    {"flush_interval_ms", SETTING_U32, offsetof(configData, flushIntervalMs), 1, 0, 600000},
+    {"deadband.temperature", SETTING_FLOAT, offsetof(configData, deadband[TELEMETRY_TEMPERATURE]), NUMBER_OF_SENSORS,
+     0, 10},
+    {"setpoint.min", SETTING_FLOAT, offsetof(configData, setpointMin), 1, TEMP_SETPOINT_LIMIT_LOW,
+     TEMP_SETPOINT_LIMIT_HIGH},
+    {"setpoint.max", SETTING_FLOAT, offsetof(configData, setpointMax), 1, TEMP_SETPOINT_LIMIT_LOW,
+     TEMP_SETPOINT_LIMIT_HIGH},
+    {"control.strategy", SETTING_U16, offsetof(configData, controlStrategy), 1, 0, CONTROL_STRATEGIES - 1},
+    {"control.kp", SETTING_FLOAT, offsetof(configData, controlKp), 1, 0, 100},
+    {"control.ki", SETTING_FLOAT, offsetof(configData, controlKi), 1, 0, 10},
+    {"alarm.high", SETTING_FLOAT, offsetof(configData, alarmHigh), NUMBER_OF_SENSORS, -40, 125},
+    {"alarm.low", SETTING_FLOAT, offsetof(configData, alarmLow), NUMBER_OF_SENSORS, -40, 125},
+    {"alarm.hysteresis", SETTING_FLOAT, offsetof(configData, alarmHysteresis), NUMBER_OF_SENSORS, 0, 20},
+    {"alarm.rate", SETTING_FLOAT, offsetof(configData, alarmRate), NUMBER_OF_SENSORS, 0, 60},
+    {"alarm.debounce", SETTING_U16, offsetof(configData, alarmDebounce), NUMBER_OF_SENSORS, 1, 100},
+};
+
+#undef TEXT_SETTING
+
+static const uint8_t SETTING_COUNT = sizeof(SETTINGS) / sizeof(SETTINGS[0]);
+
+// Fields of the old one-line config.json ("ASN001,SN001,v1.0,v1.0")
+static const char *const LEGACY_KEYS[] = {"asn", "sn", "hw", "fw"};
+static const uint8_t LEGACY_FIELDS = sizeof(LEGACY_KEYS) / sizeof(LEGACY_KEYS[0]);
+static const uint8_t LEGACY_DONE = 0xFF;
+
+// ---------- Number parsing (strtof/strtoul pull in newlib's allocating strtod) ----------
+
+static bool parseUInt(const char *text, uint32_t &value)
+{
+  if (*text == '\0')
+  {
+    return false;
+  }
+  uint32_t result = 0;
+  for (; *text != '\0'; text++)
+  {
+    if (*text < '0' || *text > '9')
+    {
+      return false;
+    }
+    uint32_t digit = *text - '0';
+    if (result > (UINT32_MAX - digit) / 10)
+    {
+      return false; // Overflow
+    }
+    result = result * 10 + digit;
+  }
+  value = result;
+  return true;
+}
+
+/// Decimal text to float: [-]digits[.digits][e[+-]digits], up to 9
+/// significant digits, the rest must be zeros
+static bool parseFloat(const char *text, float &value)
+{
+  bool isNegative = *text == '-';
+  if (isNegative)
+  {
+    text++;
+  }
+
+  uint32_t mantissa = 0;
+  uint8_t significant = 0;
+  int16_t exponent = 0;
+  bool hasDigits = false;
+  bool isFraction = false;
+  for (; *text != '\0' && *text != 'e' && *text != 'E'; text++)
+  {
+    if (*text == '.' && !isFraction)
+    {
+      isFraction = true;
+      continue;
+    }
+    if (*text < '0' || *text > '9')
+    {
+      return false;
+    }
+    hasDigits = true;
+    if (mantissa == 0 && *text == '0')
+    {
+      exponent -= isFraction ? 1 : 0; // Leading zero
+      continue;
+    }
+    if (significant < 9)
+    {
+      mantissa = mantissa * 10 + (*text - '0');
+      significant++;
+      exponent -= isFraction ? 1 : 0;
+    }
+    else if (*text != '0')
+    {
+      return false; // More precision than a float holds
+    }
+    else
+    {
+      exponent += isFraction ? 0 : 1;
+    }
+  }
+  if (!hasDigits)
+  {
+    return false;
+  }
+
+  if (*text == 'e' || *text == 'E')
+  {
+    text++;
+    bool isNegativeExponent = *text == '-';
+    if (*text == '-' || *text == '+')
+    {
+      text++;
+    }
+    uint32_t power;
+    if (!parseUInt(text, power) || power > 38)
+    {
+      return false;
+    }
+    exponent += isNegativeExponent ? -(int16_t)power : (int16_t)power;
+  }
+
+  // One multiplication or division by an exact power of ten
+  float scale = 1.0f;
+  for (int16_t i = exponent < 0 ? -exponent : exponent; i > 0; i--)
+  {
+    scale *= 10.0f;
+  }
+  float result = exponent < 0 ? (float)mantissa / scale : (float)mantissa * scale;
+  value = isNegative ? -result : result;
+  return true;
+}
+
+// ---------- JsonScanner ----------
+
+void JsonScanner::begin(ConfigHandler handler, void *context)
+{
+  this->handler = handler;
+  this->context = context;
+  state = STATE_VALUE;
+  key[0] = '\0';
+  keyLength = 0;
+  tokenLength = 0;
+  depth = 0;
+  escape = 0;
+  line = 1;
+  error = nullptr;
+}
+
+uint16_t JsonScanner::getLine() const
+{
+  return line;
+}
+
+const char *JsonScanner::getError() const
+{
+  return error ? error : "";
+}
+
+bool JsonScanner::fail(const char *reason)
+{
+  if (state != STATE_ERROR)
+  {
+    error = reason;
+    state = STATE_ERROR;
+  }
+  return false;
+}
+
+bool JsonScanner::feed(char c)
+{
+  bool isOk = step(c);
+  if (c == '\n' && isOk)
+  {
+    line++; // An error on a line break belongs to the line it ends
+  }
+  return isOk;
+}
+
+bool JsonScanner::step(char c)
+{
+  bool isSpace = c == ' ' || c == '\t' || c == '\r' || c == '\n';
+  switch (state)
+  {
+  case STATE_VALUE_OR_END:
+    if (c == ']')
+    {
+      return closeContainer(c);
+    }
+    // fall through
+  case STATE_VALUE:
+    return isSpace || startValue(c);
+
+  case STATE_KEY_OR_END:
+    if (c == '}')
+    {
+      return closeContainer(c);
+    }
+    // fall through
+  case STATE_KEY:
+    if (isSpace)
+    {
+      return true;
+    }
+    if (c != '"')
+    {
+      return fail("chave esperada");
+    }
+    tokenLength = 0;
+    state = STATE_KEY_STRING;
+    return true;
+
+  case STATE_KEY_STRING:
+  case STATE_STRING:
+    return readString(c);
+
+  case STATE_COLON:
+    if (isSpace)
+    {
+      return true;
+    }
+    if (c != ':')
+    {
+      return fail("':' esperado");
+    }
+    state = STATE_VALUE;
+    return true;
+
+  case STATE_BARE:
+    if ((c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || c == '.' || c == '-' || c == '+' || c == 'E')
+    {
+      if (tokenLength >= CONFIG_VALUE_SIZE - 1)
+      {
+        return fail("valor demasiado longo");
+      }
+      token[tokenLength++] = c;
+      return true;
+    }
+    if (!finishBare())
+    {
+      return false;
+    }
+    return step(c); // The delimiter belongs to what follows the value
+
+  case STATE_AFTER_VALUE:
+    if (isSpace)
+    {
+      return true;
+    }
+    if (c == ',')
+    {
+      Frame &frame = frames[depth - 1];
+      if (frame.isArray)
+      {
+        keyLength = frame.keyLength;
+        state = STATE_VALUE;
+        return appendIndex(++frame.index);
+      }
+      state = STATE_KEY;
+      return true;
+    }
+    if (c == '}' || c == ']')
+    {
+      return closeContainer(c);
+    }
+    return fail("',' esperada");
+
+  case STATE_DONE:
+    return isSpace || fail("texto após o fim");
+
+  case STATE_ERROR:
+  default:
+    return false;
+  }
+}
+
+bool JsonScanner::end()
+{
+  if (state == STATE_BARE && !finishBare())
+  {
+    return false;
+  }
+  return state == STATE_DONE || fail(state == STATE_ERROR ? error : "fim inesperado");
+}
+
+bool JsonScanner::startValue(char c)
+{
+  tokenLength = 0;
+  if (c == '{' || c == '[')
+  {
+    if (depth >= CONFIG_DEPTH_MAX)
+    {
+      return fail("demasiados níveis");
+    }
+    Frame &frame = frames[depth++];
+    frame.isArray = c == '[';
+    frame.keyLength = keyLength;
+    frame.index = 0;
+    state = frame.isArray ? STATE_VALUE_OR_END : STATE_KEY_OR_END;
+    return !frame.isArray || appendIndex(0);
+  }
+  if (c == '"')
+  {
+    state = STATE_STRING;
+    return true;
+  }
+  if (c == '-' || (c >= '0' && c <= '9') || c == 't' || c == 'f' || c == 'n')
+  {
+    token[tokenLength++] = c;
+    state = STATE_BARE;
+    return true;
+  }
+  return fail("valor esperado");
+}
+
+bool JsonScanner::readString(char c)
+{
+  if (escape == 1)
+  {
+    static const char ESCAPES[] = "\"\"\\\\//b\bf\fn\nr\rt\t";
+    escape = 0;
+    if (c == 'u')
+    {
+      escape = 2;
+      codePoint = 0;
+      return true;
+    }
+    const char *found = nullptr;
+    for (const char *e = ESCAPES; *e != '\0'; e += 2)
+    {
+      if (*e == c)
+      {
+        found = e + 1;
+        break;
+      }
+    }
+    if (!found)
+    {
+      return fail("escape inválido");
+    }
+    c = *found;
+  }
+  else if (escape >= 2)
+  {
+    uint8_t nibble;
+    if (c >= '0' && c <= '9')
+    {
+      nibble = c - '0';
+    }
+    else if ((c | 0x20) >= 'a' && (c | 0x20) <= 'f')
+    {
+      nibble = (c | 0x20) - 'a' + 10;
+    }
+    else
+    {
+      return fail("escape \\u inválido");
+    }
+    codePoint = (codePoint << 4) | nibble;
+    if (++escape < 6)
+    {
+      return true;
+    }
+    escape = 0;
+    if (codePoint == 0 || (codePoint >= 0xD800 && codePoint <= 0xDFFF))
+    {
+      return fail("escape \\u inválido"); // NUL or half of a surrogate pair
+    }
+
+    // UTF-8
+    char bytes[3];
+    uint8_t count;
+    if (codePoint < 0x80)
+    {
+      bytes[0] = (char)codePoint;
+      count = 1;
+    }
+    else if (codePoint < 0x800)
+    {
+      bytes[0] = (char)(0xC0 | (codePoint >> 6));
+      bytes[1] = (char)(0x80 | (codePoint & 0x3F));
+      count = 2;
+    }
+    else
+    {
+      bytes[0] = (char)(0xE0 | (codePoint >> 12));
+      bytes[1] = (char)(0x80 | ((codePoint >> 6) & 0x3F));
+      bytes[2] = (char)(0x80 | (codePoint & 0x3F));
+      count = 3;
+    }
+    if (tokenLength + count > CONFIG_VALUE_SIZE - 1)
+    {
+      return fail("valor demasiado longo");
+    }
+    memcpy(token + tokenLength, bytes, count);
+    tokenLength += count;
+    return true;
+  }
+  else if (c == '\\')
+  {
+    escape = 1;
+    return true;
+  }
+  else if (c == '"')
+  {
+    token[tokenLength] = '\0';
+    if (state == STATE_KEY_STRING)
+    {
+      keyLength = frames[depth - 1].keyLength;
+      state = STATE_COLON;
+      return appendKey(token);
+    }
+    handler(key, token, true, context);
+    return finishValue();
+  }
+  else if ((uint8_t)c < 0x20)
+  {
+    return fail("caráter de controlo no texto");
+  }
+
+  if (tokenLength >= CONFIG_VALUE_SIZE - 1)
+  {
+    return fail("valor demasiado longo");
+  }
+  token[tokenLength++] = c;
+  return true;
+}
+
+bool JsonScanner::finishBare()
+{
+  token[tokenLength] = '\0';
+  if (token[0] == '-' || (token[0] >= '0' && token[0] <= '9'))
+  {
+    handler(key, token, false, context); // Number, checked by whoever knows its type
+  }
+  else if (strcmp(token, "true") == 0 || strcmp(token, "false") == 0)
+  {
+    handler(key, token, false, context);
+  }
+  else if (strcmp(token, "null") != 0) // null: key left at its default
+  {
+    return fail("valor inválido");
+  }
+  return finishValue();
+}
+
+bool JsonScanner::finishValue()
+{
+  if (depth == 0)
+  {
+    state = STATE_DONE;
+    return true;
+  }
+  keyLength = frames[depth - 1].keyLength;
+  key[keyLength] = '\0';
+  state = STATE_AFTER_VALUE;
+  return true;
+}
+
+bool JsonScanner::closeContainer(char c)
+{
+  Frame &frame = frames[depth - 1];
+  if (frame.isArray != (c == ']'))
+  {
+    return fail(frame.isArray ? "']' esperado" : "'}' esperado");
+  }
+  depth--;
+  keyLength = frame.keyLength;
+  key[keyLength] = '\0';
+  return finishValue();
+}
+
+bool JsonScanner::appendKey(const char *segment)
+{
+  size_t length = strlen(segment);
+  size_t separator = keyLength > 0 ? 1 : 0;
+  if (keyLength + separator + length > CONFIG_KEY_SIZE - 1)
+  {
+    return fail("chave demasiado longa");
+  }
+  if (separator)
+  {
+    key[keyLength++] = '.';
+  }
+  memcpy(key + keyLength, segment, length);
+  keyLength += length;
+  key[keyLength] = '\0';
+  return true;
+}
+
+bool JsonScanner::appendIndex(uint16_t index)
+{
+  char digits[6];
+  digits[formatUInt(digits, index)] = '\0';
+  return appendKey(digits);
+}
+
+// ---------- Defaults and writer ----------
+
+void loadConfigDefaults(configData &config)
+{
+  memset(&config, 0, sizeof(config));
+  strcpy(config.asn, CONFIG_DEFAULT_ASN);
+  strcpy(config.sn, CONFIG_DEFAULT_SN);
+  strcpy(config.hw, CONFIG_DEFAULT_HW);
+  strcpy(config.fw, CONFIG_DEFAULT_FW);
+  strcpy(config.ssid, SERVER_SSID);
+  strcpy(config.password, SERVER_PASSWORD);
+  strcpy(config.brokerHost, SERVER_IP);
+  config.brokerPort = SERVER_PORT;
+  strcpy(config.clientId, MQTT_CLIENT_ID);
+  config.sampleIntervalMs = SAMPLE_INTERVAL_DEFAULT;
+  config.heartbeatMs = PUBLISH_HEARTBEAT;
+  config.flushIntervalMs = 0;
+  memcpy(config.deadband, PUBLISH_DEADBAND, sizeof(config.deadband));
+  config.setpointMin = TEMP_SETPOINT_MIN_DEFAULT;
+  config.setpointMax = TEMP_SETPOINT_MAX_DEFAULT;
+  config.controlStrategy = CONTROL_STRATEGY_DEFAULT;
+  config.controlKp = CONTROL_KP_DEFAULT;
+  config.controlKi = CONTROL_KI_DEFAULT;
+  for (uint8_t i = 0; i < NUMBER_OF_SENSORS; i++)
+  {
+    config.alarmHigh[i] = ALARM_HIGH_DEFAULT;
+    config.alarmLow[i] = ALARM_LOW_DEFAULT;
+    config.alarmHysteresis[i] = ALARM_HYSTERESIS_DEFAULT;
+    config.alarmRate[i] = ALARM_RATE_DEFAULT;
+    config.alarmDebounce[i] = ALARM_DEBOUNCE_DEFAULT;
+  }
+}
+
+bool writeConfigJson(Print &out, const configData &config)
+{
+  const uint8_t *base = (const uint8_t *)&config;
+  StrBuilder<CONFIG_KEY_SIZE + 2 * CONFIG_VALUE_SIZE> line;
+  bool isWritten = out.write("{\n", 2) == 2;
+
+  for (uint8_t i = 0; i < SETTING_COUNT; i++)
+  {
+    const Setting &setting = SETTINGS[i];
+    const uint8_t *field = base + setting.offset;
+
+    line.clear().append("  \"").append(setting.key).append("\": ");
+    if (setting.type == SETTING_TEXT)
+    {
+      line.append('"');
+      for (const char *c = (const char *)field; *c != '\0'; c++)
+      {
+        if (*c == '"' || *c == '\\')
+        {
+          line.append('\\');
+        }
+        line.append(*c);
+      }
+      line.append('"');
+    }
+    else
+    {
+      line.append(setting.size > 1 ? "[" : "");
+      for (uint16_t n = 0; n < setting.size; n++)
+      {
+        line.append(n > 0 ? ", " : "");
+        if (setting.type == SETTING_U16)
+        {
+          uint16_t value;
+          memcpy(&value, field + n * sizeof(value), sizeof(value));
+          line.appendUInt(value);
+        }
+        else if (setting.type == SETTING_U32)
+        {
+          uint32_t value;
+          memcpy(&value, field + n * sizeof(value), sizeof(value));
+          line.appendUInt(value);
+        }
+        else
+        {
+          float value;
+          memcpy(&value, field + n * sizeof(float), sizeof(value));
+          line.appendFixed(value, 3);
+        }
+      }
+      line.append(setting.size > 1 ? "]" : "");
+    }
+    line.append(i + 1 < SETTING_COUNT ? ",\n" : "\n");
+    isWritten &= !line.truncated() && out.write(line.c_str(), line.length()) == line.length();
+  }
+  return isWritten && out.write("}\n", 2) == 2;
+}
+
+// ---------- ConfigParser ----------
+
+ConfigParser::ConfigParser()
+{
+  config = nullptr;
+  format = FORMAT_UNKNOWN;
+  applied = 0;
+  rejected = 0;
+  unknown = 0;
+  lastRejected[0] = '\0';
+  error = "";
+}
+
+void ConfigParser::begin(configData &target)
+{
+  config = &target;
+  loadConfigDefaults(target);
+  scanner.begin(onValue, this);
+  format = FORMAT_UNKNOWN;
+  fieldLength = 0;
+  fieldIndex = 0;
+  isFieldTooLong = false;
+  applied = 0;
+  rejected = 0;
+  unknown = 0;
+  lastRejected[0] = '\0';
+  error = "";
+}
+
+bool ConfigParser::feed(const char *data, size_t length)
+{
+  for (size_t i = 0; i < length; i++)
+  {
+    char c = data[i];
+    if (format == FORMAT_UNKNOWN)
+    {
+      // Whitespace and a UTF-8 BOM before the first character
+      if ((uint8_t)c == 0xEF || (uint8_t)c == 0xBB || (uint8_t)c == 0xBF)
+      {
+        continue;
+      }
+      if (c == ' ' || c == '\t' || c == '\r' || c == '\n')
+      {
+        scanner.feed(c); // Line count
+        continue;
+      }
+      format = c == '{' ? FORMAT_JSON : FORMAT_CSV;
+    }
+
+    if (!(format == FORMAT_JSON ? scanner.feed(c) : feedLegacy(c)))
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ConfigParser::end()
+{
+  if (format == FORMAT_CSV)
+  {
+    feedLegacy('\n'); // Last line without a line break
+  }
+  else if (format == FORMAT_UNKNOWN || !scanner.end())
+  {
+    error = format == FORMAT_UNKNOWN ? "ficheiro vazio" : scanner.getError();
+    loadConfigDefaults(*config); // Nothing from a broken file is kept
+    return false;
+  }
+
+  // Settings checked against each other
+  if (config->setpointMin >= config->setpointMax)
+  {
+    config->setpointMin = TEMP_SETPOINT_MIN_DEFAULT;
+    config->setpointMax = TEMP_SETPOINT_MAX_DEFAULT;
+    reject("setpoint", false);
+  }
+  return true;
+}
+
+bool ConfigParser::isLegacy() const
+{
+  return format == FORMAT_CSV;
+}
+
+uint16_t ConfigParser::getApplied() const
+{
+  return applied;
+}
+
+uint16_t ConfigParser::getRejected() const
+{
+  return rejected;
+}
+
+uint16_t ConfigParser::getUnknown() const
+{
+  return unknown;
+}
+
+uint16_t ConfigParser::getLine() const
+{
+  return scanner.getLine();
+}
+
+const char *ConfigParser::getError() const
+{
+  return error;
+}
+
+const char *ConfigParser::getLastRejected() const
+{
+  return lastRejected;
+}
+
+void ConfigParser::onValue(const char *key, const char *value, bool isString, void *context)
+{
+  ((ConfigParser *)context)->apply(key, value, isString);
+}
+
+void ConfigParser::reject(const char *key, bool isUnknown)
+{
+  if (isUnknown)
+  {
+    unknown++;
+  }
+  else
+  {
+    rejected++;
+  }
+  strncpy(lastRejected, key, sizeof(lastRejected) - 1);
+  lastRejected[sizeof(lastRejected) - 1] = '\0';
+}
+
+void ConfigParser::apply(const char *key, const char *value, bool isString)
+{
+  // Exact key, or "key.N" for element N of a table
+  const Setting *setting = nullptr;
+  uint32_t element = 0;
+  for (uint8_t i = 0; i < SETTING_COUNT && !setting; i++)
+  {
+    size_t length = strlen(SETTINGS[i].key);
+    if (strncmp(key, SETTINGS[i].key, length) != 0)
+    {
+      continue;
+    }
+    bool isTable = SETTINGS[i].type != SETTING_TEXT && SETTINGS[i].size > 1;
+    if ((key[length] == '\0' && !isTable) ||
+        (key[length] == '.' && isTable && parseUInt(key + length + 1, element) && element < SETTINGS[i].size))
+    {
+      setting = &SETTINGS[i];
+    }
+  }
+  if (!setting)
+  {
+    reject(key, true);
+    return;
+  }
+
+  uint8_t *field = (uint8_t *)config + setting->offset;
+  if (setting->type == SETTING_TEXT)
+  {
+    size_t length = strlen(value);
+    if (!isString || length >= setting->size)
+    {
+      reject(key, false); // Never cut: a truncated SSID or password is silently wrong
+      return;
+    }
+    memcpy(field, value, length + 1);
+  }
+  else if (setting->type == SETTING_FLOAT)
+  {
+    float number;
+    if (isString || !parseFloat(value, number) || number < setting->min || number > setting->max)
+    {
+      reject(key, false);
+      return;
+    }
+    memcpy(field + element * sizeof(float), &number, sizeof(number));
+  }
+  else
+  {
+    uint32_t number;
+    if (isString || !parseUInt(value, number) || number < setting->min || number > setting->max)
+    {
+      reject(key, false);
+      return;
+    }
+    if (setting->type == SETTING_U16)
+    {
+      uint16_t narrow = (uint16_t)number;
+      memcpy(field + element * sizeof(narrow), &narrow, sizeof(narrow));
+    }
+    else
+    {
+      memcpy(field + element * sizeof(number), &number, sizeof(number));
+    }
+  }
+  applied++;
+}
+
+bool ConfigParser::feedLegacy(char c)
+{
+  if (fieldIndex == LEGACY_DONE)
+  {
+    return true; // Only the first line is read
+  }
+  if (c != ',' && c != '\n' && c != '\r')
+  {
+    if (fieldLength < CONFIG_VALUE_SIZE - 1)
+    {
+      field[fieldLength++] = c;
+    }
+    else
+    {
+      isFieldTooLong = true;
+    }
+    return true;
+  }
+
+  // Field complete, surrounding spaces ignored
+  field[fieldLength] = '\0';
+  char *text = field;
+  while (*text == ' ')
+  {
+    text++;
+  }
+  for (size_t end = strlen(text); end > 0 && text[end - 1] == ' '; end--)
+  {
+    text[end - 1] = '\0';
+  }
+
+  if (fieldIndex < LEGACY_FIELDS)
+  {
+    if (isFieldTooLong)
+    {
+      reject(LEGACY_KEYS[fieldIndex], false);
+    }
+    else if (*text != '\0')
+    {
+      apply(LEGACY_KEYS[fieldIndex], text, true);
+    }
+  }
+  else
+  {
+    reject("csv", true); // Extra field
+  }
+  fieldIndex = c == ',' ? fieldIndex + 1 : LEGACY_DONE;
+  fieldLength = 0;
+  isFieldTooLong = false;
+  return true;
+}
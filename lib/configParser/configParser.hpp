@@ -0,0 +1,229 @@
+#ifndef CONFIGPARSER_HPP
+#define CONFIGPARSER_HPP
+
+// Framework libs
+#include <Print.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Local Includes
+#include <config.hpp>
+
+static constexpr uint8_t CONFIG_KEY_SIZE = 48;   // Longest dotted key path + NUL
+static constexpr uint8_t CONFIG_VALUE_SIZE = 80; // Longest value + NUL
+static constexpr uint8_t CONFIG_DEPTH_MAX = 4;   // Nested objects/arrays
+
+/// ConfigHandler
+/// @brief Called once per scalar value of the document
+///
+/// @param[in] key: Dotted path ("mqtt.port", "deadband.temperature.2")
+/// @param[in] value: Text of the value, escapes already decoded
+/// @param[in] isString: The value was quoted
+/// @param[in] context: Pointer given to JsonScanner::begin()
+///
+typedef void (*ConfigHandler)(const char *key, const char *value, bool isString, void *context);
+
+/// JsonScanner
+/// @brief Streaming JSON reader with fixed buffers: fed one character at a
+/// time, it reports every scalar with its dotted path and never holds more
+/// than one key path and one value. A key or value longer than its buffer
+/// is a syntax error, never a silent truncation.
+///
+class JsonScanner
+{
+public:
+  /// begin
+  /// @brief Resets the scanner for a new document
+  ///
+  /// @param[in] handler: Receives each scalar
+  /// @param[in] context: Passed back to the handler
+  ///
+  /// @return none
+  ///
+  void begin(ConfigHandler handler, void *context);
+
+  /// feed
+  /// @brief Consumes the next character of the document
+  ///
+  /// @param[in] c: Character
+  ///
+  /// @return false once the document is invalid (see getError())
+  ///
+  bool feed(char c);
+
+  /// end
+  /// @brief Checks that the document is complete
+  ///
+  /// @param[in] none
+  ///
+  /// @return true for one complete value followed only by whitespace
+  ///
+  bool end();
+
+  uint16_t getLine() const;
+  const char *getError() const;
+
+private:
+  enum State : uint8_t
+  {
+    STATE_VALUE,
+    STATE_VALUE_OR_END,
+    STATE_KEY,
+    STATE_KEY_OR_END,
+    STATE_KEY_STRING,
+    STATE_COLON,
+    STATE_STRING,
+    STATE_BARE,
+    STATE_AFTER_VALUE,
+    STATE_DONE,
+    STATE_ERROR
+  };
+
+  struct Frame
+  {
+    bool isArray;
+    uint8_t keyLength; // Path of the container itself
+    uint16_t index;    // Next array element
+  };
+
+  // Private methods
+  bool step(char c);
+  bool fail(const char *reason);
+  bool startValue(char c);
+  bool readString(char c);
+  bool finishBare();
+  bool finishValue();
+  bool closeContainer(char c);
+  bool appendKey(const char *segment);
+  bool appendIndex(uint16_t index);
+
+  // Private attributes
+  ConfigHandler handler;
+  void *context;
+  State state;
+  char key[CONFIG_KEY_SIZE];
+  uint8_t keyLength;
+  char token[CONFIG_VALUE_SIZE];
+  uint8_t tokenLength;
+  Frame frames[CONFIG_DEPTH_MAX];
+  uint8_t depth;
+  uint8_t escape;    // 0, 1 after '\', 2..5 inside \uXXXX
+  uint16_t codePoint;
+  uint16_t line;
+  const char *error;
+};
+
+/// loadConfigDefaults
+/// @brief Fills the configuration with the defaults of config.hpp. Padding
+///        is zeroed so equal settings always give the same snapshot CRC.
+///
+/// @param[out] config: Configuration to fill
+///
+/// @return none
+///
+void loadConfigDefaults(configData &config);
+
+/// writeConfigJson
+/// @brief Writes the configuration as a flat JSON document that
+///        ConfigParser reads back to the same values
+///
+/// @param[out] out: Destination (file, Serial)
+/// @param[in] config: Values to write
+///
+/// @return true if every byte was written
+///
+bool writeConfigJson(Print &out, const configData &config);
+
+/// ConfigParser
+/// @brief Applies a config file to configData in one pass over its bytes.
+/// JSON (nested objects or flat dotted keys) is read through JsonScanner;
+/// a file not starting with '{' is the old one-line "asn,sn,hw,fw" CSV.
+/// Each value is checked against its key's type and range: a value that
+/// does not fit is rejected and the field keeps its default.
+///
+class ConfigParser
+{
+public:
+  /// ConfigParser
+  /// @brief Class constructor
+  ///
+  /// @param[in] none
+  ///
+  /// @return none
+  ///
+  ConfigParser();
+
+  /// begin
+  /// @brief Starts a new file; the target is reset to the defaults
+  ///
+  /// @param[out] target: Configuration to fill
+  ///
+  /// @return none
+  ///
+  void begin(configData &target);
+
+  /// feed
+  /// @brief Consumes the next bytes of the file
+  ///
+  /// @param[in] data: Bytes
+  /// @param[in] length: Number of bytes
+  ///
+  /// @return false once the file is invalid
+  ///
+  bool feed(const char *data, size_t length);
+
+  /// end
+  /// @brief Completes the file and checks the settings against each other
+  ///
+  /// @param[in] none
+  ///
+  /// @return true if the file was valid (rejected values do not fail it)
+  ///
+  bool end();
+
+  bool isLegacy() const;
+  uint16_t getApplied() const;
+  uint16_t getRejected() const;
+  uint16_t getUnknown() const;
+  uint16_t getLine() const;
+
+  /// getError
+  /// @brief Why end() failed, "" if the file was valid
+  ///
+  const char *getError() const;
+
+  /// getLastRejected
+  /// @brief Key of the last rejected or unknown value, "" if none
+  ///
+  const char *getLastRejected() const;
+
+private:
+  enum Format : uint8_t
+  {
+    FORMAT_UNKNOWN,
+    FORMAT_JSON,
+    FORMAT_CSV
+  };
+
+  // Private methods
+  static void onValue(const char *key, const char *value, bool isString, void *context);
+  void apply(const char *key, const char *value, bool isString);
+  void reject(const char *key, bool isUnknown);
+  bool feedLegacy(char c);
+
+  // Private attributes
+  configData *config;
+  JsonScanner scanner;
+  Format format;
+  char field[CONFIG_VALUE_SIZE]; // CSV field being read
+  uint8_t fieldLength;
+  uint8_t fieldIndex;
+  bool isFieldTooLong;
+  uint16_t applied;
+  uint16_t rejected;
+  uint16_t unknown;
+  char lastRejected[CONFIG_KEY_SIZE];
+  const char *error;
+};
+
+#endif // CONFIGPARSER_HPP
@@ -1,79 +1,225 @@
 #include "connect.hpp"
+#include "commands.hpp"
 #include "logs.hpp"
+#include "espUart.hpp"
 
 // Variáveis globais
+#if MQTT_TRANSPORT == MQTT_TRANSPORT_AT
+extern DmaSerial espSerial;
+AtMqttClient mqttClient(espSerial); // O ESP trata do protocolo MQTT
+#else
 WiFiClient wifiClient;
-PubSubClient mqttClient(wifiClient);
-server sv(SERVER_SSID, SERVER_PASSWORD, SERVER_IP, SERVER_PORT);
+AckTapClient mqttTransport(wifiClient); // Deteta PUBACKs para a fila QoS1
+PubSubClient mqttClient(mqttTransport);
+#endif
+server sv(config_data); // Valores de config.json, lidos antes de connection.begin()
+ConnectionManager connection;
 
 extern ExtMEM logs;
 
-// Receber MQTT
+// Receber MQTT: o payload é passado aos comandos sem cópia
 void callback(char *topic, byte *payload, unsigned int length)
 {
-  char message[length + 1];
-  memcpy(message, payload, length);
-  message[length] = '\0';
-  
-  logs.info("MQTT message received");
-  logs.debug(topic);
-  logs.debug(message);
-}
-
-// Ligar WiFi
-void connectWiFi()
-{
-  int tentativas = 0;
-  unsigned long startTime = millis();
-  
-  while (WiFi.status() != WL_CONNECTED && tentativas < 3 && (millis() - startTime) < 6000)
+  if (!commands.dispatch(topic, payload, length))
   {
-    WiFi.begin(sv.get_ssid(), sv.get_password());
-    tentativas++;
-    delay(2000);
+    logs.debug("MQTT: tópico sem comando");
+    logs.debug(topic);
   }
+}
 
-  if (WiFi.status() == WL_CONNECTED) {
-    logs.info("WiFi ligado");
-  } else {
-    logs.warning("WiFi falhou");
-  }
+ConnectionManager::ConnectionManager()
+{
+  state = CONNECTION_DOWN;
+  stateSince = 0;
+  nextAttempt = 0;
+  lastPoll = 0;
+  downSince = 0;
+  backoffMs = CONNECTION_BACKOFF_MIN;
+  memset(&stats, 0, sizeof(stats));
 }
 
-// Ligar MQTT
-void connectMQTT()
+void ConnectionManager::begin()
 {
-  if (WiFi.status() != WL_CONNECTED) {
-    logs.warning("Cannot connect MQTT - No WiFi");
-    return;
-  }
-  
   mqttClient.setServer(sv.get_ip(), sv.get_port());
   mqttClient.setCallback(callback);
+  mqttClient.setSocketTimeout(MQTT_SOCKET_TIMEOUT_S);
+
+  downSince = millis();
+  nextAttempt = downSince; // Primeira tentativa imediata
+  enterState(CONNECTION_DOWN);
+}
 
-  int tentativas = 0;
-  while (!mqttClient.connected() && tentativas < 3)
+void ConnectionManager::update()
+{
+  unsigned long now = millis();
+
+  switch (state)
   {
-    logs.info("Connecting to MQTT...");
+  case CONNECTION_DOWN:
+    if (!isRetryDue(now))
+    {
+      break;
+    }
+    if (WiFi.status() == WL_CONNECTED)
+    {
+      onWiFiAssociated();
+      break;
+    }
+    logs.info("A ligar ao WiFi...");
+    stats.wifiAttempts++;
+    WiFi.begin(sv.get_ssid(), sv.get_password()); // Limitado pelo timeout AT
+    enterState(CONNECTION_ASSOCIATING);
+    break;
+
+  case CONNECTION_ASSOCIATING:
+    if (now - lastPoll < CONNECTION_POLL_INTERVAL)
+    {
+      break;
+    }
+    lastPoll = now;
+    if (WiFi.status() == WL_CONNECTED)
+    {
+      onWiFiAssociated();
+    }
+    else if (now - stateSince >= WIFI_ASSOCIATE_TIMEOUT)
+    {
+      stats.wifiFailures++;
+      logs.warning("Falha na ligação WiFi");
+      scheduleRetry();
+      enterState(CONNECTION_DOWN);
+    }
+    break;
+
+  case CONNECTION_CONNECTING:
+    if (!isRetryDue(now))
+    {
+      break;
+    }
+    if (WiFi.status() != WL_CONNECTED)
+    {
+      logs.warning("WiFi perdido antes do MQTT");
+      scheduleRetry();
+      enterState(CONNECTION_DOWN);
+      break;
+    }
+    {
+      logs.info("A ligar ao MQTT...");
+      stats.mqttAttempts++;
 
-    String clientId = "STM32_RECEIVER_";
-    clientId += String(random(0xffff), HEX);
+      char clientId[40];
+      snprintf(clientId, sizeof(clientId), "%s_%04lx", sv.get_client_id(), (unsigned long)random(0xffff));
+      if (mqttClient.connect(clientId)) // Limitado por MQTT_SOCKET_TIMEOUT_S
+      {
+        onMqttConnected();
+      }
+      else
+      {
+        stats.mqttFailures++;
+        stats.lastMqttState = mqttClient.state();
+        char msg[60];
+        snprintf(msg, sizeof(msg), "Falha na ligação MQTT, rc=%d", stats.lastMqttState);
+        logs.error(msg);
+        scheduleRetry();
+      }
+    }
+    break;
 
-    if (mqttClient.connect(clientId.c_str()))
+  case CONNECTION_UP:
+    mqttClient.loop();
+    if (now - lastPoll < CONNECTION_POLL_INTERVAL)
     {
-      logs.info("MQTT connected!");
-      mqttClient.subscribe("stm32/topic");
-      logs.info("Subscribed to stm32/topic");
       break;
     }
+    lastPoll = now;
+#if MQTT_TRANSPORT == MQTT_TRANSPORT_AT
+    // Sem AT+CIPSTATUS aqui: o WiFiEspAT descartaria URCs +MQTT*, e uma
+    // queda do WiFi chega como +MQTTDISCONNECTED
+    if (!mqttClient.connected())
+#else
+    if (WiFi.status() != WL_CONNECTED || !mqttClient.connected())
+#endif
+    {
+      stats.drops++;
+      stats.totalUpMs += now - stats.upSince;
+      downSince = now;
+      logs.warning("Ligação perdida");
+      nextAttempt = now; // Primeira tentativa sem espera, depois backoff
+      enterState(WiFi.status() == WL_CONNECTED ? CONNECTION_CONNECTING : CONNECTION_DOWN);
+    }
+#if MQTT_TRANSPORT != MQTT_TRANSPORT_AT
     else
     {
-      logs.error("MQTT failed. Retrying...");
-      char rcStr[10];
-      itoa(mqttClient.state(), rcStr, 10);
-      logs.debug(rcStr);
-      tentativas++;
-      if (tentativas < 3) delay(2000);
+      stats.rssi = WiFi.RSSI();
     }
+#endif
+    break;
   }
-}
\ No newline at end of file
+}
+
+bool ConnectionManager::isUp() const
+{
+  return state == CONNECTION_UP;
+}
+
+ConnectionState ConnectionManager::getState() const
+{
+  return state;
+}
+
+const ConnectionStats &ConnectionManager::getStats() const
+{
+  return stats;
+}
+
+void ConnectionManager::enterState(ConnectionState newState)
+{
+  state = newState;
+  stateSince = millis();
+  lastPoll = stateSince;
+}
+
+void ConnectionManager::scheduleRetry()
+{
+  // "Equal jitter": metade fixa, metade aleatória, para não sincronizar
+  // vários dispositivos a tentar ao mesmo tempo
+  uint32_t wait = backoffMs / 2 + (uint32_t)random(backoffMs / 2 + 1);
+  nextAttempt = millis() + wait;
+
+  backoffMs = backoffMs >= CONNECTION_BACKOFF_MAX / 2 ? CONNECTION_BACKOFF_MAX : backoffMs * 2;
+}
+
+bool ConnectionManager::isRetryDue(unsigned long now) const
+{
+  return (long)(now - nextAttempt) >= 0;
+}
+
+void ConnectionManager::onWiFiAssociated()
+{
+  char msg[60];
+  IPAddress ip = WiFi.localIP();
+  snprintf(msg, sizeof(msg), "WiFi ligado: %u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+  logs.info(msg);
+
+  nextAttempt = millis();
+  enterState(CONNECTION_CONNECTING);
+}
+
+void ConnectionManager::onMqttConnected()
+{
+  unsigned long now = millis();
+  stats.upSince = now;
+  stats.lastRecoveryMs = now - downSince;
+  stats.rssi = WiFi.RSSI();
+  backoffMs = CONNECTION_BACKOFF_MIN;
+
+  commands.subscribeAll(mqttClient); // Tópicos da tabela de comandos
+
+  char msg[96]; // 42 characters of text and five 10-digit counters
+  snprintf(msg, sizeof(msg), "MQTT ligado em %lu ms (WiFi %lu/%lu, MQTT %lu/%lu falhas)",
+           (unsigned long)stats.lastRecoveryMs,
+           (unsigned long)stats.wifiFailures, (unsigned long)stats.wifiAttempts,
+           (unsigned long)stats.mqttFailures, (unsigned long)stats.mqttAttempts);
+  logs.info(msg);
+
+  enterState(CONNECTION_UP);
+}
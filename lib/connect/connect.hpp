@@ -6,14 +6,129 @@
 
 #include <config.hpp>
 #include "server.hpp"
+#include "outbound.hpp"
+#include "atMqtt.hpp"
+
+// Same publish/subscribe API on both transports
+#if MQTT_TRANSPORT == MQTT_TRANSPORT_AT
+typedef AtMqttClient MqttClient;
+#else
+typedef PubSubClient MqttClient;
+#endif
+
+/// Link states, advanced one step per ConnectionManager::update()
+enum ConnectionState
+{
+  CONNECTION_DOWN,        // Waiting for the next attempt (backoff)
+  CONNECTION_ASSOCIATING, // WiFi join requested, waiting for the AP
+  CONNECTION_CONNECTING,  // WiFi up, MQTT session being opened
+  CONNECTION_UP           // WiFi and MQTT connected
+};
+
+/// Connection quality statistics
+struct ConnectionStats
+{
+  uint32_t wifiAttempts;  // WiFi join attempts
+  uint32_t wifiFailures;  // WiFi join attempts that timed out
+  uint32_t mqttAttempts;  // MQTT connect attempts
+  uint32_t mqttFailures;  // MQTT connect attempts refused or timed out
+  uint32_t drops;         // Times an UP link was lost
+  uint32_t lastRecoveryMs; // Time from DOWN to UP of the last recovery
+  uint32_t totalUpMs;     // Accumulated UP time (closed sessions)
+  uint32_t upSince;       // millis() of the current UP session
+  int32_t rssi;           // Last RSSI read while UP (dBm)
+  int lastMqttState;      // Last MqttClient state() after a failure
+};
+
+/// ConnectionManager
+/// @brief Non-blocking WiFi/MQTT state machine with jittered exponential
+/// backoff. Never waits inside update(), so loop() keeps its cadence while
+/// the access point or the broker are unreachable.
+///
+class ConnectionManager
+{
+public:
+  /// ConnectionManager
+  /// @brief Class constructor
+  ///
+  /// @param[in] none
+  ///
+  /// @return none
+  ///
+  ConnectionManager();
+
+  /// begin
+  /// @brief Configures the MQTT client and schedules the first attempt
+  ///
+  /// @param none
+  ///
+  /// @return none
+  ///
+  void begin();
+
+  /// update
+  /// @brief Advances the state machine one step, call on every loop() pass
+  ///
+  /// @param none
+  ///
+  /// @return none
+  ///
+  void update();
+
+  /// isUp
+  /// @brief Whether WiFi and MQTT are both connected
+  ///
+  /// @param none
+  ///
+  /// @return true if the link is UP
+  ///
+  bool isUp() const;
+
+  /// getState
+  /// @brief Current state of the link
+  ///
+  /// @param none
+  ///
+  /// @return connection state
+  ///
+  ConnectionState getState() const;
+
+  /// getStats
+  /// @brief Connection quality statistics
+  ///
+  /// @param none
+  ///
+  /// @return reference to the statistics
+  ///
+  const ConnectionStats &getStats() const;
+
+private:
+  // Private methods
+  void enterState(ConnectionState newState);
+  void scheduleRetry();
+  bool isRetryDue(unsigned long now) const;
+  void onWiFiAssociated();
+  void onMqttConnected();
+
+  // Private attributes
+  ConnectionState state;
+  unsigned long stateSince;  // millis() when the current state was entered
+  unsigned long nextAttempt; // millis() of the next attempt
+  unsigned long lastPoll;    // millis() of the last link health check
+  unsigned long downSince;   // millis() when the link was lost
+  uint32_t backoffMs;        // Current backoff ceiling
+  ConnectionStats stats;
+};
 
 // External declarations of WiFi and MQTT clients
+#if MQTT_TRANSPORT != MQTT_TRANSPORT_AT
 extern WiFiClient wifiClient;
-extern PubSubClient mqttClient;
+extern AckTapClient mqttTransport;
+#endif
+extern MqttClient mqttClient;
 extern server sv;
+extern ConnectionManager connection;
 
 void callback(char *topic, byte *payload, unsigned int length);
-void connectWiFi();
-void connectMQTT();
 
-#endif // CONNECT_HPP
\ No newline at end of file
+#endif // CONNECT_HPP
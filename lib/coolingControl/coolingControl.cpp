@@ -0,0 +1,191 @@
+// Local Includes
+#include "coolingControl.hpp"
+
+// Framework libs
+#include <math.h>
+#include <string.h>
+
+static float clampOutput(float value)
+{
+  return value < 0 ? 0 : (value > 1 ? 1 : value);
+}
+
+// ========== CoolingController ==========
+
+CoolingController::CoolingController()
+{
+  strategy = CONTROL_HYSTERESIS;
+  kp = 0;
+  ki = 0;
+  low = 0;
+  high = 0;
+  integral = 0;
+  output = 0;
+}
+
+void CoolingController::setStrategy(ControlStrategy newStrategy)
+{
+  if (newStrategy < CONTROL_STRATEGIES && newStrategy != strategy)
+  {
+    strategy = newStrategy;
+    integral = output; // PI picks up where the previous output was
+  }
+}
+
+void CoolingController::setGains(float newKp, float newKi)
+{
+  kp = newKp;
+  ki = newKi;
+}
+
+void CoolingController::setSetpoints(float newLow, float newHigh)
+{
+  low = newLow;
+  high = newHigh;
+}
+
+float CoolingController::update(float temperature, float periodS)
+{
+  if (isnan(temperature))
+  {
+    return output;
+  }
+
+  if (strategy == CONTROL_HYSTERESIS)
+  {
+    if (temperature >= high)
+    {
+      output = 1;
+    }
+    else if (temperature <= low)
+    {
+      output = 0;
+    }
+    integral = output;
+    return output;
+  }
+
+  // Cooling: a positive error (too warm) asks for more output
+  float error = temperature - (low + high) / 2;
+  float proportional = kp * error;
+  float unclamped = proportional + integral;
+
+  // Conditional integration: hold the integral while saturated in the
+  // direction the error pushes
+  bool isHeldHigh = unclamped >= 1 && error > 0;
+  bool isHeldLow = unclamped <= 0 && error < 0;
+  if (!isHeldHigh && !isHeldLow)
+  {
+    integral = clampOutput(integral + ki * error * periodS);
+  }
+  output = clampOutput(proportional + integral);
+  return output;
+}
+
+void CoolingController::track(float imposed, float temperature)
+{
+  output = clampOutput(imposed);
+  float proportional = isnan(temperature) ? 0 : kp * (temperature - (low + high) / 2);
+  integral = clampOutput(output - proportional);
+}
+
+float CoolingController::getOutput() const
+{
+  return output;
+}
+
+float CoolingController::getIntegral() const
+{
+  return integral;
+}
+
+ControlStrategy CoolingController::getStrategy() const
+{
+  return strategy;
+}
+
+// ========== RelayWindow ==========
+
+RelayWindow::RelayWindow(uint32_t periodUs, uint32_t windowUs, uint32_t minOnUs, uint32_t minOffUs)
+    : periodUs(periodUs), windowUs(windowUs > periodUs ? windowUs : periodUs), minOnUs(minOnUs),
+      minOffUs(minOffUs), stateUs(minOffUs), debtUs(0), isOn(false)
+{
+}
+
+bool RelayWindow::next(float output)
+{
+  output = output < 0 ? 0 : (output > 1 ? 1 : output);
+
+  // Band of +-window/8 on the undelivered on time: one full window per
+  // cycle at 50 %. Output 0 or 1 switches at once, and the state only
+  // changes once its minimum is over
+  float bandUs = windowUs / 8.0f;
+  bool isDue = isOn ? output <= 0 || debtUs <= -bandUs : output >= 1 || debtUs >= bandUs;
+  if (isDue && stateUs >= (isOn ? minOnUs : minOffUs))
+  {
+    isOn = !isOn;
+    stateUs = 0;
+  }
+  stateUs += stateUs < minOnUs + minOffUs ? periodUs : 0;
+
+  // On time asked for minus on time given; what a minimum time adds or
+  // holds back is made up over the next cycles, so the mean follows output
+  debtUs += (output - (isOn ? 1 : 0)) * periodUs;
+  float limitUs = windowUs + (minOnUs > minOffUs ? minOnUs : minOffUs);
+  debtUs = debtUs > limitUs ? limitUs : (debtUs < -limitUs ? -limitUs : debtUs);
+  return isOn;
+}
+
+void RelayWindow::stop()
+{
+  isOn = false;
+  stateUs = 0;
+  debtUs = 0;
+}
+
+// ========== ControlTiming ==========
+
+ControlTiming::ControlTiming()
+{
+  begin(0);
+}
+
+void ControlTiming::begin(uint32_t nominalUs)
+{
+  memset(&stats, 0, sizeof(stats));
+  periodUs = nominalUs;
+  lastStartUs = 0;
+}
+
+void ControlTiming::record(uint32_t startUs, uint32_t actuatedUs)
+{
+  if (stats.periods > 0)
+  {
+    uint32_t measuredUs = startUs - lastStartUs;
+    uint32_t jitterUs = measuredUs > periodUs ? measuredUs - periodUs : periodUs - measuredUs;
+    stats.jitterLastUs = jitterUs;
+    stats.jitterSumUs += jitterUs;
+    if (jitterUs > stats.jitterMaxUs)
+    {
+      stats.jitterMaxUs = jitterUs;
+    }
+    if (measuredUs > periodUs + periodUs / 2)
+    {
+      stats.missed++;
+    }
+  }
+  lastStartUs = startUs;
+  stats.periods++;
+
+  uint32_t latencyUs = actuatedUs - startUs;
+  stats.latencyLastUs = latencyUs;
+  if (latencyUs > stats.latencyMaxUs)
+  {
+    stats.latencyMaxUs = latencyUs;
+  }
+}
+
+const ControlTimingStats &ControlTiming::getStats() const
+{
+  return stats;
+}
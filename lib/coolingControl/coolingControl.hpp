@@ -0,0 +1,211 @@
+#ifndef COOLINGCONTROL_HPP
+#define COOLINGCONTROL_HPP
+
+// Framework libs
+#include <stdint.h>
+
+enum ControlStrategy : uint8_t
+{
+  CONTROL_HYSTERESIS, // On above the high setpoint, off below the low one
+  CONTROL_PI,         // Proportional-integral towards the middle of the band
+  CONTROL_STRATEGIES
+};
+
+/// CoolingController
+/// @brief Cooling actuator controller called at a fixed rate. The output is
+/// the cooling demand in 0..1: on/off for the hysteresis strategy, a duty
+/// cycle for PI. The PI integral only moves while the output is not pushed
+/// further into saturation (conditional integration), so a long overload
+/// does not leave a wound-up integral behind. No Arduino dependencies and
+/// no clock of its own: the same inputs give the same outputs on the board
+/// and on the host.
+///
+class CoolingController
+{
+public:
+  /// CoolingController
+  /// @brief Class constructor, hysteresis strategy, output off
+  ///
+  /// @param[in] none
+  ///
+  /// @return none
+  ///
+  CoolingController();
+
+  /// setStrategy
+  /// @brief Hysteresis or PI. The new strategy starts from the current
+  ///        output, so the switch is bumpless.
+  ///
+  /// @param[in] strategy: CONTROL_HYSTERESIS or CONTROL_PI
+  ///
+  /// @return none
+  ///
+  void setStrategy(ControlStrategy strategy);
+
+  /// setGains
+  /// @brief PI gains, temperatures in °C and time in seconds
+  ///
+  /// @param[in] kp: Output per °C above the target
+  /// @param[in] ki: Output per °C·s above the target
+  ///
+  /// @return none
+  ///
+  void setGains(float kp, float ki);
+
+  /// setSetpoints
+  /// @brief Temperature band: the hysteresis limits, the PI target is its middle
+  ///
+  /// @param[in] low: Lower limit (°C)
+  /// @param[in] high: Upper limit (°C)
+  ///
+  /// @return none
+  ///
+  void setSetpoints(float low, float high);
+
+  /// update
+  /// @brief One control period
+  ///
+  /// @param[in] temperature: Measured temperature (NaN holds the output)
+  /// @param[in] periodS: Time since the previous update, in seconds
+  ///
+  /// @return Cooling demand, 0..1
+  ///
+  float update(float temperature, float periodS);
+
+  /// track
+  /// @brief Output imposed from outside (manual mode, emergency). The
+  ///        integral is set so that PI would give the same output at this
+  ///        temperature, and automatic control resumes without a bump.
+  ///
+  /// @param[in] output: Imposed output, clamped to 0..1
+  /// @param[in] temperature: Measured temperature (NaN: integral = output)
+  ///
+  /// @return none
+  ///
+  void track(float output, float temperature);
+
+  /// getOutput
+  /// @brief Last output
+  float getOutput() const;
+
+  /// getIntegral
+  /// @brief PI integral term, in output units
+  float getIntegral() const;
+
+  /// getStrategy
+  /// @brief Strategy in use
+  ControlStrategy getStrategy() const;
+
+private:
+  ControlStrategy strategy;
+  float kp;
+  float ki;
+  float low;
+  float high;
+  float integral;
+  float output;
+};
+
+/// RelayWindow
+/// @brief Time-proportional output for an on/off actuator: within each
+/// window of whole control periods the relay is on for the fraction the
+/// output asks for. The relay never stays on or off for less than its
+/// minimum time: low or high demand gives longer cycles instead, and what
+/// a minimum time adds or holds back is made up over the following cycles,
+/// so the mean on time still follows the output.
+///
+class RelayWindow
+{
+public:
+  /// RelayWindow
+  /// @brief Class constructor
+  ///
+  /// @param[in] periodUs: Control period
+  /// @param[in] windowUs: Window, a multiple of the period
+  /// @param[in] minOnUs: Shortest time the relay stays on once switched on
+  /// @param[in] minOffUs: Shortest time the relay stays off once switched off
+  ///
+  /// @return none
+  ///
+  RelayWindow(uint32_t periodUs, uint32_t windowUs, uint32_t minOnUs = 0, uint32_t minOffUs = 0);
+
+  /// next
+  /// @brief Relay state for the coming control period
+  ///
+  /// @param[in] output: Demand, 0..1
+  ///
+  /// @return true if the relay must be on
+  ///
+  bool next(float output);
+
+  /// stop
+  /// @brief Relay off now, whatever its minimum on time (emergency); the
+  ///        minimum off time counts from here
+  ///
+  /// @param none
+  ///
+  /// @return none
+  ///
+  void stop();
+
+private:
+  uint32_t periodUs;
+  uint32_t windowUs;
+  uint32_t minOnUs;
+  uint32_t minOffUs;
+  uint32_t stateUs; // Time in the current state, saturating past both minimums
+  float debtUs;     // On time asked for and not given yet (negative: given in excess)
+  bool isOn;
+};
+
+/// Period jitter and actuation latency of the fixed-rate control interrupt
+struct ControlTimingStats
+{
+  uint32_t periods;       // Interrupts recorded
+  uint32_t jitterLastUs;  // |measured period - nominal period|
+  uint32_t jitterMaxUs;
+  uint64_t jitterSumUs;
+  uint32_t latencyLastUs; // Interrupt entry to output written
+  uint32_t latencyMaxUs;
+  uint32_t missed;        // Periods longer than 1.5 nominal periods
+};
+
+/// ControlTiming
+/// @brief Records when each control interrupt starts and when its output
+/// is written, against the nominal period
+///
+class ControlTiming
+{
+public:
+  ControlTiming();
+
+  /// begin
+  /// @brief Clears the counters
+  ///
+  /// @param[in] periodUs: Nominal period in microseconds
+  ///
+  /// @return none
+  ///
+  void begin(uint32_t periodUs);
+
+  /// record
+  /// @brief One control interrupt
+  ///
+  /// @param[in] startUs: Interrupt entry
+  /// @param[in] actuatedUs: Output written
+  ///
+  /// @return none
+  ///
+  void record(uint32_t startUs, uint32_t actuatedUs);
+
+  /// getStats
+  /// @brief Counters since begin()
+  const ControlTimingStats &getStats() const;
+
+private:
+  ControlTimingStats stats;
+  uint32_t periodUs;
+  uint32_t lastStartUs;
+};
+
+#endif // COOLINGCONTROL_HPP
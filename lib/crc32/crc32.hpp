@@ -0,0 +1,20 @@
+#ifndef CRC32_HPP
+#define CRC32_HPP
+
+// Framework libs
+#include <stddef.h>
+#include <stdint.h>
+
+/// crc32
+/// @brief CRC-32 (IEEE 802.3, reflected) with a nibble table to stay small.
+///        Chains like zlib: pass the previous result to continue a stream.
+///
+/// @param[in] data: Bytes to check
+/// @param[in] length: Number of bytes
+/// @param[in] previous: CRC of the preceding bytes, 0 to start
+///
+/// @return CRC value
+///
+uint32_t crc32(const uint8_t *data, size_t length, uint32_t previous = 0);
+
+#endif // CRC32_HPP
@@ -0,0 +1,166 @@
+// Local Includes
+#include "deviceConfig.hpp"
+#include "crc32.hpp"
+
+extern SdFat sd;
+
+static const char SNAPSHOT_MAGIC[4] = {'C', 'F', 'G', '1'};
+static constexpr uint8_t READ_CHUNK = 64;
+
+DeviceConfig deviceConfig;
+
+static uint32_t snapshotCrc(const ConfigSnapshotHeader &header, const configData &config)
+{
+  uint32_t crc = crc32((const uint8_t *)&header, offsetof(ConfigSnapshotHeader, crc));
+  return crc32((const uint8_t *)&config, sizeof(config), crc);
+}
+
+DeviceConfig::DeviceConfig()
+{
+  source = CONFIG_DEFAULTS;
+  loadUs = 0;
+}
+
+ConfigSource DeviceConfig::load()
+{
+  uint32_t started = micros();
+  loadConfigDefaults(config_data);
+  source = CONFIG_DEFAULTS;
+
+  ConfigSnapshotHeader current;
+  if (sd.fatType() != 0)
+  {
+    bool isCreated = false;
+    if (!sd.exists(CONFIG_FILENAME))
+    {
+      isCreated = createSource();
+    }
+
+    if (!readSourceInfo(current))
+    {
+      source = readSnapshot(nullptr) ? CONFIG_FROM_OLD_SNAPSHOT : CONFIG_DEFAULTS;
+    }
+    else if (readSnapshot(&current))
+    {
+      source = CONFIG_FROM_SNAPSHOT;
+    }
+    else if (parseSource())
+    {
+      writeSnapshot(current);
+      source = isCreated ? CONFIG_CREATED : CONFIG_FROM_FILE;
+    }
+    else if (readSnapshot(nullptr))
+    {
+      source = CONFIG_FROM_OLD_SNAPSHOT; // Keep running with the last config that was valid
+    }
+  }
+
+  loadUs = micros() - started;
+  return source;
+}
+
+ConfigSource DeviceConfig::getSource() const
+{
+  return source;
+}
+
+uint32_t DeviceConfig::getLoadUs() const
+{
+  return loadUs;
+}
+
+const ConfigParser &DeviceConfig::getParser() const
+{
+  return parser;
+}
+
+bool DeviceConfig::readSourceInfo(ConfigSnapshotHeader &header)
+{
+  memset(&header, 0, sizeof(header));
+  if (!configFile.open(CONFIG_FILENAME, O_RDONLY))
+  {
+    return false;
+  }
+  header.sourceSize = configFile.fileSize();
+  bool isDated = configFile.getModifyDateTime(&header.sourceDate, &header.sourceTime);
+  configFile.close();
+  return isDated;
+}
+
+bool DeviceConfig::readSnapshot(const ConfigSnapshotHeader *expected)
+{
+  ConfigSnapshotHeader header;
+  bool isRead = false;
+  if (configFile.open(CONFIG_SNAPSHOT_FILENAME, O_RDONLY))
+  {
+    isRead = configFile.read(&header, sizeof(header)) == (int)sizeof(header) &&
+             configFile.read(&config_data, sizeof(config_data)) == (int)sizeof(config_data);
+    configFile.close();
+  }
+
+  bool isValid = isRead && memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0 &&
+                 header.version == CONFIG_SNAPSHOT_VERSION && header.size == sizeof(configData) &&
+                 header.crc == snapshotCrc(header, config_data);
+  if (isValid && expected)
+  {
+    isValid = header.sourceSize == expected->sourceSize && header.sourceDate == expected->sourceDate &&
+              header.sourceTime == expected->sourceTime;
+  }
+  if (!isValid)
+  {
+    loadConfigDefaults(config_data); // Never run on half a snapshot, nor on what a failed parse left
+  }
+  return isValid;
+}
+
+bool DeviceConfig::writeSnapshot(const ConfigSnapshotHeader &source)
+{
+  ConfigSnapshotHeader header = source;
+  memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+  header.version = CONFIG_SNAPSHOT_VERSION;
+  header.size = sizeof(configData);
+  header.crc = snapshotCrc(header, config_data);
+
+  // A torn write fails the CRC and config.json is parsed again next boot
+  if (!configFile.open(CONFIG_SNAPSHOT_FILENAME, O_WRONLY | O_CREAT | O_TRUNC))
+  {
+    return false;
+  }
+  bool isWritten = configFile.write(&header, sizeof(header)) == sizeof(header) &&
+                   configFile.write(&config_data, sizeof(config_data)) == sizeof(config_data);
+  return configFile.close() && isWritten;
+}
+
+bool DeviceConfig::parseSource()
+{
+  if (!configFile.open(CONFIG_FILENAME, O_RDONLY))
+  {
+    return false;
+  }
+
+  char chunk[READ_CHUNK];
+  bool isValid = true;
+  parser.begin(config_data);
+  int count;
+  while (isValid && (count = configFile.read(chunk, sizeof(chunk))) > 0)
+  {
+    isValid = parser.feed(chunk, count);
+  }
+  configFile.close();
+  isValid = parser.end() && isValid;
+  if (!isValid)
+  {
+    loadConfigDefaults(config_data); // Keys before the error were already applied
+  }
+  return isValid;
+}
+
+bool DeviceConfig::createSource()
+{
+  if (!configFile.open(CONFIG_FILENAME, O_WRONLY | O_CREAT | O_TRUNC))
+  {
+    return false;
+  }
+  bool isWritten = writeConfigJson(configFile, config_data); // config_data holds the defaults here
+  return configFile.close() && isWritten;
+}
@@ -0,0 +1,89 @@
+#ifndef DEVICECONFIG_HPP
+#define DEVICECONFIG_HPP
+
+// Framework libs
+#include <SdFat.h>
+
+// Local Includes
+#include <config.hpp>
+#include "configParser.hpp"
+
+/// Where the configuration in use came from
+enum ConfigSource : uint8_t
+{
+  CONFIG_FROM_SNAPSHOT,     // config.bin, config.json unchanged
+  CONFIG_FROM_FILE,         // config.json parsed, config.bin rewritten
+  CONFIG_CREATED,           // config.json missing, written with the defaults
+  CONFIG_FROM_OLD_SNAPSHOT, // config.json invalid, last good config.bin kept
+  CONFIG_DEFAULTS           // No card, or nothing usable on it
+};
+
+/// ConfigSnapshotHeader
+/// @brief Start of config.bin, followed by configData. The source fields
+///        identify the config.json the snapshot was made from.
+///
+struct ConfigSnapshotHeader
+{
+  char magic[4];       // "CFG1"
+  uint16_t version;    // CONFIG_SNAPSHOT_VERSION
+  uint16_t size;       // sizeof(configData)
+  uint32_t sourceSize; // config.json size (bytes)
+  uint16_t sourceDate; // config.json FAT modify date
+  uint16_t sourceTime; // config.json FAT modify time
+  uint32_t crc;        // CRC-32 of the fields above and the payload
+};
+
+/// DeviceConfig
+/// @brief Loads config_data at boot. config.json is parsed only when it
+/// changed (size or modify time differ from the ones recorded in
+/// config.bin); otherwise the CRC-checked binary copy is read in one go.
+///
+class DeviceConfig
+{
+public:
+  /// DeviceConfig
+  /// @brief Class constructor
+  ///
+  /// @param[in] none
+  ///
+  /// @return none
+  ///
+  DeviceConfig();
+
+  /// load
+  /// @brief Fills config_data from the card. Must be called after the SD
+  ///        card is mounted; without a card the defaults are used.
+  ///
+  /// @param[in] none
+  ///
+  /// @return where the configuration came from
+  ///
+  ConfigSource load();
+
+  ConfigSource getSource() const;
+  uint32_t getLoadUs() const;
+
+  /// getParser
+  /// @brief Counters and error of the last parse of config.json (only
+  ///        meaningful when the source is not CONFIG_FROM_SNAPSHOT)
+  ///
+  const ConfigParser &getParser() const;
+
+private:
+  // Private methods
+  bool readSourceInfo(ConfigSnapshotHeader &header);
+  bool readSnapshot(const ConfigSnapshotHeader *expected);
+  bool writeSnapshot(const ConfigSnapshotHeader &source);
+  bool parseSource();
+  bool createSource();
+
+  // Private attributes
+  SdFile configFile;
+  ConfigParser parser;
+  ConfigSource source;
+  uint32_t loadUs;
+};
+
+extern DeviceConfig deviceConfig;
+
+#endif // DEVICECONFIG_HPP
@@ -0,0 +1,331 @@
+// Local Includes
+#include "espUart.hpp"
+
+#if defined(ARDUINO_ARCH_STM32)
+// USART1 on the STM32L476: RX on DMA1 channel 5, TX on DMA1 channel 4 (request 2)
+static DMA_HandleTypeDef dmaRx;
+static DMA_HandleTypeDef dmaTx;
+static DmaSerial *dmaSerial = nullptr;
+
+extern "C" void DMA1_Channel4_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&dmaTx);
+}
+
+extern "C" void DMA1_Channel5_IRQHandler(void)
+{
+  HAL_DMA_IRQHandler(&dmaRx);
+}
+
+// Idle line, half and full ring events of HAL_UARTEx_ReceiveToIdle_DMA
+extern "C" void HAL_UARTEx_RxEventCallback(UART_HandleTypeDef *huart, uint16_t position)
+{
+  if (dmaSerial && huart->Instance == USART1)
+  {
+    dmaSerial->onRxEvent(position);
+  }
+}
+#endif
+
+DmaSerial::DmaSerial(uint32_t rx, uint32_t tx) : HardwareSerial(rx, tx)
+{
+  baudRate = 0;
+  isFlowControl = false;
+  memset(&stats, 0, sizeof(stats));
+  rxRead = 0;
+  rxEventPosition = 0;
+  rxProduced = 0;
+  rxConsumed = 0;
+  txLength = 0;
+  txFill = 0;
+}
+
+void DmaSerial::begin(unsigned long baud, bool flowControl)
+{
+  baudRate = baud;
+  isFlowControl = flowControl;
+
+#if defined(ARDUINO_ARCH_STM32)
+  if (flowControl)
+  {
+    setRts(ESP_UART_RTS_PIN);
+    setCts(ESP_UART_CTS_PIN);
+  }
+#endif
+
+  HardwareSerial::begin(baud);
+  startDma();
+}
+
+bool DmaSerial::negotiateBaud(unsigned long baud, bool flowControl)
+{
+  flush();
+  while (available())
+  {
+    read();
+  }
+
+  // Flow control: 0 = none, 3 = RTS and CTS
+  char command[48];
+  snprintf(command, sizeof(command), "AT+UART_CUR=%lu,8,1,0,%d\r\n", baud, flowControl ? 3 : 0);
+  write((const uint8_t *)command, strlen(command));
+  flush();
+
+  // The modem answers OK at the old rate and then switches
+  if (!waitForOk(ESP_UART_AT_TIMEOUT))
+  {
+    return false;
+  }
+
+  unsigned long previousBaud = baudRate;
+  bool previousFlowControl = isFlowControl;
+  delay(ESP_UART_SWITCH_DELAY);
+  begin(baud, flowControl);
+
+  const char *probe = "AT\r\n";
+  write((const uint8_t *)probe, strlen(probe));
+  flush();
+  if (waitForOk(ESP_UART_AT_TIMEOUT))
+  {
+    return true;
+  }
+
+  // No answer at the new rate: assume the OK was garbled and the modem stayed
+  begin(previousBaud, previousFlowControl);
+  return false;
+}
+
+unsigned long DmaSerial::getBaud() const
+{
+  return baudRate;
+}
+
+const EspUartStats &DmaSerial::getStats() const
+{
+  return stats;
+}
+
+int DmaSerial::available()
+{
+#if defined(ARDUINO_ARCH_STM32)
+  kickTx(); // The driver polls for the answer right after writing a command
+  uint16_t writeIndex = rxWriteIndex(); // One DMA snapshot for the check and the count
+
+  // rxProduced only moves on RX events, so the reader is often ahead of it
+  // with bytes the DMA wrote since: only a lead of a whole ring is an overrun
+  if ((int32_t)(rxProduced - rxConsumed) > (int32_t)ESP_UART_RX_DMA_SIZE)
+  {
+    // The DMA lapped the reader, what is left in the ring is garbage
+    stats.overruns++;
+    rxConsumed = rxProduced;
+    rxRead = writeIndex;
+  }
+  return (writeIndex + ESP_UART_RX_DMA_SIZE - rxRead) % ESP_UART_RX_DMA_SIZE;
+#else
+  return HardwareSerial::available();
+#endif
+}
+
+int DmaSerial::read()
+{
+#if defined(ARDUINO_ARCH_STM32)
+  if (available() == 0)
+  {
+    return -1;
+  }
+  uint8_t b = rxRing[rxRead];
+  rxRead = (rxRead + 1) % ESP_UART_RX_DMA_SIZE;
+  rxConsumed++;
+  return b;
+#else
+  return HardwareSerial::read();
+#endif
+}
+
+int DmaSerial::peek()
+{
+#if defined(ARDUINO_ARCH_STM32)
+  if (available() == 0)
+  {
+    return -1;
+  }
+  return rxRing[rxRead];
+#else
+  return HardwareSerial::peek();
+#endif
+}
+
+size_t DmaSerial::write(uint8_t b)
+{
+  return write(&b, 1);
+}
+
+size_t DmaSerial::write(const uint8_t *buffer, size_t size)
+{
+#if defined(ARDUINO_ARCH_STM32)
+  size_t written = 0;
+  while (written < size)
+  {
+    if (txLength == ESP_UART_TX_SIZE)
+    {
+      kickTx();
+      continue; // Fill buffer still full: the other one is on the wire
+    }
+    size_t chunk = min((size_t)(ESP_UART_TX_SIZE - txLength), size - written);
+    memcpy(txBuffers[txFill] + txLength, buffer + written, chunk);
+    txLength += chunk;
+    written += chunk;
+  }
+  stats.txBytes += size;
+  return size;
+#else
+  stats.txBytes += size;
+  return HardwareSerial::write(buffer, size);
+#endif
+}
+
+void DmaSerial::flush()
+{
+#if defined(ARDUINO_ARCH_STM32)
+  UART_HandleTypeDef *huart = &_serial.handle;
+  while (txLength > 0 || huart->gState != HAL_UART_STATE_READY)
+  {
+    kickTx();
+  }
+#else
+  HardwareSerial::flush();
+#endif
+}
+
+void DmaSerial::startDma()
+{
+#if defined(ARDUINO_ARCH_STM32)
+  UART_HandleTypeDef *huart = &_serial.handle;
+
+  // HardwareSerial::begin() armed the one-byte interrupt reception, take over
+  HAL_UART_AbortReceive(huart);
+
+  __HAL_RCC_DMA1_CLK_ENABLE();
+
+  dmaRx.Instance = DMA1_Channel5;
+  dmaRx.Init.Request = DMA_REQUEST_2;
+  dmaRx.Init.Direction = DMA_PERIPH_TO_MEMORY;
+  dmaRx.Init.PeriphInc = DMA_PINC_DISABLE;
+  dmaRx.Init.MemInc = DMA_MINC_ENABLE;
+  dmaRx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+  dmaRx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+  dmaRx.Init.Mode = DMA_CIRCULAR;
+  dmaRx.Init.Priority = DMA_PRIORITY_HIGH;
+  HAL_DMA_DeInit(&dmaRx);
+  HAL_DMA_Init(&dmaRx);
+  __HAL_LINKDMA(huart, hdmarx, dmaRx);
+
+  dmaTx.Instance = DMA1_Channel4;
+  dmaTx.Init.Request = DMA_REQUEST_2;
+  dmaTx.Init.Direction = DMA_MEMORY_TO_PERIPH;
+  dmaTx.Init.PeriphInc = DMA_PINC_DISABLE;
+  dmaTx.Init.MemInc = DMA_MINC_ENABLE;
+  dmaTx.Init.PeriphDataAlignment = DMA_PDATAALIGN_BYTE;
+  dmaTx.Init.MemDataAlignment = DMA_MDATAALIGN_BYTE;
+  dmaTx.Init.Mode = DMA_NORMAL;
+  dmaTx.Init.Priority = DMA_PRIORITY_MEDIUM;
+  HAL_DMA_DeInit(&dmaTx);
+  HAL_DMA_Init(&dmaTx);
+  __HAL_LINKDMA(huart, hdmatx, dmaTx);
+
+  HAL_NVIC_SetPriority(DMA1_Channel4_IRQn, 1, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel4_IRQn);
+  HAL_NVIC_SetPriority(DMA1_Channel5_IRQn, 1, 0);
+  HAL_NVIC_EnableIRQ(DMA1_Channel5_IRQn);
+
+  rxRead = 0;
+  rxEventPosition = 0;
+  rxProduced = 0;
+  rxConsumed = 0;
+  txLength = 0;
+  dmaSerial = this;
+
+  HAL_UARTEx_ReceiveToIdle_DMA(huart, rxRing, ESP_UART_RX_DMA_SIZE);
+#endif
+}
+
+void DmaSerial::kickTx()
+{
+#if defined(ARDUINO_ARCH_STM32)
+  UART_HandleTypeDef *huart = &_serial.handle;
+  if (txLength == 0 || huart->gState != HAL_UART_STATE_READY)
+  {
+    return;
+  }
+
+  if (HAL_UART_Transmit_DMA(huart, txBuffers[txFill], txLength) == HAL_OK)
+  {
+    stats.txBursts++;
+    txFill ^= 1; // Keep filling the other buffer while this one is sent
+    txLength = 0;
+  }
+#endif
+}
+
+uint16_t DmaSerial::rxWriteIndex() const
+{
+#if defined(ARDUINO_ARCH_STM32)
+  return (ESP_UART_RX_DMA_SIZE - __HAL_DMA_GET_COUNTER(&dmaRx)) % ESP_UART_RX_DMA_SIZE;
+#else
+  return 0;
+#endif
+}
+
+bool DmaSerial::waitForOk(uint32_t timeoutMs)
+{
+  // Matches "OK" at the start of a line, anything else is ignored
+  uint8_t matched = 0;
+  bool isLineStart = true;
+  unsigned long start = millis();
+
+  while (millis() - start < timeoutMs)
+  {
+    int c = read();
+    if (c < 0)
+    {
+      continue;
+    }
+    if (c == '\n')
+    {
+      if (matched == 2)
+      {
+        return true;
+      }
+      isLineStart = true;
+      matched = 0;
+      continue;
+    }
+    if (c == '\r')
+    {
+      continue;
+    }
+    if (isLineStart && matched < 2 && c == "OK"[matched])
+    {
+      matched++;
+    }
+    else
+    {
+      isLineStart = false;
+      matched = 0;
+    }
+  }
+  return false;
+}
+
+#if defined(ARDUINO_ARCH_STM32)
+void DmaSerial::onRxEvent(uint16_t position)
+{
+  // position is the DMA write index at the event (half, full or idle line)
+  uint16_t received = (position + ESP_UART_RX_DMA_SIZE - rxEventPosition) % ESP_UART_RX_DMA_SIZE;
+  rxEventPosition = position % ESP_UART_RX_DMA_SIZE;
+  rxProduced += received;
+  stats.rxBytes += received;
+  stats.rxEvents++;
+  stats.lastRxEventUs = micros();
+}
+#endif
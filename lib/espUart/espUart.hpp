@@ -0,0 +1,117 @@
+#ifndef ESPUART_HPP
+#define ESPUART_HPP
+
+// Framework libs
+#include <Arduino.h>
+#include <HardwareSerial.h>
+
+// Local Includes
+#include <config.hpp>
+
+/// Transfer counters of the ESP link
+struct EspUartStats
+{
+  uint32_t rxBytes;    // Bytes received by DMA
+  uint32_t txBytes;    // Bytes handed to the TX DMA
+  uint32_t rxEvents;   // Idle-line / half / full buffer events
+  uint32_t txBursts;   // DMA transmissions started
+  uint32_t overruns;   // Times the RX ring was overwritten before being read
+  uint32_t lastRxEventUs; // micros() of the last RX event (end of a burst)
+};
+
+/// DmaSerial
+/// @brief Serial port for the ESP8266 with DMA circular reception, idle-line
+/// detection and double-buffered DMA transmission. Drop-in Stream for
+/// WiFi.init(): the CPU no longer takes one interrupt per byte, so reception
+/// survives the DHT driver masking interrupts for a whole read.
+/// On builds other than STM32 it behaves as the plain HardwareSerial.
+///
+class DmaSerial : public HardwareSerial
+{
+public:
+  /// DmaSerial
+  /// @brief Class constructor
+  ///
+  /// @param[in] rx: RX pin
+  /// @param[in] tx: TX pin
+  ///
+  /// @return none
+  ///
+  DmaSerial(uint32_t rx, uint32_t tx);
+
+  /// begin
+  /// @brief Opens the port and starts DMA reception
+  ///
+  /// @param[in] baud: Baud rate
+  /// @param[in] flowControl: Enables RTS/CTS on ESP_UART_RTS_PIN/ESP_UART_CTS_PIN
+  ///
+  /// @return none
+  ///
+  void begin(unsigned long baud, bool flowControl = false);
+
+  /// negotiateBaud
+  /// @brief Asks the ESP-AT firmware to switch baud rate (AT+UART_CUR, not
+  ///        persisted) and follows it. Falls back to the current rate when
+  ///        the modem does not answer OK.
+  ///
+  /// @param[in] baud: New baud rate
+  /// @param[in] flowControl: Also enable RTS/CTS on both ends
+  ///
+  /// @return true if the link now runs at the new rate
+  ///
+  bool negotiateBaud(unsigned long baud, bool flowControl);
+
+  /// getBaud
+  /// @brief Current baud rate of the link
+  ///
+  /// @param none
+  ///
+  /// @return baud rate
+  ///
+  unsigned long getBaud() const;
+
+  /// getStats
+  /// @brief Transfer counters, used to report bytes/s and latency
+  ///
+  /// @param none
+  ///
+  /// @return reference to the counters
+  ///
+  const EspUartStats &getStats() const;
+
+  // Stream interface
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  void flush() override;
+  using Print::write;
+
+#if defined(ARDUINO_ARCH_STM32)
+  // Called from the HAL callbacks (interrupt context)
+  void onRxEvent(uint16_t position);
+#endif
+
+private:
+  void startDma();
+  bool waitForOk(uint32_t timeoutMs);
+  void kickTx();
+  uint16_t rxWriteIndex() const;
+
+  unsigned long baudRate;
+  bool isFlowControl;
+  EspUartStats stats;
+
+  uint8_t rxRing[ESP_UART_RX_DMA_SIZE]; // Written by DMA in circular mode
+  uint16_t rxRead;                      // Consumer index
+  uint16_t rxEventPosition;             // DMA position at the last event
+  volatile uint32_t rxProduced;         // Bytes written by DMA since start
+  uint32_t rxConsumed;                  // Bytes read by the driver since start
+
+  uint8_t txBuffers[2][ESP_UART_TX_SIZE]; // One filled while the other is sent
+  uint16_t txLength;                      // Bytes waiting in the fill buffer
+  uint8_t txFill;                         // Index of the fill buffer
+};
+
+#endif // ESPUART_HPP
@@ -0,0 +1,117 @@
+// Local Includes
+#include "format.hpp"
+
+// Math
+#include <math.h>
+
+// "00".."99", lets the converters emit two digits per division
+static const char DIGIT_PAIRS[201] =
+    "00010203040506070809"
+    "10111213141516171819"
+    "20212223242526272829"
+    "30313233343536373839"
+    "40414243444546474849"
+    "50515253545556575859"
+    "60616263646566676869"
+    "70717273747576777879"
+    "80818283848586878889"
+    "90919293949596979899";
+
+static const uint32_t POWERS_OF_TEN[] = {1, 10, 100, 1000, 10000};
+
+size_t formatUInt(char *out, uint32_t value)
+{
+  // Build backwards in a scratch buffer, then copy in order
+  char scratch[10];
+  char *p = scratch + sizeof(scratch);
+
+  while (value >= 100)
+  {
+    uint32_t pair = (value % 100) * 2;
+    value /= 100;
+    *--p = DIGIT_PAIRS[pair + 1];
+    *--p = DIGIT_PAIRS[pair];
+  }
+  if (value >= 10)
+  {
+    *--p = DIGIT_PAIRS[value * 2 + 1];
+    *--p = DIGIT_PAIRS[value * 2];
+  }
+  else
+  {
+    *--p = (char)('0' + value);
+  }
+
+  size_t count = scratch + sizeof(scratch) - p;
+  for (size_t i = 0; i < count; i++)
+  {
+    out[i] = p[i];
+  }
+  return count;
+}
+
+size_t formatInt(char *out, int32_t value)
+{
+  if (value < 0)
+  {
+    *out = '-';
+    return 1 + formatUInt(out + 1, 0u - (uint32_t)value);
+  }
+  return formatUInt(out, (uint32_t)value);
+}
+
+size_t formatFixed(char *out, float value, uint8_t decimals)
+{
+  if (isnan(value))
+  {
+    out[0] = 'n';
+    out[1] = 'a';
+    out[2] = 'n';
+    return 3;
+  }
+
+  if (decimals > 4)
+  {
+    decimals = 4;
+  }
+
+  float magnitude = fabsf(value);
+  if (!(magnitude < 4294967040.0f)) // Largest float below 2^32
+  {
+    out[0] = 'o';
+    out[1] = 'v';
+    out[2] = 'f';
+    return 3;
+  }
+
+  // Integer and fractional parts are scaled separately so large values keep
+  // their precision, the rounding carry is propagated by hand
+  uint32_t scale = POWERS_OF_TEN[decimals];
+  uint32_t whole = (uint32_t)magnitude;
+  uint32_t fraction = (uint32_t)((magnitude - whole) * scale + 0.5f);
+  if (fraction >= scale)
+  {
+    whole++;
+    fraction -= scale;
+  }
+
+  size_t count = 0;
+  if (value < 0 && (whole != 0 || fraction != 0))
+  {
+    out[count++] = '-';
+  }
+
+  count += formatUInt(out + count, whole);
+  if (decimals == 0)
+  {
+    return count;
+  }
+
+  out[count++] = '.';
+  for (uint8_t i = decimals; i > 0; i--)
+  {
+    out[count + i - 1] = (char)('0' + fraction % 10);
+    fraction /= 10;
+  }
+  return count + decimals;
+}
@@ -0,0 +1,123 @@
+#ifndef FORMAT_HPP
+#define FORMAT_HPP
+
+// Framework libs
+#include <stddef.h>
+#include <stdint.h>
+
+// Longest text produced by formatFixed() (sign, 10 digits, point, 4 decimals)
+static constexpr size_t FORMAT_FIXED_MAX = 16;
+
+/// formatUInt
+/// @brief Writes the decimal digits of value, two digits per division
+///
+/// @param[out] out: Destination, needs room for 10 characters
+/// @param[in] value: Value to convert
+///
+/// @return number of characters written (no terminator)
+///
+size_t formatUInt(char *out, uint32_t value);
+
+/// formatInt
+/// @brief Signed variant of formatUInt()
+///
+/// @param[out] out: Destination, needs room for 11 characters
+/// @param[in] value: Value to convert
+///
+/// @return number of characters written (no terminator)
+///
+size_t formatInt(char *out, int32_t value);
+
+/// formatFixed
+/// @brief Fixed-point replacement for dtostrf(value, 0, decimals): splits
+///        the value into integer and scaled fraction, rounds half away from
+///        zero and prints both with integer arithmetic. No heap.
+///
+/// @param[out] out: Destination, needs room for FORMAT_FIXED_MAX characters
+/// @param[in] value: Value to convert ("nan" and "ovf" when not representable)
+/// @param[in] decimals: Digits after the decimal point (0..4)
+///
+/// @return number of characters written (no terminator)
+///
+size_t formatFixed(char *out, float value, uint8_t decimals);
+
+/// StrBuilder
+/// @brief Fixed-capacity string builder used instead of Arduino String on the
+/// per-tick path. Appends past the capacity are truncated, the buffer is
+/// always NUL-terminated and nothing is ever allocated.
+///
+template <size_t N>
+class StrBuilder
+{
+public:
+  StrBuilder() : len(0), isTruncated(false) { buf[0] = '\0'; }
+
+  StrBuilder &clear()
+  {
+    len = 0;
+    isTruncated = false;
+    buf[0] = '\0';
+    return *this;
+  }
+
+  StrBuilder &append(const char *text)
+  {
+    while (*text)
+    {
+      append(*text++);
+    }
+    return *this;
+  }
+
+  StrBuilder &append(char c)
+  {
+    if (len < N - 1)
+    {
+      buf[len++] = c;
+      buf[len] = '\0';
+    }
+    else
+    {
+      isTruncated = true;
+    }
+    return *this;
+  }
+
+  StrBuilder &appendUInt(uint32_t value)
+  {
+    char digits[10];
+    return appendRaw(digits, formatUInt(digits, value));
+  }
+
+  StrBuilder &appendInt(int32_t value)
+  {
+    char digits[11];
+    return appendRaw(digits, formatInt(digits, value));
+  }
+
+  StrBuilder &appendFixed(float value, uint8_t decimals)
+  {
+    char digits[FORMAT_FIXED_MAX];
+    return appendRaw(digits, formatFixed(digits, value, decimals));
+  }
+
+  const char *c_str() const { return buf; }
+  size_t length() const { return len; }
+  bool truncated() const { return isTruncated; }
+
+private:
+  StrBuilder &appendRaw(const char *text, size_t count)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      append(text[i]);
+    }
+    return *this;
+  }
+
+  char buf[N];
+  size_t len;
+  bool isTruncated;
+};
+
+#endif // FORMAT_HPP
@@ -0,0 +1,171 @@
+// Local Includes
+#include "history.hpp"
+#include "logs.hpp"
+#include "outbound.hpp"
+
+extern ExtMEM logs;
+
+static const char SERIAL_COMMAND[] = "consulta ";
+
+HistoryResponder history;
+
+// Decimal field up to the next ';' or the end, advances position
+static bool parseField(const uint8_t *text, size_t length, size_t &position, uint32_t &value)
+{
+  uint64_t result = 0;
+  size_t start = position;
+  while (position < length && text[position] != ';')
+  {
+    if (text[position] < '0' || text[position] > '9' || position - start >= 10)
+    {
+      return false;
+    }
+    result = result * 10 + (text[position] - '0');
+    position++;
+  }
+  if (position == start || result > UINT32_MAX)
+  {
+    return false;
+  }
+  if (position < length)
+  {
+    position++; // Skip ';'
+  }
+  value = (uint32_t)result;
+  return true;
+}
+
+HistoryResponder::HistoryResponder() : query(storage)
+{
+  hasHeld = false;
+  isAnswering = false;
+  sink = HISTORY_MQTT;
+  samples = 0;
+  previousEpoch = 0;
+  lineLength = 0;
+}
+
+bool HistoryResponder::request(const uint8_t *text, size_t length, HistorySink sink)
+{
+  size_t position = 0;
+  uint32_t from;
+  uint32_t to;
+  uint32_t sensor = 0;
+  if (!parseField(text, length, position, from) || !parseField(text, length, position, to) ||
+      (position < length && !parseField(text, length, position, sensor)) || position < length ||
+      sensor > NUMBER_OF_SENSORS)
+  {
+    return false;
+  }
+
+  // An empty range still gets its "fim,0"
+  query.begin(from, to, (uint8_t)sensor);
+  this->sink = sink;
+  chunk.clear();
+  hasHeld = false;
+  samples = 0;
+  isAnswering = true;
+  logs.info("Consulta de histórico iniciada");
+  return true;
+}
+
+void HistoryResponder::pollSerial()
+{
+  while (Serial.available() > 0)
+  {
+    char c = Serial.read();
+    if (c != '\n' && c != '\r')
+    {
+      if (lineLength < sizeof(line) - 1)
+      {
+        line[lineLength++] = c;
+      }
+      continue;
+    }
+
+    size_t prefix = sizeof(SERIAL_COMMAND) - 1;
+    if (lineLength > prefix && strncmp(line, SERIAL_COMMAND, prefix) == 0 &&
+        !request((const uint8_t *)line + prefix, lineLength - prefix, HISTORY_SERIAL))
+    {
+      Serial.println("[ERRO] Uso: consulta de;até[;sensor]");
+    }
+    lineLength = 0;
+  }
+}
+
+void HistoryResponder::service(uint32_t budgetUs)
+{
+  if (!isAnswering || !idleBudget.allows(budgetUs))
+  {
+    return; // Nothing to send, or the SD reads could overlap the next tick
+  }
+  if (sink == HISTORY_MQTT && outbound.freeSlots() <= HISTORY_MIN_FREE_SLOTS)
+  {
+    return; // Live telemetry first
+  }
+
+  uint32_t started = micros();
+
+  // A chunk refused by the queue is kept and offered again
+  if (chunk.length() == 0)
+  {
+    StrBuilder<24> piece;
+    TelemetrySample sample;
+    while (hasHeld || query.next(sample))
+    {
+      if (hasHeld)
+      {
+        sample = held;
+        hasHeld = false;
+      }
+
+      piece.clear();
+      if (chunk.length() == 0)
+      {
+        piece.appendUInt(sample.epoch);
+      }
+      else
+      {
+        piece.append(';').append('+').appendUInt(sample.epoch - previousEpoch);
+      }
+      piece.append(',').appendUInt(sample.sensor).append(',').appendFixed(sample.value / 100.0f, 2);
+
+      if (chunk.length() + piece.length() > OUTBOUND_PAYLOAD_SIZE)
+      {
+        held = sample;
+        hasHeld = true;
+        break;
+      }
+      chunk.append(piece.c_str());
+      previousEpoch = sample.epoch;
+      samples++;
+    }
+
+    if (chunk.length() == 0)
+    {
+      chunk.append("fim,").appendUInt(samples);
+    }
+  }
+  bool isEnd = strncmp(chunk.c_str(), "fim,", 4) == 0;
+
+  if (deliver(chunk.c_str()))
+  {
+    chunk.clear();
+    if (isEnd)
+    {
+      isAnswering = false;
+    }
+  }
+
+  idleBudget.record(micros() - started);
+}
+
+bool HistoryResponder::deliver(const char *payload)
+{
+  if (sink == HISTORY_SERIAL)
+  {
+    Serial.println(payload);
+    return true;
+  }
+  return outbound.offer(TOPIC_HISTORY, payload);
+}
@@ -0,0 +1,92 @@
+#ifndef HISTORY_HPP
+#define HISTORY_HPP
+
+// Framework libs
+#include <Arduino.h>
+
+// Local Includes
+#include <config.hpp>
+#include "format.hpp"
+#include "idleBudget.hpp"
+#include "telemetryFile.hpp"
+
+/// Where the answer of a query goes
+enum HistorySink : uint8_t
+{
+  HISTORY_MQTT,   // Chunks on TOPIC_HISTORY through the outbound queue
+  HISTORY_SERIAL  // One chunk per line on Serial
+};
+
+/// HistoryResponder
+/// @brief Answers "from;to[;sensor]" queries (epoch seconds, sensor 1..N or
+/// all) with the stored telemetry of that range. Samples are streamed in
+/// chunks of at most OUTBOUND_PAYLOAD_SIZE bytes, each starting with an
+/// absolute epoch so it can be read on its own:
+///   <epoch>,<sensor>,<value>;<+seconds>,<sensor>,<value>;...
+/// and the answer ends with "fim,<samples>". Runs from loop() in the idle
+/// time before the next sampling tick, one chunk per call.
+///
+class HistoryResponder
+{
+public:
+  /// HistoryResponder
+  /// @brief Class constructor
+  ///
+  /// @param[in] none
+  ///
+  /// @return none
+  ///
+  HistoryResponder();
+
+  /// request
+  /// @brief Parses a query and starts answering it, replacing any query
+  ///        in progress
+  ///
+  /// @param[in] text: "from;to[;sensor]", not NUL-terminated
+  /// @param[in] length: Length of text
+  /// @param[in] sink: Where the chunks go
+  ///
+  /// @return false if the query is malformed
+  ///
+  bool request(const uint8_t *text, size_t length, HistorySink sink);
+
+  /// pollSerial
+  /// @brief Reads "consulta from;to[;sensor]" lines typed on Serial
+  ///
+  /// @param none
+  ///
+  /// @return none
+  ///
+  void pollSerial();
+
+  /// service
+  /// @brief Sends the next chunk if the budget and the queue allow
+  ///
+  /// @param[in] budgetUs: Microseconds until the next sampling tick
+  ///
+  /// @return none
+  ///
+  void service(uint32_t budgetUs);
+
+private:
+  // Private methods
+  bool deliver(const char *payload);
+
+  // Private attributes
+  SdTelemetryStorage storage;
+  TelemetryQuery query;
+  StrBuilder<OUTBOUND_PAYLOAD_SIZE + 1> chunk;
+  TelemetrySample held; // Did not fit the previous chunk
+  bool hasHeld;
+  bool isAnswering;
+  HistorySink sink;
+  uint32_t samples;
+  uint32_t previousEpoch;
+  IdleBudget idleBudget;
+  char line[HISTORY_LINE_SIZE];
+  uint8_t lineLength;
+};
+
+extern HistoryResponder history;
+
+#endif // HISTORY_HPP
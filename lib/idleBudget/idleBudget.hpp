@@ -0,0 +1,65 @@
+#ifndef IDLEBUDGET_HPP
+#define IDLEBUDGET_HPP
+
+// Framework libs
+#include <stdint.h>
+
+// Local Includes
+#include <config.hpp>
+
+/// IdleBudget
+/// @brief Decides whether one step of loop()-side SD work fits in the time
+/// left before the next sampling tick. A step runs only if the budget covers
+/// IDLE_GUARD_US plus twice the slowest step seen; the slowest step decays
+/// by 1/64 per call so one slow card access does not stop the work for good.
+///
+class IdleBudget
+{
+public:
+  IdleBudget() : worstStepUs(IDLE_STEP_ESTIMATE_US) {}
+
+  /// allows
+  /// @brief Whether a step may start now
+  ///
+  /// @param[in] budgetUs: Microseconds until the next sampling tick
+  ///
+  /// @return true if the slowest step seen still ends before the guard
+  ///
+  bool allows(uint32_t budgetUs) const
+  {
+    return budgetUs >= IDLE_GUARD_US + 2 * worstStepUs;
+  }
+
+  /// record
+  /// @brief Feeds the duration of the step that just ran
+  ///
+  /// @param[in] elapsedUs: Duration of the step (us)
+  ///
+  /// @return none
+  ///
+  void record(uint32_t elapsedUs)
+  {
+    worstStepUs -= worstStepUs >> 6;
+    if (elapsedUs > worstStepUs)
+    {
+      worstStepUs = elapsedUs;
+    }
+  }
+
+  /// getWorstStepUs
+  /// @brief Slowest step seen, after decay
+  ///
+  /// @param[in] none
+  ///
+  /// @return microseconds
+  ///
+  uint32_t getWorstStepUs() const
+  {
+    return worstStepUs;
+  }
+
+private:
+  uint32_t worstStepUs;
+};
+
+#endif // IDLEBUDGET_HPP
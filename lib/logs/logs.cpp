@@ -3,19 +3,44 @@
 #include "config.hpp"
 #include "set_rtc.hpp"
 
-// Variáveis globais só para date_time
-char date_time[20];
-
 SdFat sd;
-SdFile file;
 // SdFile logFile;
 // SdFile csvFile;
 // SdFile snFile;
 
+static constexpr uint16_t SECTOR_SIZE = 512;
+
+// O cartão só é escrito fora das interrupções: uma linha registada numa ISR
+// fica em RAM até ao loop(), nunca abre uma transação SPI a meio de outra
+static bool isInterrupt()
+{
+#if defined(ARDUINO_ARCH_STM32)
+  return __get_IPSR() != 0;
+#else
+  return isInterruptContext();
+#endif
+}
+
+// Com o SPI dedicado o SdFat controla o CS (mantém o cartão selecionado
+// durante as escritas multi-bloco)
+static void selectCard(bool isSelected)
+{
+  if (!IS_SD_DEDICATED_SPI)
+  {
+    digitalWrite(uSD_CS_PIN, isSelected ? LOW : HIGH);
+  }
+}
+
 ExtMEM::ExtMEM()
 {
   fileIndex = 0;  // Inicializar índice para cada instância
   filename[0] = '\0';  // Inicializar filename vazio
+  fileType[0] = '\0';
+  bufferLimit = SD_WRITE_BUFFER_SIZE;
+  buffered = 0;
+  lastFlush = 0;
+  flushInterval = SD_FLUSH_INTERVAL;
+  droppedLines = 0;
 }
 
 bool ExtMEM::initExtMem()
@@ -23,23 +48,29 @@ bool ExtMEM::initExtMem()
   // Start Serial communication
   Serial.begin(SERIAL_BAUD_RATE);
 
+  // The card is shared by every instance: mount it only once
+  if (sd.fatType() != 0)
+  {
+    isSDCardInitialized = true;
+    return true;
+  }
+
   // Prepare GPIO
   pinMode(uSD_CS_PIN, OUTPUT);
-  digitalWrite(uSD_CS_PIN, LOW);
+  selectCard(true);
 
   // initialising SD card via SPI
-  if (!sd.begin(uSD_CS_PIN, SD_SCK_MHZ(10)))
+  SdSpiConfig spiConfig(uSD_CS_PIN, IS_SD_DEDICATED_SPI ? DEDICATED_SPI : SHARED_SPI, SD_SCK_MHZ(SD_SPI_MHZ));
+  if (!sd.begin(spiConfig))
   {
     Serial.println("[ERROR] uSD initialization failed!");
-    delay(100);
-    digitalWrite(uSD_CS_PIN, HIGH);
+    selectCard(false);
     isSDCardInitialized = false;
     return false;
   }
 
   isSDCardInitialized = true;
-  delay(100);
-  digitalWrite(uSD_CS_PIN, HIGH);
+  selectCard(false);
   return true;
 }
 
@@ -52,158 +83,279 @@ bool ExtMEM::initFile(const char *type)
     return false;
   }
 
-  // Usar a mesma lógica para todos os ficheiros (funciona para logs)
+  if (type != fileType)
+  {
+    strncpy(fileType, type, sizeof(fileType) - 1);
+    fileType[sizeof(fileType) - 1] = '\0';
+  }
+
+  // Usar a mesma lógica para todos os ficheiros (funciona para logs).
+  // Um índice já comprimido (<nome>.lz) também está ocupado.
+  char compressed[sizeof(filename) + 4];
   do
   {
     if (strcmp(type, "csv") == 0) {
-      snprintf(filename, sizeof(filename), "%s%s%d.%s", LOG_PATH.c_str(), CSV_FILENAME.c_str(), fileIndex, type);
+      snprintf(filename, sizeof(filename), "%s%s%d.%s", LOG_PATH, CSV_FILENAME, fileIndex, type);
     } else {
-      snprintf(filename, sizeof(filename), "%s%s%d.%s", LOG_PATH.c_str(), LOG_FILENAME.c_str(), fileIndex, type);
+      snprintf(filename, sizeof(filename), "%s%s%d.%s", LOG_PATH, LOG_FILENAME, fileIndex, type);
     }
+    snprintf(compressed, sizeof(compressed), "%s.%s", filename, COMPRESSED_EXTENSION);
     fileIndex++;
-  } while (sd.exists(filename));
+  } while (sd.exists(filename) || sd.exists(compressed));
 
   return true;
 }
 
-void ExtMEM::info(const char *message)
+const char *ExtMEM::getFilename() const
 {
-  if (!isSDCardInitialized)
+  return filename;
+}
+
+bool ExtMEM::openFile()
+{
+  if (!logFile.isOpen() && !logFile.open(filename, O_RDWR | O_CREAT | O_APPEND))
   {
-    return;
+    return false;
+  }
+  if (logFile.fileSize() + buffered < MAX_FILE_SIZE)
+  {
+    return true;
   }
 
-  if (!IS_RTC_ENABLED)
+  // Segmento cheio: fecha-o (fica pronto para compressão) e passa ao índice seguinte
+  drain(true);
+  logFile.close();
+  if (!initFile(fileType))
   {
-    sprintf(date_time, "%u", millis());
+    return false;
   }
-  else
+  if (!logFile.open(filename, O_RDWR | O_CREAT | O_APPEND))
   {
-    // Get RTC date and time
-    DateTime now = get_rtc_datetime();
-    sprintf(date_time, "%02d/%02d/%04d %02d:%02d:%02d", now.day, now.month, now.year, now.hours, now.minutes, now.seconds);
+    return false;
   }
+  if (strcmp(fileType, "csv") == 0)
+  {
+    logFile.println(CSV_HEADER); // Cada segmento CSV é legível sozinho
+  }
+  return true;
+}
 
-  char formatted_log_message[strlen(date_time) + strlen(message) + 100];
-  snprintf(formatted_log_message, sizeof(formatted_log_message), "[%s] [INFO] %s", date_time, message);
-
-  if (!file.open(filename, O_RDWR | O_CREAT | O_APPEND))
+bool ExtMEM::writeLine(const char *text)
+{
+  // Sem buffer: uma escrita parcial de setor por linha, ficheiro fechado
+  if (SD_WRITE_BUFFER_SIZE == 0)
   {
-    Serial.println("[ERROR] Log failed!");
-    return;
+    if (!openFile())
+    {
+      return false;
+    }
+    logFile.println(text);
+    return logFile.close();
   }
 
-  file.println(formatted_log_message);
-  file.close();
+  size_t length = strlen(text);
 
-  if (IS_SERIAL_PRINT)
+  // Lines come from the ISR and from loop()/setup(): copy with the ISR held off
+  noInterrupts();
+  bool isCopied = buffered + length + 2 <= bufferLimit;
+  if (isCopied)
   {
-    Serial.println(formatted_log_message);
+    copyLine(text, length);
   }
-}
+  interrupts();
 
-void ExtMEM::debug(const char *message)
-{
-  if (!isSDCardInitialized)
+  if (isInterrupt())
   {
-    return;
+    if (!isCopied)
+    {
+      droppedLines++; // Never touch the card from an interrupt
+    }
+    return isCopied;
   }
 
-  if (!IS_RTC_ENABLED)
+  // service() normally writes and syncs; do it here if the buffer is full
+  // or loop() never had the time
+  bool isOverdue = millis() - lastFlush >= 2 * flushInterval;
+  if (isCopied && !isOverdue)
   {
-    sprintf(date_time, "%u", millis());
+    return true;
   }
-  else
+
+  bool isWritten = openFile();
+  if (isWritten && !isCopied)
   {
-    // Get RTC date and time
-    DateTime now = get_rtc_datetime();
-    sprintf(date_time, "%02d/%02d/%04d %02d:%02d:%02d", now.day, now.month, now.year, now.hours, now.minutes, now.seconds);
+    drain(false);
+    if (buffered + length + 2 > bufferLimit)
+    {
+      drain(true);
+    }
+    if (length + 2 > bufferLimit)
+    {
+      // Longer than the whole buffer: write it through
+      logFile.write(text, length);
+      isWritten = logFile.write("\r\n", 2) == 2;
+    }
+    else
+    {
+      noInterrupts();
+      copyLine(text, length);
+      interrupts();
+    }
   }
+  if (isWritten && isOverdue)
+  {
+    isWritten = sync();
+  }
+  return isWritten;
+}
 
-  char formatted_log_message[strlen(date_time) + strlen(message) + 100];
-  snprintf(formatted_log_message, sizeof(formatted_log_message), "[%s] [DEBUG] %s", date_time, message);
+void ExtMEM::copyLine(const char *text, size_t length)
+{
+  memcpy(buffer + buffered, text, length);
+  buffer[buffered + length] = '\r';
+  buffer[buffered + length + 1] = '\n';
+  buffered += length + 2;
+}
 
-  if (!file.open(filename, O_RDWR | O_CREAT | O_APPEND))
+bool ExtMEM::drain(bool isAll)
+{
+  uint16_t pending = buffered;
+  if (pending == 0)
   {
-    Serial.println("[ERROR] Log failed!");
-    return;
+    return true;
   }
 
-  file.println(formatted_log_message);
-  file.close();
-
-  if (IS_SERIAL_PRINT)
+  // Write up to the last sector boundary of the file so the card gets whole
+  // sectors; the tail stays in the buffer for the next lines
+  uint16_t count = pending;
+  if (!isAll)
   {
-    Serial.println(formatted_log_message);
+    uint16_t tail = (logFile.fileSize() + pending) % SECTOR_SIZE;
+    if (tail >= pending)
+    {
+      return true; // No boundary reached yet
+    }
+    count = pending - tail;
   }
+
+  size_t written = logFile.write(buffer, count);
+
+  // The ISR may have appended lines during the write
+  noInterrupts();
+  memmove(buffer, buffer + count, buffered - count);
+  buffered -= count;
+  interrupts();
+  return written == count;
 }
 
-void ExtMEM::warning(const char *message)
+bool ExtMEM::sync()
 {
-  if (!isSDCardInitialized)
+  lastFlush = millis();
+  if (buffered == 0 && !logFile.isOpen())
   {
-    return;
+    return true;
   }
-
-  if (!IS_RTC_ENABLED)
+  if (!openFile())
   {
-    sprintf(date_time, "%u", millis());
+    return false;
   }
-  else
+  bool isWritten = drain(true);
+  return logFile.sync() && isWritten;
+}
+
+void ExtMEM::setProfile(uint16_t bufferSize, uint32_t flushIntervalMs)
+{
+  if (SD_WRITE_BUFFER_SIZE == 0)
   {
-    // Get RTC date and time
-    DateTime now = get_rtc_datetime();
-    sprintf(date_time, "%02d/%02d/%04d %02d:%02d:%02d", now.day, now.month, now.year, now.hours, now.minutes, now.seconds);
+    return;
   }
+  bufferLimit = bufferSize < SECTOR_SIZE ? SECTOR_SIZE : (bufferSize > sizeof(buffer) ? sizeof(buffer) : bufferSize);
+  flushInterval = flushIntervalMs;
+}
 
-  char formatted_log_message[strlen(date_time) + strlen(message) + 100];
-  snprintf(formatted_log_message, sizeof(formatted_log_message), "[%s] [WARNING] %s", date_time, message);
+void ExtMEM::service(uint32_t budgetUs)
+{
+  if (SD_WRITE_BUFFER_SIZE == 0 || !isSDCardInitialized || !idleBudget.allows(budgetUs))
+  {
+    return; // The write could still be running when the next tick fires
+  }
 
-  if (!file.open(filename, O_RDWR | O_CREAT | O_APPEND))
+  bool isDue = buffered > 0 && millis() - lastFlush >= flushInterval;
+  if (!isDue && buffered < SECTOR_SIZE)
   {
-    Serial.println("[ERROR] Log failed!");
     return;
   }
 
-  file.println(formatted_log_message);
-  file.close();
-
-  if (IS_SERIAL_PRINT)
+  uint32_t started = micros();
+  if (isDue)
   {
-    Serial.println(formatted_log_message);
+    sync();
   }
+  else if (openFile())
+  {
+    drain(false);
+  }
+
+  idleBudget.record(micros() - started);
+}
+
+uint32_t ExtMEM::getDroppedLines() const
+{
+  return droppedLines;
+}
+
+void ExtMEM::info(const char *message)
+{
+  logLine("INFO", message);
+}
+
+void ExtMEM::debug(const char *message)
+{
+  logLine("DEBUG", message);
+}
+
+void ExtMEM::warning(const char *message)
+{
+  logLine("WARNING", message);
 }
 
 void ExtMEM::error(const char *message)
+{
+  logLine("ERROR", message);
+}
+
+void ExtMEM::logLine(const char *level, const char *message)
 {
   if (!isSDCardInitialized)
   {
     return;
   }
 
+  // Local buffers of fixed size: this runs in the TIM3 ISR as well, so the
+  // stack it takes must not depend on the message (longer ones are cut)
+  char dateTime[20];
   if (!IS_RTC_ENABLED)
   {
-    sprintf(date_time, "%u", millis());
+    snprintf(dateTime, sizeof(dateTime), "%lu", (unsigned long)millis());
   }
   else
   {
     // Get RTC date and time
     DateTime now = get_rtc_datetime();
-    sprintf(date_time, "%02d/%02d/%04d %02d:%02d:%02d", now.day, now.month, now.year, now.hours, now.minutes, now.seconds);
+    snprintf(dateTime, sizeof(dateTime), "%02u/%02u/%04u %02u:%02u:%02u", (unsigned)now.day % 100,
+             (unsigned)now.month % 100, (unsigned)now.year % 10000, (unsigned)now.hours % 100,
+             (unsigned)now.minutes % 100, (unsigned)now.seconds % 100);
   }
 
-  char formatted_log_message[strlen(date_time) + strlen(message) + 100];
-  snprintf(formatted_log_message, sizeof(formatted_log_message), "[%s] [ERROR] %s", date_time, message);
+  char formatted_log_message[LOG_LINE_SIZE];
+  snprintf(formatted_log_message, sizeof(formatted_log_message), "[%s] [%s] %s", dateTime, level, message);
 
-  if (!file.open(filename, O_RDWR | O_CREAT | O_APPEND))
+  if (!writeLine(formatted_log_message))
   {
     Serial.println("[ERROR] Log failed!");
     return;
   }
 
-  file.println(formatted_log_message);
-  file.close();
-
   if (IS_SERIAL_PRINT)
   {
     Serial.println(formatted_log_message);
@@ -217,99 +369,9 @@ void ExtMEM::data(const char *message)
     return;
   }
 
-  if (!IS_RTC_ENABLED)
-  {
-    sprintf(date_time, "%u", millis());
-  }
-
-  if (!file.open(filename, O_RDWR | O_CREAT | O_APPEND))
+  if (!writeLine(message))
   {
     Serial.println("[ERROR] CSV Log failed!");
     return;
   }
-
-  file.println(message);
-  file.close();
 }
-
-void ExtMEM::readSN()
-{
-
-  digitalWrite(uSD_CS_PIN, LOW);
-  delay(10);
-
-  Serial.println("[INFO] Checking config file...");
-  if (!sd.exists(CONFIG_FILENAME.c_str()))
-  {
-    Serial.println("[INFO] Config file does not exist, creating default...");
-    
-    // Criar ficheiro config.json com valores padrão
-    if (!file.open(CONFIG_FILENAME.c_str(), O_WRONLY | O_CREAT | O_TRUNC))
-    {
-      Serial.println("[ERROR] Failed to create config file!");
-      digitalWrite(uSD_CS_PIN, HIGH);
-      return;
-    }
-    
-    // Escrever dados padrão no formato CSV
-    file.println("ASN001,SN001,v1.0,v1.0");
-    file.close();
-    Serial.println("[INFO] Default config file created successfully!");
-    
-    // Definir valores padrão na estrutura
-    strncpy(config_data.asn, "ASN001", sizeof(config_data.asn));
-    strncpy(config_data.sn, "SN001", sizeof(config_data.sn));
-    strncpy(config_data.hw, "v1.0", sizeof(config_data.hw));
-    strncpy(config_data.fw, "v1.0", sizeof(config_data.fw));
-    
-    digitalWrite(uSD_CS_PIN, HIGH);
-    return;
-  }
-
-  Serial.println("[INFO] Opening config file...");
-  if (!file.open(CONFIG_FILENAME.c_str(), O_RDONLY))
-  {
-    Serial.println("[ERROR] Failed to open CSV file!");
-    digitalWrite(uSD_CS_PIN, HIGH);
-    return;
-  }
-
-  Serial.println("[INFO] Reading file...");
-  char line[64];
-  while (file.fgets(line, sizeof(line)))
-  {
-
-    // Parse CSV values
-    char *token = strtok(line, ",");
-    if (token)
-      strncpy(config_data.asn, token, sizeof(config_data.asn));
-
-    token = strtok(NULL, ",");
-    if (token)
-      strncpy(config_data.sn, token, sizeof(config_data.sn));
-
-    token = strtok(NULL, ",");
-    if (token)
-      strncpy(config_data.hw, token, sizeof(config_data.hw));
-
-    token = strtok(NULL, ",");
-    if (token)
-      strncpy(config_data.fw, token, sizeof(config_data.fw));
-
-    // Print extracted values
-    if (IS_SERIAL_PRINT)
-    {
-      Serial.print("ASN: ");
-      Serial.println(config_data.asn);
-      Serial.print("SN: ");
-      Serial.println(config_data.sn);
-      Serial.print("HW: ");
-      Serial.println(config_data.hw);
-      Serial.print("FW: ");
-      Serial.println(config_data.fw);
-    }
-  }
-
-  file.close();
-  digitalWrite(uSD_CS_PIN, HIGH);
-}
\ No newline at end of file
@@ -5,10 +5,10 @@
 #include <SPI.h>
 #include <chrono>
 #include <SdFat.h>
-#include <string>
 
 // Local Includes
 #include <config.hpp>
+#include "idleBudget.hpp"
 
 // Defines and Global Variables
 // -
@@ -50,6 +50,15 @@ public:
   ///
   bool initFile(const char *type);
 
+  /// getFilename
+  /// @brief Name of the file being written
+  ///
+  /// @param none
+  ///
+  /// @return file name
+  ///
+  const char *getFilename() const;
+
   /// info
   /// @brief Information to be stored in the file
   ///
@@ -91,20 +100,62 @@ public:
   /// @return none
   void data(const char *message);
 
-  /// readSN
-  /// @brief Reads the serial number from the SD card
+  /// sync
+  /// @brief Writes the buffered lines and commits the file size to the card
+  ///
+  /// @param none
+  ///
+  /// @return true or false in case of success/fail
+  bool sync();
+
+  /// setProfile
+  /// @brief Applies the write profile picked for the card (SdProbe). Call
+  ///        before the first line is written.
+  ///
+  /// @param[in] bufferSize: Line buffer, at most SD_WRITE_BUFFER_MAX
+  /// @param[in] flushIntervalMs: Longest time a line stays only in RAM
+  ///
+  /// @return none
+  void setProfile(uint16_t bufferSize, uint32_t flushIntervalMs);
+
+  /// service
+  /// @brief Writes the whole sectors gathered in the buffer, and syncs
+  ///        when the flush interval is due, in the idle time of loop().
+  ///        Lines logged from an interrupt are only copied into RAM: the
+  ///        card is written from loop()/setup() only.
+  ///
+  /// @param[in] budgetUs: Microseconds until the next sampling tick
   ///
-  /// @param[in] none
   /// @return none
-  void readSN();
+  void service(uint32_t budgetUs);
+
+  /// getDroppedLines
+  /// @brief Lines logged from an interrupt and lost because the buffer was full
+  uint32_t getDroppedLines() const;
 
 private:
+  // Private methods
+  void logLine(const char *level, const char *message);
+  bool openFile();
+  bool writeLine(const char *text);
+  bool drain(bool isAll);
+  void copyLine(const char *text, size_t length);
+
   // Private attributes
   bool isLogFileOpen;
   bool isCSVFileOpen;
   bool isSDCardInitialized;
   char filename[30];  // Cada instância tem o seu filename
+  char fileType[4];   // Extensão passada a initFile, usada na rotação
   int fileIndex;
+  SdFile logFile;     // Mantido aberto entre linhas quando há buffer
+  char buffer[SD_WRITE_BUFFER_SIZE > 0 ? SD_WRITE_BUFFER_MAX : 1];
+  uint16_t bufferLimit;        // Parte do buffer em uso (perfil do cartão)
+  volatile uint16_t buffered;  // Bytes em buffer ainda por escrever
+  uint32_t lastFlush;          // millis() da última escrita completa
+  uint32_t flushInterval;      // ms
+  IdleBudget idleBudget;       // Decide se service() cabe antes da próxima leitura
+  volatile uint32_t droppedLines;
 };
 
 #endif // ExtMEM_HPP_INCLUDED_
\ No newline at end of file
@@ -0,0 +1,235 @@
+// Local Includes
+#include "lzss.hpp"
+
+#include <string.h>
+
+static constexpr int16_t NONE = -1;
+static constexpr int16_t HISTORY_SIZE = 2 * LZSS_WINDOW + LZSS_MAX_MATCH;
+
+LzssEncoder::LzssEncoder()
+{
+  begin();
+}
+
+void LzssEncoder::begin()
+{
+  for (uint16_t i = 0; i < LZSS_HASH_SIZE; i++)
+  {
+    head[i] = NONE;
+  }
+  position = 0;
+  end = 0;
+  group[0] = 0;
+  groupLength = 1;
+  groupItems = 0;
+}
+
+size_t LzssEncoder::compress(const uint8_t *input, size_t length, bool isFinal, uint8_t *output)
+{
+  size_t n = 0;
+
+  while (true)
+  {
+    if (end == HISTORY_SIZE)
+    {
+      slide();
+    }
+    size_t room = HISTORY_SIZE - end;
+    size_t take = length < room ? length : room;
+    if (take > 0)
+    {
+      memcpy(history + end, input, take);
+    }
+    end += take;
+    input += take;
+    length -= take;
+
+    // Keep a full match length of lookahead until the stream ends
+    bool isLast = isFinal && length == 0;
+    while (position < end && (isLast || end - position >= LZSS_MAX_MATCH))
+    {
+      uint16_t distance = 0;
+      uint8_t matched = longestMatch(&distance);
+      if (matched >= LZSS_MIN_MATCH)
+      {
+        uint16_t code = distance - 1;
+        emit(false, code & 0xFF, ((code >> 8) << 6) | (matched - LZSS_MIN_MATCH), output, n);
+        for (uint8_t i = 0; i < matched; i++)
+        {
+          insert(position++);
+        }
+      }
+      else
+      {
+        emit(true, history[position], 0, output, n);
+        insert(position++);
+      }
+    }
+
+    if (length == 0)
+    {
+      break;
+    }
+  }
+
+  if (isFinal)
+  {
+    flushGroup(output, n);
+  }
+  return n;
+}
+
+void LzssEncoder::slide()
+{
+  // Drop the oldest window; positions move by exactly LZSS_WINDOW so the
+  // chain slots (position % LZSS_WINDOW) stay where they are
+  memmove(history, history + LZSS_WINDOW, end - LZSS_WINDOW);
+  position -= LZSS_WINDOW;
+  end -= LZSS_WINDOW;
+
+  for (uint16_t i = 0; i < LZSS_HASH_SIZE; i++)
+  {
+    head[i] = head[i] >= (int16_t)LZSS_WINDOW ? head[i] - LZSS_WINDOW : NONE;
+  }
+  for (uint16_t i = 0; i < LZSS_WINDOW; i++)
+  {
+    chain[i] = chain[i] >= (int16_t)LZSS_WINDOW ? chain[i] - LZSS_WINDOW : NONE;
+  }
+}
+
+void LzssEncoder::insert(int16_t at)
+{
+  if (at + 2 >= end)
+  {
+    return; // Not enough bytes to hash, only happens at the end of the stream
+  }
+  uint16_t h = hash(at);
+  chain[at & (LZSS_WINDOW - 1)] = head[h];
+  head[h] = at;
+}
+
+uint8_t LzssEncoder::longestMatch(uint16_t *distance) const
+{
+  int16_t available = end - position;
+  uint8_t limit = available < LZSS_MAX_MATCH ? available : LZSS_MAX_MATCH;
+  if (limit < LZSS_MIN_MATCH)
+  {
+    return 0;
+  }
+
+  uint8_t best = 0;
+  int16_t candidate = head[hash(position)];
+  for (uint8_t tries = 0; candidate != NONE && tries < LZSS_MAX_CHAIN; tries++)
+  {
+    int16_t gap = position - candidate;
+    if (gap <= 0 || gap > (int16_t)LZSS_WINDOW)
+    {
+      break;
+    }
+
+    // Check the byte that would extend the best match first
+    if (history[candidate + best] == history[position + best])
+    {
+      uint8_t matched = 0;
+      while (matched < limit && history[candidate + matched] == history[position + matched])
+      {
+        matched++;
+      }
+      if (matched > best)
+      {
+        best = matched;
+        *distance = gap;
+        if (best == limit)
+        {
+          break;
+        }
+      }
+    }
+
+    int16_t next = chain[candidate & (LZSS_WINDOW - 1)];
+    if (next >= candidate)
+    {
+      break; // Slot reused by a newer position
+    }
+    candidate = next;
+  }
+  return best;
+}
+
+uint16_t LzssEncoder::hash(int16_t at) const
+{
+  uint32_t key = ((uint32_t)history[at] << 16) | ((uint32_t)history[at + 1] << 8) | history[at + 2];
+  return (key * 2654435761u) >> (32 - 8) & (LZSS_HASH_SIZE - 1);
+}
+
+void LzssEncoder::emit(bool isLiteral, uint8_t first, uint8_t second, uint8_t *output, size_t &n)
+{
+  if (isLiteral)
+  {
+    group[0] |= 1 << groupItems;
+    group[groupLength++] = first;
+  }
+  else
+  {
+    group[groupLength++] = first;
+    group[groupLength++] = second;
+  }
+
+  if (++groupItems == 8)
+  {
+    flushGroup(output, n);
+  }
+}
+
+void LzssEncoder::flushGroup(uint8_t *output, size_t &n)
+{
+  if (groupItems > 0)
+  {
+    memcpy(output + n, group, groupLength);
+    n += groupLength;
+  }
+  group[0] = 0;
+  groupLength = 1;
+  groupItems = 0;
+}
+
+size_t lzssDecompress(const uint8_t *input, size_t length, uint8_t *output, size_t capacity)
+{
+  size_t in = 0;
+  size_t out = 0;
+
+  while (in < length && out < capacity)
+  {
+    uint8_t flags = input[in++];
+    for (uint8_t item = 0; item < 8 && out < capacity; item++)
+    {
+      if (flags & (1 << item))
+      {
+        if (in >= length)
+        {
+          return out;
+        }
+        output[out++] = input[in++];
+        continue;
+      }
+
+      if (in + 1 >= length)
+      {
+        return out;
+      }
+      uint16_t distance = (input[in] | ((input[in + 1] >> 6) << 8)) + 1;
+      uint8_t matched = (input[in + 1] & 0x3F) + LZSS_MIN_MATCH;
+      in += 2;
+      if (distance > out)
+      {
+        return out; // Points before the start: damaged stream
+      }
+      // Byte by byte: a match may overlap the bytes it produces
+      for (uint8_t i = 0; i < matched && out < capacity; i++, out++)
+      {
+        output[out] = output[out - distance];
+      }
+    }
+  }
+  return out;
+}
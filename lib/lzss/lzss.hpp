@@ -0,0 +1,120 @@
+#ifndef LZSS_HPP
+#define LZSS_HPP
+
+// Framework libs
+#include <stddef.h>
+#include <stdint.h>
+
+// Format: groups of one flag byte (bit i set = item i is a literal) and up
+// to 8 items; a literal is 1 byte, a match is 2 bytes holding a 10-bit
+// distance (1..1024) and a 6-bit length (3..66)
+static constexpr uint16_t LZSS_WINDOW = 1024;
+static constexpr uint8_t LZSS_MIN_MATCH = 3;
+static constexpr uint8_t LZSS_MAX_MATCH = 66;
+static constexpr uint16_t LZSS_HASH_SIZE = 256; // Power of 2
+static constexpr uint8_t LZSS_MAX_CHAIN = 16;   // Candidates tried per byte
+
+static constexpr uint32_t LZSS_MAGIC = 0x31535A4C; // "LZS1"
+
+/// LzssFileHeader
+/// @brief Header of a .lz file, followed by the compressed stream
+///        (little-endian, as both the STM32 and the host are)
+///
+struct LzssFileHeader
+{
+  uint32_t magic;        // LZSS_MAGIC, 0 while the file is being written
+  uint32_t originalSize; // Bytes of the uncompressed file
+  uint32_t crc;          // crc32() of the uncompressed file
+  uint16_t window;       // LZSS_WINDOW used by the encoder
+  uint16_t reserved;
+};
+
+static_assert(sizeof(LzssFileHeader) == 16, "LzssFileHeader must stay 16 bytes on disk");
+
+/// lzssBound
+/// @brief Worst-case output of LzssEncoder::compress() for length bytes:
+///        all literals, including the lookahead held back by the previous
+///        call, plus a pending partial group
+///
+/// @param[in] length: Input bytes of one call
+///
+/// @return bytes the output buffer must hold
+///
+constexpr size_t lzssBound(size_t length)
+{
+  return (length + LZSS_MAX_MATCH) + (length + LZSS_MAX_MATCH + 7) / 8 + 1 + 2 * 8;
+}
+
+/// LzssEncoder
+/// @brief Streaming LZSS compressor with a 1 KB window and hash chains.
+/// Works in place on about 4.7 KB of RAM (history, hash heads and chain
+/// links) and accepts the input in pieces, so a file can be compressed one
+/// sector at a time in idle slices. No Arduino dependencies.
+///
+class LzssEncoder
+{
+public:
+  /// LzssEncoder
+  /// @brief Class constructor
+  ///
+  /// @param[in] none
+  ///
+  /// @return none
+  ///
+  LzssEncoder();
+
+  /// begin
+  /// @brief Starts a new stream
+  ///
+  /// @param none
+  ///
+  /// @return none
+  ///
+  void begin();
+
+  /// compress
+  /// @brief Compresses the next piece of the stream. Up to LZSS_MAX_MATCH
+  ///        bytes are held back for matching until the final call.
+  ///
+  /// @param[in] input: Next bytes of the stream
+  /// @param[in] length: Number of bytes
+  /// @param[in] isFinal: Last piece, flushes everything
+  /// @param[out] output: Room for lzssBound(length) bytes
+  ///
+  /// @return number of bytes written to output
+  ///
+  size_t compress(const uint8_t *input, size_t length, bool isFinal, uint8_t *output);
+
+private:
+  // Private methods
+  void slide();
+  void insert(int16_t at);
+  uint8_t longestMatch(uint16_t *distance) const;
+  uint16_t hash(int16_t at) const;
+  void emit(bool isLiteral, uint8_t first, uint8_t second, uint8_t *output, size_t &n);
+  void flushGroup(uint8_t *output, size_t &n);
+
+  // Private attributes
+  uint8_t history[2 * LZSS_WINDOW + LZSS_MAX_MATCH];
+  int16_t head[LZSS_HASH_SIZE];  // Newest position per hash, -1 if none
+  int16_t chain[LZSS_WINDOW];    // Previous position with the same hash
+  int16_t position;              // Next byte to encode
+  int16_t end;                   // Bytes held in history
+  uint8_t group[1 + 2 * 8];      // Flag byte and up to 8 items
+  uint8_t groupLength;
+  uint8_t groupItems;
+};
+
+/// lzssDecompress
+/// @brief Decompresses a whole stream held in memory
+///
+/// @param[in] input: Compressed stream (without the file header)
+/// @param[in] length: Compressed bytes
+/// @param[out] output: Destination
+/// @param[in] capacity: Bytes to produce (originalSize of the header)
+///
+/// @return bytes produced, less than capacity if the stream is damaged
+///
+size_t lzssDecompress(const uint8_t *input, size_t length, uint8_t *output, size_t capacity);
+
+#endif // LZSS_HPP
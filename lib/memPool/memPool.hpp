@@ -0,0 +1,149 @@
+#ifndef MEMPOOL_HPP
+#define MEMPOOL_HPP
+
+// Framework libs
+#include <atomic>
+#include <new>
+#include <stddef.h>
+#include <stdint.h>
+#include <type_traits>
+#include <utility>
+
+/// ScratchArena
+/// @brief Bump allocator over a static buffer for data that lives one
+/// cycle (one reading, one loop() pass): allocations are a pointer bump and
+/// reset() drops all of them at once. Only trivially destructible types, as
+/// nothing is destroyed. Not reentrant.
+///
+template <size_t N>
+class ScratchArena
+{
+public:
+  ScratchArena() : used(0), highWater(0), failures(0) {}
+
+  /// allocate
+  /// @brief Reserves size bytes until the next reset()
+  ///
+  /// @param[in] size: Bytes
+  /// @param[in] align: Alignment (power of 2)
+  ///
+  /// @return the memory, nullptr if the arena is exhausted
+  ///
+  void *allocate(size_t size, size_t align = alignof(max_align_t))
+  {
+    size_t start = (used + align - 1) & ~(align - 1);
+    if (start + size > N)
+    {
+      failures++;
+      return nullptr;
+    }
+    used = start + size;
+    if (used > highWater)
+    {
+      highWater = used;
+    }
+    return buffer + start;
+  }
+
+  /// create
+  /// @brief Constructs a T in the arena
+  ///
+  /// @param[in] args: Constructor arguments
+  ///
+  /// @return the object, nullptr if the arena is exhausted
+  ///
+  template <typename T, typename... Args>
+  T *create(Args &&...args)
+  {
+    static_assert(std::is_trivially_destructible<T>::value, "Arena objects are never destroyed");
+    static_assert(sizeof(T) <= N, "Type larger than the arena");
+    void *memory = allocate(sizeof(T), alignof(T));
+    return memory ? new (memory) T(std::forward<Args>(args)...) : nullptr;
+  }
+
+  /// reset
+  /// @brief Releases everything allocated since the last reset
+  ///
+  void reset() { used = 0; }
+
+  size_t capacity() const { return N; }
+  size_t getUsed() const { return used; }
+  size_t getHighWater() const { return highWater; }
+  uint32_t getFailures() const { return failures; }
+
+private:
+  alignas(max_align_t) uint8_t buffer[N];
+  size_t used;
+  size_t highWater;
+  uint32_t failures;
+};
+
+/// RingQueue
+/// @brief FIFO of up to N - 1 T in static storage between one producer and
+/// one consumer in different contexts (an ISR pushes, loop() pops), with
+/// no masking: each index is written by one side only, and an element is
+/// copied before the index that publishes it. A full queue refuses the
+/// new element and counts it.
+///
+template <typename T, uint8_t N>
+class RingQueue
+{
+  static_assert(N >= 2 && (N & (N - 1)) == 0, "Queue size must be a power of two");
+
+public:
+  RingQueue() : head(0), tail(0), dropped(0) {}
+
+  /// push
+  /// @brief Producer side: copies item to the back of the queue
+  ///
+  /// @param[in] item: Element to queue
+  ///
+  /// @return false if the queue is full (item dropped and counted)
+  ///
+  bool push(const T &item)
+  {
+    uint8_t position = head;
+    uint8_t next = (position + 1) & (N - 1);
+    if (next == tail)
+    {
+      dropped++;
+      return false;
+    }
+    items[position] = item;
+    std::atomic_signal_fence(std::memory_order_release); // Element written before it is published
+    head = next;
+    return true;
+  }
+
+  /// pop
+  /// @brief Consumer side: takes the oldest element
+  ///
+  /// @param[out] item: Element taken from the queue
+  ///
+  /// @return false if the queue is empty
+  ///
+  bool pop(T &item)
+  {
+    uint8_t position = tail;
+    if (position == head)
+    {
+      return false;
+    }
+    std::atomic_signal_fence(std::memory_order_acquire);
+    item = items[position];
+    std::atomic_signal_fence(std::memory_order_release); // Element read before the slot is handed back
+    tail = (position + 1) & (N - 1);
+    return true;
+  }
+
+  bool isEmpty() const { return head == tail; }
+  uint32_t getDropped() const { return dropped; }
+
+private:
+  T items[N];
+  volatile uint8_t head; // Written by push() only
+  volatile uint8_t tail; // Written by pop() only
+  volatile uint32_t dropped;
+};
+
+#endif // MEMPOOL_HPP
@@ -0,0 +1,53 @@
+// Local Includes
+#include "memstats.hpp"
+
+// Framework libs
+#include <stddef.h>
+
+static volatile uint32_t allocations = 0;
+static volatile uint32_t frees = 0;
+
+extern "C"
+{
+  void *__real_malloc(size_t size);
+  void *__real_calloc(size_t count, size_t size);
+  void *__real_realloc(void *ptr, size_t size);
+  void __real_free(void *ptr);
+
+  void *__wrap_malloc(size_t size)
+  {
+    allocations++;
+    return __real_malloc(size);
+  }
+
+  void *__wrap_calloc(size_t count, size_t size)
+  {
+    allocations++;
+    return __real_calloc(count, size);
+  }
+
+  void *__wrap_realloc(void *ptr, size_t size)
+  {
+    allocations++;
+    return __real_realloc(ptr, size);
+  }
+
+  void __wrap_free(void *ptr)
+  {
+    if (ptr)
+    {
+      frees++;
+    }
+    __real_free(ptr);
+  }
+}
+
+uint32_t allocationCount()
+{
+  return allocations;
+}
+
+uint32_t freeCount()
+{
+  return frees;
+}
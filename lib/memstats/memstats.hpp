@@ -0,0 +1,26 @@
+#ifndef MEMSTATS_HPP
+#define MEMSTATS_HPP
+
+#include <stdint.h>
+
+/// allocationCount
+/// @brief Number of malloc/calloc/realloc calls since boot. Counted by the
+///        --wrap linker options in platformio.ini, so it includes the
+///        allocations made by Arduino String and by the libraries.
+///
+/// @param none
+///
+/// @return allocation count
+///
+uint32_t allocationCount();
+
+/// freeCount
+/// @brief Number of free() calls with a non-null pointer since boot
+///
+/// @param none
+///
+/// @return free count
+///
+uint32_t freeCount();
+
+#endif // MEMSTATS_HPP
@@ -0,0 +1,436 @@
+// Local Includes
+#include "outbound.hpp"
+#include "connect.hpp"
+#include "logs.hpp"
+
+OutboundQueue outbound;
+
+// MQTT fixed header types
+static constexpr uint8_t MQTT_PUBLISH = 0x30;
+static constexpr uint8_t MQTT_PUBACK = 0x40;
+static constexpr uint8_t MQTT_DUP = 0x08;
+
+// Inbound framing states of AckTapClient
+static constexpr uint8_t PARSE_HEADER = 0;
+static constexpr uint8_t PARSE_LENGTH = 1;
+static constexpr uint8_t PARSE_BODY = 2;
+
+static void onPuback(uint16_t packetId)
+{
+  outbound.acknowledge(packetId);
+}
+
+// ========== AckTapClient ==========
+
+AckTapClient::AckTapClient(Client &client) : client(client)
+{
+  ackHandler = nullptr;
+  parseState = PARSE_HEADER;
+  packetType = 0;
+  remaining = 0;
+  lengthShift = 0;
+  packetId = 0;
+}
+
+void AckTapClient::setAckHandler(void (*handler)(uint16_t packetId))
+{
+  ackHandler = handler;
+}
+
+int AckTapClient::connect(IPAddress ip, uint16_t port)
+{
+  parseState = PARSE_HEADER; // New session, new stream
+  return client.connect(ip, port);
+}
+
+int AckTapClient::connect(const char *host, uint16_t port)
+{
+  parseState = PARSE_HEADER;
+  return client.connect(host, port);
+}
+
+size_t AckTapClient::write(uint8_t b)
+{
+  return client.write(b);
+}
+
+size_t AckTapClient::write(const uint8_t *buf, size_t size)
+{
+  return client.write(buf, size);
+}
+
+int AckTapClient::available()
+{
+  return client.available();
+}
+
+int AckTapClient::read()
+{
+  int b = client.read();
+  if (b >= 0)
+  {
+    tap((uint8_t)b);
+  }
+  return b;
+}
+
+int AckTapClient::read(uint8_t *buf, size_t size)
+{
+  int n = client.read(buf, size);
+  for (int i = 0; i < n; i++)
+  {
+    tap(buf[i]);
+  }
+  return n;
+}
+
+int AckTapClient::peek()
+{
+  return client.peek();
+}
+
+void AckTapClient::flush()
+{
+  client.flush();
+}
+
+void AckTapClient::stop()
+{
+  client.stop();
+}
+
+uint8_t AckTapClient::connected()
+{
+  return client.connected();
+}
+
+AckTapClient::operator bool()
+{
+  return (bool)client;
+}
+
+void AckTapClient::tap(uint8_t b)
+{
+  switch (parseState)
+  {
+  case PARSE_HEADER:
+    packetType = b & 0xF0;
+    remaining = 0;
+    lengthShift = 0;
+    parseState = PARSE_LENGTH;
+    break;
+
+  case PARSE_LENGTH:
+    remaining |= (uint32_t)(b & 0x7F) << lengthShift;
+    lengthShift += 7;
+    if (!(b & 0x80))
+    {
+      parseState = remaining == 0 ? PARSE_HEADER : PARSE_BODY;
+    }
+    break;
+
+  case PARSE_BODY:
+    if (packetType == MQTT_PUBACK)
+    {
+      // PUBACK body is the 2-byte packet id, most significant byte first
+      packetId = remaining == 2 ? (uint16_t)(b << 8) : (uint16_t)(packetId | b);
+    }
+    if (--remaining == 0)
+    {
+      if (packetType == MQTT_PUBACK && ackHandler)
+      {
+        ackHandler(packetId);
+      }
+      parseState = PARSE_HEADER;
+    }
+    break;
+  }
+}
+
+// ========== OutboundQueue ==========
+
+OutboundQueue::OutboundQueue()
+{
+  head = 0;
+  tail = 0;
+  count = 0;
+  inFlight = 0;
+  nextPacketId = 1;
+  wasUp = false;
+  spillRead = 0;
+  spillWrite = 0;
+  memset(&stats, 0, sizeof(stats));
+}
+
+void OutboundQueue::begin()
+{
+#if MQTT_TRANSPORT == MQTT_TRANSPORT_AT
+  mqttClient.setAckHandler(onPuback); // Publicação entregue ao modem
+#else
+  mqttTransport.setAckHandler(onPuback);
+#endif
+
+  if (spillFile.open(OUTBOUND_SPILL_FILENAME, O_RDONLY))
+  {
+    spillWrite = spillFile.fileSize() - (spillFile.fileSize() % sizeof(OutboundMessage));
+    spillRead = 0;
+    spillFile.close();
+  }
+}
+
+bool OutboundQueue::enqueue(const char *topic, const char *payload, uint8_t flags)
+{
+  OutboundMessage message;
+  strncpy(message.topic, topic, sizeof(message.topic) - 1);
+  message.topic[sizeof(message.topic) - 1] = '\0';
+  size_t length = strlen(payload);
+  message.payloadLength = length < sizeof(message.payload) ? length : sizeof(message.payload);
+  memcpy(message.payload, payload, message.payloadLength);
+  message.flags = flags;
+
+  // Once something is spilled, newer messages follow it to keep FIFO order
+  bool isStored = spillRead == spillWrite && store(message);
+
+  if (!isStored && !spill(message))
+  {
+    stats.dropped++;
+    return false;
+  }
+
+  stats.enqueued++;
+  return true;
+}
+
+bool OutboundQueue::offer(const char *topic, const char *payload, uint8_t flags)
+{
+  if (spillRead != spillWrite || freeSlots() == 0)
+  {
+    return false;
+  }
+  return enqueue(topic, payload, flags);
+}
+
+void OutboundQueue::service()
+{
+  bool isUp = connection.isUp();
+  unsigned long now = millis();
+
+  if (isUp && !wasUp)
+  {
+    // New session: the broker may have lost every unacknowledged message,
+    // expire them so they are resent (with DUP) below
+    for (uint8_t i = 0; i < count; i++)
+    {
+      Slot &slot = slots[(tail + i) % OUTBOUND_POOL_SIZE];
+      if (slot.state == SLOT_INFLIGHT)
+      {
+        slot.sentAt = now - OUTBOUND_ACK_TIMEOUT;
+      }
+    }
+  }
+  wasUp = isUp;
+
+  if (!isUp)
+  {
+    return;
+  }
+
+  reclaim();
+  refill();
+
+  uint8_t pending = count; // Entries queued while sending wait for the next pass
+
+  for (uint8_t i = 0; i < pending; i++)
+  {
+    Slot &slot = slots[(tail + i) % OUTBOUND_POOL_SIZE];
+
+    if (slot.state == SLOT_INFLIGHT && now - slot.sentAt >= OUTBOUND_ACK_TIMEOUT)
+    {
+      if (!transmit(slot, true))
+      {
+        break;
+      }
+      stats.retransmits++;
+    }
+    else if (slot.state == SLOT_QUEUED && inFlight < OUTBOUND_WINDOW)
+    {
+      if (slot.message.flags & OUTBOUND_QOS1)
+      {
+        slot.packetId = nextPacketId;
+        nextPacketId = nextPacketId == 0xFFFF ? 1 : nextPacketId + 1;
+      }
+      if (!transmit(slot, false))
+      {
+        break;
+      }
+      stats.published++;
+      if (slot.message.flags & OUTBOUND_QOS1)
+      {
+        slot.state = SLOT_INFLIGHT;
+        inFlight++;
+      }
+      else
+      {
+        slot.state = SLOT_DONE;
+      }
+    }
+  }
+
+  reclaim();
+}
+
+void OutboundQueue::acknowledge(uint16_t packetId)
+{
+  for (uint8_t i = 0; i < count; i++)
+  {
+    Slot &slot = slots[(tail + i) % OUTBOUND_POOL_SIZE];
+    if (slot.state == SLOT_INFLIGHT && slot.packetId == packetId)
+    {
+      slot.state = SLOT_DONE;
+      inFlight--;
+      stats.acked++;
+      return;
+    }
+  }
+}
+
+uint8_t OutboundQueue::freeSlots() const
+{
+  return OUTBOUND_POOL_SIZE - count;
+}
+
+const OutboundStats &OutboundQueue::getStats() const
+{
+  return stats;
+}
+
+bool OutboundQueue::store(const OutboundMessage &message)
+{
+  if (count == OUTBOUND_POOL_SIZE)
+  {
+    return false;
+  }
+
+  Slot &slot = slots[head];
+  slot.message = message;
+  slot.packetId = 0;
+  slot.sentAt = 0;
+  slot.state = SLOT_QUEUED;
+  head = (head + 1) % OUTBOUND_POOL_SIZE;
+  count++;
+  return true;
+}
+
+bool OutboundQueue::spill(const OutboundMessage &message)
+{
+  if (spillWrite + sizeof(OutboundMessage) > OUTBOUND_SPILL_MAX_SIZE)
+  {
+    return false;
+  }
+
+  if (!spillFile.open(OUTBOUND_SPILL_FILENAME, O_RDWR | O_CREAT))
+  {
+    return false;
+  }
+
+  spillFile.seekSet(spillWrite);
+  bool isWritten = spillFile.write(&message, sizeof(message)) == sizeof(message);
+  spillFile.close();
+
+  if (isWritten)
+  {
+    spillWrite += sizeof(OutboundMessage);
+    stats.spilled++;
+  }
+  return isWritten;
+}
+
+void OutboundQueue::refill()
+{
+  if (spillRead < spillWrite && count < OUTBOUND_POOL_SIZE && spillFile.open(OUTBOUND_SPILL_FILENAME, O_RDONLY))
+  {
+    spillFile.seekSet(spillRead);
+    OutboundMessage message;
+    while (spillRead < spillWrite && count < OUTBOUND_POOL_SIZE &&
+           spillFile.read(&message, sizeof(message)) == sizeof(message))
+    {
+      store(message);
+      spillRead += sizeof(OutboundMessage);
+    }
+    spillFile.close();
+  }
+
+  if (spillRead != 0 && spillRead >= spillWrite)
+  {
+    // Spill drained, start over with an empty file
+    if (spillFile.open(OUTBOUND_SPILL_FILENAME, O_RDWR))
+    {
+      spillFile.truncate(0);
+      spillFile.close();
+    }
+    spillRead = 0;
+    spillWrite = 0;
+  }
+}
+
+bool OutboundQueue::transmit(Slot &slot, bool isDuplicate)
+{
+  const OutboundMessage &message = slot.message;
+  bool isRetained = message.flags & OUTBOUND_RETAIN;
+
+  if (!(message.flags & OUTBOUND_QOS1))
+  {
+    return mqttClient.publish(message.topic, (const uint8_t *)message.payload, message.payloadLength, isRetained);
+  }
+
+#if MQTT_TRANSPORT == MQTT_TRANSPORT_AT
+  // The modem frames the packet and keeps the QoS1 session; the id comes
+  // back through the ack handler on the next mqttClient.loop()
+  if (!mqttClient.publish(message.topic, (const uint8_t *)message.payload, message.payloadLength, isRetained,
+                          1, slot.packetId))
+  {
+    return false;
+  }
+#else
+  // PubSubClient only publishes QoS0, QoS1 packets are written directly to
+  // the transport between its own packets (both only run from loop())
+  uint8_t packet[5 + 2 + OUTBOUND_TOPIC_SIZE + 2 + OUTBOUND_PAYLOAD_SIZE];
+  size_t topicLength = strlen(message.topic);
+  uint32_t remainingLength = 2 + topicLength + 2 + message.payloadLength;
+  size_t n = 0;
+
+  packet[n++] = MQTT_PUBLISH | (1 << 1) | (isDuplicate ? MQTT_DUP : 0) | (isRetained ? 1 : 0);
+  do
+  {
+    uint8_t digit = remainingLength & 0x7F;
+    remainingLength >>= 7;
+    packet[n++] = remainingLength ? (digit | 0x80) : digit;
+  } while (remainingLength);
+
+  packet[n++] = topicLength >> 8;
+  packet[n++] = topicLength & 0xFF;
+  memcpy(packet + n, message.topic, topicLength);
+  n += topicLength;
+  packet[n++] = slot.packetId >> 8;
+  packet[n++] = slot.packetId & 0xFF;
+  memcpy(packet + n, message.payload, message.payloadLength);
+  n += message.payloadLength;
+
+  if (!mqttClient.connected() || mqttTransport.write(packet, n) != n)
+  {
+    return false;
+  }
+#endif
+
+  slot.sentAt = millis();
+  return true;
+}
+
+void OutboundQueue::reclaim()
+{
+  while (count > 0 && slots[tail].state == SLOT_DONE)
+  {
+    tail = (tail + 1) % OUTBOUND_POOL_SIZE;
+    count--;
+  }
+}
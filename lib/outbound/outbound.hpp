@@ -0,0 +1,202 @@
+#ifndef OUTBOUND_HPP
+#define OUTBOUND_HPP
+
+// Framework libs
+#include <Client.h>
+#include <SdFat.h>
+
+// Local Includes
+#include <config.hpp>
+
+/// OutboundMessage
+/// @brief Message as kept in the RAM pool and in the SD spill file
+///
+struct OutboundMessage
+{
+  char topic[OUTBOUND_TOPIC_SIZE];
+  char payload[OUTBOUND_PAYLOAD_SIZE];
+  uint8_t payloadLength;
+  uint8_t flags; // OUTBOUND_QOS1 | OUTBOUND_RETAIN
+};
+
+static constexpr uint8_t OUTBOUND_QOS1 = 0x01;
+static constexpr uint8_t OUTBOUND_RETAIN = 0x02;
+
+/// Delivery counters, messages/s is published/elapsed time
+struct OutboundStats
+{
+  uint32_t enqueued;    // Messages accepted (RAM or spill)
+  uint32_t published;   // First transmissions
+  uint32_t retransmits; // Retransmissions (timeout or reconnect)
+  uint32_t acked;       // PUBACKs matched to an in-flight message
+  uint32_t spilled;     // Messages written to the SD spill file
+  uint32_t dropped;     // Messages lost (pool and spill full)
+};
+
+/// AckTapClient
+/// @brief Transparent Client wrapper placed between PubSubClient and the
+/// WiFi client. PubSubClient discards PUBACK packets, so the wrapper follows
+/// the MQTT framing of the inbound stream and reports every PUBACK id.
+///
+class AckTapClient : public Client
+{
+public:
+  AckTapClient(Client &client);
+
+  /// setAckHandler
+  /// @brief Function called with the packet id of each PUBACK received
+  ///
+  /// @param[in] handler: Function to call, nullptr to disable
+  ///
+  /// @return none
+  ///
+  void setAckHandler(void (*handler)(uint16_t packetId));
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char *host, uint16_t port) override;
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t *buf, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t *buf, size_t size) override;
+  int peek() override;
+  void flush() override;
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override;
+
+private:
+  void tap(uint8_t b);
+
+  Client &client;
+  void (*ackHandler)(uint16_t packetId);
+  uint8_t parseState;     // Header, length or body
+  uint8_t packetType;     // Fixed header of the current packet
+  uint32_t remaining;     // Body bytes still to come
+  uint8_t lengthShift;    // Varint decoding position
+  uint16_t packetId;      // PUBACK id being assembled
+};
+
+/// OutboundQueue
+/// @brief QoS1 publishing layer on top of PubSubClient. Messages wait in a
+/// fixed RAM pool, at most OUTBOUND_WINDOW are in flight, unacknowledged
+/// messages are retransmitted on timeout and after a reconnect, and the
+/// pool overflows into a spill file on the SD card.
+///
+class OutboundQueue
+{
+public:
+  OutboundQueue();
+
+  /// begin
+  /// @brief Recovers messages left in the spill file by a previous run.
+  ///        Must be called after the SD card is mounted.
+  ///
+  /// @param none
+  ///
+  /// @return none
+  ///
+  void begin();
+
+  /// enqueue
+  /// @brief Queues a message, spilling to SD when the pool is full.
+  ///        Call from loop(), never from an interrupt (SD access).
+  ///
+  /// @param[in] topic: Topic (truncated to OUTBOUND_TOPIC_SIZE - 1)
+  /// @param[in] payload: Payload (truncated to OUTBOUND_PAYLOAD_SIZE)
+  /// @param[in] flags: OUTBOUND_QOS1 and/or OUTBOUND_RETAIN
+  ///
+  /// @return false if the message was dropped
+  ///
+  bool enqueue(const char *topic, const char *payload, uint8_t flags = OUTBOUND_QOS1);
+
+  /// offer
+  /// @brief Queues a message only if the RAM pool has room (no spill),
+  ///        used by the backlog replay so SD records are not copied twice
+  ///
+  /// @param[in] topic: Topic (truncated to OUTBOUND_TOPIC_SIZE - 1)
+  /// @param[in] payload: Payload (truncated to OUTBOUND_PAYLOAD_SIZE)
+  /// @param[in] flags: OUTBOUND_QOS1 and/or OUTBOUND_RETAIN
+  ///
+  /// @return false if the pool is full
+  ///
+  bool offer(const char *topic, const char *payload, uint8_t flags = OUTBOUND_QOS1);
+
+  /// service
+  /// @brief Sends queued messages, expires acknowledgements and refills
+  ///        the pool from the spill file. Call from loop(), like every
+  ///        other method: the queue is never touched by an interrupt.
+  ///
+  /// @param none
+  ///
+  /// @return none
+  ///
+  void service();
+
+  /// acknowledge
+  /// @brief Releases the in-flight message with the given packet id
+  ///
+  /// @param[in] packetId: Id carried by the PUBACK
+  ///
+  /// @return none
+  ///
+  void acknowledge(uint16_t packetId);
+
+  /// freeSlots
+  /// @brief Number of free entries in the RAM pool
+  ///
+  /// @param none
+  ///
+  /// @return free entries
+  ///
+  uint8_t freeSlots() const;
+
+  /// getStats
+  /// @brief Delivery counters
+  ///
+  /// @param none
+  ///
+  /// @return reference to the counters
+  ///
+  const OutboundStats &getStats() const;
+
+private:
+  enum SlotState : uint8_t
+  {
+    SLOT_QUEUED,   // Waiting for a window slot
+    SLOT_INFLIGHT, // Sent, waiting for PUBACK
+    SLOT_DONE      // Acknowledged (or QoS0 sent), waiting to be reclaimed
+  };
+
+  struct Slot
+  {
+    OutboundMessage message;
+    uint16_t packetId;
+    uint32_t sentAt;
+    SlotState state;
+  };
+
+  // Private methods
+  bool store(const OutboundMessage &message);
+  bool spill(const OutboundMessage &message);
+  void refill();
+  bool transmit(Slot &slot, bool isDuplicate);
+  void reclaim();
+
+  // Private attributes
+  Slot slots[OUTBOUND_POOL_SIZE];
+  uint8_t head;  // Next free entry
+  uint8_t tail;  // Oldest entry
+  uint8_t count; // Entries in use
+  uint8_t inFlight;
+  uint16_t nextPacketId;
+  bool wasUp;
+  SdFile spillFile;
+  uint32_t spillRead;  // Offset of the oldest spilled message
+  uint32_t spillWrite; // Offset where the next one is appended
+  OutboundStats stats;
+};
+
+extern OutboundQueue outbound;
+
+#endif // OUTBOUND_HPP
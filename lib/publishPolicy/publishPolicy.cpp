@@ -0,0 +1,67 @@
+// Local Includes
+#include "publishPolicy.hpp"
+
+// Framework libs
+#include <math.h>
+
+PublishPolicy::PublishPolicy()
+{
+  for (uint8_t i = 0; i < PUBLISH_POLICY_MAX_CHANNELS; i++)
+  {
+    channels[i].lastValue = 0;
+    channels[i].lastAt = 0;
+    channels[i].deadband = 0;
+    channels[i].hasValue = false;
+  }
+  heartbeat = 0;
+  evaluatedCount = 0;
+  publishedCount = 0;
+}
+
+void PublishPolicy::setDeadband(uint8_t channel, float deadband)
+{
+  if (channel < PUBLISH_POLICY_MAX_CHANNELS)
+  {
+    channels[channel].deadband = deadband;
+  }
+}
+
+void PublishPolicy::setHeartbeat(uint32_t heartbeatMs)
+{
+  heartbeat = heartbeatMs;
+}
+
+bool PublishPolicy::evaluate(uint8_t channel, float value, uint32_t now)
+{
+  if (channel >= PUBLISH_POLICY_MAX_CHANNELS || isnan(value))
+  {
+    return false;
+  }
+
+  evaluatedCount++;
+  Channel &state = channels[channel];
+
+  bool isDue = !state.hasValue ||
+               fabsf(value - state.lastValue) >= state.deadband ||
+               (heartbeat != 0 && now - state.lastAt >= heartbeat);
+  if (!isDue)
+  {
+    return false;
+  }
+
+  state.lastValue = value;
+  state.lastAt = now;
+  state.hasValue = true;
+  publishedCount++;
+  return true;
+}
+
+uint32_t PublishPolicy::evaluated() const
+{
+  return evaluatedCount;
+}
+
+uint32_t PublishPolicy::published() const
+{
+  return publishedCount;
+}
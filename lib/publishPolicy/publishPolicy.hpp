@@ -0,0 +1,83 @@
+#ifndef PUBLISHPOLICY_HPP
+#define PUBLISHPOLICY_HPP
+
+// Framework libs
+#include <stdint.h>
+
+// Channels tracked by one policy (sensor x quantity)
+static constexpr uint8_t PUBLISH_POLICY_MAX_CHANNELS = 16;
+
+/// PublishPolicy
+/// @brief Report-by-exception filter. A channel is published when its value
+/// leaves the deadband around the last published value, or when the
+/// heartbeat interval expires without a publication. Has no Arduino
+/// dependencies so the same code runs in the host replay tool.
+///
+class PublishPolicy
+{
+public:
+  /// PublishPolicy
+  /// @brief Class constructor, every channel starts with a zero deadband
+  ///        (publish everything) and no heartbeat limit
+  ///
+  /// @param[in] none
+  ///
+  /// @return none
+  ///
+  PublishPolicy();
+
+  /// setDeadband
+  /// @brief Minimum change that triggers a publication on a channel
+  ///
+  /// @param[in] channel: Channel index (< PUBLISH_POLICY_MAX_CHANNELS)
+  /// @param[in] deadband: Absolute change, same unit as the value
+  ///
+  /// @return none
+  ///
+  void setDeadband(uint8_t channel, float deadband);
+
+  /// setHeartbeat
+  /// @brief Maximum time between two publications of the same channel
+  ///
+  /// @param[in] heartbeatMs: Interval in milliseconds (0 disables it)
+  ///
+  /// @return none
+  ///
+  void setHeartbeat(uint32_t heartbeatMs);
+
+  /// evaluate
+  /// @brief Decides whether a new sample must be published and, if so,
+  ///        records it as the last published value
+  ///
+  /// @param[in] channel: Channel index
+  /// @param[in] value: New sample (NaN is never published)
+  /// @param[in] now: Current time in milliseconds
+  ///
+  /// @return true if the sample must be published
+  ///
+  bool evaluate(uint8_t channel, float value, uint32_t now);
+
+  /// evaluated
+  /// @brief Number of samples passed to evaluate()
+  uint32_t evaluated() const;
+
+  /// published
+  /// @brief Number of samples evaluate() accepted
+  uint32_t published() const;
+
+private:
+  struct Channel
+  {
+    float lastValue;  // Last published value
+    uint32_t lastAt;  // Time of the last publication
+    float deadband;
+    bool hasValue;    // Something was published already
+  };
+
+  Channel channels[PUBLISH_POLICY_MAX_CHANNELS];
+  uint32_t heartbeat;
+  uint32_t evaluatedCount;
+  uint32_t publishedCount;
+};
+
+#endif // PUBLISHPOLICY_HPP
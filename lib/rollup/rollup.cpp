@@ -0,0 +1,167 @@
+// Local Includes
+#include "rollup.hpp"
+#include "format.hpp"
+#include "outbound.hpp"
+
+#include <math.h>
+
+extern SdFat sd;
+
+static const uint32_t PERIOD_SECONDS[ROLLUP_PERIODS] = {60, 3600};
+static const char *const PERIOD_TOPICS[ROLLUP_PERIODS] = {TOPIC_ROLLUP_MINUTE, TOPIC_ROLLUP_HOUR};
+static constexpr uint32_t NO_BUCKET = UINT32_MAX;
+
+RollupEngine rollups;
+
+// ========== RollupAccumulator ==========
+
+void RollupAccumulator::reset(uint32_t bucket)
+{
+  this->bucket = bucket;
+  count = 0;
+  minimum = 0;
+  maximum = 0;
+  mean = 0;
+  m2 = 0;
+}
+
+void RollupAccumulator::add(float value)
+{
+  if (count == 0 || value < minimum)
+  {
+    minimum = value;
+  }
+  if (count == 0 || value > maximum)
+  {
+    maximum = value;
+  }
+
+  // Welford: stable without keeping the sum of squares
+  count++;
+  float delta = value - mean;
+  mean += delta / count;
+  m2 += delta * (value - mean);
+}
+
+float RollupAccumulator::variance() const
+{
+  return count > 0 ? m2 / count : 0;
+}
+
+// ========== RollupEngine ==========
+
+RollupEngine::RollupEngine()
+{
+  for (uint8_t p = 0; p < ROLLUP_PERIODS; p++)
+  {
+    for (uint8_t s = 0; s < NUMBER_OF_SENSORS; s++)
+    {
+      buckets[p][s].reset(NO_BUCKET);
+    }
+  }
+  filename[0] = '\0';
+  fileIndex = 0;
+  records = 0;
+  isReady = false;
+}
+
+bool RollupEngine::init()
+{
+  isReady = false;
+  if (sd.fatType() == 0)
+  {
+    return false; // Card not mounted
+  }
+
+  fileIndex = 0;
+  nextFile();
+  isReady = true;
+  return true;
+}
+
+void RollupEngine::add(uint8_t sensor, float value, uint32_t epoch)
+{
+  if (sensor == 0 || sensor > NUMBER_OF_SENSORS)
+  {
+    return;
+  }
+
+  for (uint8_t p = 0; p < ROLLUP_PERIODS; p++)
+  {
+    RollupAccumulator &accumulator = buckets[p][sensor - 1];
+    uint32_t bucket = epoch / PERIOD_SECONDS[p];
+    if (bucket != accumulator.bucket)
+    {
+      close(p, sensor);
+      accumulator.reset(bucket);
+    }
+    if (!isnan(value))
+    {
+      accumulator.add(value);
+    }
+  }
+}
+
+uint32_t RollupEngine::getRecords() const
+{
+  return records;
+}
+
+void RollupEngine::close(uint8_t period, uint8_t sensor)
+{
+  const RollupAccumulator &accumulator = buckets[period][sensor - 1];
+  if (accumulator.bucket == NO_BUCKET || accumulator.count == 0)
+  {
+    return; // First bucket since boot, or every reading failed
+  }
+
+  RollupRecord record;
+  record.start = accumulator.bucket * PERIOD_SECONDS[period];
+  record.period = period;
+  record.sensor = sensor;
+  record.count = accumulator.count;
+  record.minimum = (int16_t)lroundf(accumulator.minimum * 100);
+  record.maximum = (int16_t)lroundf(accumulator.maximum * 100);
+  record.mean = (int16_t)lroundf(accumulator.mean * 100);
+  record.stddev = (uint16_t)lroundf(sqrtf(accumulator.variance()) * 100);
+  records++;
+
+  store(record);
+
+  StrBuilder<OUTBOUND_PAYLOAD_SIZE + 1> payload;
+  payload.appendUInt(record.start).append(',').appendUInt(record.sensor).append(',').appendUInt(record.count);
+  payload.append(',').appendFixed(record.minimum / 100.0f, 2).append(',').appendFixed(record.mean / 100.0f, 2);
+  payload.append(',').appendFixed(record.maximum / 100.0f, 2).append(',').appendFixed(record.stddev / 100.0f, 2);
+  outbound.enqueue(PERIOD_TOPICS[period], payload.c_str());
+}
+
+void RollupEngine::store(const RollupRecord &record)
+{
+  if (!isReady)
+  {
+    return;
+  }
+
+  if (!rollupFile.open(filename, O_RDWR | O_CREAT | O_APPEND))
+  {
+    return;
+  }
+  rollupFile.write(&record, sizeof(record));
+  bool isFull = rollupFile.fileSize() + sizeof(record) > MAX_FILE_SIZE;
+  rollupFile.close();
+
+  if (isFull)
+  {
+    nextFile();
+  }
+}
+
+void RollupEngine::nextFile()
+{
+  do
+  {
+    snprintf(filename, sizeof(filename), "%s%s%d.%s", LOG_PATH, ROLLUP_FILENAME, fileIndex,
+             ROLLUP_EXTENSION);
+    fileIndex++;
+  } while (sd.exists(filename));
+}
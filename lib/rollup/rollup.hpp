@@ -0,0 +1,123 @@
+#ifndef ROLLUP_HPP
+#define ROLLUP_HPP
+
+// Framework libs
+#include <SdFat.h>
+
+// Local Includes
+#include <config.hpp>
+
+/// Rollup periods, index of the accumulator tables
+enum RollupPeriod : uint8_t
+{
+  ROLLUP_MINUTE,
+  ROLLUP_HOUR,
+  ROLLUP_PERIODS
+};
+
+/// RollupRecord
+/// @brief Aggregate of one sensor over one closed bucket, as stored in
+/// agregados<N>.bin
+///
+struct RollupRecord
+{
+  uint32_t start;  // Epoch of the start of the bucket (s)
+  uint8_t period;  // RollupPeriod
+  uint8_t sensor;  // Sensor number (1..NUMBER_OF_SENSORS)
+  uint16_t count;  // Valid samples in the bucket
+  int16_t minimum; // Hundredths
+  int16_t maximum; // Hundredths
+  int16_t mean;    // Hundredths
+  uint16_t stddev; // Hundredths, population standard deviation
+};
+
+static_assert(sizeof(RollupRecord) == 16, "RollupRecord must stay 16 bytes on disk");
+
+/// RollupAccumulator
+/// @brief Streaming min/max/count and Welford mean/variance of one bucket.
+/// O(1) per sample, no samples kept.
+///
+struct RollupAccumulator
+{
+  uint32_t bucket; // Epoch / period of the bucket being filled
+  uint16_t count;
+  float minimum;
+  float maximum;
+  float mean;
+  float m2;        // Sum of squared deviations from the mean
+
+  /// reset
+  /// @brief Starts an empty bucket
+  void reset(uint32_t bucket);
+
+  /// add
+  /// @brief Adds one sample
+  void add(float value);
+
+  /// variance
+  /// @brief Population variance of the bucket
+  float variance() const;
+};
+
+/// RollupEngine
+/// @brief Per-minute and per-hour rollups of every sensor, fed by each new
+/// sample. When a sample falls in a new bucket the previous one is closed:
+/// its RollupRecord is appended to agregados<N>.bin and published on
+/// TOPIC_ROLLUP_MINUTE / TOPIC_ROLLUP_HOUR as
+///   <start>,<sensor>,<count>,<min>,<mean>,<max>,<stddev>
+///
+class RollupEngine
+{
+public:
+  /// RollupEngine
+  /// @brief Class constructor
+  ///
+  /// @param[in] none
+  ///
+  /// @return none
+  ///
+  RollupEngine();
+
+  /// init
+  /// @brief Picks the first unused agregados<N>.bin. Must be called after the
+  ///        SD card is mounted.
+  ///
+  /// @param none
+  ///
+  /// @return true if the card is ready
+  ///
+  bool init();
+
+  /// add
+  /// @brief Feeds one reading to the minute and hour buckets of a sensor
+  ///
+  /// @param[in] sensor: Sensor number (1..NUMBER_OF_SENSORS)
+  /// @param[in] value: Reading, NaN if it failed (not counted)
+  /// @param[in] epoch: Time of the reading (s)
+  ///
+  /// @return none
+  ///
+  void add(uint8_t sensor, float value, uint32_t epoch);
+
+  /// getRecords
+  /// @brief Rollup records emitted since boot
+  uint32_t getRecords() const;
+
+private:
+  // Private methods
+  void close(uint8_t period, uint8_t sensor);
+  void store(const RollupRecord &record);
+  void nextFile();
+
+  // Private attributes
+  RollupAccumulator buckets[ROLLUP_PERIODS][NUMBER_OF_SENSORS];
+  SdFile rollupFile;
+  char filename[30];
+  int fileIndex;
+  uint32_t records;
+  bool isReady;
+};
+
+extern RollupEngine rollups;
+
+#endif // ROLLUP_HPP
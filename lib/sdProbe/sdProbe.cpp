@@ -0,0 +1,174 @@
+// Local Includes
+#include "sdProbe.hpp"
+
+extern SdFat sd;
+
+static constexpr uint16_t SECTOR_SIZE = 512;
+static constexpr uint8_t APPEND_SIZE = 64; // About one log line
+static const char *const PROBE_FILENAME = "sdprobe.tmp";
+
+// CSD TRAN_SPEED: time value x10 and unit in kbit/s
+static const uint8_t TRAN_SPEED_VALUE[16] = {0, 10, 12, 13, 15, 20, 25, 30, 35, 40, 45, 50, 55, 60, 70, 80};
+static const uint32_t TRAN_SPEED_UNIT[4] = {100, 1000, 10000, 100000};
+// SD status SPEED_CLASS code -> class
+static const uint8_t SPEED_CLASS[5] = {0, 2, 4, 6, 10};
+
+static uint8_t sector[SECTOR_SIZE];
+static uint32_t appendUs[SD_PROBE_APPENDS];
+
+SdProbe sdProbe;
+
+SdProfile chooseSdProfile(const SdProbeResult &result, uint32_t sampleIntervalMs)
+{
+  SdCardTier tier = SD_TIER_FAST;
+  if (result.appendMaxUs >= SD_PROBE_SLOW_STALL_US || result.sequentialKBps < SD_PROBE_SLOW_KBPS)
+  {
+    tier = SD_TIER_SLOW;
+  }
+  else if (result.appendMaxUs >= SD_PROBE_FAST_STALL_US || result.sequentialKBps < SD_PROBE_FAST_KBPS)
+  {
+    tier = SD_TIER_MEDIUM;
+  }
+
+  SdProfile profile;
+  profile.tier = tier;
+  profile.bufferSize = SD_PROFILE_BUFFER_SIZE[tier];
+  profile.flushIntervalMs = SD_PROFILE_FLUSH_INTERVAL[tier];
+  profile.preallocBytes = SD_PROFILE_PREALLOCATION[tier];
+
+  // Lines keep arriving while the card stalls: the buffer must hold every
+  // sample taken during the worst stall, plus the one being written
+  uint32_t intervalUs = (sampleIntervalMs > 0 ? sampleIntervalMs : 1) * 1000;
+  uint32_t samples = (result.appendMaxUs + intervalUs - 1) / intervalUs + 1;
+  uint32_t needed = samples * SD_BYTES_PER_SAMPLE;
+  while (profile.bufferSize < needed && profile.bufferSize < SD_WRITE_BUFFER_MAX)
+  {
+    profile.bufferSize *= 2;
+  }
+  if (profile.bufferSize > SD_WRITE_BUFFER_MAX)
+  {
+    profile.bufferSize = SD_WRITE_BUFFER_MAX;
+  }
+  return profile;
+}
+
+SdProbe::SdProbe()
+{
+  memset(&info, 0, sizeof(info));
+  memset(&result, 0, sizeof(result));
+  profile.tier = SD_TIER_FAST;
+  profile.bufferSize = SD_WRITE_BUFFER_SIZE;
+  profile.flushIntervalMs = SD_FLUSH_INTERVAL;
+  profile.preallocBytes = 0;
+}
+
+bool SdProbe::run(uint32_t sampleIntervalMs)
+{
+  if (sd.fatType() == 0)
+  {
+    return false; // Card not mounted
+  }
+
+  readInfo();
+  if (!measure())
+  {
+    return false;
+  }
+  profile = chooseSdProfile(result, sampleIntervalMs);
+  return true;
+}
+
+const SdCardInfo &SdProbe::getInfo() const
+{
+  return info;
+}
+
+const SdProbeResult &SdProbe::getResult() const
+{
+  return result;
+}
+
+const SdProfile &SdProbe::getProfile() const
+{
+  return profile;
+}
+
+bool SdProbe::readInfo()
+{
+  SdCard *card = sd.card();
+  info.sizeMB = card->sectorCount() / (1048576 / SECTOR_SIZE);
+
+  cid_t cid;
+  if (card->readCID(&cid))
+  {
+    info.manufacturer = cid.mid;
+    memcpy(info.oem, cid.oid, 2);
+    info.oem[2] = '\0';
+    memcpy(info.product, cid.pnm, 5);
+    info.product[5] = '\0';
+    info.revision = cid.prv;
+  }
+
+  csd_t csd;
+  if (card->readCSD(&csd))
+  {
+    info.csdVersion = (csd.csd[0] >> 6) + 1;
+    uint8_t tranSpeed = csd.csd[3];
+    info.maxKbps = TRAN_SPEED_VALUE[(tranSpeed >> 3) & 0x0F] * TRAN_SPEED_UNIT[tranSpeed & 0x03] / 10;
+  }
+
+  // Speed class is only in the SD status (ACMD13), not in CID/CSD
+  sds_t sds;
+  if (card->readSDS(&sds) && sds.speedClass < sizeof(SPEED_CLASS))
+  {
+    info.speedClass = SPEED_CLASS[sds.speedClass];
+  }
+  return true;
+}
+
+bool SdProbe::measure()
+{
+  sd.remove(PROBE_FILENAME);
+  if (!probeFile.open(PROBE_FILENAME, O_RDWR | O_CREAT | O_TRUNC))
+  {
+    return false;
+  }
+  memset(sector, 'p', sizeof(sector));
+
+  // Sequential: whole sectors, committed once at the end
+  bool isWritten = true;
+  uint32_t started = micros();
+  for (uint16_t i = 0; i < SD_PROBE_SEQUENTIAL_KB * 1024 / SECTOR_SIZE; i++)
+  {
+    isWritten &= probeFile.write(sector, SECTOR_SIZE) == SECTOR_SIZE;
+  }
+  isWritten &= probeFile.sync();
+  uint32_t elapsed = micros() - started;
+  result.sequentialKBps = elapsed > 0 ? (uint32_t)((uint64_t)SD_PROBE_SEQUENTIAL_KB * 1000000 / elapsed) : 0;
+
+  // Small appends, each committed: what an unbuffered log line costs
+  for (uint8_t i = 0; i < SD_PROBE_APPENDS; i++)
+  {
+    started = micros();
+    isWritten &= probeFile.write(sector, APPEND_SIZE) == APPEND_SIZE;
+    isWritten &= probeFile.sync();
+    appendUs[i] = micros() - started;
+  }
+  probeFile.close();
+  sd.remove(PROBE_FILENAME);
+
+  // Insertion sort: a few dozen values
+  for (uint8_t i = 1; i < SD_PROBE_APPENDS; i++)
+  {
+    uint32_t value = appendUs[i];
+    uint8_t j = i;
+    for (; j > 0 && appendUs[j - 1] > value; j--)
+    {
+      appendUs[j] = appendUs[j - 1];
+    }
+    appendUs[j] = value;
+  }
+  result.appendP50Us = appendUs[SD_PROBE_APPENDS / 2];
+  result.appendMaxUs = appendUs[SD_PROBE_APPENDS - 1];
+  return isWritten;
+}
@@ -0,0 +1,114 @@
+#ifndef SDPROBE_HPP
+#define SDPROBE_HPP
+
+// Framework libs
+#include <SdFat.h>
+
+// Local Includes
+#include <config.hpp>
+
+/// Write profiles, from the fastest cards to the slowest
+enum SdCardTier : uint8_t
+{
+  SD_TIER_FAST,
+  SD_TIER_MEDIUM,
+  SD_TIER_SLOW,
+  SD_TIERS
+};
+
+/// SdCardInfo
+/// @brief Identity and nominal speed of the card, from CID, CSD and the SD
+/// status register
+///
+struct SdCardInfo
+{
+  uint8_t manufacturer;   // CID MID
+  char oem[3];            // CID OID
+  char product[6];        // CID PNM
+  uint8_t revision;       // CID PRV, BCD n.m
+  uint8_t csdVersion;     // 1 = SDSC, 2 = SDHC/SDXC
+  uint32_t maxKbps;       // CSD TRAN_SPEED
+  uint8_t speedClass;     // 0, 2, 4, 6 or 10
+  uint32_t sizeMB;
+};
+
+/// SdProbeResult
+/// @brief Write timings measured on the card
+///
+struct SdProbeResult
+{
+  uint32_t sequentialKBps; // Sector-aligned writes of SD_PROBE_SEQUENTIAL_KB
+  uint32_t appendP50Us;    // Small append + sync, median
+  uint32_t appendMaxUs;    // Small append + sync, worst (garbage collection)
+};
+
+/// SdProfile
+/// @brief Write strategy picked for the card
+///
+struct SdProfile
+{
+  SdCardTier tier;
+  uint16_t bufferSize;      // ExtMEM line buffer (bytes)
+  uint32_t flushIntervalMs; // ExtMEM sync period
+  uint32_t preallocBytes;   // Contiguous clusters for each telemetria<N>.bin, 0 = none
+};
+
+/// chooseSdProfile
+/// @brief Picks the tier from the measured timings, then grows the buffer
+///        until it holds every line sampled during the worst stall seen
+///
+/// @param[in] result: Probe timings
+/// @param[in] sampleIntervalMs: Time between two readings (TIM3)
+///
+/// @return the profile
+///
+SdProfile chooseSdProfile(const SdProbeResult &result, uint32_t sampleIntervalMs);
+
+/// SdProbe
+/// @brief Short boot-time measure of the mounted card: sequential write
+/// speed and small-append latency on a scratch file, plus the card
+/// registers. Takes well under a second on a good card.
+///
+class SdProbe
+{
+public:
+  /// SdProbe
+  /// @brief Class constructor
+  ///
+  /// @param[in] none
+  ///
+  /// @return none
+  ///
+  SdProbe();
+
+  /// run
+  /// @brief Reads the card registers, measures it and picks the profile.
+  ///        Must be called after the SD card is mounted; without a card
+  ///        (or if the scratch file fails) the profile keeps the defaults
+  ///        from config.hpp.
+  ///
+  /// @param[in] sampleIntervalMs: Time between two readings (TIM3)
+  ///
+  /// @return true if the card was measured
+  ///
+  bool run(uint32_t sampleIntervalMs);
+
+  const SdCardInfo &getInfo() const;
+  const SdProbeResult &getResult() const;
+  const SdProfile &getProfile() const;
+
+private:
+  // Private methods
+  bool readInfo();
+  bool measure();
+
+  // Private attributes
+  SdFile probeFile;
+  SdCardInfo info;
+  SdProbeResult result;
+  SdProfile profile;
+};
+
+extern SdProbe sdProbe;
+
+#endif // SDPROBE_HPP
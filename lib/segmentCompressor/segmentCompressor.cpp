@@ -0,0 +1,286 @@
+// Local Includes
+#include "segmentCompressor.hpp"
+#include "crc32.hpp"
+#include "logs.hpp"
+
+#include <ctype.h>
+
+extern SdFat sd;
+extern ExtMEM logs;
+
+SegmentCompressor::SegmentCompressor()
+{
+  state = IDLE;
+  sourceName[0] = '\0';
+  activeCount = 0;
+  lastScan = 0;
+  sourceSize = 0;
+  sourceRead = 0;
+  targetSize = 0;
+  sourceCrc = 0;
+  segmentCpuUs = 0;
+  segments = 0;
+  totalIn = 0;
+  totalOut = 0;
+  totalCpuUs = 0;
+}
+
+void SegmentCompressor::protect(const char *filename)
+{
+  if (activeCount < SEGMENT_MAX_ACTIVE)
+  {
+    active[activeCount++] = filename;
+  }
+}
+
+void SegmentCompressor::service(uint32_t budgetUs)
+{
+  if (!IS_COMPRESSION_ENABLED || !idleBudget.allows(budgetUs))
+  {
+    return; // The step could still be running when the next tick fires
+  }
+
+  uint32_t started = micros();
+  switch (state)
+  {
+  case IDLE:
+    if (millis() - lastScan < COMPRESSION_SCAN_INTERVAL)
+    {
+      return;
+    }
+    lastScan = millis();
+    if (directory.open(LOG_PATH[0] == '\0' ? "/" : LOG_PATH, O_RDONLY))
+    {
+      state = SCANNING;
+    }
+    break;
+
+  case SCANNING:
+    scan();
+    break;
+
+  case COMPRESSING:
+    if (!compressChunk())
+    {
+      abort();
+    }
+    break;
+  }
+
+  idleBudget.record(micros() - started);
+}
+
+uint32_t SegmentCompressor::getSegments() const
+{
+  return segments;
+}
+
+uint32_t SegmentCompressor::getBytesIn() const
+{
+  return totalIn;
+}
+
+uint32_t SegmentCompressor::getBytesOut() const
+{
+  return totalOut;
+}
+
+uint32_t SegmentCompressor::getCpuUsPerKB() const
+{
+  return totalIn == 0 ? 0 : (uint32_t)((uint64_t)totalCpuUs * 1024 / totalIn);
+}
+
+void SegmentCompressor::scan()
+{
+  SdFile entry;
+  char name[24];
+  char path[sizeof(sourceName)];
+
+  for (uint8_t i = 0; i < COMPRESSION_SCAN_ENTRIES; i++)
+  {
+    if (!entry.openNext(&directory, O_RDONLY))
+    {
+      directory.close(); // End of the directory, nothing left to compress
+      state = IDLE;
+      return;
+    }
+    bool isFile = !entry.isDir() && entry.getName(name, sizeof(name));
+    entry.close();
+    if (!isFile)
+    {
+      continue;
+    }
+    snprintf(path, sizeof(path), "%s%s", LOG_PATH, name);
+
+    // Left by a reset in the middle of a segment: the source is still
+    // there and is compressed again
+    size_t length = strlen(name);
+    size_t extension = sizeof(COMPRESSING_EXTENSION) - 1;
+    if (length > extension + 1 && name[length - extension - 1] == '.' &&
+        strcmp(name + length - extension, COMPRESSING_EXTENSION) == 0)
+    {
+      sd.remove(path);
+      continue;
+    }
+
+    if (isCandidate(path, name))
+    {
+      directory.close();
+      state = start(path) ? COMPRESSING : IDLE;
+      return;
+    }
+  }
+}
+
+bool SegmentCompressor::isCandidate(const char *path, const char *name) const
+{
+  // <LOG_FILENAME><N>.log or <CSV_FILENAME><N>.csv
+  const char *rest;
+  const char *type;
+  if (strncmp(name, LOG_FILENAME, sizeof(LOG_FILENAME) - 1) == 0)
+  {
+    rest = name + sizeof(LOG_FILENAME) - 1;
+    type = ".log";
+  }
+  else if (strncmp(name, CSV_FILENAME, sizeof(CSV_FILENAME) - 1) == 0)
+  {
+    rest = name + sizeof(CSV_FILENAME) - 1;
+    type = ".csv";
+  }
+  else
+  {
+    return false;
+  }
+
+  if (!isdigit((unsigned char)*rest))
+  {
+    return false;
+  }
+  while (isdigit((unsigned char)*rest))
+  {
+    rest++;
+  }
+  if (strcmp(rest, type) != 0)
+  {
+    return false;
+  }
+
+  for (uint8_t i = 0; i < activeCount; i++)
+  {
+    if (strcmp(active[i], path) == 0)
+    {
+      return false; // Still being written
+    }
+  }
+  return true;
+}
+
+bool SegmentCompressor::start(const char *path)
+{
+  char targetName[sizeof(sourceName) + 4];
+  snprintf(targetName, sizeof(targetName), "%s.%s", path, COMPRESSING_EXTENSION);
+
+  if (!source.open(path, O_RDONLY))
+  {
+    return false;
+  }
+  if (!target.open(targetName, O_RDWR | O_CREAT | O_TRUNC))
+  {
+    source.close();
+    return false;
+  }
+
+  // Placeholder: the magic is only written once the stream is complete
+  LzssFileHeader header = {};
+  if (target.write(&header, sizeof(header)) != sizeof(header))
+  {
+    target.remove();
+    source.close();
+    return false;
+  }
+
+  strncpy(sourceName, path, sizeof(sourceName) - 1);
+  sourceName[sizeof(sourceName) - 1] = '\0';
+  sourceSize = source.fileSize();
+  sourceRead = 0;
+  targetSize = sizeof(header);
+  sourceCrc = 0;
+  segmentCpuUs = 0;
+  encoder.begin();
+  return true;
+}
+
+bool SegmentCompressor::compressChunk()
+{
+  int n = source.read(input, sizeof(input));
+  if (n < 0)
+  {
+    return false;
+  }
+  sourceRead += n;
+  sourceCrc = crc32(input, n, sourceCrc);
+  bool isFinal = n < (int)sizeof(input) || sourceRead >= sourceSize;
+
+  uint32_t started = micros();
+  size_t produced = encoder.compress(input, n, isFinal, output);
+  segmentCpuUs += micros() - started;
+
+  if (target.write(output, produced) != produced)
+  {
+    return false;
+  }
+  targetSize += produced;
+
+  if (isFinal)
+  {
+    finish();
+  }
+  return true;
+}
+
+void SegmentCompressor::finish()
+{
+  LzssFileHeader header;
+  header.magic = LZSS_MAGIC;
+  header.originalSize = sourceRead;
+  header.crc = sourceCrc;
+  header.window = LZSS_WINDOW;
+  header.reserved = 0;
+
+  char finalName[sizeof(sourceName) + 4];
+  snprintf(finalName, sizeof(finalName), "%s.%s", sourceName, COMPRESSED_EXTENSION);
+  if (!target.seekSet(0) || target.write(&header, sizeof(header)) != sizeof(header) || !target.sync() ||
+      !target.rename(finalName))
+  {
+    abort();
+    return;
+  }
+  target.close();
+  source.close();
+  sd.remove(sourceName); // Only once the .lz is complete
+  state = IDLE;
+
+  segments++;
+  totalIn += sourceRead;
+  totalOut += targetSize;
+  totalCpuUs += segmentCpuUs;
+
+  char msg[sizeof(sourceName) + 100]; // Name plus four numbers at full width
+  snprintf(msg, sizeof(msg), "Comprimido %s: %lu -> %lu bytes (%lu%%), %lu us/KB", sourceName,
+           (unsigned long)sourceRead, (unsigned long)targetSize,
+           (unsigned long)(sourceRead == 0 ? 0 : (uint64_t)targetSize * 100 / sourceRead),
+           (unsigned long)(sourceRead == 0 ? 0 : (uint64_t)segmentCpuUs * 1024 / sourceRead));
+  logs.info(msg);
+}
+
+void SegmentCompressor::abort()
+{
+  target.remove(); // Partial output, the source stays for the next scan
+  target.close();
+  source.close();
+  state = IDLE;
+
+  char msg[60];
+  snprintf(msg, sizeof(msg), "Compressão falhou: %s", sourceName);
+  logs.warning(msg);
+}
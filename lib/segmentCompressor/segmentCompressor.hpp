@@ -0,0 +1,103 @@
+#ifndef SEGMENTCOMPRESSOR_HPP
+#define SEGMENTCOMPRESSOR_HPP
+
+// Framework libs
+#include <SdFat.h>
+
+// Local Includes
+#include <config.hpp>
+#include "idleBudget.hpp"
+#include "lzss.hpp"
+
+static constexpr size_t SEGMENT_CHUNK_SIZE = 512; // One sector per step
+static constexpr uint8_t SEGMENT_MAX_ACTIVE = 4;  // Files being written, never compressed
+
+/// SegmentCompressor
+/// @brief Turns closed log and CSV segments into <name>.lz in the idle time
+/// between two sampling ticks. Each service() call does at most one step
+/// (a few directory entries, or one 512-byte chunk read, compressed and
+/// written) and only when the time left before the next TIM3 tick is more
+/// than twice the slowest step seen, so the ISR never waits on the SD bus.
+/// Output goes to <name>.lzt and is renamed when complete; the source is
+/// removed only after that. tools/lzss decompresses the files on a PC.
+///
+class SegmentCompressor
+{
+public:
+  /// SegmentCompressor
+  /// @brief Class constructor
+  ///
+  /// @param[in] none
+  ///
+  /// @return none
+  ///
+  SegmentCompressor();
+
+  /// protect
+  /// @brief Registers the name buffer of a file still being written. The
+  ///        buffer is read on every scan, so rotation is followed.
+  ///
+  /// @param[in] filename: Name buffer (e.g. ExtMEM::getFilename())
+  ///
+  /// @return none
+  ///
+  void protect(const char *filename);
+
+  /// service
+  /// @brief Advances the compression by one step if the budget allows
+  ///
+  /// @param[in] budgetUs: Microseconds until the next sampling tick
+  ///
+  /// @return none
+  ///
+  void service(uint32_t budgetUs);
+
+  /// Totals since boot
+  uint32_t getSegments() const;
+  uint32_t getBytesIn() const;
+  uint32_t getBytesOut() const;
+  uint32_t getCpuUsPerKB() const;
+
+private:
+  // Private methods
+  void scan();
+  bool isCandidate(const char *path, const char *name) const;
+  bool start(const char *name);
+  bool compressChunk();
+  void finish();
+  void abort();
+
+  // Private attributes
+  enum State
+  {
+    IDLE,
+    SCANNING,
+    COMPRESSING
+  };
+
+  State state;
+  SdFile directory;
+  SdFile source;
+  SdFile target;
+  LzssEncoder encoder;
+  uint8_t input[SEGMENT_CHUNK_SIZE];
+  uint8_t output[lzssBound(SEGMENT_CHUNK_SIZE)];
+  char sourceName[30];
+  const char *active[SEGMENT_MAX_ACTIVE];
+  uint8_t activeCount;
+
+  uint32_t lastScan;
+  IdleBudget idleBudget;
+  uint32_t sourceSize;
+  uint32_t sourceRead;
+  uint32_t targetSize;
+  uint32_t sourceCrc;
+  uint32_t segmentCpuUs;
+
+  uint32_t segments;
+  uint32_t totalIn;
+  uint32_t totalOut;
+  uint32_t totalCpuUs; // Time spent in LzssEncoder::compress() only
+};
+
+#endif // SEGMENTCOMPRESSOR_HPP
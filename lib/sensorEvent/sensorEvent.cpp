@@ -1,15 +1,12 @@
 // Includes locais
 #include "sensorEvent.hpp"
+#include "format.hpp"
 
 // Definição de classes
 DHT_Unified dht(DHTPIN, DHTTYPE);
 sensors_event_t event;
 
 // Definição de variáveis
-char convertFloatStringTemp[50];    // String para dados de temperatura convertidos
-char convertFloatStringHum[10];     // String para dados de humidade convertidos
-char resultTemp[200];               // String para dados de temperatura resultantes
-char resultHum[200];                // String para dados de humidade resultantes
 float sumTemperatureAverageSensors; // Variável para soma da temperatura média
 float sumHumidityAverageSensors;    // Variável para soma da humidade média
 float offsetTempSensors = 0.25;     // Offset para sensores de temperatura
@@ -20,6 +17,9 @@ struct sensorData sensor_data = {0};
 
 // Construtor da classe
 sensorEvent::sensorEvent() {
+    sampleHandler = nullptr;
+    lastSampleMs = 0;
+    hasSample = false;
 }
 
 void sensorEvent::initSensor() { // Inicializar o sensor DHT
@@ -35,12 +35,27 @@ void sensorEvent::getTemperature() { // Obter temperatura do sensor
         }
         logs.error("Falha na leitura da temperatura!");
     } else {
+        uint32_t sampleUs = micros(); // Hora da leitura, para a latência dos alarmes
         for (int i = 0; i < NUMBER_OF_SENSORS; i++) {
             sensor_data.temperatureSensors[i] = event.temperature;
         }
+        sensor_data.temperatureSensors[1] += offsetTempSensors;       // Mesmos ajustes da média
+        sensor_data.temperatureSensors[2] -= offsetTempSensors;
+        sensor_data.temperatureSensors[3] += 2 * offsetTempSensors;
+
+        // Só leituras novas: as repetidas pelo driver contariam várias vezes para o debounce
+        if (sampleHandler && (!hasSample || millis() - lastSampleMs >= DHT_MIN_INTERVAL_MS)) {
+            lastSampleMs = millis();
+            hasSample = true;
+            sampleHandler(sensor_data.temperatureSensors, sampleUs);
+        }
     }
 }
 
+void sensorEvent::setSampleHandler(void (*handler)(const float *temperatures, uint32_t sampleUs)) { // Alarmes avaliados por leitura
+    sampleHandler = handler;
+}
+
 void sensorEvent::getHumidity() { // Obter humidade do sensor
     dht.humidity().getEvent(&event);
 
@@ -95,25 +110,19 @@ void sensorEvent::getHumidityAverage() { // Obter humidade média dos sensores
 }
 
 void sensorEvent::writeTemperatureAverage() { // Escrever dados de temperatura média nos logs
+    StrBuilder<64> tempMsg; // Mensagem construída no local, sem heap
     for (int i = 0; i < NUMBER_OF_SENSORS; i++) {
-        dtostrf(sensor_data.temperatureAverageSensors[i], 4, 2, convertFloatStringTemp);
-        String tempMsg = "Temperatura Média Sensor ";
-        tempMsg += String(i + 1);
-        tempMsg += " = ";
-        tempMsg += convertFloatStringTemp;
-        tempMsg += " C";
+        tempMsg.clear().append("Temperatura Média Sensor ").appendUInt(i + 1).append(" = ");
+        tempMsg.appendFixed(sensor_data.temperatureAverageSensors[i], 2).append(" C");
         logs.info(tempMsg.c_str());
     }
 }
 
 void sensorEvent::writeHumidityAverage() { // Escrever dados de humidade média nos logs
+    StrBuilder<64> humMsg; // Mensagem construída no local, sem heap
     for (int i = 0; i < NUMBER_OF_SENSORS; i++) {
-        dtostrf(sensor_data.humidityAverageSensors[i], 2, 0, convertFloatStringHum);
-        String humMsg = "Humidade Média Sensor ";
-        humMsg += String(i + 1);
-        humMsg += " = ";
-        humMsg += convertFloatStringHum;
-        humMsg += "%";
+        humMsg.clear().append("Humidade Média Sensor ").appendUInt(i + 1).append(" = ");
+        humMsg.appendFixed(sensor_data.humidityAverageSensors[i], 0).append('%');
         logs.info(humMsg.c_str());
     }
 }
\ No newline at end of file
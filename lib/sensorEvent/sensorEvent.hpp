@@ -25,8 +25,14 @@ public:
 
     void getHumidityAverage(); // Obter humidade média dos sensores
 
+    void setSampleHandler(void (*handler)(const float *temperatures, uint32_t sampleUs)); // Chamada a cada leitura nova do DHT
+
 private:
     // Atributos privados
+    void (*sampleHandler)(const float *temperatures, uint32_t sampleUs); // Alarmes por leitura, nullptr = nenhuma
+    unsigned long lastSampleMs; // Última leitura nova (o driver repete a anterior durante DHT_MIN_INTERVAL_MS)
+    bool hasSample;
+
     void writeTemperatureAverage(); // Escrever dados de temperatura média nos logs
 
     void writeHumidityAverage(); // Escrever dados de humidade média nos logs
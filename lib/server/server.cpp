@@ -2,20 +2,25 @@
 
 const char *server::get_ssid() 
 {
-    return ssid.c_str();
+    return config.ssid;
 }
 
 const char *server::get_password()
 { 
-    return password.c_str(); 
+    return config.password; 
 }
 
 const char *server::get_ip() 
 {
-    return ip.c_str(); 
+    return config.brokerHost; 
 }
 
 int server::get_port() 
 { 
-    return port;
+    return config.brokerPort;
+}
+
+const char *server::get_client_id()
+{
+    return config.clientId;
 }
\ No newline at end of file
@@ -1,24 +1,21 @@
 #ifndef __SERVER__HPP
 #define __SERVER__HPP
 
-#include <string>
-#include <HardwareSerial.h>
+#include <config.hpp>
 
+// Broker and access point, read from the loaded configuration (config.json)
 class server {
 public:
-    server(std::string ssid, std::string password, std::string ip, int port) :
-        ssid(ssid), password(password), ip(ip), port(port) {}
+    server(const configData &config) : config(config) {}
 
     const char* get_ssid();
     const char* get_password();
     const char* get_ip();
     int get_port();
+    const char* get_client_id();
 
 private:
-    std::string ssid;
-    std::string password;
-    std::string ip;
-    int port;
+    const configData &config;
 };
 
 #endif
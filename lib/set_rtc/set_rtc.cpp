@@ -66,4 +66,27 @@ DateTime get_rtc_datetime()
     dt.minutes = rtc.getMinutes();
     dt.seconds = rtc.getSeconds();
     return dt;
-}
\ No newline at end of file
+}
+
+// Days from 1970-01-01 to a date of the Gregorian calendar
+static uint32_t days_from_civil(uint16_t year, uint8_t month, uint8_t day)
+{
+    year -= month <= 2; // Years start in March, so February is last
+    uint32_t era = year / 400;
+    uint32_t yearOfEra = year - era * 400;
+    uint32_t dayOfYear = (153 * (month > 2 ? month - 3 : month + 9) + 2) / 5 + day - 1;
+    uint32_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+uint32_t get_rtc_epoch()
+{
+    // Not rtc.getEpoch(): its mktime() goes through newlib's tzset, which can allocate
+    DateTime dt;
+    uint8_t seconds;
+    do {
+        seconds = rtc.getSeconds();
+        dt = get_rtc_datetime();
+    } while (dt.seconds != seconds); // A second ticked between the fields: read again
+    return days_from_civil(dt.year, dt.month, dt.day) * 86400UL + dt.hours * 3600UL + dt.minutes * 60UL + dt.seconds;
+}
@@ -22,4 +22,6 @@ void set_rtc_time(int day, int month, int year, int hour, int minute, int second
 
 DateTime get_rtc_datetime();
 
+uint32_t get_rtc_epoch();
+
 #endif /* SET_RTC_DATE_TIME_HPP_INCLUDED_ */
\ No newline at end of file
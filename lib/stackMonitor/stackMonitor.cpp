@@ -0,0 +1,173 @@
+// Local Includes
+#include "stackMonitor.hpp"
+
+// Framework libs
+#include <malloc.h>
+
+static constexpr uint32_t STACK_PATTERN = 0xC5C5C5C5;
+static constexpr size_t SP_MARGIN = 16; // Never paint right at the SP of the painting code
+
+#if defined(__arm__)
+extern "C"
+{
+  extern uint32_t _estack;        // Top of RAM, start of the main stack (linker script)
+  extern uint8_t _Min_Stack_Size; // Stack reserve the heap never takes (its address is the value)
+  void *_sbrk(ptrdiff_t increment);
+}
+
+static inline uint32_t *stackPointer()
+{
+  return (uint32_t *)__get_MSP();
+}
+#endif
+
+StackMonitor stackMonitor;
+
+static uint32_t *firstWritten(uint32_t *from, uint32_t *to)
+{
+  while (from < to && *from == STACK_PATTERN)
+  {
+    from++;
+  }
+  return from;
+}
+
+StackMonitor::StackMonitor()
+{
+  stackTop = nullptr;
+  lowest = nullptr;
+  isrTop = nullptr;
+  isrBottom = nullptr;
+  isrHighWater = 0;
+  isPainted = false;
+}
+
+uint32_t *StackMonitor::heapTop() const
+{
+#if defined(__arm__)
+  // The heap only grows: rounding up keeps the painted words inside free RAM
+  return (uint32_t *)(((uintptr_t)_sbrk(0) + 3) & ~(uintptr_t)3);
+#else
+  return nullptr;
+#endif
+}
+
+void StackMonitor::begin()
+{
+#if defined(__arm__)
+  stackTop = &_estack;
+  uint32_t *end = (uint32_t *)((uint8_t *)stackPointer() - SP_MARGIN);
+  for (uint32_t *word = heapTop(); word < end; word++)
+  {
+    *word = STACK_PATTERN;
+  }
+  lowest = end;
+  isPainted = true;
+#endif
+}
+
+void StackMonitor::isrEnter()
+{
+#if defined(__arm__)
+  if (!isPainted)
+  {
+    return;
+  }
+  uint32_t *top = (uint32_t *)((uint8_t *)stackPointer() - SP_MARGIN);
+  uint32_t *bottom = top - STACK_ISR_WINDOW / sizeof(uint32_t);
+  uint32_t *heap = heapTop();
+  if (bottom < heap)
+  {
+    bottom = heap; // Never paint over the heap
+  }
+
+  // Whatever loop() left in the window counts before it is painted over
+  uint32_t *written = firstWritten(bottom, top);
+  if (written < lowest)
+  {
+    lowest = written;
+  }
+  for (uint32_t *word = bottom; word < top; word++)
+  {
+    *word = STACK_PATTERN;
+  }
+  isrTop = top;
+  isrBottom = bottom;
+#endif
+}
+
+void StackMonitor::isrExit()
+{
+  if (!isrTop)
+  {
+    return;
+  }
+  uint32_t *written = firstWritten(isrBottom, isrTop);
+  uint32_t depth = (uint32_t)((uint8_t *)isrTop - (uint8_t *)written);
+  if (depth > isrHighWater)
+  {
+    isrHighWater = depth;
+  }
+  if (written < lowest)
+  {
+    lowest = written;
+  }
+  isrTop = nullptr;
+}
+
+void StackMonitor::update()
+{
+  if (!isPainted)
+  {
+    return;
+  }
+  uint32_t *written = firstWritten(heapTop(), lowest);
+
+  // The ISR may have lowered the mark during the scan
+  noInterrupts();
+  if (written < lowest)
+  {
+    lowest = written;
+  }
+  interrupts();
+}
+
+uint32_t StackMonitor::getStackHighWater() const
+{
+  return isPainted ? (uint32_t)((uint8_t *)stackTop - (uint8_t *)lowest) : 0;
+}
+
+uint32_t StackMonitor::getIsrHighWater() const
+{
+  return isrHighWater;
+}
+
+uint32_t StackMonitor::getHeapFree() const
+{
+#if defined(__arm__)
+  if (!isPainted)
+  {
+    return 0;
+  }
+  uint8_t *limit = (uint8_t *)&_estack - (uintptr_t)&_Min_Stack_Size;
+  if ((uint8_t *)lowest < limit)
+  {
+    limit = (uint8_t *)lowest;
+  }
+  uint8_t *heap = (uint8_t *)_sbrk(0);
+  uint32_t unclaimed = limit > heap ? (uint32_t)(limit - heap) : 0;
+  return (uint32_t)mallinfo().fordblks + unclaimed;
+#else
+  return 0;
+#endif
+}
+
+uint32_t StackMonitor::getHeadroom() const
+{
+  if (!isPainted)
+  {
+    return 0;
+  }
+  uint32_t *heap = heapTop();
+  return lowest > heap ? (uint32_t)((uint8_t *)lowest - (uint8_t *)heap) : 0;
+}
@@ -0,0 +1,104 @@
+#ifndef STACKMONITOR_HPP
+#define STACKMONITOR_HPP
+
+// Framework libs
+#include <Arduino.h>
+
+// Local Includes
+#include <config.hpp>
+
+/// StackMonitor
+/// @brief Stack and heap high-water marks from stack painting. begin()
+/// fills the free RAM between the heap and the stack with a pattern; the
+/// deepest word no longer holding it is the deepest the stack has been.
+///
+/// loop() and the interrupts share the main stack (MSP), so two figures
+/// are kept: the total depth, which is what overflows into the heap and
+/// the globals, and the depth of the TIM3 ISR alone. For the latter the
+/// ISR repaints STACK_ISR_WINDOW bytes below itself on entry and scans
+/// them on exit. On the host build everything reads 0.
+///
+class StackMonitor
+{
+public:
+  /// StackMonitor
+  /// @brief Class constructor
+  ///
+  /// @param[in] none
+  ///
+  /// @return none
+  ///
+  StackMonitor();
+
+  /// begin
+  /// @brief Paints the free RAM; call first thing in setup()
+  ///
+  /// @param none
+  ///
+  /// @return none
+  ///
+  void begin();
+
+  /// isrEnter
+  /// @brief Start of the TIM3 ISR: keeps the depth loop() left in the
+  ///        window and repaints it
+  ///
+  /// @param none
+  ///
+  /// @return none
+  ///
+  void isrEnter();
+
+  /// isrExit
+  /// @brief End of the TIM3 ISR: depth reached since isrEnter()
+  ///
+  /// @param none
+  ///
+  /// @return none
+  ///
+  void isrExit();
+
+  /// update
+  /// @brief Scans the painted RAM from the heap up. Takes a few hundred
+  ///        microseconds: call from loop() at the report interval.
+  ///
+  /// @param none
+  ///
+  /// @return none
+  ///
+  void update();
+
+  /// getStackHighWater
+  /// @brief Deepest the main stack has been, in bytes (loop() plus
+  ///        whatever interrupts were nested at that point)
+  uint32_t getStackHighWater() const;
+
+  /// getIsrHighWater
+  /// @brief Deepest the TIM3 ISR has gone below its own frame, in bytes
+  ///        (STACK_ISR_WINDOW when it went past the window)
+  uint32_t getIsrHighWater() const;
+
+  /// getHeapFree
+  /// @brief Bytes malloc could still hand out: freed blocks plus the room
+  ///        left before the lower of the stack reserve and the deepest stack
+  uint32_t getHeapFree() const;
+
+  /// getHeadroom
+  /// @brief Painted bytes never touched, between the heap and the deepest
+  ///        stack
+  uint32_t getHeadroom() const;
+
+private:
+  uint32_t *heapTop() const;
+
+  uint32_t *stackTop;    // _estack
+  uint32_t *lowest;      // Deepest stack word seen written
+  uint32_t *isrTop;      // Window of the current tick
+  uint32_t *isrBottom;
+  uint32_t isrHighWater; // bytes
+  bool isPainted;
+};
+
+extern StackMonitor stackMonitor;
+
+#endif // STACKMONITOR_HPP
@@ -0,0 +1,197 @@
+// Local Includes
+#include "telemetryBlock.hpp"
+#include "crc32.hpp"
+
+#include <string.h>
+
+// Header fields
+static constexpr size_t OFFSET_MAGIC = 0;
+static constexpr size_t OFFSET_SEQUENCE = 4;
+static constexpr size_t OFFSET_BASE = 8;
+static constexpr size_t OFFSET_SENSORS = 12;
+static constexpr size_t OFFSET_ROWS = 13;
+static constexpr size_t OFFSET_CAPACITY = 14;
+static constexpr size_t HEADER_SIZE = 16;
+static constexpr size_t OFFSET_CRC = TELEMETRY_BLOCK_SIZE - 4;
+
+TelemetryBlock::TelemetryBlock()
+{
+  begin(0, 0);
+}
+
+uint8_t TelemetryBlock::capacity(uint8_t sensors)
+{
+  // Header, footer (min/max per sensor + CRC), then delta + values per row
+  return (TELEMETRY_BLOCK_SIZE - HEADER_SIZE - 4 * sensors - 4) / (4 + 2 * sensors);
+}
+
+void TelemetryBlock::begin(uint32_t sequence, uint8_t sensors)
+{
+  if (sensors > TELEMETRY_BLOCK_MAX_SENSORS)
+  {
+    sensors = TELEMETRY_BLOCK_MAX_SENSORS;
+  }
+
+  memset(block, 0, sizeof(block));
+  write32(OFFSET_MAGIC, TELEMETRY_BLOCK_MAGIC);
+  write32(OFFSET_SEQUENCE, sequence);
+  block[OFFSET_SENSORS] = sensors;
+  block[OFFSET_ROWS] = 0;
+  block[OFFSET_CAPACITY] = capacity(sensors);
+  lastTimestamp = 0;
+}
+
+bool TelemetryBlock::append(uint32_t timestamp, const int16_t *values)
+{
+  uint8_t row = block[OFFSET_ROWS];
+  if (row == block[OFFSET_CAPACITY])
+  {
+    return false;
+  }
+
+  if (row == 0)
+  {
+    write32(OFFSET_BASE, timestamp);
+  }
+  write32(HEADER_SIZE + 4 * row, row == 0 ? 0 : timestamp - lastTimestamp);
+  for (uint8_t s = 0; s < sensors(); s++)
+  {
+    write16(valueOffset(s, row), values[s]);
+  }
+
+  lastTimestamp = timestamp;
+  block[OFFSET_ROWS] = row + 1;
+  return true;
+}
+
+void TelemetryBlock::seal()
+{
+  size_t footer = footerOffset();
+  for (uint8_t s = 0; s < sensors(); s++)
+  {
+    int16_t low = TELEMETRY_MISSING;
+    int16_t high = TELEMETRY_MISSING;
+    for (uint8_t row = 0; row < rows(); row++)
+    {
+      int16_t v = value(s, row);
+      if (v == TELEMETRY_MISSING)
+      {
+        continue;
+      }
+      if (low == TELEMETRY_MISSING || v < low)
+      {
+        low = v;
+      }
+      if (high == TELEMETRY_MISSING || v > high)
+      {
+        high = v;
+      }
+    }
+    write16(footer + 2 * s, low);
+    write16(footer + 2 * (sensors() + s), high);
+  }
+  write32(OFFSET_CRC, crc32(block, OFFSET_CRC));
+}
+
+bool TelemetryBlock::load(const uint8_t *sector)
+{
+  memcpy(block, sector, sizeof(block));
+  uint8_t columns = block[OFFSET_SENSORS];
+
+  if (read32(OFFSET_MAGIC) != TELEMETRY_BLOCK_MAGIC || columns > TELEMETRY_BLOCK_MAX_SENSORS ||
+      block[OFFSET_CAPACITY] != capacity(columns) || block[OFFSET_ROWS] > block[OFFSET_CAPACITY] ||
+      read32(OFFSET_CRC) != crc32(block, OFFSET_CRC))
+  {
+    return false;
+  }
+
+  lastTimestamp = rows() > 0 ? timestamp(rows() - 1) : 0;
+  return true;
+}
+
+uint8_t TelemetryBlock::rows() const
+{
+  return block[OFFSET_ROWS];
+}
+
+uint8_t TelemetryBlock::sensors() const
+{
+  return block[OFFSET_SENSORS];
+}
+
+uint32_t TelemetryBlock::sequence() const
+{
+  return read32(OFFSET_SEQUENCE);
+}
+
+bool TelemetryBlock::isFull() const
+{
+  return block[OFFSET_ROWS] == block[OFFSET_CAPACITY];
+}
+
+uint32_t TelemetryBlock::timestamp(uint8_t row) const
+{
+  uint32_t time = read32(OFFSET_BASE);
+  for (uint8_t r = 1; r <= row; r++)
+  {
+    time += read32(HEADER_SIZE + 4 * r);
+  }
+  return time;
+}
+
+int16_t TelemetryBlock::value(uint8_t sensor, uint8_t row) const
+{
+  return read16(valueOffset(sensor, row));
+}
+
+int16_t TelemetryBlock::minimum(uint8_t sensor) const
+{
+  return read16(footerOffset() + 2 * sensor);
+}
+
+int16_t TelemetryBlock::maximum(uint8_t sensor) const
+{
+  return read16(footerOffset() + 2 * (sensors() + sensor));
+}
+
+const uint8_t *TelemetryBlock::data() const
+{
+  return block;
+}
+
+size_t TelemetryBlock::valueOffset(uint8_t sensor, uint8_t row) const
+{
+  uint8_t rowCapacity = block[OFFSET_CAPACITY];
+  return HEADER_SIZE + 4 * rowCapacity + 2 * ((size_t)sensor * rowCapacity + row);
+}
+
+size_t TelemetryBlock::footerOffset() const
+{
+  return OFFSET_CRC - 4 * sensors();
+}
+
+// Explicit little-endian access: same file on the STM32 and on the host
+uint32_t TelemetryBlock::read32(size_t offset) const
+{
+  return (uint32_t)block[offset] | ((uint32_t)block[offset + 1] << 8) | ((uint32_t)block[offset + 2] << 16) |
+         ((uint32_t)block[offset + 3] << 24);
+}
+
+void TelemetryBlock::write32(size_t offset, uint32_t value)
+{
+  block[offset] = value & 0xFF;
+  block[offset + 1] = (value >> 8) & 0xFF;
+  block[offset + 2] = (value >> 16) & 0xFF;
+  block[offset + 3] = value >> 24;
+}
+
+int16_t TelemetryBlock::read16(size_t offset) const
+{
+  return (int16_t)(block[offset] | (block[offset + 1] << 8));
+}
+
+void TelemetryBlock::write16(size_t offset, int16_t value)
+{
+  block[offset] = (uint16_t)value & 0xFF;
+  block[offset + 1] = (uint16_t)value >> 8;
+}
@@ -0,0 +1,113 @@
+#ifndef TELEMETRYBLOCK_HPP
+#define TELEMETRYBLOCK_HPP
+
+// Framework libs
+#include <stddef.h>
+#include <stdint.h>
+
+// One block per SD sector, so every write is a whole sector
+static constexpr size_t TELEMETRY_BLOCK_SIZE = 512;
+static constexpr uint32_t TELEMETRY_BLOCK_MAGIC = 0x32424C54; // "TLB2"
+static constexpr uint8_t TELEMETRY_BLOCK_MAX_SENSORS = 16;
+static constexpr int16_t TELEMETRY_MISSING = INT16_MIN; // Failed reading
+
+/// TelemetryBlock
+/// @brief Columnar 512-byte telemetry block. Rows share a base timestamp
+/// and store 32-bit millisecond deltas, so any sample interval or power
+/// cut fits in the block it falls in; each sensor is a column of
+/// fixed-point values (hundredths). The footer keeps per-sensor min/max and
+/// a CRC32 of the block. Little-endian, no Arduino dependencies, so the
+/// same code writes blocks on the target and decodes them in tools/.
+///
+/// Layout (S sensors, C = capacity(S) rows):
+///   0   magic u32, sequence u32, base timestamp u32,
+///       sensors u8, rows u8, capacity u8, reserved u8
+///   16  delta u32[C]     (ms since the previous row, 0 for the first)
+///   ..  value i16[S][C]  (column per sensor)
+///   ..  min i16[S], max i16[S], crc32 u32 (end of the block)
+///
+class TelemetryBlock
+{
+public:
+  /// TelemetryBlock
+  /// @brief Class constructor, the block starts empty with no sensors
+  ///
+  /// @param[in] none
+  ///
+  /// @return none
+  ///
+  TelemetryBlock();
+
+  /// capacity
+  /// @brief Rows that fit in one block
+  ///
+  /// @param[in] sensors: Number of value columns
+  ///
+  /// @return rows per block
+  ///
+  static uint8_t capacity(uint8_t sensors);
+
+  /// begin
+  /// @brief Clears the block and starts a new one
+  ///
+  /// @param[in] sequence: Block number within the file
+  /// @param[in] sensors: Number of value columns (<= TELEMETRY_BLOCK_MAX_SENSORS)
+  ///
+  /// @return none
+  ///
+  void begin(uint32_t sequence, uint8_t sensors);
+
+  /// append
+  /// @brief Adds one row
+  ///
+  /// @param[in] timestamp: millis() of the row
+  /// @param[in] values: One value per sensor, TELEMETRY_MISSING if failed
+  ///
+  /// @return false if the block is full
+  ///
+  bool append(uint32_t timestamp, const int16_t *values);
+
+  /// seal
+  /// @brief Writes min/max and the CRC, call before the block is stored
+  ///
+  /// @param none
+  ///
+  /// @return none
+  ///
+  void seal();
+
+  /// load
+  /// @brief Takes a stored block and checks magic, layout and CRC
+  ///
+  /// @param[in] sector: TELEMETRY_BLOCK_SIZE bytes
+  ///
+  /// @return true if the block is valid
+  ///
+  bool load(const uint8_t *sector);
+
+  /// Accessors of the current block
+  uint8_t rows() const;
+  uint8_t sensors() const;
+  uint32_t sequence() const;
+  bool isFull() const;
+  uint32_t timestamp(uint8_t row) const;
+  int16_t value(uint8_t sensor, uint8_t row) const;
+  int16_t minimum(uint8_t sensor) const;
+  int16_t maximum(uint8_t sensor) const;
+  const uint8_t *data() const;
+
+private:
+  // Private methods
+  size_t valueOffset(uint8_t sensor, uint8_t row) const;
+  size_t footerOffset() const;
+  uint32_t read32(size_t offset) const;
+  void write32(size_t offset, uint32_t value);
+  int16_t read16(size_t offset) const;
+  void write16(size_t offset, int16_t value);
+
+  // Private attributes
+  uint8_t block[TELEMETRY_BLOCK_SIZE];
+  uint32_t lastTimestamp;
+};
+
+#endif // TELEMETRYBLOCK_HPP
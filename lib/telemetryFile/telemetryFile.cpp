@@ -0,0 +1,220 @@
+// Local Includes
+#include "telemetryFile.hpp"
+#include "set_rtc.hpp"
+
+extern SdFat sd;
+
+TelemetryFile::TelemetryFile()
+{
+  filename[0] = '\0';
+  fileIndex = 0;
+  fileNumber = 0;
+  lastEpoch = 0;
+  blockOffset = 0;
+  sequence = 0;
+  preallocBytes = 0;
+  unsyncedRows = 0;
+  isReady = false;
+}
+
+bool TelemetryFile::init()
+{
+  isReady = false;
+  if (sd.fatType() == 0)
+  {
+    return false; // Card not mounted
+  }
+
+  fileIndex = 0;
+  nextFile();
+
+  // Drop an entry torn by a power loss and resume after the newest one
+  lastEpoch = 0;
+  if (dataFile.open(TELEMETRY_INDEX_FILENAME, O_RDWR | O_CREAT))
+  {
+    uint32_t size = dataFile.fileSize() - dataFile.fileSize() % sizeof(TelemetryIndexEntry);
+    dataFile.truncate(size);
+    TelemetryIndexEntry last;
+    if (size > 0 && dataFile.seekSet(size - sizeof(last)) && dataFile.read(&last, sizeof(last)) == sizeof(last))
+    {
+      lastEpoch = last.epoch;
+    }
+    dataFile.close();
+  }
+
+  isReady = true;
+  return true;
+}
+
+bool TelemetryFile::append(uint32_t timestamp, const float *values)
+{
+  if (!isReady)
+  {
+    return false;
+  }
+
+  int16_t row[NUMBER_OF_SENSORS];
+  for (int i = 0; i < NUMBER_OF_SENSORS; i++)
+  {
+    float scaled = values[i] * 100.0f;
+    row[i] = (isnan(values[i]) || scaled <= INT16_MIN || scaled > INT16_MAX) ? TELEMETRY_MISSING
+                                                                             : (int16_t)lroundf(scaled);
+  }
+
+  bool isWritten = true;
+  if (!block.append(timestamp, row))
+  {
+    // Full: close this block
+    isWritten = writeBlock();
+    nextBlock();
+    block.append(timestamp, row);
+  }
+
+  if (block.rows() == 1)
+  {
+    isWritten &= appendIndex(timestamp); // First row of a new block
+  }
+
+  if (block.isFull())
+  {
+    isWritten &= writeBlock();
+    nextBlock();
+  }
+  else if (++unsyncedRows >= TELEMETRY_SYNC_ROWS)
+  {
+    isWritten &= sync();
+  }
+  return isWritten;
+}
+
+bool TelemetryFile::sync()
+{
+  if (!isReady || block.rows() == 0)
+  {
+    return true;
+  }
+  return writeBlock();
+}
+
+void TelemetryFile::setPreallocation(uint32_t bytes)
+{
+  preallocBytes = bytes;
+}
+
+const char *TelemetryFile::getFilename() const
+{
+  return filename;
+}
+
+bool TelemetryFile::writeBlock()
+{
+  block.seal();
+  unsyncedRows = 0;
+
+  if (!dataFile.open(filename, O_RDWR | O_CREAT))
+  {
+    return false;
+  }
+  if (blockOffset == 0 && preallocBytes > 0 && dataFile.fileSize() == 0)
+  {
+    dataFile.preAllocate(preallocBytes); // Best effort: without it the file grows cluster by cluster
+  }
+
+  // Sector-aligned offset and size: SdFat writes straight to the card,
+  // without a read-modify-write of its cache
+  dataFile.seekSet(blockOffset);
+  bool isWritten = dataFile.write(block.data(), TELEMETRY_BLOCK_SIZE) == TELEMETRY_BLOCK_SIZE;
+  dataFile.close();
+  return isWritten;
+}
+
+bool TelemetryFile::appendIndex(uint32_t timestamp)
+{
+  // A clock set back would break the binary search: keep the epoch monotonic
+  uint32_t epoch = IS_RTC_ENABLED ? get_rtc_epoch() : timestamp / 1000;
+  if (epoch < lastEpoch)
+  {
+    epoch = lastEpoch;
+  }
+  lastEpoch = epoch;
+
+  TelemetryIndexEntry entry;
+  entry.epoch = epoch;
+  entry.timestamp = timestamp;
+  entry.file = fileNumber;
+  entry.block = blockOffset / TELEMETRY_BLOCK_SIZE;
+
+  if (!dataFile.open(TELEMETRY_INDEX_FILENAME, O_RDWR | O_CREAT | O_APPEND))
+  {
+    return false;
+  }
+  bool isWritten = dataFile.write(&entry, sizeof(entry)) == sizeof(entry);
+  dataFile.close();
+  return isWritten;
+}
+
+void TelemetryFile::nextBlock()
+{
+  blockOffset += TELEMETRY_BLOCK_SIZE;
+  sequence++;
+  if (blockOffset + TELEMETRY_BLOCK_SIZE > MAX_FILE_SIZE)
+  {
+    nextFile();
+    return;
+  }
+  block.begin(sequence, NUMBER_OF_SENSORS);
+}
+
+void TelemetryFile::nextFile()
+{
+  do
+  {
+    snprintf(filename, sizeof(filename), "%s%s%d.%s", LOG_PATH, TELEMETRY_FILENAME, fileIndex,
+             TELEMETRY_EXTENSION);
+    fileNumber = fileIndex;
+    fileIndex++;
+  } while (sd.exists(filename));
+
+  blockOffset = 0;
+  sequence = 0;
+  unsyncedRows = 0;
+  block.begin(sequence, NUMBER_OF_SENSORS);
+}
+
+uint32_t SdTelemetryStorage::entries()
+{
+  if (!storageFile.open(TELEMETRY_INDEX_FILENAME, O_RDONLY))
+  {
+    return 0;
+  }
+  uint32_t count = storageFile.fileSize() / sizeof(TelemetryIndexEntry);
+  storageFile.close();
+  return count;
+}
+
+bool SdTelemetryStorage::readEntry(uint32_t position, TelemetryIndexEntry &entry)
+{
+  if (!storageFile.open(TELEMETRY_INDEX_FILENAME, O_RDONLY))
+  {
+    return false;
+  }
+  bool isRead = storageFile.seekSet(position * sizeof(entry)) &&
+                storageFile.read(&entry, sizeof(entry)) == (int)sizeof(entry);
+  storageFile.close();
+  return isRead;
+}
+
+bool SdTelemetryStorage::readBlock(uint16_t file, uint16_t block, uint8_t *sector)
+{
+  char name[30];
+  snprintf(name, sizeof(name), "%s%s%u.%s", LOG_PATH, TELEMETRY_FILENAME, file,
+           TELEMETRY_EXTENSION);
+  if (!storageFile.open(name, O_RDONLY))
+  {
+    return false;
+  }
+  bool isRead = storageFile.seekSet((uint32_t)block * TELEMETRY_BLOCK_SIZE) &&
+                storageFile.read(sector, TELEMETRY_BLOCK_SIZE) == (int)TELEMETRY_BLOCK_SIZE;
+  storageFile.close();
+  return isRead;
+}
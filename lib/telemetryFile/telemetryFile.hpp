@@ -0,0 +1,121 @@
+#ifndef TELEMETRYFILE_HPP
+#define TELEMETRYFILE_HPP
+
+// Framework libs
+#include <SdFat.h>
+
+// Local Includes
+#include <config.hpp>
+#include "telemetryBlock.hpp"
+#include "telemetryIndex.hpp"
+
+/// TelemetryFile
+/// @brief Binary replacement of temperatura<N>.csv. Rows are collected in a
+/// TelemetryBlock and written as whole 512-byte sectors to
+/// telemetria<N>.bin: when the block fills, and in place every
+/// TELEMETRY_SYNC_ROWS rows so a power loss costs at most that many rows.
+/// tools/bin2csv converts the file back to the CSV schema.
+/// Each new block also gets an entry in TELEMETRY_INDEX_FILENAME, used by
+/// TelemetryQuery to seek to a time range.
+///
+class TelemetryFile
+{
+public:
+  /// TelemetryFile
+  /// @brief Class constructor
+  ///
+  /// @param[in] none
+  ///
+  /// @return none
+  ///
+  TelemetryFile();
+
+  /// init
+  /// @brief Picks the first unused telemetria<N>.bin. Must be called after
+  ///        the SD card is mounted.
+  ///
+  /// @param none
+  ///
+  /// @return true if the card is ready
+  ///
+  bool init();
+
+  /// append
+  /// @brief Adds one row with the reading of every sensor
+  ///
+  /// @param[in] timestamp: millis() of the reading
+  /// @param[in] values: NUMBER_OF_SENSORS values (NaN if the read failed)
+  ///
+  /// @return false if the block could not be written
+  ///
+  bool append(uint32_t timestamp, const float *values);
+
+  /// sync
+  /// @brief Writes the current partial block in place
+  ///
+  /// @param none
+  ///
+  /// @return false if the write failed
+  ///
+  bool sync();
+
+  /// setPreallocation
+  /// @brief Allocates each new telemetria<N>.bin as contiguous clusters of
+  ///        this size, so appends never search the FAT. Unwritten blocks
+  ///        fail their CRC and are skipped on read.
+  ///
+  /// @param[in] bytes: Size to preallocate, 0 = none
+  ///
+  /// @return none
+  ///
+  void setPreallocation(uint32_t bytes);
+
+  /// getFilename
+  /// @brief Name of the file being written
+  ///
+  /// @param none
+  ///
+  /// @return file name
+  ///
+  const char *getFilename() const;
+
+private:
+  // Private methods
+  bool writeBlock();
+  bool appendIndex(uint32_t timestamp);
+  void nextBlock();
+  void nextFile();
+
+  // Private attributes
+  SdFile dataFile;
+  TelemetryBlock block;
+  char filename[30];
+  int fileIndex;
+  uint16_t fileNumber;  // N of the file being written
+  uint32_t lastEpoch;   // Epoch of the newest index entry
+  uint32_t blockOffset; // File offset of the block being filled
+  uint32_t sequence;    // Block number within the file
+  uint32_t preallocBytes;
+  uint8_t unsyncedRows;
+  bool isReady;
+};
+
+/// SdTelemetryStorage
+/// @brief TelemetryStorage over the index sidecar and the telemetria<N>.bin
+/// files on the card. Every read opens and closes its file: between two
+/// history steps, TelemetryFile::append() (serviceReadings() in the same
+/// loop()) adds blocks and index entries and may start a new file, and a
+/// handle kept open would still carry the old file size.
+///
+class SdTelemetryStorage : public TelemetryStorage
+{
+public:
+  uint32_t entries() override;
+  bool readEntry(uint32_t position, TelemetryIndexEntry &entry) override;
+  bool readBlock(uint16_t file, uint16_t block, uint8_t *sector) override;
+
+private:
+  SdFile storageFile;
+};
+
+#endif // TELEMETRYFILE_HPP
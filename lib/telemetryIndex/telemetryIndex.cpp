@@ -0,0 +1,147 @@
+// Local Includes
+#include "telemetryIndex.hpp"
+
+TelemetryQuery::TelemetryQuery(TelemetryStorage &storage) : storage(storage)
+{
+  position = 0;
+  entryCount = 0;
+  from = 0;
+  to = 0;
+  reads = 0;
+  sensor = 0;
+  row = 0;
+  column = 0;
+  isLoaded = false;
+  isRunning = false;
+}
+
+bool TelemetryQuery::begin(uint32_t from, uint32_t to, uint8_t sensor)
+{
+  this->from = from;
+  this->to = to;
+  this->sensor = sensor;
+  reads = 0;
+  isLoaded = false;
+  isRunning = false;
+
+  entryCount = storage.entries();
+  if (from > to || entryCount == 0)
+  {
+    return false;
+  }
+
+  // First entry that starts after from; the block before it may still hold
+  // rows of the range
+  uint32_t low = 0;
+  uint32_t high = entryCount;
+  while (low < high)
+  {
+    uint32_t middle = low + (high - low) / 2;
+    TelemetryIndexEntry probe;
+    reads++;
+    if (!storage.readEntry(middle, probe))
+    {
+      return false;
+    }
+    if (probe.epoch <= from)
+    {
+      low = middle + 1;
+    }
+    else
+    {
+      high = middle;
+    }
+  }
+
+  position = low > 0 ? low - 1 : 0;
+  isRunning = true;
+  return true;
+}
+
+bool TelemetryQuery::next(TelemetrySample &sample)
+{
+  while (isRunning)
+  {
+    if (!isLoaded && !loadBlock())
+    {
+      continue; // Skipped a bad block, or the query ended
+    }
+
+    if (row >= block.rows())
+    {
+      isLoaded = false;
+      position++;
+      continue;
+    }
+
+    // Rows keep millisecond deltas from the entry's base timestamp
+    uint32_t epoch = entry.epoch + (block.timestamp(row) - entry.timestamp) / 1000;
+    if (epoch > to)
+    {
+      isRunning = false;
+      break;
+    }
+
+    uint8_t s = sensor > 0 ? sensor - 1 : column;
+    int16_t value = block.value(s, row);
+    if (sensor > 0 || ++column >= block.sensors())
+    {
+      column = 0;
+      row++;
+    }
+
+    if (epoch >= from && value != TELEMETRY_MISSING)
+    {
+      sample.epoch = epoch;
+      sample.sensor = s + 1;
+      sample.value = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool TelemetryQuery::isActive() const
+{
+  return isRunning;
+}
+
+uint32_t TelemetryQuery::getReads() const
+{
+  return reads;
+}
+
+bool TelemetryQuery::loadBlock()
+{
+  if (position >= entryCount)
+  {
+    isRunning = false;
+    return false;
+  }
+
+  reads++;
+  if (!storage.readEntry(position, entry))
+  {
+    isRunning = false;
+    return false;
+  }
+  if (entry.epoch > to)
+  {
+    isRunning = false;
+    return false;
+  }
+
+  // Written before its first sync, or the file was replaced: skip it
+  reads++;
+  if (!storage.readBlock(entry.file, entry.block, sector) || !block.load(sector) || block.rows() == 0 ||
+      block.timestamp(0) != entry.timestamp || (sensor > 0 && sensor > block.sensors()))
+  {
+    position++;
+    return false;
+  }
+
+  row = 0;
+  column = 0;
+  isLoaded = true;
+  return true;
+}
@@ -0,0 +1,127 @@
+#ifndef TELEMETRYINDEX_HPP
+#define TELEMETRYINDEX_HPP
+
+// Framework libs
+#include <stddef.h>
+#include <stdint.h>
+
+// Local Includes
+#include "telemetryBlock.hpp"
+
+/// TelemetryIndexEntry
+/// @brief One entry of the index sidecar per telemetry block, appended when
+///        the block gets its first row. Entries are in append order and the
+///        epoch never decreases, so the file can be binary searched.
+///        Little-endian, as both the STM32 and the host are.
+///
+struct TelemetryIndexEntry
+{
+  uint32_t epoch;     // RTC time of the first row (s), clamped to be monotonic
+  uint32_t timestamp; // millis() of the same row, the block's base timestamp
+  uint16_t file;      // N of telemetria<N>.bin
+  uint16_t block;     // Block number, file offset / TELEMETRY_BLOCK_SIZE
+};
+
+static_assert(sizeof(TelemetryIndexEntry) == 12, "TelemetryIndexEntry must stay 12 bytes on disk");
+
+/// TelemetrySample
+/// @brief One value returned by a query
+///
+struct TelemetrySample
+{
+  uint32_t epoch; // s
+  uint8_t sensor; // 1..sensors
+  int16_t value;  // Hundredths
+};
+
+/// TelemetryStorage
+/// @brief Access to the index and to the blocks, implemented over SdFat on
+/// the target and over plain files or memory on the host
+///
+class TelemetryStorage
+{
+public:
+  virtual ~TelemetryStorage() {}
+
+  /// entries
+  /// @brief Number of entries in the index
+  virtual uint32_t entries() = 0;
+
+  /// readEntry
+  /// @brief Reads entry number position of the index
+  virtual bool readEntry(uint32_t position, TelemetryIndexEntry &entry) = 0;
+
+  /// readBlock
+  /// @brief Reads one TELEMETRY_BLOCK_SIZE block of telemetria<file>.bin
+  virtual bool readBlock(uint16_t file, uint16_t block, uint8_t *sector) = 0;
+};
+
+/// TelemetryQuery
+/// @brief Streams the samples of a time range. begin() binary searches the
+/// index (O(log n) entry reads) and next() walks forward from there, so a
+/// query costs O(log n + k) reads for k matching samples instead of a scan
+/// of every file. Blocks that fail their CRC, or that no longer match their
+/// entry, are skipped. No Arduino dependencies.
+///
+class TelemetryQuery
+{
+public:
+  /// TelemetryQuery
+  /// @brief Class constructor
+  ///
+  /// @param[in] storage: Index and blocks to query
+  ///
+  /// @return none
+  ///
+  explicit TelemetryQuery(TelemetryStorage &storage);
+
+  /// begin
+  /// @brief Starts a query, replacing any query in progress
+  ///
+  /// @param[in] from: First epoch included (s)
+  /// @param[in] to: Last epoch included (s)
+  /// @param[in] sensor: 1..sensors, 0 for all
+  ///
+  /// @return false if the range is empty or the index cannot be read
+  ///
+  bool begin(uint32_t from, uint32_t to, uint8_t sensor);
+
+  /// next
+  /// @brief Next sample of the range, in time order
+  ///
+  /// @param[out] sample: Sample found
+  ///
+  /// @return false when the range is exhausted
+  ///
+  bool next(TelemetrySample &sample);
+
+  /// isActive
+  /// @brief A query was started and has samples left to check
+  bool isActive() const;
+
+  /// getReads
+  /// @brief Entry and block reads since begin(), to check the query cost
+  uint32_t getReads() const;
+
+private:
+  // Private methods
+  bool loadBlock();
+
+  // Private attributes
+  TelemetryStorage &storage;
+  TelemetryBlock block;
+  uint8_t sector[TELEMETRY_BLOCK_SIZE];
+  TelemetryIndexEntry entry;
+  uint32_t position; // Index entry of the current block
+  uint32_t entryCount;
+  uint32_t from;
+  uint32_t to;
+  uint32_t reads;
+  uint8_t sensor;
+  uint8_t row;
+  uint8_t column;
+  bool isLoaded;
+  bool isRunning;
+};
+
+#endif // TELEMETRYINDEX_HPP
@@ -0,0 +1,25 @@
+#ifndef NATIVE_ADAFRUIT_SENSOR_H
+#define NATIVE_ADAFRUIT_SENSOR_H
+
+#include <stdint.h>
+
+/// Host version of the Adafruit unified sensor event (fields the firmware reads)
+typedef struct
+{
+  int32_t version;
+  int32_t sensor_id;
+  int32_t type;
+  int32_t reserved0;
+  int32_t timestamp;
+  union
+  {
+    float data[4];
+    float temperature;
+    float relative_humidity;
+  };
+} sensors_event_t;
+
+#define SENSOR_TYPE_AMBIENT_TEMPERATURE 13
+#define SENSOR_TYPE_RELATIVE_HUMIDITY 12
+
+#endif // NATIVE_ADAFRUIT_SENSOR_H
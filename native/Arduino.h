@@ -0,0 +1,111 @@
+#ifndef NATIVE_ARDUINO_H
+#define NATIVE_ARDUINO_H
+
+// Host (Linux) subset of the Arduino core: enough for the network layer
+// and PubSubClient, and with the fakes of this directory for the whole
+// firmware (env:native) to build and run as a normal process
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <math.h>
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 0x1
+#define LOW 0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+#define INPUT_PULLDOWN 0x3
+
+#define CHANGE 2
+#define FALLING 3
+#define RISING 4
+
+// STM32 pin names (include/config.hpp), numbered like the Nucleo variant
+enum
+{
+  PA0, PA1, PA2, PA3, PA4, PA5, PA6, PA7, PA8, PA9, PA10, PA11, PA12, PA13, PA14, PA15,
+  PB0, PB1, PB2, PB3, PB4, PB5, PB6, PB7, PB8, PB9, PB10, PB11, PB12, PB13, PB14, PB15,
+  PC0, PC1, PC2, PC3, PC4, PC5, PC6, PC7, PC8, PC9, PC10, PC11, PC12, PC13, PC14, PC15,
+};
+
+#define LED_BUILTIN PA5
+#define USER_BTN PC13
+#define NUM_DIGITAL_PINS (PC15 + 1)
+
+#define HEX 16
+#define DEC 10
+
+// AVR compatibility used by PubSubClient's *_P methods
+#define PROGMEM
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_byte_near(addr) pgm_read_byte(addr)
+#define strlen_P strlen
+#define memcpy_P memcpy
+
+#ifdef __cplusplus
+#include <algorithm>
+using std::min;
+using std::max;
+#endif
+
+uint32_t millis();
+uint32_t micros();
+uint64_t hostMicros(); // micros() without the 32-bit wrap, for the fakes
+void delay(uint32_t ms);
+void delayMicroseconds(uint32_t us);
+void yield();
+
+long random(long howbig);
+long random(long howsmall, long howbig);
+void randomSeed(unsigned long seed);
+
+void pinMode(uint32_t pin, uint32_t mode);
+void digitalWrite(uint32_t pin, uint32_t value);
+int digitalRead(uint32_t pin);
+
+// External (EXTI) edge interrupts: the pin number is the interrupt number
+#define digitalPinToInterrupt(pin) (pin)
+void attachInterrupt(uint32_t pin, void (*callback)(), uint32_t mode);
+void detachInterrupt(uint32_t pin);
+// Host side of an input pin (a button of the simulation): sets the level
+// and makes the attached edge interrupt pending if the edge matches
+void setPinInput(uint32_t pin, uint32_t level);
+
+// Interrupts of the host build run on the main thread: sources registered
+// here (HardwareTimer) are polled between loop() passes, in
+// delay() and when interrupts() unmasks them, never in the middle of code
+// that runs with them masked
+void noInterrupts();
+void interrupts();
+void serviceInterrupts();
+void addInterruptSource(void (*poll)());
+bool isInterruptContext();
+
+// Virtual time (simulation of env:native): the clock stops following the
+// host and only moves when the code waits (delay(), delayMicroseconds(),
+// the latency of the fakes) or when advanceVirtualTime() jumps it to the
+// next event. Each clock read also costs VIRTUAL_READ_US, so loops that
+// poll millis() until a timeout still end.
+static constexpr uint32_t VIRTUAL_READ_US = 1;
+void setVirtualTime(bool isEnabled);
+bool isVirtualTime();
+void advanceVirtualTime(uint64_t us);
+
+char *itoa(int value, char *str, int base);
+char *utoa(unsigned value, char *str, int base);
+char *ltoa(long value, char *str, int base);
+char *dtostrf(double value, signed char width, unsigned char decimals, char *str);
+
+#include "Print.h"
+#include "Stream.h"
+#include "HardwareSerial.h"
+#include "HardwareTimer.h"
+
+#endif // NATIVE_ARDUINO_H
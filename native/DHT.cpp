@@ -0,0 +1,119 @@
+#include "DHT.h"
+
+#include <vector>
+
+struct ScriptPoint
+{
+  uint32_t ms;
+  float temperature;
+  float humidity;
+};
+
+static std::vector<ScriptPoint> script = {{0, 21.5f, 50.0f}};
+static uint32_t readUs = 23000;       // ~18 ms start pulse + ~5 ms of bits
+static uint32_t minIntervalMs = 2000; // DHT11: one conversion every 2 s
+static uint32_t lastReadMs = 0;
+static bool hasRead = false;
+static float lastTemperature = NAN;
+static float lastHumidity = NAN;
+static uint32_t reads = 0;
+
+bool FakeDht::loadScript(const char *path)
+{
+  FILE *file = fopen(path, "r");
+  if (!file)
+  {
+    return false;
+  }
+  std::vector<ScriptPoint> points;
+  char line[128];
+  bool isValid = true;
+  while (fgets(line, sizeof(line), file))
+  {
+    char *text = line + strspn(line, " \t");
+    if (*text == '#' || *text == '\n' || *text == '\0')
+    {
+      continue;
+    }
+    unsigned long ms;
+    char temperature[16];
+    char humidity[16];
+    if (sscanf(text, "%lu %15s %15s", &ms, temperature, humidity) != 3 || (!points.empty() && ms < points.back().ms))
+    {
+      isValid = false;
+      break;
+    }
+    points.push_back({(uint32_t)ms, strtof(temperature, nullptr), strtof(humidity, nullptr)});
+  }
+  fclose(file);
+  if (!isValid || points.empty())
+  {
+    return false;
+  }
+  script = points;
+  hasRead = false;
+  return true;
+}
+
+void FakeDht::set(float temperature, float humidity)
+{
+  script = {{0, temperature, humidity}};
+  hasRead = false;
+}
+
+void FakeDht::setTiming(uint32_t newReadUs, uint32_t newMinIntervalMs)
+{
+  readUs = newReadUs;
+  minIntervalMs = newMinIntervalMs;
+}
+
+static float interpolate(float from, float to, uint32_t fromMs, uint32_t toMs, uint32_t now)
+{
+  if (isnan(from) || isnan(to) || toMs == fromMs)
+  {
+    return from;
+  }
+  return from + (to - from) * (float)(now - fromMs) / (float)(toMs - fromMs);
+}
+
+void FakeDht::read(float &temperature, float &humidity)
+{
+  uint32_t now = millis();
+  if (hasRead && now - lastReadMs < minIntervalMs)
+  {
+    temperature = lastTemperature;
+    humidity = lastHumidity;
+    return;
+  }
+
+  delayMicroseconds(readUs); // Interrupts are masked during the read on the board
+  reads++;
+  hasRead = true;
+  lastReadMs = now;
+
+  size_t next = 0;
+  while (next < script.size() && script[next].ms <= now)
+  {
+    next++;
+  }
+  if (next == 0 || next == script.size())
+  {
+    const ScriptPoint &point = script[next == 0 ? 0 : script.size() - 1];
+    lastTemperature = point.temperature;
+    lastHumidity = point.humidity;
+  }
+  else
+  {
+    const ScriptPoint &from = script[next - 1];
+    const ScriptPoint &to = script[next];
+    lastTemperature = interpolate(from.temperature, to.temperature, from.ms, to.ms, now);
+    lastHumidity = interpolate(from.humidity, to.humidity, from.ms, to.ms, now);
+  }
+  temperature = lastTemperature;
+  humidity = lastHumidity;
+}
+
+uint32_t FakeDht::getReads()
+{
+  return reads;
+}
@@ -0,0 +1,32 @@
+#ifndef NATIVE_DHT_H
+#define NATIVE_DHT_H
+
+#include "Arduino.h"
+
+#define DHT11 11
+#define DHT12 12
+#define DHT21 21
+#define DHT22 22
+
+/// FakeDht
+/// @brief Scripted DHT sensor. Values come from set() or from a script of
+/// "<ms> <°C> <%RH>" lines (ms since boot, '#' comments): readings between
+/// two lines are interpolated, and "nan" fails the reads until the next
+/// line. Like the Adafruit driver, a read within minIntervalMs of the last
+/// one returns the cached values; a real read costs readUs of busy time
+/// (start pulse and bit stream of the DHT11).
+///
+class FakeDht
+{
+public:
+  static bool loadScript(const char *path);
+  static void set(float temperature, float humidity);
+  static void setTiming(uint32_t readUs, uint32_t minIntervalMs);
+
+  /// Called by DHT_Unified: values at millis(), charging the read time
+  static void read(float &temperature, float &humidity);
+
+  static uint32_t getReads();
+};
+
+#endif // NATIVE_DHT_H
@@ -0,0 +1,73 @@
+#ifndef NATIVE_DHT_U_H
+#define NATIVE_DHT_U_H
+
+#include "Adafruit_Sensor.h"
+#include "DHT.h"
+
+/// DHT_Unified
+/// @brief Host version of the Adafruit unified DHT driver, over FakeDht
+///
+class DHT_Unified
+{
+public:
+  DHT_Unified(uint8_t pin, uint8_t type, uint8_t count = 6, int32_t tempSensorId = -1, int32_t humiditySensorId = -1)
+      : pin(pin), type(type), temperatureSensor(this), humiditySensor(this)
+  {
+    (void)count;
+    (void)tempSensorId;
+    (void)humiditySensorId;
+  }
+
+  void begin() { pinMode(pin, INPUT_PULLUP); }
+
+  class Temperature
+  {
+  public:
+    Temperature(DHT_Unified *parent) : parent(parent) {}
+    bool getEvent(sensors_event_t *event) { return parent->fill(event, SENSOR_TYPE_AMBIENT_TEMPERATURE); }
+
+  private:
+    DHT_Unified *parent;
+  };
+
+  class Humidity
+  {
+  public:
+    Humidity(DHT_Unified *parent) : parent(parent) {}
+    bool getEvent(sensors_event_t *event) { return parent->fill(event, SENSOR_TYPE_RELATIVE_HUMIDITY); }
+
+  private:
+    DHT_Unified *parent;
+  };
+
+  Temperature temperature() { return temperatureSensor; }
+  Humidity humidity() { return humiditySensor; }
+
+private:
+  bool fill(sensors_event_t *event, int32_t sensorType)
+  {
+    float temperature;
+    float humidity;
+    FakeDht::read(temperature, humidity);
+    memset(event, 0, sizeof(*event));
+    event->version = sizeof(sensors_event_t);
+    event->type = sensorType;
+    event->timestamp = (int32_t)millis();
+    if (sensorType == SENSOR_TYPE_AMBIENT_TEMPERATURE)
+    {
+      event->temperature = temperature;
+    }
+    else
+    {
+      event->relative_humidity = humidity;
+    }
+    return true;
+  }
+
+  uint8_t pin;
+  uint8_t type;
+  Temperature temperatureSensor;
+  Humidity humiditySensor;
+};
+
+#endif // NATIVE_DHT_U_H
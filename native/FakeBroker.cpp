@@ -0,0 +1,347 @@
+#include "Arduino.h"
+#include "FakeBroker.h"
+
+enum ParseState : uint8_t
+{
+  PARSE_HEADER,
+  PARSE_LENGTH,
+  PARSE_BODY
+};
+
+static constexpr uint8_t MQTT_CONNECT = 0x10;
+static constexpr uint8_t MQTT_CONNACK = 0x20;
+static constexpr uint8_t MQTT_PUBLISH = 0x30;
+static constexpr uint8_t MQTT_PUBACK = 0x40;
+static constexpr uint8_t MQTT_SUBSCRIBE = 0x80;
+static constexpr uint8_t MQTT_SUBACK = 0x90;
+static constexpr uint8_t MQTT_UNSUBSCRIBE = 0xA0;
+static constexpr uint8_t MQTT_UNSUBACK = 0xB0;
+static constexpr uint8_t MQTT_PINGREQ = 0xC0;
+static constexpr uint8_t MQTT_PINGRESP = 0xD0;
+static constexpr uint8_t MQTT_DISCONNECT = 0xE0;
+
+static uint16_t readUInt16(const std::string &body, size_t position)
+{
+  return position + 1 < body.size() ? (uint16_t)((uint8_t)body[position] << 8 | (uint8_t)body[position + 1]) : 0;
+}
+
+static std::string readString(const std::string &body, size_t &position)
+{
+  uint16_t length = readUInt16(body, position);
+  position += 2;
+  std::string text = body.substr(std::min(position, body.size()), length);
+  position += length;
+  return text;
+}
+
+static std::string uint16Bytes(uint16_t value)
+{
+  return std::string{(char)(value >> 8), (char)(value & 0xFF)};
+}
+
+FakeBroker::FakeBroker()
+    : isAvailable(true), isAckEnabled(true), isEcho(false), isOpen(false), isSession(false), outputStart(0),
+      header(0), remaining(0), lengthShift(0), parseState(PARSE_HEADER), stats()
+{
+}
+
+void FakeBroker::setAvailable(bool available)
+{
+  isAvailable = available;
+  if (!available && isOpen)
+  {
+    stats.drops++;
+    stop();
+  }
+}
+
+void FakeBroker::setAckEnabled(bool isEnabled)
+{
+  isAckEnabled = isEnabled;
+}
+
+void FakeBroker::setEcho(bool isEnabled)
+{
+  isEcho = isEnabled;
+}
+
+bool FakeBroker::deliver(const char *topic, const char *payload)
+{
+  if (!isSession || !isSubscribed(topic))
+  {
+    return false;
+  }
+  std::string name = topic;
+  reply(MQTT_PUBLISH, uint16Bytes((uint16_t)name.size()) + name + payload);
+  return true;
+}
+
+const std::vector<FakeBrokerMessage> &FakeBroker::getMessages() const
+{
+  return messages;
+}
+
+void FakeBroker::clearMessages()
+{
+  messages.clear();
+}
+
+const FakeBrokerStats &FakeBroker::getStats() const
+{
+  return stats;
+}
+
+int FakeBroker::connect(IPAddress ip, uint16_t port)
+{
+  (void)ip;
+  (void)port;
+  if (!isAvailable)
+  {
+    return 0; // TCP refused
+  }
+  stop();
+  isOpen = true;
+  return 1;
+}
+
+int FakeBroker::connect(const char *host, uint16_t port)
+{
+  (void)host;
+  return connect(IPAddress(), port);
+}
+
+size_t FakeBroker::write(uint8_t b)
+{
+  return write(&b, 1);
+}
+
+size_t FakeBroker::write(const uint8_t *buffer, size_t size)
+{
+  if (!isOpen)
+  {
+    return 0;
+  }
+  stats.bytesIn += size;
+  for (size_t i = 0; i < size && isOpen; i++)
+  {
+    input(buffer[i]);
+  }
+  return size;
+}
+
+int FakeBroker::available()
+{
+  return (int)(output.size() - outputStart);
+}
+
+int FakeBroker::read()
+{
+  if (outputStart >= output.size())
+  {
+    return -1;
+  }
+  uint8_t b = (uint8_t)output[outputStart++];
+  if (outputStart == output.size())
+  {
+    output.clear();
+    outputStart = 0;
+  }
+  return b;
+}
+
+int FakeBroker::read(uint8_t *buffer, size_t size)
+{
+  size_t count = 0;
+  while (count < size && available() > 0)
+  {
+    buffer[count++] = (uint8_t)read();
+  }
+  return count > 0 ? (int)count : -1;
+}
+
+int FakeBroker::peek()
+{
+  return outputStart < output.size() ? (uint8_t)output[outputStart] : -1;
+}
+
+void FakeBroker::flush()
+{
+}
+
+void FakeBroker::stop()
+{
+  isOpen = false;
+  isSession = false;
+  output.clear();
+  outputStart = 0;
+  parseState = PARSE_HEADER;
+  subscriptions.clear(); // Clean session
+}
+
+uint8_t FakeBroker::connected()
+{
+  // Like a socket: still "connected" while unread bytes remain
+  return isOpen || available() > 0;
+}
+
+FakeBroker::operator bool()
+{
+  return isOpen;
+}
+
+void FakeBroker::input(uint8_t b)
+{
+  switch (parseState)
+  {
+  case PARSE_HEADER:
+    header = b;
+    remaining = 0;
+    lengthShift = 0;
+    body.clear();
+    parseState = PARSE_LENGTH;
+    break;
+
+  case PARSE_LENGTH:
+    remaining |= (uint32_t)(b & 0x7F) << lengthShift;
+    lengthShift += 7;
+    if (!(b & 0x80))
+    {
+      parseState = PARSE_BODY;
+      if (remaining == 0)
+      {
+        parseState = PARSE_HEADER;
+        packet(header, body);
+      }
+    }
+    break;
+
+  default:
+    body += (char)b;
+    if (--remaining == 0)
+    {
+      parseState = PARSE_HEADER;
+      packet(header, body);
+    }
+    break;
+  }
+}
+
+void FakeBroker::packet(uint8_t fixedHeader, const std::string &data)
+{
+  uint8_t type = fixedHeader & 0xF0;
+  if (!isSession && type != MQTT_CONNECT)
+  {
+    stop(); // Protocol violation: the broker closes the connection
+    return;
+  }
+
+  switch (type)
+  {
+  case MQTT_CONNECT:
+    if (!isAvailable)
+    {
+      stats.refused++;
+      reply(MQTT_CONNACK, std::string{0, 3}); // Server unavailable
+      break;
+    }
+    stats.connects++;
+    isSession = true;
+    reply(MQTT_CONNACK, std::string{0, 0});
+    break;
+
+  case MQTT_PUBLISH:
+  {
+    size_t position = 0;
+    FakeBrokerMessage message;
+    message.ms = millis();
+    message.topic = readString(data, position);
+    message.qos = (fixedHeader >> 1) & 0x03;
+    message.isRetained = fixedHeader & 0x01;
+    message.isDuplicate = fixedHeader & 0x08;
+    uint16_t packetId = 0;
+    if (message.qos > 0)
+    {
+      packetId = readUInt16(data, position);
+      position += 2;
+    }
+    message.payload = data.substr(std::min(position, data.size()));
+    stats.publishes++;
+    stats.duplicates += message.isDuplicate ? 1 : 0;
+    if (isEcho)
+    {
+      ::printf("[broker] %s %s\n", message.topic.c_str(), message.payload.c_str());
+    }
+    messages.push_back(message);
+    if (message.qos == 1 && isAckEnabled)
+    {
+      stats.pubacks++;
+      reply(MQTT_PUBACK, uint16Bytes(packetId));
+    }
+    break;
+  }
+
+  case MQTT_SUBSCRIBE:
+  {
+    size_t position = 2;
+    std::string granted;
+    while (position < data.size())
+    {
+      std::string filter = readString(data, position);
+      position++; // Requested QoS
+      if (!isSubscribed(filter))
+      {
+        subscriptions.push_back(filter);
+      }
+      stats.subscribes++;
+      granted += (char)0;
+    }
+    reply(MQTT_SUBACK, data.substr(0, 2) + granted);
+    break;
+  }
+
+  case MQTT_UNSUBSCRIBE:
+    reply(MQTT_UNSUBACK, data.substr(0, 2));
+    break;
+
+  case MQTT_PINGREQ:
+    stats.pings++;
+    reply(MQTT_PINGRESP, "");
+    break;
+
+  case MQTT_DISCONNECT:
+    stop();
+    break;
+
+  default:
+    break; // PUBACK of a QoS1 delivery: never sent, deliver() uses QoS0
+  }
+}
+
+void FakeBroker::reply(uint8_t fixedHeader, const std::string &data)
+{
+  std::string packetBytes(1, (char)fixedHeader);
+  uint32_t length = data.size();
+  do
+  {
+    uint8_t digit = length & 0x7F;
+    length >>= 7;
+    packetBytes += (char)(length ? digit | 0x80 : digit);
+  } while (length);
+  packetBytes += data;
+  output += packetBytes;
+  stats.bytesOut += packetBytes.size();
+}
+
+bool FakeBroker::isSubscribed(const std::string &topic) const
+{
+  for (const std::string &filter : subscriptions)
+  {
+    if (filter == topic || filter == "#" ||
+        (filter.size() >= 2 && filter.compare(filter.size() - 2, 2, "/#") == 0 &&
+         topic.compare(0, filter.size() - 1, filter, 0, filter.size() - 1) == 0))
+    {
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,106 @@
+#ifndef NATIVE_FAKEBROKER_H
+#define NATIVE_FAKEBROKER_H
+
+#include <string>
+#include <vector>
+
+#include "Client.h"
+
+/// Message received by the fake broker
+struct FakeBrokerMessage
+{
+  uint32_t ms; // millis() when it arrived
+  std::string topic;
+  std::string payload;
+  uint8_t qos;
+  bool isRetained;
+  bool isDuplicate;
+};
+
+/// Packets seen by the fake broker
+struct FakeBrokerStats
+{
+  uint32_t connects;
+  uint32_t refused;      // CONNECT while unavailable
+  uint32_t publishes;    // PUBLISH packets, duplicates included
+  uint32_t duplicates;   // PUBLISH with the DUP flag
+  uint32_t pubacks;      // PUBACKs sent
+  uint32_t subscribes;   // Topic filters subscribed
+  uint32_t pings;
+  uint32_t drops;        // Sessions closed by setAvailable(false)
+  uint64_t bytesIn;
+  uint64_t bytesOut;
+};
+
+/// FakeBroker
+/// @brief In-process MQTT 3.1.1 broker on the other end of a Client: the
+/// endpoint WiFiClient connects to on the host build. Answers CONNECT,
+/// SUBSCRIBE, UNSUBSCRIBE, PINGREQ and QoS1 PUBLISH like a broker would,
+/// records every message, and delivers messages given to deliver() to the
+/// matching subscriptions. One session at a time.
+///
+class FakeBroker : public Client
+{
+public:
+  FakeBroker();
+
+  /// setAvailable
+  /// @brief false refuses CONNECT and closes the current session
+  void setAvailable(bool isAvailable);
+
+  /// setAckEnabled
+  /// @brief false stops PUBACKs (QoS1 messages stay unacknowledged)
+  void setAckEnabled(bool isEnabled);
+
+  /// setEcho
+  /// @brief Prints each received message on stdout
+  void setEcho(bool isEnabled);
+
+  /// deliver
+  /// @brief PUBLISH (QoS0) to the client if a subscription matches
+  /// @return true if it was sent
+  bool deliver(const char *topic, const char *payload);
+
+  const std::vector<FakeBrokerMessage> &getMessages() const;
+  void clearMessages();
+  const FakeBrokerStats &getStats() const;
+
+  // Client, seen from the firmware
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char *host, uint16_t port) override;
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t *buffer, size_t size) override;
+  int peek() override;
+  void flush() override;
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override;
+  using Print::write;
+
+private:
+  void input(uint8_t b);
+  void packet(uint8_t header, const std::string &body);
+  void reply(uint8_t header, const std::string &body);
+  bool isSubscribed(const std::string &topic) const;
+
+  bool isAvailable;
+  bool isAckEnabled;
+  bool isEcho;
+  bool isOpen;
+  bool isSession;          // CONNECT accepted
+  std::string output;      // Bytes for the client
+  size_t outputStart;
+  uint8_t header;          // Fixed header of the packet being received
+  uint32_t remaining;      // Body bytes still to come
+  uint8_t lengthShift;     // Position in the remaining-length varint
+  uint8_t parseState;
+  std::string body;
+  std::vector<std::string> subscriptions;
+  std::vector<FakeBrokerMessage> messages;
+  FakeBrokerStats stats;
+};
+
+#endif // NATIVE_FAKEBROKER_H
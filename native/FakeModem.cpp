@@ -0,0 +1,443 @@
+#include "FakeModem.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <algorithm>
+
+static std::string unescape(const std::string &text)
+{
+  std::string out;
+  for (size_t i = 0; i < text.size(); i++)
+  {
+    if (text[i] != '\\' || i + 1 == text.size())
+    {
+      out += text[i];
+      continue;
+    }
+    char c = text[++i];
+    out += c == 'r' ? '\r' : c == 'n' ? '\n' : c;
+  }
+  return out;
+}
+
+static bool startsWith(const std::string &text, const char *prefix)
+{
+  return text.compare(0, strlen(prefix), prefix) == 0;
+}
+
+// Parameters after '=', quotes removed and ESP-AT backslash escapes undone
+static std::vector<std::string> parameters(const std::string &command)
+{
+  std::vector<std::string> params;
+  size_t equals = command.find('=');
+  if (equals == std::string::npos)
+  {
+    return params;
+  }
+
+  std::string current;
+  bool isQuoted = false;
+  for (size_t i = equals + 1; i < command.size(); i++)
+  {
+    char c = command[i];
+    if (c == '\\' && i + 1 < command.size())
+    {
+      current += command[++i];
+    }
+    else if (c == '"')
+    {
+      isQuoted = !isQuoted;
+    }
+    else if (c == ',' && !isQuoted)
+    {
+      params.push_back(current);
+      current.clear();
+    }
+    else
+    {
+      current += c;
+    }
+  }
+  params.push_back(current);
+  return params;
+}
+
+FakeModem::FakeModem()
+{
+  outputStart = 0;
+  rawTarget = RAW_NONE;
+  rawRemaining = 0;
+  isLinkOpen = false;
+  isMqttConnected = false;
+  memset(&stats, 0, sizeof(stats));
+}
+
+bool FakeModem::loadScript(const char *path)
+{
+  FILE *file = fopen(path, "r");
+  if (!file)
+  {
+    return false;
+  }
+
+  char buffer[512];
+  bool isValid = true;
+  while (fgets(buffer, sizeof(buffer), file))
+  {
+    std::string line(buffer);
+    while (!line.empty() && (line.back() == '\n' || line.back() == '\r'))
+    {
+      line.pop_back();
+    }
+    if (line.empty() || line[0] == '#')
+    {
+      continue;
+    }
+
+    if (line[0] == '@')
+    {
+      size_t space = line.find(' ');
+      if (space == std::string::npos)
+      {
+        isValid = false;
+        continue;
+      }
+      injectAfter((uint32_t)strtoul(line.c_str() + 1, nullptr, 10), unescape(line.substr(space + 1)).c_str());
+      continue;
+    }
+
+    size_t arrow = line.find(" => ");
+    if (arrow == std::string::npos)
+    {
+      isValid = false;
+      continue;
+    }
+    rules.push_back({line.substr(0, arrow), unescape(line.substr(arrow + 4))});
+  }
+  fclose(file);
+  return isValid;
+}
+
+void FakeModem::addRule(const char *prefix, const char *reply)
+{
+  rules.push_back({prefix, reply});
+}
+
+void FakeModem::inject(const char *text)
+{
+  reply(text);
+}
+
+void FakeModem::injectAfter(uint32_t command, const char *text)
+{
+  urcs.push_back({command, text});
+}
+
+void FakeModem::deliver(const char *topic, const char *payload)
+{
+  std::string text(payload);
+  if (isMqttConnected)
+  {
+    reply(std::string("+MQTTSUBRECV:0,\"") + topic + "\"," + std::to_string(text.size()) + "," + text + "\r\n");
+  }
+  else if (isLinkOpen)
+  {
+    linkOutput(publishPacket(topic, text));
+  }
+}
+
+const FakeModemStats &FakeModem::getStats() const
+{
+  return stats;
+}
+
+size_t FakeModem::write(uint8_t b)
+{
+  stats.hostToModem++;
+
+  if (rawTarget != RAW_NONE)
+  {
+    raw += (char)b;
+    if (--rawRemaining == 0)
+    {
+      onRawData();
+    }
+    return 1;
+  }
+
+  command += (char)b;
+  if (command.size() >= 2 && command.compare(command.size() - 2, 2, "\r\n") == 0)
+  {
+    command.resize(command.size() - 2);
+    if (!command.empty())
+    {
+      stats.commands++;
+      onCommand(command);
+      for (const TimedUrc &urc : urcs)
+      {
+        if (urc.command == stats.commands)
+        {
+          reply(urc.text);
+        }
+      }
+    }
+    command.clear();
+  }
+  return 1;
+}
+
+int FakeModem::available()
+{
+  return (int)(output.size() - outputStart);
+}
+
+int FakeModem::read()
+{
+  if (outputStart == output.size())
+  {
+    return -1;
+  }
+  stats.modemToHost++;
+  uint8_t b = (uint8_t)output[outputStart++];
+  if (outputStart == output.size())
+  {
+    output.clear();
+    outputStart = 0;
+  }
+  return b;
+}
+
+int FakeModem::peek()
+{
+  return outputStart == output.size() ? -1 : (uint8_t)output[outputStart];
+}
+
+void FakeModem::onCommand(const std::string &command)
+{
+  for (const Rule &rule : rules)
+  {
+    if (startsWith(command, rule.prefix.c_str()))
+    {
+      reply(rule.reply);
+      return;
+    }
+  }
+
+  if (!builtIn(command))
+  {
+    reply("\r\nERROR\r\n");
+  }
+}
+
+bool FakeModem::builtIn(const std::string &command)
+{
+  std::vector<std::string> params = parameters(command);
+
+  if (command == "AT" || startsWith(command, "AT+CIPMUX=") || startsWith(command, "AT+CIPRECVMODE=") ||
+      startsWith(command, "AT+MQTTUSERCFG=") || startsWith(command, "AT+MQTTCONNCFG="))
+  {
+    reply("\r\nOK\r\n");
+    return true;
+  }
+
+  // ESP-AT MQTT client
+  if (startsWith(command, "AT+MQTTCLEAN="))
+  {
+    isMqttConnected = false;
+    subscriptions.clear();
+    reply("\r\nOK\r\n");
+    return true;
+  }
+  if (startsWith(command, "AT+MQTTCONN=") && params.size() >= 3)
+  {
+    isMqttConnected = true;
+    reply("+MQTTCONNECTED:0,1,\"" + params[1] + "\",\"" + params[2] + "\",\"\",0\r\n\r\nOK\r\n");
+    return true;
+  }
+  if (startsWith(command, "AT+MQTTSUB=") && params.size() >= 2)
+  {
+    subscriptions.push_back(params[1]);
+    reply("\r\nOK\r\n");
+    return true;
+  }
+  if (startsWith(command, "AT+MQTTPUBRAW=") && params.size() >= 3)
+  {
+    rawTopic = params[1];
+    rawRemaining = strtoul(params[2].c_str(), nullptr, 10);
+    rawTarget = rawRemaining > 0 ? RAW_MQTTPUB : RAW_NONE;
+    reply("\r\nOK\r\n\r\n>");
+    if (rawRemaining == 0)
+    {
+      onRawData();
+    }
+    return true;
+  }
+
+  // TCP link in passive receive mode, as driven by WiFiEspAT
+  if (startsWith(command, "AT+CIPSTART=") && params.size() >= 4)
+  {
+    isLinkOpen = true;
+    linkRx.clear();
+    packet.clear();
+    reply("0,CONNECT\r\n\r\nOK\r\n");
+    return true;
+  }
+  if (startsWith(command, "AT+CIPSEND=") && params.size() >= 2 && isLinkOpen)
+  {
+    rawRemaining = strtoul(params[1].c_str(), nullptr, 10);
+    rawTarget = rawRemaining > 0 ? RAW_CIPSEND : RAW_NONE;
+    reply("\r\nOK\r\n\r\n>");
+    return rawRemaining > 0;
+  }
+  if (startsWith(command, "AT+CIPRECVDATA=") && params.size() >= 2)
+  {
+    size_t length = std::min(linkRx.size(), (size_t)strtoul(params[1].c_str(), nullptr, 10));
+    reply("+CIPRECVDATA:" + std::to_string(length) + "," + linkRx.substr(0, length) + "\r\nOK\r\n");
+    linkRx.erase(0, length);
+    return true;
+  }
+  if (startsWith(command, "AT+CIPCLOSE"))
+  {
+    isLinkOpen = false;
+    reply("0,CLOSED\r\n\r\nOK\r\n");
+    return true;
+  }
+
+  return false;
+}
+
+void FakeModem::onRawData()
+{
+  RawTarget target = rawTarget;
+  rawTarget = RAW_NONE;
+
+  if (target == RAW_CIPSEND)
+  {
+    reply("\r\nRecv " + std::to_string(raw.size()) + " bytes\r\n\r\nSEND OK\r\n");
+    for (char c : raw)
+    {
+      brokerInput((uint8_t)c);
+    }
+  }
+  else
+  {
+    reply("\r\n+MQTTPUB:OK\r\n");
+    if (isSubscribed(rawTopic))
+    {
+      reply("+MQTTSUBRECV:0,\"" + rawTopic + "\"," + std::to_string(raw.size()) + "," + raw + "\r\n");
+    }
+  }
+  raw.clear();
+}
+
+void FakeModem::reply(const std::string &text)
+{
+  output += text;
+}
+
+void FakeModem::brokerInput(uint8_t b)
+{
+  packet += (char)b;
+
+  // Fixed header: type, then remaining length in 7-bit groups
+  uint32_t remaining = 0;
+  size_t i = 1;
+  for (uint8_t shift = 0; i < packet.size(); i++, shift += 7)
+  {
+    remaining |= (uint32_t)(packet[i] & 0x7F) << shift;
+    if (!(packet[i] & 0x80))
+    {
+      break;
+    }
+  }
+  if (i >= packet.size() || packet.size() < i + 1 + remaining)
+  {
+    return;
+  }
+
+  std::string complete = packet;
+  packet.clear();
+  brokerPacket(complete);
+}
+
+void FakeModem::brokerPacket(const std::string &p)
+{
+  size_t h = 1;
+  while (p[h] & 0x80)
+  {
+    h++;
+  }
+  h++; // First byte after the fixed header
+
+  uint8_t type = (uint8_t)p[0] & 0xF0;
+  if (type == 0x10) // CONNECT
+  {
+    linkOutput(std::string("\x20\x02\x00\x00", 4));
+  }
+  else if (type == 0x30) // PUBLISH
+  {
+    size_t topicLength = ((uint8_t)p[h] << 8) | (uint8_t)p[h + 1];
+    std::string topic = p.substr(h + 2, topicLength);
+    size_t position = h + 2 + topicLength;
+    if (((uint8_t)p[0] >> 1) & 0x03)
+    {
+      linkOutput(std::string("\x40\x02", 2) + p.substr(position, 2)); // PUBACK
+      position += 2;
+    }
+    if (isSubscribed(topic))
+    {
+      linkOutput(publishPacket(topic, p.substr(position)));
+    }
+  }
+  else if (type == 0x80) // SUBSCRIBE
+  {
+    size_t filterLength = ((uint8_t)p[h + 2] << 8) | (uint8_t)p[h + 3];
+    subscriptions.push_back(p.substr(h + 4, filterLength));
+    linkOutput(std::string("\x90\x03", 2) + p.substr(h, 2) + std::string(1, '\x00'));
+  }
+  else if (type == 0xC0) // PINGREQ
+  {
+    linkOutput(std::string("\xD0\x00", 2));
+  }
+  else if (type == 0xE0) // DISCONNECT
+  {
+    isLinkOpen = false;
+  }
+}
+
+void FakeModem::linkOutput(const std::string &packet)
+{
+  linkRx += packet;
+  reply("+IPD,0," + std::to_string(packet.size()) + "\r\n");
+}
+
+std::string FakeModem::publishPacket(const std::string &topic, const std::string &payload)
+{
+  // QoS0 PUBLISH, as the broker forwards it to a QoS0 subscription
+  std::string body(1, (char)(topic.size() >> 8));
+  body += (char)(topic.size() & 0xFF);
+  body += topic + payload;
+
+  std::string packet(1, '\x30');
+  size_t length = body.size();
+  do
+  {
+    packet += (char)((length & 0x7F) | (length > 0x7F ? 0x80 : 0));
+    length >>= 7;
+  } while (length);
+  return packet + body;
+}
+
+bool FakeModem::isSubscribed(const std::string &topic) const
+{
+  for (const std::string &filter : subscriptions)
+  {
+    if (filter == topic || (!filter.empty() && filter.back() == '#' &&
+                            topic.compare(0, filter.size() - 1, filter, 0, filter.size() - 1) == 0))
+    {
+      return true;
+    }
+  }
+  return false;
+}
@@ -0,0 +1,115 @@
+#ifndef NATIVE_FAKEMODEM_H
+#define NATIVE_FAKEMODEM_H
+
+#include <string>
+#include <vector>
+
+#include "Stream.h"
+
+/// Bytes and commands seen on the fake UART
+struct FakeModemStats
+{
+  uint32_t commands;    // AT command lines received
+  uint32_t hostToModem; // Bytes written by the STM32 side (its TX)
+  uint32_t modemToHost; // Bytes read by the STM32 side (its RX)
+};
+
+/// FakeModem
+/// @brief Scripted ESP-AT modem on the other end of a Stream. Answers the
+/// commands used by WiFiEspAT's TCP path (passive receive mode:
+/// AT+CIPSTART/CIPSEND/CIPRECVDATA) and by the ESP-AT MQTT client
+/// (AT+MQTTUSERCFG/CONNCFG/CONN/PUBRAW/SUB/CLEAN). Both paths share a
+/// minimal in-process broker that acknowledges QoS1 and echoes messages on
+/// subscribed topics. Script rules override the built-in answers and can
+/// inject URCs after a given number of commands.
+///
+/// Script format, one entry per line (\r, \n and \\ escapes in replies):
+///   # comment
+///   AT+MQTTCONN= => ERROR\r\n        reply to commands starting with the prefix
+///   @12 +MQTTDISCONNECTED:0\r\n      emitted after the 12th command
+///
+class FakeModem : public Stream
+{
+public:
+  FakeModem();
+
+  /// loadScript
+  /// @brief Adds the rules and timed URCs of a script file
+  /// @return false if the file cannot be read or has a malformed line
+  bool loadScript(const char *path);
+
+  /// addRule
+  /// @brief Replaces the built-in answer of commands starting with prefix
+  void addRule(const char *prefix, const char *reply);
+
+  /// inject
+  /// @brief Queues unsolicited output (URC) for the STM32 side
+  void inject(const char *text);
+
+  /// injectAfter
+  /// @brief Queues a URC once the given number of commands was received
+  void injectAfter(uint32_t command, const char *text);
+
+  /// deliver
+  /// @brief Broker-side message to this client: +MQTTSUBRECV when the AT
+  ///        MQTT session is up, a PUBLISH on the TCP link otherwise
+  void deliver(const char *topic, const char *payload);
+
+  /// getStats
+  /// @brief Traffic counters since construction
+  const FakeModemStats &getStats() const;
+
+  size_t write(uint8_t b) override;
+  int available() override;
+  int read() override;
+  int peek() override;
+  using Print::write;
+
+private:
+  enum RawTarget
+  {
+    RAW_NONE,
+    RAW_CIPSEND, // TCP payload for the broker
+    RAW_MQTTPUB  // AT+MQTTPUBRAW message
+  };
+
+  struct Rule
+  {
+    std::string prefix;
+    std::string reply;
+  };
+
+  struct TimedUrc
+  {
+    uint32_t command;
+    std::string text;
+  };
+
+  void onCommand(const std::string &command);
+  bool builtIn(const std::string &command);
+  void onRawData();
+  void reply(const std::string &text);
+  void brokerInput(uint8_t b);
+  void brokerPacket(const std::string &packet);
+  void linkOutput(const std::string &packet);
+  static std::string publishPacket(const std::string &topic, const std::string &payload);
+  bool isSubscribed(const std::string &topic) const;
+
+  std::string output;   // Pending bytes for the STM32 side
+  size_t outputStart;
+  std::string command;  // Current command line
+  RawTarget rawTarget;
+  size_t rawRemaining;
+  std::string raw;      // Raw data after a '>' prompt
+  std::string rawTopic; // Topic of the pending AT+MQTTPUBRAW
+  std::vector<Rule> rules;
+  std::vector<TimedUrc> urcs;
+  std::vector<std::string> subscriptions;
+  std::string linkRx;   // TCP bytes not yet read with AT+CIPRECVDATA
+  std::string packet;   // Broker input being assembled
+  bool isLinkOpen;
+  bool isMqttConnected;
+  FakeModemStats stats;
+};
+
+#endif // NATIVE_FAKEMODEM_H
@@ -0,0 +1,111 @@
+#include "Arduino.h"
+
+#include <poll.h>
+#include <unistd.h>
+
+HardwareSerial Serial;
+Stream *HardwareSerial::defaultPeer = nullptr;
+
+HardwareSerial::HardwareSerial() : isConsole(true), peer(nullptr), pending(-1)
+{
+}
+
+HardwareSerial::HardwareSerial(uint32_t rx, uint32_t tx) : isConsole(false), peer(nullptr), pending(-1)
+{
+  (void)rx;
+  (void)tx;
+}
+
+void HardwareSerial::begin(unsigned long baud)
+{
+  (void)baud;
+}
+
+void HardwareSerial::end()
+{
+}
+
+void HardwareSerial::setPeer(Stream *stream)
+{
+  peer = stream;
+}
+
+void HardwareSerial::setDefaultPeer(Stream *stream)
+{
+  defaultPeer = stream;
+}
+
+Stream *HardwareSerial::target() const
+{
+  return peer ? peer : defaultPeer;
+}
+
+bool HardwareSerial::fillConsole()
+{
+  if (pending >= 0)
+  {
+    return true;
+  }
+  struct pollfd input = {STDIN_FILENO, POLLIN, 0};
+  uint8_t b;
+  if (poll(&input, 1, 0) == 1 && (input.revents & POLLIN) && ::read(STDIN_FILENO, &b, 1) == 1)
+  {
+    pending = b;
+  }
+  return pending >= 0;
+}
+
+int HardwareSerial::available()
+{
+  if (isConsole)
+  {
+    return fillConsole() ? 1 : 0;
+  }
+  Stream *stream = target();
+  return stream ? stream->available() : 0;
+}
+
+int HardwareSerial::read()
+{
+  if (isConsole)
+  {
+    int b = fillConsole() ? pending : -1;
+    pending = -1;
+    return b;
+  }
+  Stream *stream = target();
+  return stream ? stream->read() : -1;
+}
+
+int HardwareSerial::peek()
+{
+  if (isConsole)
+  {
+    return fillConsole() ? pending : -1;
+  }
+  Stream *stream = target();
+  return stream ? stream->peek() : -1;
+}
+
+size_t HardwareSerial::write(uint8_t b)
+{
+  return write(&b, 1);
+}
+
+size_t HardwareSerial::write(const uint8_t *buffer, size_t size)
+{
+  if (isConsole)
+  {
+    return fwrite(buffer, 1, size, stdout);
+  }
+  Stream *stream = target();
+  return stream ? stream->write(buffer, size) : size;
+}
+
+void HardwareSerial::flush()
+{
+  if (isConsole)
+  {
+    fflush(stdout);
+  }
+}
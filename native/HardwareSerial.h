@@ -0,0 +1,49 @@
+#ifndef NATIVE_HARDWARESERIAL_H
+#define NATIVE_HARDWARESERIAL_H
+
+#include "Stream.h"
+
+/// HardwareSerial
+/// @brief Host version of the STM32 core UART. Serial is the console:
+/// writes go to stdout and reads come from stdin without blocking. A port
+/// built from pins talks to the Stream given to setPeer() (FakeModem for
+/// the ESP8266 link), or to setDefaultPeer() for ports created before it;
+/// without a peer it reads nothing and drops what is written.
+///
+class HardwareSerial : public Stream
+{
+public:
+  HardwareSerial();
+  HardwareSerial(uint32_t rx, uint32_t tx);
+
+  void begin(unsigned long baud);
+  void end();
+  void setPeer(Stream *stream);
+  static void setDefaultPeer(Stream *stream);
+
+  int available() override;
+  int read() override;
+  int peek() override;
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  void flush() override;
+  using Print::write;
+  operator bool() { return true; }
+
+  // Flow control pins, kept only for the API
+  void setRts(uint32_t pin) { (void)pin; }
+  void setCts(uint32_t pin) { (void)pin; }
+
+private:
+  Stream *target() const;
+  bool fillConsole();
+
+  bool isConsole;
+  Stream *peer;
+  int pending; // Console byte read ahead by peek(), -1 if none
+  static Stream *defaultPeer;
+};
+
+extern HardwareSerial Serial;
+
+#endif // NATIVE_HARDWARESERIAL_H
@@ -0,0 +1,218 @@
+#include "Arduino.h"
+
+#include <time.h>
+
+static constexpr uint32_t TIMER_CLOCK_HZ = 80000000; // SYSCLK of the firmware, no APB divider
+
+static TIM_TypeDef timers[] = {{2}, {3}, {4}, {6}, {7}};
+TIM_TypeDef *const TIM2 = &timers[0];
+TIM_TypeDef *const TIM3 = &timers[1];
+TIM_TypeDef *const TIM4 = &timers[2];
+TIM_TypeDef *const TIM6 = &timers[3];
+TIM_TypeDef *const TIM7 = &timers[4];
+
+HardwareTimer *FakeTimers::attached = nullptr;
+TimerObserver FakeTimers::observer = nullptr;
+
+// ========== FakeTimers ==========
+
+uint64_t FakeTimers::nextEvent()
+{
+  uint64_t next = UINT64_MAX;
+  for (HardwareTimer *timer = FakeTimers::attached; timer; timer = timer->next)
+  {
+    uint64_t period = timer->periodUs();
+    if (timer->isStarted && timer->callback && period > 0)
+    {
+      next = std::min(next, timer->periodStart + period);
+    }
+  }
+  return next;
+}
+
+void FakeTimers::setObserver(TimerObserver newObserver)
+{
+  observer = newObserver;
+}
+
+static uint64_t cpuNanos()
+{
+  struct timespec now;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &now);
+  return (uint64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+}
+
+// ========== HardwareTimer ==========
+
+HardwareTimer::HardwareTimer() : instance(nullptr), prescaler(1), overflow(0x10000), periodStart(0), isStarted(false),
+                                 next(nullptr)
+{
+}
+
+HardwareTimer::HardwareTimer(TIM_TypeDef *instance) : HardwareTimer()
+{
+  setup(instance);
+}
+
+HardwareTimer::~HardwareTimer()
+{
+  detachInterrupt();
+}
+
+void HardwareTimer::setup(TIM_TypeDef *timer)
+{
+  instance = timer;
+}
+
+void HardwareTimer::setPrescaleFactor(uint32_t value)
+{
+  prescaler = value > 0 ? value : 1;
+}
+
+uint32_t HardwareTimer::getPrescaleFactor()
+{
+  return prescaler;
+}
+
+uint64_t HardwareTimer::periodUs() const
+{
+  return (uint64_t)overflow * prescaler * 1000000 / TIMER_CLOCK_HZ;
+}
+
+uint32_t HardwareTimer::fromUs(uint64_t us, TimerFormat_t format) const
+{
+  switch (format)
+  {
+  case MICROSEC_FORMAT:
+    return (uint32_t)us;
+  case HERTZ_FORMAT:
+    return us > 0 ? (uint32_t)(1000000 / us) : 0;
+  default:
+    return (uint32_t)(us * TIMER_CLOCK_HZ / 1000000 / prescaler);
+  }
+}
+
+void HardwareTimer::setOverflow(uint32_t value, TimerFormat_t format)
+{
+  uint64_t ticks;
+  switch (format)
+  {
+  case MICROSEC_FORMAT:
+    ticks = (uint64_t)value * (TIMER_CLOCK_HZ / 1000000) / prescaler;
+    break;
+  case HERTZ_FORMAT:
+    ticks = value > 0 ? TIMER_CLOCK_HZ / value / prescaler : 0;
+    break;
+  default:
+    ticks = value;
+    break;
+  }
+  overflow = ticks > 0 ? (uint32_t)ticks : 1;
+}
+
+uint32_t HardwareTimer::getOverflow(TimerFormat_t format)
+{
+  return format == TICK_FORMAT ? overflow : fromUs(periodUs(), format);
+}
+
+void HardwareTimer::setCount(uint32_t value, TimerFormat_t format)
+{
+  uint64_t us = format == MICROSEC_FORMAT ? value : (uint64_t)value * prescaler * 1000000 / TIMER_CLOCK_HZ;
+  periodStart = hostMicros() - us;
+}
+
+uint32_t HardwareTimer::getCount(TimerFormat_t format)
+{
+  if (!isStarted)
+  {
+    return 0;
+  }
+  uint64_t period = periodUs();
+  uint64_t elapsed = hostMicros() - periodStart;
+  return fromUs(period > 0 ? elapsed % period : 0, format);
+}
+
+void HardwareTimer::attachInterrupt(callback_function_t function)
+{
+  callback = function;
+  if (!next && FakeTimers::attached != this)
+  {
+    next = FakeTimers::attached;
+    FakeTimers::attached = this;
+  }
+  addInterruptSource(pollAll);
+}
+
+void HardwareTimer::detachInterrupt()
+{
+  callback = nullptr;
+  for (HardwareTimer **link = &FakeTimers::attached; *link; link = &(*link)->next)
+  {
+    if (*link == this)
+    {
+      *link = next;
+      next = nullptr;
+      break;
+    }
+  }
+}
+
+void HardwareTimer::setInterruptPriority(uint32_t, uint32_t)
+{
+}
+
+void HardwareTimer::resume()
+{
+  if (!isStarted)
+  {
+    periodStart = hostMicros();
+    isStarted = true;
+  }
+}
+
+void HardwareTimer::pause()
+{
+  isStarted = false;
+}
+
+void HardwareTimer::refresh()
+{
+  periodStart = hostMicros();
+}
+
+bool HardwareTimer::isRunning()
+{
+  return isStarted;
+}
+
+uint32_t HardwareTimer::getTimerClkFreq()
+{
+  return TIMER_CLOCK_HZ;
+}
+
+void HardwareTimer::pollAll()
+{
+  for (HardwareTimer *timer = FakeTimers::attached; timer; timer = timer->next)
+  {
+    timer->poll();
+  }
+}
+
+void HardwareTimer::poll()
+{
+  uint64_t period = periodUs();
+  uint64_t now = hostMicros();
+  if (!isStarted || !callback || period == 0 || now - periodStart < period)
+  {
+    return;
+  }
+  periodStart += (now - periodStart) / period * period; // Missed periods are lost
+  if (!FakeTimers::observer)
+  {
+    callback();
+    return;
+  }
+  uint64_t cpuStart = cpuNanos();
+  callback();
+  FakeTimers::observer(instance, hostMicros() - now, cpuNanos() - cpuStart);
+}
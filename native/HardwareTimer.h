@@ -0,0 +1,100 @@
+#ifndef NATIVE_HARDWARETIMER_H
+#define NATIVE_HARDWARETIMER_H
+
+#include <stdint.h>
+#include <functional>
+
+/// Timer instances of the STM32L476 used by the firmware
+struct TIM_TypeDef
+{
+  uint8_t index;
+};
+extern TIM_TypeDef *const TIM2;
+extern TIM_TypeDef *const TIM3;
+extern TIM_TypeDef *const TIM4;
+extern TIM_TypeDef *const TIM6;
+extern TIM_TypeDef *const TIM7;
+
+typedef std::function<void(void)> callback_function_t;
+
+enum TimerFormat_t
+{
+  TICK_FORMAT,
+  MICROSEC_FORMAT,
+  HERTZ_FORMAT
+};
+
+class HardwareTimer;
+
+/// Called after each timer callback with the time it took: virtual (or
+/// host) microseconds on the clock of Arduino.h, and host CPU nanoseconds
+typedef void (*TimerObserver)(TIM_TypeDef *instance, uint64_t clockUs, uint64_t cpuNs);
+
+/// FakeTimers
+/// @brief Host-only view of the running timers, for the simulation loop
+///
+class FakeTimers
+{
+public:
+  /// nextEvent
+  /// @brief hostMicros() of the next update event with a callback,
+  ///        UINT64_MAX when no timer is running
+  static uint64_t nextEvent();
+
+  static void setObserver(TimerObserver observer);
+
+private:
+  friend class HardwareTimer;
+  static HardwareTimer *attached; // Timers with a callback
+  static TimerObserver observer;
+};
+
+/// HardwareTimer
+/// @brief Host version of the STM32 core timer in update (periodic) mode.
+/// The counter follows micros(): getCount() is the time since the last
+/// update event, and the callback runs as an interrupt (see
+/// serviceInterrupts() in Arduino.h) once the period has elapsed. Periods
+/// missed while interrupts were held off fire once, like the update flag.
+///
+class HardwareTimer
+{
+public:
+  HardwareTimer();
+  HardwareTimer(TIM_TypeDef *instance);
+  ~HardwareTimer();
+
+  void setup(TIM_TypeDef *instance);
+  void setPrescaleFactor(uint32_t prescaler);
+  uint32_t getPrescaleFactor();
+  void setOverflow(uint32_t value, TimerFormat_t format = TICK_FORMAT);
+  uint32_t getOverflow(TimerFormat_t format = TICK_FORMAT);
+  void setCount(uint32_t value, TimerFormat_t format = TICK_FORMAT);
+  uint32_t getCount(TimerFormat_t format = TICK_FORMAT);
+  void attachInterrupt(callback_function_t callback);
+  /// No-op: the host services every interrupt source at one priority,
+  /// so a callback never preempts another one
+  void setInterruptPriority(uint32_t preemptPriority, uint32_t subPriority);
+  void detachInterrupt();
+  void resume();
+  void pause();
+  void refresh();
+  bool isRunning();
+  uint32_t getTimerClkFreq();
+
+private:
+  friend class FakeTimers;
+  static void pollAll();
+  void poll();
+  uint64_t periodUs() const;
+  uint32_t fromUs(uint64_t us, TimerFormat_t format) const;
+
+  TIM_TypeDef *instance;
+  uint32_t prescaler;
+  uint32_t overflow;    // Ticks per period
+  uint64_t periodStart; // micros() of the last update event, 64-bit
+  bool isStarted;
+  callback_function_t callback;
+  HardwareTimer *next;  // Timers polled by the interrupt service
+};
+
+#endif // NATIVE_HARDWARETIMER_H
@@ -0,0 +1,27 @@
+#ifndef NATIVE_IPADDRESS_H
+#define NATIVE_IPADDRESS_H
+
+#include <stdint.h>
+
+/// Host version of the Arduino IPv4 address
+class IPAddress
+{
+public:
+  IPAddress() : address{0, 0, 0, 0} {}
+  IPAddress(uint8_t a, uint8_t b, uint8_t c, uint8_t d) : address{a, b, c, d} {}
+
+  uint8_t operator[](int index) const { return address[index]; }
+  uint8_t &operator[](int index) { return address[index]; }
+  bool operator==(const IPAddress &other) const
+  {
+    return address[0] == other.address[0] && address[1] == other.address[1] &&
+           address[2] == other.address[2] && address[3] == other.address[3];
+  }
+
+  bool fromString(const char *text);
+
+private:
+  uint8_t address[4];
+};
+
+#endif // NATIVE_IPADDRESS_H
@@ -0,0 +1,215 @@
+// Host TCP client, see PosixClient.h
+
+#include "PosixClient.h"
+#include "Arduino.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <stdio.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+PosixClient::PosixClient()
+{
+  fd = -1;
+  connectTimeout = 2000;
+  rxStart = 0;
+  rxEnd = 0;
+  isPeerClosed = false;
+}
+
+PosixClient::~PosixClient()
+{
+  stop();
+}
+
+void PosixClient::setConnectTimeout(uint32_t timeoutMs)
+{
+  connectTimeout = timeoutMs;
+}
+
+int PosixClient::connect(IPAddress ip, uint16_t port)
+{
+  char host[16];
+  snprintf(host, sizeof(host), "%u.%u.%u.%u", ip[0], ip[1], ip[2], ip[3]);
+  return connect(host, port);
+}
+
+int PosixClient::connect(const char *host, uint16_t port)
+{
+  stop();
+
+  struct addrinfo hints = {};
+  struct addrinfo *result = nullptr;
+  char service[8];
+  hints.ai_family = AF_INET;
+  hints.ai_socktype = SOCK_STREAM;
+  snprintf(service, sizeof(service), "%u", port);
+  if (getaddrinfo(host, service, &hints, &result) != 0 || !result)
+  {
+    return 0;
+  }
+
+  fd = socket(result->ai_family, result->ai_socktype, result->ai_protocol);
+  if (fd < 0)
+  {
+    freeaddrinfo(result);
+    return 0;
+  }
+
+  // Non-blocking connect so the timeout is ours, not the kernel's
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  int rc = ::connect(fd, result->ai_addr, result->ai_addrlen);
+  freeaddrinfo(result);
+
+  if (rc < 0 && errno == EINPROGRESS)
+  {
+    struct pollfd waiter = {fd, POLLOUT, 0};
+    int error = 0;
+    socklen_t length = sizeof(error);
+    if (poll(&waiter, 1, (int)connectTimeout) != 1 ||
+        getsockopt(fd, SOL_SOCKET, SO_ERROR, &error, &length) < 0 || error != 0)
+    {
+      stop();
+      return 0;
+    }
+  }
+  else if (rc < 0)
+  {
+    stop();
+    return 0;
+  }
+
+  int enable = 1;
+  setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable)); // MQTT packets are small
+  return 1;
+}
+
+size_t PosixClient::write(uint8_t b)
+{
+  return write(&b, 1);
+}
+
+size_t PosixClient::write(const uint8_t *buffer, size_t size)
+{
+  size_t sent = 0;
+  while (fd >= 0 && sent < size)
+  {
+    ssize_t n = send(fd, buffer + sent, size - sent, MSG_NOSIGNAL);
+    if (n > 0)
+    {
+      sent += (size_t)n;
+    }
+    else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+    {
+      struct pollfd waiter = {fd, POLLOUT, 0};
+      poll(&waiter, 1, 100);
+    }
+    else
+    {
+      isPeerClosed = true;
+      break;
+    }
+  }
+  return sent;
+}
+
+int PosixClient::available()
+{
+  if (rxStart == rxEnd)
+  {
+    fill();
+  }
+  return (int)(rxEnd - rxStart);
+}
+
+int PosixClient::read()
+{
+  if (available() == 0)
+  {
+    return -1;
+  }
+  return rxBuffer[rxStart++];
+}
+
+int PosixClient::read(uint8_t *buffer, size_t size)
+{
+  size_t count = 0;
+  while (count < size && available() > 0)
+  {
+    size_t chunk = min(size - count, rxEnd - rxStart);
+    memcpy(buffer + count, rxBuffer + rxStart, chunk);
+    rxStart += chunk;
+    count += chunk;
+  }
+  return count == 0 ? -1 : (int)count;
+}
+
+int PosixClient::peek()
+{
+  if (available() == 0)
+  {
+    return -1;
+  }
+  return rxBuffer[rxStart];
+}
+
+void PosixClient::flush()
+{
+}
+
+void PosixClient::stop()
+{
+  if (fd >= 0)
+  {
+    close(fd);
+  }
+  fd = -1;
+  rxStart = 0;
+  rxEnd = 0;
+  isPeerClosed = false;
+}
+
+uint8_t PosixClient::connected()
+{
+  if (fd < 0)
+  {
+    return 0;
+  }
+  // Like the Arduino clients: still "connected" while unread data remains
+  if (rxStart == rxEnd)
+  {
+    fill();
+  }
+  return (!isPeerClosed || rxStart != rxEnd) ? 1 : 0;
+}
+
+PosixClient::operator bool()
+{
+  return fd >= 0;
+}
+
+bool PosixClient::fill()
+{
+  if (fd < 0 || isPeerClosed)
+  {
+    return false;
+  }
+
+  ssize_t n = recv(fd, rxBuffer, sizeof(rxBuffer), MSG_DONTWAIT);
+  if (n > 0)
+  {
+    rxStart = 0;
+    rxEnd = (size_t)n;
+    return true;
+  }
+  if (n == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+  {
+    isPeerClosed = true; // Orderly shutdown or reset
+  }
+  return false;
+}
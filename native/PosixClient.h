@@ -0,0 +1,47 @@
+#ifndef NATIVE_POSIXCLIENT_H
+#define NATIVE_POSIXCLIENT_H
+
+#include "Client.h"
+
+/// PosixClient
+/// @brief Arduino Client over a POSIX TCP socket. Stands in for
+/// WiFiEspAT's WiFiClient on Linux so PubSubClient and the firmware's
+/// MQTT paths talk to a real broker on localhost. Reads are served from a
+/// small user-space buffer because PubSubClient reads one byte at a time.
+///
+class PosixClient : public Client
+{
+public:
+  PosixClient();
+  ~PosixClient();
+
+  /// setConnectTimeout
+  /// @brief Bound for connect(), like the AT timeout on the target
+  void setConnectTimeout(uint32_t timeoutMs);
+
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char *host, uint16_t port) override;
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t *buffer, size_t size) override;
+  int peek() override;
+  void flush() override;
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override;
+  using Print::write;
+
+private:
+  bool fill();
+
+  int fd;
+  uint32_t connectTimeout;
+  uint8_t rxBuffer[1024];
+  size_t rxStart; // First unread byte
+  size_t rxEnd;   // One past the last buffered byte
+  bool isPeerClosed;
+};
+
+#endif // NATIVE_POSIXCLIENT_H
@@ -0,0 +1,33 @@
+#ifndef NATIVE_ROOMMODEL_H
+#define NATIVE_ROOMMODEL_H
+
+/// RoomModel
+/// @brief First-order thermal model of the machine room: the temperature
+/// relaxes towards ambient + heat load - cooling * output with time
+/// constant tau. Explicit Euler, so steps must stay well below tau.
+///
+struct RoomModel
+{
+  float ambient = 30;  // °C outside the room
+  float load = 0;      // °C the equipment adds at equilibrium
+  float cooling = 15;  // °C removed at equilibrium with the actuator always on
+  float tauS = 600;    // Time constant (s)
+  float temperature = 30;
+
+  /// step
+  /// @brief Advances the model
+  ///
+  /// @param[in] seconds: Time step
+  /// @param[in] output: Actuator output over the step, 0..1
+  ///
+  /// @return Temperature after the step
+  ///
+  float step(float seconds, float output)
+  {
+    float target = ambient + load - cooling * output;
+    temperature += (target - temperature) * seconds / tauS;
+    return temperature;
+  }
+};
+
+#endif // NATIVE_ROOMMODEL_H
@@ -0,0 +1,15 @@
+#ifndef NATIVE_SPI_H
+#define NATIVE_SPI_H
+
+// The fake card (SdFat.h) needs no bus: SPIClass is only here for the API
+
+#include "Arduino.h"
+
+class SPIClass
+{
+public:
+  void begin() {}
+  void end() {}
+};
+
+#endif // NATIVE_SPI_H
@@ -0,0 +1,143 @@
+#include "Arduino.h"
+#include "STM32RTC.h"
+
+#include <sys/time.h>
+
+static constexpr uint32_t EPOCH_2000 = 946684800;
+
+STM32RTC &STM32RTC::getInstance()
+{
+  static STM32RTC instance;
+  return instance;
+}
+
+STM32RTC::STM32RTC() : isSet(true)
+{
+  struct timeval wall;
+  gettimeofday(&wall, nullptr);
+  offsetUs = (int64_t)wall.tv_sec * 1000000 + wall.tv_usec - (int64_t)hostMicros();
+}
+
+void STM32RTC::begin(bool resetTime, Hour_Format format)
+{
+  (void)format;
+  if (resetTime)
+  {
+    FakeRtc::lose();
+  }
+}
+
+bool STM32RTC::isTimeSet()
+{
+  return isSet;
+}
+
+struct tm STM32RTC::now()
+{
+  time_t seconds = (time_t)(((int64_t)hostMicros() + offsetUs) / 1000000);
+  struct tm calendar;
+  gmtime_r(&seconds, &calendar);
+  return calendar;
+}
+
+void STM32RTC::setCalendar(const struct tm &calendar)
+{
+  struct tm copy = calendar;
+  setEpoch(timegm(&copy));
+}
+
+void STM32RTC::setTime(uint8_t hours, uint8_t minutes, uint8_t seconds, uint32_t subSeconds)
+{
+  (void)subSeconds;
+  struct tm calendar = now();
+  calendar.tm_hour = hours;
+  calendar.tm_min = minutes;
+  calendar.tm_sec = seconds;
+  setCalendar(calendar);
+}
+
+void STM32RTC::setDate(uint8_t weekDay, uint8_t day, uint8_t month, uint8_t year)
+{
+  (void)weekDay; // Derived from the date
+  setDate(day, month, year);
+}
+
+void STM32RTC::setDate(uint8_t day, uint8_t month, uint8_t year)
+{
+  struct tm calendar = now();
+  calendar.tm_mday = day;
+  calendar.tm_mon = month - 1;
+  calendar.tm_year = year + 100;
+  setCalendar(calendar);
+}
+
+void STM32RTC::setEpoch(time_t epoch, uint32_t subSeconds)
+{
+  offsetUs = (int64_t)epoch * 1000000 + (int64_t)subSeconds * 1000 - (int64_t)hostMicros();
+  isSet = true;
+}
+
+uint32_t STM32RTC::getEpoch(uint32_t *subSeconds)
+{
+  int64_t us = (int64_t)hostMicros() + offsetUs;
+  if (subSeconds)
+  {
+    *subSeconds = (uint32_t)(us % 1000000 / 1000);
+  }
+  return (uint32_t)(us / 1000000);
+}
+
+uint8_t STM32RTC::getWeekDay()
+{
+  int weekDay = now().tm_wday;
+  return weekDay == 0 ? 7 : weekDay; // 1 = Monday .. 7 = Sunday
+}
+
+uint8_t STM32RTC::getDay()
+{
+  return now().tm_mday;
+}
+
+uint8_t STM32RTC::getMonth()
+{
+  return now().tm_mon + 1;
+}
+
+uint8_t STM32RTC::getYear()
+{
+  return (now().tm_year - 100) % 100;
+}
+
+uint8_t STM32RTC::getHours()
+{
+  return now().tm_hour;
+}
+
+uint8_t STM32RTC::getMinutes()
+{
+  return now().tm_min;
+}
+
+uint8_t STM32RTC::getSeconds()
+{
+  return now().tm_sec;
+}
+
+uint32_t STM32RTC::getSubSeconds()
+{
+  uint32_t subSeconds;
+  getEpoch(&subSeconds);
+  return subSeconds;
+}
+
+void FakeRtc::lose()
+{
+  STM32RTC &rtc = STM32RTC::getInstance();
+  rtc.setEpoch(EPOCH_2000);
+  rtc.isSet = false;
+}
+
+void FakeRtc::setEpoch(uint32_t epoch)
+{
+  STM32RTC::getInstance().setEpoch(epoch);
+}
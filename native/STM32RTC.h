@@ -0,0 +1,68 @@
+#ifndef NATIVE_STM32RTC_H
+#define NATIVE_STM32RTC_H
+
+#include <stdint.h>
+#include <time.h>
+
+/// STM32RTC
+/// @brief Host version of the STM32 RTC: a calendar that advances with
+/// hostMicros(). It starts at the host's wall clock, already set, like a
+/// board whose backup domain kept the time; FakeRtc::lose() starts it
+/// unset at 01/01/2000 instead.
+///
+class STM32RTC
+{
+public:
+  enum Hour_Format
+  {
+    HOUR_12,
+    HOUR_24
+  };
+
+  static STM32RTC &getInstance();
+
+  void begin(bool resetTime = false, Hour_Format format = HOUR_24);
+  void begin(Hour_Format format) { begin(false, format); }
+  bool isTimeSet();
+
+  void setTime(uint8_t hours, uint8_t minutes, uint8_t seconds, uint32_t subSeconds = 0);
+  void setDate(uint8_t weekDay, uint8_t day, uint8_t month, uint8_t year);
+  void setDate(uint8_t day, uint8_t month, uint8_t year);
+  void setEpoch(time_t epoch, uint32_t subSeconds = 0);
+  uint32_t getEpoch(uint32_t *subSeconds = nullptr);
+
+  uint8_t getWeekDay();
+  uint8_t getDay();
+  uint8_t getMonth();
+  uint8_t getYear();
+  uint8_t getHours();
+  uint8_t getMinutes();
+  uint8_t getSeconds();
+  uint32_t getSubSeconds();
+
+private:
+  STM32RTC();
+  struct tm now();
+  void setCalendar(const struct tm &calendar);
+
+  int64_t offsetUs; // Epoch in µs minus hostMicros()
+  bool isSet;
+
+  friend class FakeRtc;
+};
+
+/// FakeRtc
+/// @brief Controls of the fake RTC
+class FakeRtc
+{
+public:
+  /// lose
+  /// @brief Backup domain lost: time unset at 01/01/2000 00:00:00
+  static void lose();
+
+  /// setEpoch
+  /// @brief Starts the RTC at a given time (set)
+  static void setEpoch(uint32_t epoch);
+};
+
+#endif // NATIVE_STM32RTC_H
@@ -0,0 +1,670 @@
+// Host implementation of the SdFat subset declared in SdFat.h
+
+#include "SdFat.h"
+
+#include <errno.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+static constexpr uint32_t SECTOR_SIZE = 512;
+
+static std::string cardRoot = "sdcard";
+static FakeCardModel cardModel;
+static FakeCardStats cardStats;
+static uint32_t sectorsSinceStall = 0;
+static bool isCardFailing = false;
+static uint64_t nextWriteAddress = UINT64_MAX; // Sector that would continue the open multi-block write
+
+cid_t FakeCard::cid = {0x03, {'S', 'D'}, {'F', 'A', 'K', 'E', '1'}, 0x10, 1, 0x0189, 0};
+csd_t FakeCard::csd = {{0x40, 0x0E, 0x00, 0x32, 0x5B, 0x59, 0x00, 0x00, 0x3B, 0x37, 0x7F, 0x80, 0x0A, 0x40, 0x00, 0x00}};
+sds_t FakeCard::sds = {0, 0, {0, 0}, {0, 0, 0, 0}, 4, 0, 0x90, {0}};
+uint32_t FakeCard::sectorCount = 15523840; // 8 GB
+uint32_t FakeCard::spiKHz = 10000;
+bool FakeCard::isDedicated = false;
+
+// ========== FakeCard ==========
+
+void FakeCard::setRoot(const char *path)
+{
+  cardRoot = path;
+}
+
+const std::string &FakeCard::root()
+{
+  return cardRoot;
+}
+
+std::string FakeCard::path(const char *name)
+{
+  while (*name == '/')
+  {
+    name++;
+  }
+  return *name ? cardRoot + "/" + name : cardRoot;
+}
+
+void FakeCard::setModel(const FakeCardModel &model)
+{
+  cardModel = model;
+}
+
+const FakeCardModel &FakeCard::model()
+{
+  return cardModel;
+}
+
+void FakeCard::setRegisters(const cid_t &newCid, const csd_t &newCsd, uint32_t sectors)
+{
+  cid = newCid;
+  csd = newCsd;
+  sectorCount = sectors;
+}
+
+const FakeCardStats &FakeCard::stats()
+{
+  return cardStats;
+}
+
+void FakeCard::resetStats()
+{
+  cardStats = FakeCardStats();
+}
+
+void FakeCard::setFailing(bool isFailing)
+{
+  isCardFailing = isFailing;
+}
+
+bool FakeCard::isFailing()
+{
+  return isCardFailing;
+}
+
+bool FakeCard::refuse()
+{
+  if (isCardFailing)
+  {
+    cardStats.failures++;
+  }
+  return isCardFailing;
+}
+
+static uint64_t busUs(uint32_t sectors)
+{
+  // 8 bits per byte at the SPI clock
+  return (uint64_t)sectors * SECTOR_SIZE * 8 * 1000 / (FakeCard::spiKHz ? FakeCard::spiKHz : 1);
+}
+
+void FakeCard::chargeWrite(uint32_t sectors, uint64_t address)
+{
+  if (sectors == 0)
+  {
+    return;
+  }
+
+  // On a dedicated bus SdFat keeps a multi-block write going, also across
+  // write() calls, until another command or a non-contiguous sector
+  bool isContinued = isDedicated && address != UINT64_MAX && address == nextWriteAddress;
+  nextWriteAddress = address == UINT64_MAX ? UINT64_MAX : address + sectors;
+  if (!isContinued)
+  {
+    cardStats.commands++;
+  }
+
+  uint64_t us = busUs(sectors);
+  for (uint32_t i = 0; i < sectors; i++)
+  {
+    bool isBurst = isDedicated && (i > 0 || isContinued);
+    us += isBurst ? cardModel.burstSectorUs : cardModel.commandUs + cardModel.sectorWriteUs;
+    if (cardModel.stallEvery > 0 && ++sectorsSinceStall >= cardModel.stallEvery)
+    {
+      sectorsSinceStall = 0;
+      us += cardModel.stallUs;
+      cardStats.stalls++;
+    }
+  }
+  cardStats.commands += isDedicated ? 0 : sectors - 1;
+  cardStats.sectorsWritten += sectors;
+  wait(us);
+}
+
+void FakeCard::chargeRead(uint32_t sectors)
+{
+  nextWriteAddress = UINT64_MAX;
+  cardStats.commands++;
+  cardStats.sectorsRead += sectors;
+  wait(cardModel.commandUs + busUs(sectors) + (uint64_t)sectors * cardModel.sectorReadUs);
+}
+
+void FakeCard::chargeCommand()
+{
+  nextWriteAddress = UINT64_MAX;
+  cardStats.commands++;
+  wait(cardModel.commandUs);
+}
+
+void FakeCard::countPartialWrite()
+{
+  cardStats.partialWrites++;
+}
+
+void FakeCard::wait(uint64_t us)
+{
+  cardStats.busyUs += us;
+  if (isInterruptContext())
+  {
+    cardStats.interruptAccesses++; // The firmware only touches the card from loop()/setup()
+  }
+  if (isVirtualTime())
+  {
+    advanceVirtualTime(us);
+    return;
+  }
+  uint32_t start = micros();
+  while (micros() - start < us)
+  {
+  }
+}
+
+// ========== SdCard ==========
+
+bool SdCard::readCID(cid_t *cid)
+{
+  FakeCard::chargeCommand();
+  *cid = FakeCard::cid;
+  return true;
+}
+
+bool SdCard::readCSD(csd_t *csd)
+{
+  FakeCard::chargeCommand();
+  *csd = FakeCard::csd;
+  return true;
+}
+
+bool SdCard::readSDS(sds_t *sds)
+{
+  FakeCard::chargeRead(1);
+  *sds = FakeCard::sds;
+  return true;
+}
+
+uint32_t SdCard::sectorCount()
+{
+  return FakeCard::sectorCount;
+}
+
+uint8_t SdCard::type()
+{
+  return 3; // SDHC
+}
+
+bool SdCard::isBusy()
+{
+  return false;
+}
+
+// ========== FsFile ==========
+
+FsFile::FsFile() : fd(-1), dir(nullptr), position(0), isAppend(false), cachedSector(-1), isCacheDirty(false)
+{
+}
+
+FsFile::~FsFile()
+{
+  close();
+}
+
+bool FsFile::open(const char *path, int oflag)
+{
+  close();
+  if (FakeCard::refuse())
+  {
+    return false;
+  }
+  std::string hostPath = FakeCard::path(path);
+  FakeCard::chargeRead(1); // Directory lookup
+
+  struct stat info;
+  if (stat(hostPath.c_str(), &info) == 0 && S_ISDIR(info.st_mode))
+  {
+    dir = opendir(hostPath.c_str());
+    name = path;
+    return dir != nullptr;
+  }
+
+  bool isNew = (oflag & O_CREAT) && access(hostPath.c_str(), F_OK) != 0;
+  fd = ::open(hostPath.c_str(), oflag & ~O_APPEND, 0644);
+  if (fd < 0)
+  {
+    return false;
+  }
+  cardStats.filesCreated += isNew ? 1 : 0;
+  name = path;
+  isAppend = (oflag & O_APPEND) != 0;
+  position = 0;
+  cachedSector = -1;
+  isCacheDirty = false;
+  return true;
+}
+
+bool FsFile::openNext(FsFile *directory, int oflag)
+{
+  if (!directory || !directory->dir)
+  {
+    return false;
+  }
+
+  struct dirent *entry;
+  while ((entry = readdir(directory->dir)) != nullptr)
+  {
+    if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+    {
+      std::string child = directory->name;
+      if (!child.empty() && child.back() != '/')
+      {
+        child += "/";
+      }
+      child += entry->d_name;
+      return open(child.c_str(), oflag);
+    }
+  }
+  return false;
+}
+
+bool FsFile::close()
+{
+  if (dir)
+  {
+    closedir(dir);
+    dir = nullptr;
+    return true;
+  }
+  if (fd < 0)
+  {
+    return false;
+  }
+  sync();
+  ::close(fd);
+  fd = -1;
+  return true;
+}
+
+bool FsFile::isOpen() const
+{
+  return fd >= 0 || dir != nullptr;
+}
+
+bool FsFile::isDir() const
+{
+  return dir != nullptr;
+}
+
+FsFile::operator bool() const
+{
+  return isOpen();
+}
+
+int FsFile::available()
+{
+  uint32_t size = fileSize();
+  return position < size ? (int)(size - position) : 0;
+}
+
+int FsFile::read()
+{
+  uint8_t b;
+  return read(&b, 1) == 1 ? b : -1;
+}
+
+int FsFile::peek()
+{
+  uint8_t b;
+  if (fd < 0 || pread(fd, &b, 1, position) != 1)
+  {
+    return -1;
+  }
+  return b;
+}
+
+int FsFile::read(void *buffer, size_t count)
+{
+  if (fd < 0)
+  {
+    return -1;
+  }
+  ssize_t n = pread(fd, buffer, count, position);
+  if (n < 0)
+  {
+    return -1;
+  }
+  if (n > 0)
+  {
+    uint32_t first = position / SECTOR_SIZE;
+    uint32_t last = (position + n - 1) / SECTOR_SIZE;
+    uint32_t sectors = last - first + 1;
+    if ((int64_t)first == cachedSector)
+    {
+      sectors--; // Already in the cache
+    }
+    if (sectors > 0)
+    {
+      flushCache();
+      FakeCard::chargeRead(sectors);
+      cachedSector = last;
+    }
+  }
+  position += n;
+  return (int)n;
+}
+
+int FsFile::fgets(char *line, int size)
+{
+  int n = 0;
+  while (n < size - 1)
+  {
+    int c = read();
+    if (c < 0)
+    {
+      break;
+    }
+    line[n++] = (char)c;
+    if (c == '\n')
+    {
+      break;
+    }
+  }
+  line[n] = '\0';
+  return n;
+}
+
+size_t FsFile::write(uint8_t b)
+{
+  return write(&b, 1);
+}
+
+size_t FsFile::write(const void *buffer, size_t size)
+{
+  return write((const uint8_t *)buffer, size);
+}
+
+size_t FsFile::write(const uint8_t *buffer, size_t size)
+{
+  if (fd < 0 || size == 0 || FakeCard::refuse())
+  {
+    return 0;
+  }
+  if (isAppend)
+  {
+    position = fileSize();
+  }
+  uint32_t sizeBefore = fileSize();
+  ssize_t n = pwrite(fd, buffer, size, position);
+  if (n <= 0)
+  {
+    return 0;
+  }
+  account(position, n, sizeBefore);
+  cardStats.bytesWritten += n;
+  position += n;
+  return n;
+}
+
+// SdFat writes whole aligned sectors straight to the card and sends
+// partial ones through its one-sector cache (read-modify-write, without
+// the read past the end of the file)
+void FsFile::account(uint32_t start, uint32_t count, uint32_t sizeBefore)
+{
+  uint32_t end = start + count;
+  uint32_t run = 0;
+  uint32_t runStart = 0;
+  for (uint32_t sector = start / SECTOR_SIZE; sector * SECTOR_SIZE < end; sector++)
+  {
+    uint32_t sectorStart = sector * SECTOR_SIZE;
+    if (sectorStart >= start && sectorStart + SECTOR_SIZE <= end)
+    {
+      if ((int64_t)sector == cachedSector)
+      {
+        cachedSector = -1;
+        isCacheDirty = false;
+      }
+      runStart = run == 0 ? sector : runStart;
+      run++;
+      continue;
+    }
+
+    FakeCard::chargeWrite(run, address(runStart));
+    run = 0;
+    if ((int64_t)sector != cachedSector)
+    {
+      flushCache();
+      if (sectorStart < sizeBefore)
+      {
+        FakeCard::chargeRead(1);
+      }
+      cachedSector = sector;
+    }
+    isCacheDirty = true;
+    FakeCard::countPartialWrite();
+  }
+  FakeCard::chargeWrite(run, address(runStart));
+}
+
+uint64_t FsFile::address(uint32_t sector) const
+{
+  return ((uint64_t)fd << 32) | sector;
+}
+
+void FsFile::flushCache()
+{
+  if (isCacheDirty)
+  {
+    FakeCard::chargeWrite(1, address(cachedSector));
+    isCacheDirty = false;
+  }
+}
+
+bool FsFile::seekSet(uint32_t newPosition)
+{
+  if (fd < 0)
+  {
+    return false;
+  }
+  position = newPosition;
+  return true;
+}
+
+bool FsFile::seekEnd(int32_t offset)
+{
+  return seekSet(fileSize() + offset);
+}
+
+uint32_t FsFile::curPosition() const
+{
+  return position;
+}
+
+uint32_t FsFile::fileSize() const
+{
+  struct stat info;
+  if (fd < 0 || fstat(fd, &info) != 0)
+  {
+    return 0;
+  }
+  return (uint32_t)info.st_size;
+}
+
+bool FsFile::sync()
+{
+  if (fd < 0 || FakeCard::refuse())
+  {
+    return false;
+  }
+  // Cached data sector, then the directory entry with the new size
+  flushCache();
+  FakeCard::chargeRead(1);
+  FakeCard::chargeWrite(1);
+  return true;
+}
+
+bool FsFile::truncate(uint32_t length)
+{
+  if (fd < 0 || ftruncate(fd, length) != 0)
+  {
+    return false;
+  }
+  if (position > length)
+  {
+    position = length;
+  }
+  return true;
+}
+
+bool FsFile::truncate()
+{
+  return truncate(position);
+}
+
+bool FsFile::preAllocate(uint32_t length)
+{
+  // As on FAT: contiguous clusters and a file size of length
+  if (fd < 0 || fileSize() != 0 || ftruncate(fd, length) != 0)
+  {
+    return false;
+  }
+  FakeCard::chargeWrite(1 + length / (SECTOR_SIZE * 128)); // FAT sectors
+  return true;
+}
+
+bool FsFile::rename(const char *newPath)
+{
+  if (fd < 0 || ::rename(FakeCard::path(name.c_str()).c_str(), FakeCard::path(newPath).c_str()) != 0)
+  {
+    return false;
+  }
+  FakeCard::chargeWrite(1);
+  name = newPath;
+  return true;
+}
+
+bool FsFile::remove()
+{
+  if (fd < 0)
+  {
+    return false;
+  }
+  std::string hostPath = FakeCard::path(name.c_str());
+  ::close(fd);
+  fd = -1;
+  isCacheDirty = false;
+  FakeCard::chargeWrite(1);
+  return unlink(hostPath.c_str()) == 0;
+}
+
+bool FsFile::getModifyDateTime(uint16_t *date, uint16_t *time)
+{
+  struct stat info;
+  if (fd < 0 || fstat(fd, &info) != 0)
+  {
+    return false;
+  }
+  // FAT directory entry format: 2-second resolution, years from 1980
+  struct tm local;
+  localtime_r(&info.st_mtime, &local);
+  *date = (uint16_t)(((local.tm_year - 80) << 9) | ((local.tm_mon + 1) << 5) | local.tm_mday);
+  *time = (uint16_t)((local.tm_hour << 11) | (local.tm_min << 5) | (local.tm_sec >> 1));
+  return true;
+}
+
+bool FsFile::getName(char *buffer, size_t size)
+{
+  if (!isOpen() || size == 0)
+  {
+    return false;
+  }
+  size_t slash = name.find_last_of('/');
+  std::string base = slash == std::string::npos ? name : name.substr(slash + 1);
+  if (base.size() >= size)
+  {
+    return false;
+  }
+  strcpy(buffer, base.c_str());
+  return true;
+}
+
+// ========== SdFat ==========
+
+SdFat::SdFat() : isMounted(false)
+{
+}
+
+bool SdFat::begin(uint8_t csPin, uint32_t maxSck)
+{
+  return begin(SdSpiConfig(csPin, SHARED_SPI, maxSck));
+}
+
+bool SdFat::begin(SdSpiConfig config)
+{
+  FakeCard::spiKHz = config.maxSck / 1000;
+  FakeCard::isDedicated = config.options == DEDICATED_SPI;
+  ::mkdir(FakeCard::root().c_str(), 0755);
+
+  struct stat info;
+  isMounted = !FakeCard::refuse() && stat(FakeCard::root().c_str(), &info) == 0 && S_ISDIR(info.st_mode);
+  return isMounted;
+}
+
+void SdFat::end()
+{
+  isMounted = false;
+}
+
+bool SdFat::exists(const char *path)
+{
+  FakeCard::chargeRead(1);
+  return access(FakeCard::path(path).c_str(), F_OK) == 0;
+}
+
+bool SdFat::remove(const char *path)
+{
+  FakeCard::chargeWrite(1);
+  return unlink(FakeCard::path(path).c_str()) == 0;
+}
+
+bool SdFat::rename(const char *oldPath, const char *newPath)
+{
+  FakeCard::chargeWrite(1);
+  return ::rename(FakeCard::path(oldPath).c_str(), FakeCard::path(newPath).c_str()) == 0;
+}
+
+bool SdFat::mkdir(const char *path)
+{
+  FakeCard::chargeWrite(1);
+  return ::mkdir(FakeCard::path(path).c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+uint8_t SdFat::fatType() const
+{
+  return isMounted ? 32 : FAT_TYPE_NONE;
+}
+
+SdCard *SdFat::card()
+{
+  return &sdCard;
+}
+
+uint32_t SdFat::freeClusterCount()
+{
+  return FakeCard::sectorCount / 64;
+}
+
+uint32_t SdFat::bytesPerCluster()
+{
+  return 32768;
+}
+
+int SdFat::sdErrorCode()
+{
+  return 0;
+}
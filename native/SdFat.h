@@ -0,0 +1,238 @@
+#ifndef NATIVE_SDFAT_H
+#define NATIVE_SDFAT_H
+
+// Host (Linux) stand-in for the subset of SdFat used by the firmware.
+// Files live in a directory of the host (FakeCard::setRoot), and every
+// card access is charged a latency from FakeCardModel by busy-waiting, so
+// micros() around a write measures what a card with that behaviour would
+// cost.
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <string>
+
+#include "Arduino.h"
+
+#define SD_SCK_MHZ(maxMhz) (1000000UL * (maxMhz))
+#define SHARED_SPI 0
+#define DEDICATED_SPI 1
+
+#define O_READ O_RDONLY
+#define O_WRITE O_WRONLY
+#define O_AT_END O_APPEND
+
+#define FAT_TYPE_NONE 0
+
+struct SdSpiConfig
+{
+  SdSpiConfig(uint8_t csPin, uint8_t options, uint32_t maxSck) : csPin(csPin), options(options), maxSck(maxSck) {}
+  SdSpiConfig(uint8_t csPin, uint8_t options) : SdSpiConfig(csPin, options, SD_SCK_MHZ(50)) {}
+  uint8_t csPin;
+  uint8_t options;
+  uint32_t maxSck;
+};
+
+/// FakeCardModel
+/// @brief Latency of the fake card, in microseconds. The SPI transfer of
+/// each sector is added on top, from the clock passed to SdFat::begin().
+///
+struct FakeCardModel
+{
+  uint32_t commandUs = 0;     // Fixed cost of a card command (select, command, response)
+  uint32_t sectorReadUs = 0;  // Card time per 512-byte sector read
+  uint32_t sectorWriteUs = 0; // Card time per sector of a single-block write
+  uint32_t burstSectorUs = 0; // Card time per further sector of a multi-block write
+  uint32_t stallEvery = 0;    // Sectors written between garbage-collection stalls, 0 = never
+  uint32_t stallUs = 0;       // Length of one stall
+};
+
+/// FakeCardStats
+/// @brief Traffic seen by the fake card
+///
+struct FakeCardStats
+{
+  uint32_t commands;
+  uint32_t sectorsRead;
+  uint32_t sectorsWritten;
+  uint32_t partialWrites; // Read-modify-write of a sector
+  uint32_t stalls;
+  uint64_t busyUs;
+  uint64_t bytesWritten;  // Data written by the firmware, before sector rounding
+  uint32_t filesCreated;
+  uint32_t failures;      // Operations refused while the card was failing
+  uint32_t interruptAccesses; // Card operations issued from an interrupt (must stay 0)
+};
+
+/// cid_t / csd_t / sds_t
+/// @brief Raw card registers, as SdFat returns them
+struct cid_t
+{
+  uint8_t mid;
+  char oid[2];
+  char pnm[5];
+  uint8_t prv;
+  uint32_t psn;
+  uint16_t mdt;
+  uint8_t crc;
+};
+
+struct csd_t
+{
+  uint8_t csd[16];
+};
+
+struct sds_t
+{
+  uint8_t busWidthSecureMode;
+  uint8_t reserved1;
+  uint8_t sdCardType[2];
+  uint8_t sizeOfProtectedArea[4];
+  uint8_t speedClass; // 0..4 = class 0, 2, 4, 6, 10
+  uint8_t performanceMove;
+  uint8_t auSize;
+  uint8_t reserved2[49];
+};
+
+/// FakeCard
+/// @brief Root directory, latency model and registers of the fake card
+///
+class FakeCard
+{
+public:
+  static void setRoot(const char *path);
+  static const std::string &root();
+  static std::string path(const char *name);
+
+  static void setModel(const FakeCardModel &model);
+  static const FakeCardModel &model();
+  static void setRegisters(const cid_t &cid, const csd_t &csd, uint32_t sectors);
+
+  static const FakeCardStats &stats();
+  static void resetStats();
+
+  /// setFailing
+  /// @brief Card removed or dead: begin(), open(), write() and sync() fail
+  ///        until it is cleared (files already open stay open)
+  static void setFailing(bool isFailing);
+  static bool isFailing();
+
+  /// Charges card time for sectors written (a multi-block write when the
+  /// SPI bus is dedicated, continued if address follows the previous
+  /// write), sectors read, or a bare command
+  static void chargeWrite(uint32_t sectors, uint64_t address = UINT64_MAX);
+  static void chargeRead(uint32_t sectors);
+  static void chargeCommand();
+  static void countPartialWrite();
+  static bool refuse(); // True (and counted) while failing
+
+  // Set by SdFat::begin(), used by SdCard
+  static cid_t cid;
+  static csd_t csd;
+  static sds_t sds;
+  static uint32_t sectorCount;
+  static uint32_t spiKHz;
+  static bool isDedicated;
+
+private:
+  static void wait(uint64_t us);
+};
+
+/// SdCard
+/// @brief Card-level access of SdFat (registers, raw sectors)
+///
+class SdCard
+{
+public:
+  bool readCID(cid_t *cid);
+  bool readCSD(csd_t *csd);
+  bool readSDS(sds_t *sds);
+  uint32_t sectorCount();
+  uint8_t type();
+  bool isBusy();
+};
+
+/// FsFile
+/// @brief Host file or directory with the SdFat file API
+///
+class FsFile : public Stream
+{
+public:
+  FsFile();
+  FsFile(const FsFile &) = delete;
+  FsFile &operator=(const FsFile &) = delete;
+  ~FsFile();
+
+  bool open(const char *path, int oflag = O_RDONLY);
+  bool openNext(FsFile *directory, int oflag = O_RDONLY);
+  bool close();
+  bool isOpen() const;
+  bool isDir() const;
+  operator bool() const;
+
+  int available() override;
+  int read() override;
+  int peek() override;
+  int read(void *buffer, size_t count);
+  int fgets(char *line, int size);
+
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  size_t write(const void *buffer, size_t size);
+  using Print::write;
+
+  bool seekSet(uint32_t position);
+  bool seekEnd(int32_t offset = 0);
+  uint32_t curPosition() const;
+  uint32_t fileSize() const;
+  bool sync();
+  bool truncate(uint32_t length);
+  bool truncate();
+  bool preAllocate(uint32_t length);
+  bool rename(const char *newPath);
+  bool remove();
+  bool getName(char *name, size_t size);
+  bool getModifyDateTime(uint16_t *date, uint16_t *time);
+
+private:
+  void account(uint32_t start, uint32_t count, uint32_t sizeBefore);
+  void flushCache();
+  uint64_t address(uint32_t sector) const;
+
+  int fd;
+  DIR *dir;
+  std::string name;
+  uint32_t position;
+  bool isAppend;
+  int64_t cachedSector; // Sector held in SdFat's cache, -1 if none
+  bool isCacheDirty;
+};
+
+typedef FsFile SdFile;
+typedef FsFile File32;
+
+/// SdFat
+/// @brief Volume of the fake card
+///
+class SdFat
+{
+public:
+  SdFat();
+  bool begin(uint8_t csPin, uint32_t maxSck);
+  bool begin(SdSpiConfig config);
+  void end();
+  bool exists(const char *path);
+  bool remove(const char *path);
+  bool rename(const char *oldPath, const char *newPath);
+  bool mkdir(const char *path);
+  uint8_t fatType() const;
+  SdCard *card();
+  uint32_t freeClusterCount();
+  uint32_t bytesPerCluster();
+  int sdErrorCode();
+
+private:
+  SdCard sdCard;
+  bool isMounted;
+};
+
+#endif // NATIVE_SDFAT_H
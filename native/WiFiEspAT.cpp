@@ -0,0 +1,229 @@
+#include "WiFiEspAT.h"
+
+#include <vector>
+
+struct Outage
+{
+  uint32_t startMs;
+  uint32_t durationMs;
+};
+
+static Client *serverClient = nullptr;
+static uint32_t joinTime = 1500; // AT+CWJAP on a typical AP
+static int32_t signalDbm = -58;
+static std::vector<Outage> outages;
+
+WiFiClass WiFi;
+
+// ========== FakeWiFi ==========
+
+void FakeWiFi::setServer(Client *server)
+{
+  serverClient = server;
+}
+
+void FakeWiFi::setJoinMs(uint32_t ms)
+{
+  joinTime = ms;
+}
+
+void FakeWiFi::setRssi(int32_t dBm)
+{
+  signalDbm = dBm;
+}
+
+void FakeWiFi::addOutage(uint32_t startMs, uint32_t durationMs)
+{
+  outages.push_back({startMs, durationMs});
+}
+
+bool FakeWiFi::isLinkUp()
+{
+  uint32_t now = millis();
+  for (const Outage &outage : outages)
+  {
+    if (now - outage.startMs < outage.durationMs)
+    {
+      return false;
+    }
+  }
+  return true;
+}
+
+Client *FakeWiFi::server()
+{
+  return serverClient;
+}
+
+uint32_t FakeWiFi::joinMs()
+{
+  return joinTime;
+}
+
+int32_t FakeWiFi::rssi()
+{
+  return signalDbm;
+}
+
+// ========== WiFiClass ==========
+
+WiFiClass::WiFiClass() : isJoined(false)
+{
+}
+
+bool WiFiClass::init(Stream &serial, int8_t resetPin)
+{
+  (void)serial;
+  (void)resetPin;
+  return true;
+}
+
+uint8_t WiFiClass::begin(const char *ssid, const char *password)
+{
+  (void)password;
+  delay(FakeWiFi::joinMs());
+  isJoined = ssid && ssid[0] != '\0' && FakeWiFi::isLinkUp();
+  return isJoined ? WL_CONNECTED : WL_CONNECT_FAILED;
+}
+
+uint8_t WiFiClass::status()
+{
+  if (!isJoined)
+  {
+    return WL_DISCONNECTED;
+  }
+  if (!FakeWiFi::isLinkUp())
+  {
+    isJoined = false; // The ESP drops the association
+    return WL_CONNECTION_LOST;
+  }
+  return WL_CONNECTED;
+}
+
+int WiFiClass::disconnect()
+{
+  isJoined = false;
+  return WL_DISCONNECTED;
+}
+
+IPAddress WiFiClass::localIP()
+{
+  return isJoined ? IPAddress(192, 168, 1, 50) : IPAddress();
+}
+
+IPAddress WiFiClass::gatewayIP()
+{
+  return isJoined ? IPAddress(192, 168, 1, 1) : IPAddress();
+}
+
+IPAddress WiFiClass::dnsIP(int index)
+{
+  (void)index;
+  return gatewayIP();
+}
+
+int32_t WiFiClass::RSSI()
+{
+  return isJoined ? FakeWiFi::rssi() : 0;
+}
+
+bool WiFiClass::setPersistent(bool isPersistent)
+{
+  (void)isPersistent;
+  return true;
+}
+
+bool WiFiClass::setAutoConnect(bool isAutoConnect)
+{
+  (void)isAutoConnect;
+  return true;
+}
+
+// ========== WiFiClient ==========
+
+Client *WiFiClient::link()
+{
+  Client *server = FakeWiFi::server();
+  if (server && !FakeWiFi::isLinkUp())
+  {
+    server->stop(); // The TCP connection dies with the AP
+  }
+  return server;
+}
+
+int WiFiClient::connect(IPAddress ip, uint16_t port)
+{
+  Client *server = link();
+  return server && WiFi.status() == WL_CONNECTED ? server->connect(ip, port) : 0;
+}
+
+int WiFiClient::connect(const char *host, uint16_t port)
+{
+  Client *server = link();
+  return server && WiFi.status() == WL_CONNECTED ? server->connect(host, port) : 0;
+}
+
+size_t WiFiClient::write(uint8_t b)
+{
+  return write(&b, 1);
+}
+
+size_t WiFiClient::write(const uint8_t *buffer, size_t size)
+{
+  Client *server = link();
+  return server ? server->write(buffer, size) : 0;
+}
+
+int WiFiClient::available()
+{
+  Client *server = link();
+  return server ? server->available() : 0;
+}
+
+int WiFiClient::read()
+{
+  Client *server = link();
+  return server ? server->read() : -1;
+}
+
+int WiFiClient::read(uint8_t *buffer, size_t size)
+{
+  Client *server = link();
+  return server ? server->read(buffer, size) : -1;
+}
+
+int WiFiClient::peek()
+{
+  Client *server = link();
+  return server ? server->peek() : -1;
+}
+
+void WiFiClient::flush()
+{
+  Client *server = link();
+  if (server)
+  {
+    server->flush();
+  }
+}
+
+void WiFiClient::stop()
+{
+  Client *server = FakeWiFi::server();
+  if (server)
+  {
+    server->stop();
+  }
+}
+
+uint8_t WiFiClient::connected()
+{
+  Client *server = link();
+  return server ? server->connected() : 0;
+}
+
+WiFiClient::operator bool()
+{
+  Client *server = link();
+  return server && (bool)*server;
+}
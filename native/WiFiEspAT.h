@@ -0,0 +1,88 @@
+#ifndef NATIVE_WIFIESPAT_H
+#define NATIVE_WIFIESPAT_H
+
+#include "Arduino.h"
+#include "Client.h"
+
+#define WL_IDLE_STATUS 0
+#define WL_NO_SSID_AVAIL 1
+#define WL_CONNECTED 3
+#define WL_CONNECT_FAILED 4
+#define WL_CONNECTION_LOST 5
+#define WL_DISCONNECTED 6
+#define WL_NO_MODULE 255
+
+/// FakeWiFi
+/// @brief Link behind the host WiFi and WiFiClient. Joining the AP takes
+/// joinMs (WiFi.begin() blocks like the AT command, with interrupts
+/// serviced); during an outage the AP is gone, joins fail and open
+/// connections drop. WiFiClient connects to the Client given to
+/// setServer(): FakeBroker, or PosixClient for a real broker.
+///
+class FakeWiFi
+{
+public:
+  static void setServer(Client *server);
+  static void setJoinMs(uint32_t ms);
+  static void setRssi(int32_t dBm);
+
+  /// addOutage
+  /// @brief AP unreachable from startMs (millis()) for durationMs
+  static void addOutage(uint32_t startMs, uint32_t durationMs);
+
+  static bool isLinkUp();
+  static Client *server();
+  static uint32_t joinMs();
+  static int32_t rssi();
+};
+
+/// WiFiClass
+/// @brief Host version of the WiFiEspAT WiFi object
+///
+class WiFiClass
+{
+public:
+  WiFiClass();
+
+  bool init(Stream &serial, int8_t resetPin = -1);
+  uint8_t begin(const char *ssid, const char *password);
+  uint8_t status();
+  int disconnect();
+  IPAddress localIP();
+  IPAddress gatewayIP();
+  IPAddress dnsIP(int index = 0);
+  int32_t RSSI();
+  bool setPersistent(bool isPersistent = true);
+  bool setAutoConnect(bool isAutoConnect);
+
+private:
+  bool isJoined;
+};
+
+extern WiFiClass WiFi;
+
+/// WiFiClient
+/// @brief TCP connection through the fake link to FakeWiFi::server()
+///
+class WiFiClient : public Client
+{
+public:
+  int connect(IPAddress ip, uint16_t port) override;
+  int connect(const char *host, uint16_t port) override;
+  size_t write(uint8_t b) override;
+  size_t write(const uint8_t *buffer, size_t size) override;
+  int available() override;
+  int read() override;
+  int read(uint8_t *buffer, size_t size) override;
+  int peek() override;
+  void flush() override;
+  void stop() override;
+  uint8_t connected() override;
+  operator bool() override;
+  using Print::write;
+
+private:
+  Client *link();
+};
+
+#endif // NATIVE_WIFIESPAT_H
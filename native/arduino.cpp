@@ -0,0 +1,348 @@
+// Host implementation of the Arduino core subset declared in Arduino.h
+
+#include "Arduino.h"
+#include "IPAddress.h"
+
+#include <stdarg.h>
+#include <time.h>
+
+static uint64_t monotonicMicros()
+{
+  static struct timespec start;
+  static bool isStarted = false;
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  if (!isStarted)
+  {
+    start = now;
+    isStarted = true;
+  }
+  return (uint64_t)(now.tv_sec - start.tv_sec) * 1000000 + (now.tv_nsec - start.tv_nsec) / 1000;
+}
+
+static bool isVirtual = false;
+static uint64_t virtualNow = 0;
+
+uint64_t hostMicros()
+{
+  if (isVirtual)
+  {
+    virtualNow += VIRTUAL_READ_US;
+    return virtualNow;
+  }
+  return monotonicMicros();
+}
+
+void setVirtualTime(bool isEnabled)
+{
+  if (isEnabled && !isVirtual)
+  {
+    virtualNow = monotonicMicros(); // No jump back for what already read the clock
+  }
+  isVirtual = isEnabled;
+}
+
+bool isVirtualTime()
+{
+  return isVirtual;
+}
+
+void advanceVirtualTime(uint64_t us)
+{
+  if (isVirtual)
+  {
+    virtualNow += us;
+  }
+}
+
+uint32_t millis()
+{
+  return (uint32_t)(hostMicros() / 1000);
+}
+
+uint32_t micros()
+{
+  return (uint32_t)hostMicros();
+}
+
+void delay(uint32_t ms)
+{
+  // On the board interrupts keep running during delay()
+  uint32_t start = millis();
+  while (millis() - start < ms)
+  {
+    delayMicroseconds(1000);
+    serviceInterrupts();
+  }
+}
+
+void delayMicroseconds(uint32_t us)
+{
+  if (isVirtual)
+  {
+    advanceVirtualTime(us);
+    return;
+  }
+  struct timespec wait = {(time_t)(us / 1000000), (long)(us % 1000000) * 1000};
+  nanosleep(&wait, nullptr);
+}
+
+void yield()
+{
+}
+
+// ========== GPIO ==========
+
+static uint8_t pinModes[NUM_DIGITAL_PINS];
+static uint8_t pinLevels[NUM_DIGITAL_PINS];
+
+void pinMode(uint32_t pin, uint32_t mode)
+{
+  if (pin < NUM_DIGITAL_PINS)
+  {
+    pinModes[pin] = (uint8_t)mode;
+    if (mode == INPUT_PULLUP)
+    {
+      pinLevels[pin] = HIGH;
+    }
+  }
+}
+
+void digitalWrite(uint32_t pin, uint32_t value)
+{
+  if (pin < NUM_DIGITAL_PINS)
+  {
+    pinLevels[pin] = value ? HIGH : LOW;
+  }
+}
+
+int digitalRead(uint32_t pin)
+{
+  return pin < NUM_DIGITAL_PINS ? pinLevels[pin] : LOW;
+}
+
+static void (*edgeCallbacks[NUM_DIGITAL_PINS])();
+static uint8_t edgeModes[NUM_DIGITAL_PINS];
+static bool isEdgePending[NUM_DIGITAL_PINS];
+
+static void pollEdges()
+{
+  for (uint32_t pin = 0; pin < NUM_DIGITAL_PINS; pin++)
+  {
+    if (isEdgePending[pin])
+    {
+      isEdgePending[pin] = false;
+      if (edgeCallbacks[pin] != nullptr)
+      {
+        edgeCallbacks[pin]();
+      }
+    }
+  }
+}
+
+void attachInterrupt(uint32_t pin, void (*callback)(), uint32_t mode)
+{
+  if (pin < NUM_DIGITAL_PINS)
+  {
+    edgeCallbacks[pin] = callback;
+    edgeModes[pin] = (uint8_t)mode;
+    isEdgePending[pin] = false;
+    addInterruptSource(pollEdges);
+  }
+}
+
+void detachInterrupt(uint32_t pin)
+{
+  if (pin < NUM_DIGITAL_PINS)
+  {
+    edgeCallbacks[pin] = nullptr;
+    isEdgePending[pin] = false;
+  }
+}
+
+void setPinInput(uint32_t pin, uint32_t level)
+{
+  if (pin >= NUM_DIGITAL_PINS)
+  {
+    return;
+  }
+  uint8_t previous = pinLevels[pin];
+  pinLevels[pin] = level ? HIGH : LOW;
+  if (pinLevels[pin] == previous || edgeCallbacks[pin] == nullptr)
+  {
+    return;
+  }
+  bool isRising = pinLevels[pin] == HIGH;
+  uint8_t mode = edgeModes[pin];
+  if (mode == CHANGE || (mode == RISING && isRising) || (mode == FALLING && !isRising))
+  {
+    isEdgePending[pin] = true; // Like the EXTI pending bit: edges while pending merge into one
+    serviceInterrupts();
+  }
+}
+
+// ========== Interrupts ==========
+
+static constexpr uint8_t MAX_INTERRUPT_SOURCES = 8;
+static void (*interruptSources[MAX_INTERRUPT_SOURCES])();
+static uint8_t interruptSourceCount = 0;
+static bool isMasked = false;
+static bool isInInterrupt = false;
+
+void noInterrupts()
+{
+  isMasked = true;
+}
+
+void interrupts()
+{
+  isMasked = false;
+  serviceInterrupts(); // What became pending while masked runs now
+}
+
+void serviceInterrupts()
+{
+  if (isMasked || isInInterrupt)
+  {
+    return; // No nesting: all sources share one priority
+  }
+  isInInterrupt = true;
+  for (uint8_t i = 0; i < interruptSourceCount; i++)
+  {
+    interruptSources[i]();
+  }
+  isInInterrupt = false;
+}
+
+void addInterruptSource(void (*poll)())
+{
+  for (uint8_t i = 0; i < interruptSourceCount; i++)
+  {
+    if (interruptSources[i] == poll)
+    {
+      return;
+    }
+  }
+  if (interruptSourceCount < MAX_INTERRUPT_SOURCES)
+  {
+    interruptSources[interruptSourceCount++] = poll;
+  }
+}
+
+bool isInterruptContext()
+{
+  return isInInterrupt;
+}
+
+long random(long howbig)
+{
+  return howbig <= 0 ? 0 : rand() % howbig;
+}
+
+long random(long howsmall, long howbig)
+{
+  return howsmall >= howbig ? howsmall : howsmall + random(howbig - howsmall);
+}
+
+void randomSeed(unsigned long seed)
+{
+  srand((unsigned)seed);
+}
+
+char *ltoa(long value, char *str, int base)
+{
+  if (base == 10)
+  {
+    sprintf(str, "%ld", value);
+  }
+  else
+  {
+    sprintf(str, base == 16 ? "%lx" : "%lo", (unsigned long)value);
+  }
+  return str;
+}
+
+char *itoa(int value, char *str, int base)
+{
+  return ltoa(value, str, base);
+}
+
+char *utoa(unsigned value, char *str, int base)
+{
+  sprintf(str, base == 16 ? "%x" : "%u", value);
+  return str;
+}
+
+char *dtostrf(double value, signed char width, unsigned char decimals, char *str)
+{
+  sprintf(str, "%*.*f", width, decimals, value);
+  return str;
+}
+
+// ========== Print / Stream ==========
+
+size_t Print::print(long value, int base)
+{
+  char text[24];
+  return write(ltoa(value, text, base));
+}
+
+size_t Print::print(unsigned long value, int base)
+{
+  char text[24];
+  sprintf(text, base == 16 ? "%lx" : "%lu", value);
+  return write(text);
+}
+
+size_t Print::print(double value, int decimals)
+{
+  char text[40];
+  snprintf(text, sizeof(text), "%.*f", decimals, value);
+  return write(text);
+}
+
+int Print::printf(const char *format, ...)
+{
+  char text[256];
+  va_list args;
+  va_start(args, format);
+  int n = vsnprintf(text, sizeof(text), format, args);
+  va_end(args);
+  write(text);
+  return n;
+}
+
+size_t Stream::readBytes(char *buffer, size_t length)
+{
+  size_t count = 0;
+  uint32_t start = millis();
+  while (count < length && millis() - start < timeout)
+  {
+    int c = read();
+    if (c >= 0)
+    {
+      buffer[count++] = (char)c;
+    }
+  }
+  return count;
+}
+
+// ========== IPAddress ==========
+
+bool IPAddress::fromString(const char *text)
+{
+  unsigned parts[4];
+  if (sscanf(text, "%u.%u.%u.%u", &parts[0], &parts[1], &parts[2], &parts[3]) != 4)
+  {
+    return false;
+  }
+  for (int i = 0; i < 4; i++)
+  {
+    if (parts[i] > 255)
+    {
+      return false;
+    }
+    address[i] = (uint8_t)parts[i];
+  }
+  return true;
+}
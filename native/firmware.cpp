@@ -0,0 +1,522 @@
+/* Host runner of the firmware (env:native)
+ * src/main.cpp and the libraries build unchanged against the fakes of
+ * this directory and run as a Linux process: setup() once, then loop()
+ * with the TIM3 (readings), TIM6 (control) and button interrupts serviced
+ * between passes. The SD card is a host
+ * directory, the DHT11 follows a script, the RTC counts from the host
+ * clock and the ESP8266 link ends in an in-process MQTT broker (or a real
+ * one). At the end the traffic seen by the broker is summarised.
+ *
+ * With virtual=1 the clock is virtual (see Arduino.h): after each pass it
+ * jumps to the next timer event, at most step_ms ahead, or LOOP_PASS_US
+ * while the broker has bytes the firmware has not read yet. Weeks of
+ * operation run in minutes and, with the same arguments, always the same
+ * way. The console is muted and one line per report interval shows SD
+ * bytes and files, message counts, backlog, heap and the per-tick cost:
+ * virtual time (latency of the fakes: card, DHT read) and host CPU.
+ *
+ * Build and run:
+ *   pio run -e native
+ *   .pio/build/native/program [root=sdcard] [seconds=30 | days=N] [sensors=FILE]
+ *       [outage=START:DURATION]... [broker_down=START:DURATION]...
+ *       [sd_fail=START:DURATION]... [broker=real] [echo=1]
+ *       [virtual=1] [step_ms=1000] [report=1d] [console=1] [room=AMBIENT[:LOAD]]
+ *       [press=[N@]START:DURATION]...
+ *
+ * Times are milliseconds from boot, or take a unit: 90s, 15m, 6h, 3d.
+ * sensors:     "<ms> <°C> <%RH>" lines (see FakeDht in DHT.h).
+ * outage:      the AP disappears for a while.
+ * broker_down: the in-process broker drops the session and refuses CONNECT.
+ * sd_fail:     the card stops answering (FakeCard::setFailing()).
+ * broker:      "real" dials the broker of config.json over TCP (PosixClient)
+ *              instead of using the in-process one (real time only).
+ * echo:        print every message the in-process broker receives.
+ * console:     keep the firmware's serial output in virtual time.
+ * room:        closed loop: the DHT reads the room of RoomModel.h, starting
+ *              at AMBIENT °C, cooled by the relay on COOLING_PIN (LOAD °C
+ *              of equipment heat). Replaces the sensor script.
+ * press:       button N of BUTTON_PINS (1, the default, is B1) held down
+ *              for DURATION, with contact bounce on the press and the release.
+ * Faults may be repeated.
+ */
+#include <Arduino.h>
+#include <DHT.h>
+#include <SdFat.h>
+#include <WiFiEspAT.h>
+#include <signal.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "FakeBroker.h"
+#include "PosixClient.h"
+#include "RoomModel.h"
+#include "alarmEngine.hpp"
+#include "backlog.hpp"
+#include "buttonInput.hpp"
+#include "connect.hpp"
+#include "coolingControl.hpp"
+#include "memstats.hpp"
+#include "outbound.hpp"
+
+void setup();
+void loop();
+extern Backlog backlog;
+extern AlarmEngine alarms;
+extern ControlTiming controlTiming;
+extern CoolingController cooling;
+extern ButtonDebouncer buttons;
+
+static constexpr uint32_t LOOP_SLEEP_US = 100; // Real time: host CPU left alone between passes
+static constexpr uint32_t LOOP_PASS_US = 100;  // Virtual time: one loop() pass with work in progress
+static constexpr uint64_t DAY_MS = 86400000ULL;
+
+struct Fault
+{
+  uint64_t startMs;
+  uint64_t durationMs;
+};
+
+/// Level change of a simulated button pin, from boot
+struct PinEdge
+{
+  uint64_t atUs;
+  uint32_t pin;
+  uint32_t level;
+};
+
+// Contact bounce of a press or a release: the level flips at these offsets
+// (us) and stays at the new level after the last one
+static constexpr uint32_t BOUNCE_US[] = {0, 300, 900, 1600, 2500};
+
+/// Per-tick cost over one report interval
+struct TickStats
+{
+  uint32_t ticks;
+  uint64_t clockUs;
+  uint64_t maxClockUs;
+  uint64_t cpuNs;
+  uint64_t maxCpuNs;
+};
+
+static volatile sig_atomic_t isStopping = 0;
+static FakeBroker broker;
+static RoomModel room;
+static bool isRoom = false;
+static PosixClient realBroker;
+static std::vector<Fault> brokerFaults;
+static std::vector<Fault> cardFaults;
+static std::vector<PinEdge> pinEdges; // Sorted by time before setup()
+static size_t nextPinEdge = 0;
+static TickStats window;
+static TickStats lifetime;
+static uint32_t heapPeak = 0; // Blocks allocated and not freed
+static FILE *reportOut = stdout;
+
+static void onSignal(int)
+{
+  isStopping = 1;
+}
+
+static bool option(const char *argument, const char *name, const char **value)
+{
+  size_t length = strlen(name);
+  if (strncmp(argument, name, length) != 0 || argument[length] != '=')
+  {
+    return false;
+  }
+  *value = argument + length + 1;
+  return true;
+}
+
+// "250", "90s", "15m", "6h", "3d" -> milliseconds
+static bool parseTime(const char *text, uint64_t &ms)
+{
+  char *end;
+  double value = strtod(text, &end);
+  static const struct
+  {
+    char unit;
+    uint64_t ms;
+  } UNITS[] = {{'\0', 1}, {'s', 1000}, {'m', 60000}, {'h', 3600000}, {'d', DAY_MS}};
+  for (const auto &unit : UNITS)
+  {
+    if (end != text && value >= 0 && *end == unit.unit && (unit.unit == '\0' || end[1] == '\0'))
+    {
+      ms = (uint64_t)(value * unit.ms);
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool parseFault(const char *text, Fault &fault)
+{
+  const char *colon = strchr(text, ':');
+  if (!colon)
+  {
+    return false;
+  }
+  std::string start(text, colon - text);
+  return parseTime(start.c_str(), fault.startMs) && parseTime(colon + 1, fault.durationMs);
+}
+
+static bool isActive(const std::vector<Fault> &faults, uint64_t nowMs)
+{
+  for (const Fault &fault : faults)
+  {
+    if (nowMs >= fault.startMs && nowMs - fault.startMs < fault.durationMs)
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+// "[N@]START:DURATION": bounce trains for the press and the release (active low)
+static bool addPress(const char *text)
+{
+  uint32_t button = 0;
+  const char *at = strchr(text, '@');
+  if (at)
+  {
+    button = (uint32_t)atoi(text) - 1;
+    text = at + 1;
+  }
+  Fault press;
+  if (button >= BUTTON_COUNT || !parseFault(text, press))
+  {
+    return false;
+  }
+  const uint64_t startsUs[] = {press.startMs * 1000, (press.startMs + press.durationMs) * 1000};
+  for (uint32_t edge = 0; edge < 2; edge++)
+  {
+    uint32_t settled = edge == 0 ? LOW : HIGH;
+    for (size_t i = 0; i < sizeof(BOUNCE_US) / sizeof(BOUNCE_US[0]); i++)
+    {
+      pinEdges.push_back({startsUs[edge] + BOUNCE_US[i], BUTTON_PINS[button], i % 2 == 0 ? settled : !settled});
+    }
+  }
+  return true;
+}
+
+static void applyPinEdges(uint64_t nowUs)
+{
+  while (nextPinEdge < pinEdges.size() && pinEdges[nextPinEdge].atUs <= nowUs)
+  {
+    setPinInput(pinEdges[nextPinEdge].pin, pinEdges[nextPinEdge].level); // Edge interrupt runs here
+    nextPinEdge++;
+  }
+}
+
+static void applyFaults(uint64_t nowMs)
+{
+  static bool wasBrokerDown = false;
+  bool isBrokerDown = isActive(brokerFaults, nowMs);
+  if (isBrokerDown != wasBrokerDown)
+  {
+    broker.setAvailable(!isBrokerDown); // Drops the session once, at the start
+    wasBrokerDown = isBrokerDown;
+  }
+  FakeCard::setFailing(isActive(cardFaults, nowMs));
+}
+
+static void onTick(TIM_TypeDef *instance, uint64_t clockUs, uint64_t cpuNs)
+{
+  if (instance != TIM3)
+  {
+    return;
+  }
+  TickStats *const targets[] = {&window, &lifetime};
+  for (TickStats *stats : targets)
+  {
+    stats->ticks++;
+    stats->clockUs += clockUs;
+    stats->maxClockUs = std::max(stats->maxClockUs, clockUs);
+    stats->cpuNs += cpuNs;
+    stats->maxCpuNs = std::max(stats->maxCpuNs, cpuNs);
+  }
+}
+
+static void reportHeader()
+{
+  fprintf(reportOut, "%9s %7s %8s %8s %7s %8s %10s %6s %8s %6s %6s %7s %6s %5s\n", "time", "ticks", "tick us",
+          "max us", "cpu us", "max cpu", "SD KiB", "files", "msgs", "dups", "drops", "backlog", "lost", "heap");
+}
+
+static void reportLine(uint64_t nowMs)
+{
+  const FakeCardStats &card = FakeCard::stats();
+  const FakeBrokerStats &stats = broker.getStats();
+  uint32_t ticks = window.ticks > 0 ? window.ticks : 1;
+  char time[32]; // Room for any day count, the column only widens
+  snprintf(time, sizeof(time), "%lud%02luh%02lu", (unsigned long)(nowMs / DAY_MS),
+           (unsigned long)(nowMs % DAY_MS / 3600000), (unsigned long)(nowMs % 3600000 / 60000));
+  fprintf(reportOut, "%9s %7lu %8.0f %8lu %7.1f %8.1f %10llu %6lu %8lu %6lu %6lu %7lu %6lu %5lu\n", time,
+          (unsigned long)window.ticks, (double)window.clockUs / ticks, (unsigned long)window.maxClockUs,
+          window.cpuNs / 1000.0 / ticks, window.maxCpuNs / 1000.0, (unsigned long long)(card.bytesWritten / 1024),
+          (unsigned long)card.filesCreated, (unsigned long)stats.publishes, (unsigned long)stats.duplicates,
+          (unsigned long)connection.getStats().drops, (unsigned long)backlog.pending(),
+          (unsigned long)(backlog.dropped() + outbound.getStats().dropped), (unsigned long)heapPeak);
+  fflush(reportOut);
+  window = TickStats();
+}
+
+static void summary(uint64_t elapsedMs, double hostSeconds)
+{
+  const FakeBrokerStats &stats = broker.getStats();
+  const FakeCardStats &card = FakeCard::stats();
+  const OutboundStats &queue = outbound.getStats();
+  uint32_t qos1 = 0;
+  for (const FakeBrokerMessage &message : broker.getMessages())
+  {
+    qos1 += message.qos == 1 ? 1 : 0;
+  }
+  uint32_t ticks = lifetime.ticks > 0 ? lifetime.ticks : 1;
+  fprintf(reportOut, "\n--- %.1f s (%.2f days) in %.1f s ---\n", elapsedMs / 1000.0, (double)elapsedMs / DAY_MS,
+          hostSeconds);
+  fprintf(reportOut, "DHT reads:         %lu\n", (unsigned long)FakeDht::getReads());
+  fprintf(reportOut, "MQTT connects:     %lu (%lu refused, %lu dropped)\n", (unsigned long)stats.connects,
+          (unsigned long)stats.refused, (unsigned long)stats.drops);
+  fprintf(reportOut, "messages:          %lu (%lu QoS1, %lu duplicates)\n", (unsigned long)stats.publishes,
+          (unsigned long)qos1, (unsigned long)stats.duplicates);
+  fprintf(reportOut, "PUBACKs / pings:   %lu / %lu\n", (unsigned long)stats.pubacks, (unsigned long)stats.pings);
+  fprintf(reportOut, "bytes in / out:    %llu / %llu\n", (unsigned long long)stats.bytesIn,
+          (unsigned long long)stats.bytesOut);
+  fprintf(reportOut, "outbound:          %lu published, %lu retransmitted, %lu spilled, %lu dropped\n",
+          (unsigned long)queue.published, (unsigned long)queue.retransmits, (unsigned long)queue.spilled,
+          (unsigned long)queue.dropped);
+  const AlarmStats &alarmStats = alarms.getStats();
+  uint32_t alarmEvents = alarmStats.raised + alarmStats.cleared;
+  fprintf(reportOut, "alarms:            %lu raised, %lu cleared, %u active, latency %.0f us avg / %lu us max\n",
+          (unsigned long)alarmStats.raised, (unsigned long)alarmStats.cleared, alarms.activeCount(),
+          alarmEvents > 0 ? (double)alarmStats.latencySumUs / alarmEvents : 0.0, (unsigned long)alarmStats.latencyMaxUs);
+  const ControlTimingStats &control = controlTiming.getStats();
+  fprintf(reportOut, "control:           %lu periods, jitter %.0f us avg / %lu us max, latency %lu us max, %lu missed\n",
+          (unsigned long)control.periods,
+          control.periods > 1 ? (double)control.jitterSumUs / (control.periods - 1) : 0.0,
+          (unsigned long)control.jitterMaxUs, (unsigned long)control.latencyMaxUs, (unsigned long)control.missed);
+  ButtonStats buttonStats = buttons.getStats();
+  fprintf(reportOut, "buttons:           %lu edges, %lu short, %lu long, %lu glitches, %lu dropped\n",
+          (unsigned long)buttonStats.edges, (unsigned long)buttonStats.shortPresses,
+          (unsigned long)buttonStats.longPresses, (unsigned long)buttonStats.glitches, (unsigned long)buttonStats.dropped);
+  if (isRoom)
+  {
+    fprintf(reportOut, "room:              %.2f °C, output %.0f%%\n", room.temperature, cooling.getOutput() * 100);
+  }
+  fprintf(reportOut, "backlog:           %lu pending, %lu dropped\n", (unsigned long)backlog.pending(),
+          (unsigned long)backlog.dropped());
+  fprintf(reportOut, "card:              %llu KiB written, %lu sectors w / %lu r, %lu files created, %lu refused, "
+          "%lu from interrupts\n",
+          (unsigned long long)(card.bytesWritten / 1024), (unsigned long)card.sectorsWritten,
+          (unsigned long)card.sectorsRead, (unsigned long)card.filesCreated, (unsigned long)card.failures,
+          (unsigned long)card.interruptAccesses);
+  fprintf(reportOut, "heap:              %lu allocations, peak %lu blocks live\n", (unsigned long)allocationCount(),
+          (unsigned long)heapPeak);
+  if (lifetime.ticks > 0)
+  {
+    fprintf(reportOut, "tick:              %lu, %.0f us avg / %lu us max (clock), %.1f / %.1f us CPU\n",
+            (unsigned long)lifetime.ticks, (double)lifetime.clockUs / ticks, (unsigned long)lifetime.maxClockUs,
+            lifetime.cpuNs / 1000.0 / ticks, lifetime.maxCpuNs / 1000.0);
+  }
+  fflush(reportOut);
+}
+
+int main(int argc, char **argv)
+{
+  const char *root = "sdcard";
+  uint64_t runMs = 30000;
+  uint64_t stepMs = 1000;
+  uint64_t reportMs = DAY_MS;
+  bool isVirtual = false;
+  bool isConsole = false;
+  bool isRealBroker = false;
+  for (int i = 1; i < argc; i++)
+  {
+    const char *value;
+    Fault fault;
+    bool isValid = true;
+    if (option(argv[i], "root", &value))
+    {
+      root = value;
+    }
+    else if (option(argv[i], "seconds", &value))
+    {
+      runMs = (uint64_t)atoll(value) * 1000;
+    }
+    else if (option(argv[i], "days", &value))
+    {
+      runMs = (uint64_t)(atof(value) * DAY_MS);
+    }
+    else if (option(argv[i], "sensors", &value))
+    {
+      if (!FakeDht::loadScript(value))
+      {
+        fprintf(stderr, "cannot read sensor script %s\n", value);
+        return 1;
+      }
+    }
+    else if (option(argv[i], "outage", &value))
+    {
+      isValid = parseFault(value, fault);
+      FakeWiFi::addOutage((uint32_t)fault.startMs, (uint32_t)fault.durationMs);
+    }
+    else if (option(argv[i], "broker_down", &value))
+    {
+      isValid = parseFault(value, fault);
+      brokerFaults.push_back(fault);
+    }
+    else if (option(argv[i], "sd_fail", &value))
+    {
+      isValid = parseFault(value, fault);
+      cardFaults.push_back(fault);
+    }
+    else if (option(argv[i], "broker", &value))
+    {
+      isValid = strcmp(value, "real") == 0;
+      isRealBroker = true;
+    }
+    else if (option(argv[i], "echo", &value))
+    {
+      broker.setEcho(atoi(value) != 0);
+    }
+    else if (option(argv[i], "virtual", &value))
+    {
+      isVirtual = atoi(value) != 0;
+    }
+    else if (option(argv[i], "step_ms", &value))
+    {
+      stepMs = (uint64_t)atoll(value);
+      isValid = stepMs > 0;
+    }
+    else if (option(argv[i], "report", &value))
+    {
+      isValid = parseTime(value, reportMs);
+    }
+    else if (option(argv[i], "console", &value))
+    {
+      isConsole = atoi(value) != 0;
+    }
+    else if (option(argv[i], "room", &value))
+    {
+      char *end;
+      room.ambient = strtof(value, &end);
+      room.load = *end == ':' ? strtof(end + 1, &end) : 0;
+      room.temperature = room.ambient + room.load;
+      isValid = end != value && *end == '\0';
+      isRoom = true;
+    }
+    else if (option(argv[i], "press", &value))
+    {
+      isValid = addPress(value);
+    }
+    else
+    {
+      isValid = false;
+    }
+    if (!isValid)
+    {
+      fprintf(stderr, "bad argument %s\n", argv[i]);
+      return 1;
+    }
+  }
+  if (isVirtual && isRealBroker)
+  {
+    fprintf(stderr, "broker=real needs real time\n");
+    return 1;
+  }
+
+  std::stable_sort(pinEdges.begin(), pinEdges.end(),
+                   [](const PinEdge &a, const PinEdge &b) { return a.atUs < b.atUs; });
+
+  mkdir(root, 0755);
+  FakeCard::setRoot(root);
+  FakeWiFi::setServer(isRealBroker ? (Client *)&realBroker : (Client *)&broker);
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+
+  if (isVirtual)
+  {
+    setVirtualTime(true);
+    FakeTimers::setObserver(onTick);
+    if (!isConsole)
+    {
+      // Serial writes to stdout: the report keeps a copy of the real one
+      reportOut = fdopen(dup(STDOUT_FILENO), "w");
+      if (!reportOut || !freopen("/dev/null", "w", stdout))
+      {
+        fprintf(stderr, "cannot mute the console\n");
+        return 1;
+      }
+    }
+    reportHeader();
+  }
+  else
+  {
+    reportMs = 0;
+  }
+
+  struct timespec hostStart;
+  clock_gettime(CLOCK_MONOTONIC, &hostStart);
+  uint64_t bootUs = hostMicros();
+  uint64_t bootMs = bootUs / 1000;
+  uint64_t elapsedMs = 0;
+  uint64_t nextReport = reportMs;
+  applyFaults(0);
+  if (isRoom)
+  {
+    FakeDht::set(room.temperature, 50);
+  }
+  setup();
+  uint64_t roomUs = hostMicros();
+  while (!isStopping && elapsedMs < runMs)
+  {
+    loop();
+    serviceInterrupts();
+    if (isRoom)
+    {
+      // Relay state over the time since the last pass
+      uint64_t nowUs = hostMicros();
+      room.step((nowUs - roomUs) / 1e6f, digitalRead(COOLING_PIN) == HIGH ? 1 : 0);
+      FakeDht::set(room.temperature, 50);
+      roomUs = nowUs;
+    }
+    heapPeak = std::max(heapPeak, allocationCount() - freeCount());
+
+    if (isVirtual)
+    {
+      // Straight to the next reading unless the firmware has bytes to read
+      Client *server = FakeWiFi::server();
+      uint64_t now = hostMicros();
+      uint64_t step = server->available() > 0 ? LOOP_PASS_US : stepMs * 1000;
+      uint64_t target = std::min(FakeTimers::nextEvent(), now + step);
+      if (nextPinEdge < pinEdges.size())
+      {
+        target = std::min(target, bootUs + pinEdges[nextPinEdge].atUs);
+      }
+      if (target > now)
+      {
+        advanceVirtualTime(target - now);
+      }
+    }
+    else
+    {
+      delayMicroseconds(LOOP_SLEEP_US);
+    }
+
+    elapsedMs = hostMicros() / 1000 - bootMs;
+    applyFaults(elapsedMs);
+    applyPinEdges(hostMicros() - bootUs);
+    if (reportMs > 0 && elapsedMs >= nextReport)
+    {
+      reportLine(elapsedMs);
+      nextReport += reportMs;
+    }
+  }
+
+  struct timespec hostEnd;
+  clock_gettime(CLOCK_MONOTONIC, &hostEnd);
+  summary(elapsedMs, (hostEnd.tv_sec - hostStart.tv_sec) + (hostEnd.tv_nsec - hostStart.tv_nsec) / 1e9);
+  return 0;
+}
@@ -0,0 +1,432 @@
+#include "PubSubClient.h"
+
+static constexpr uint16_t HEADER_SIZE = 5; // Fixed header + up to 4 length bytes, reserved at the front
+
+PubSubClient::PubSubClient()
+    : client(nullptr), nextMsgId(1), lastOutActivity(0), lastInActivity(0), pingOutstanding(false),
+      callback(nullptr), domain(nullptr), port(0), keepAlive(MQTT_KEEPALIVE), socketTimeout(MQTT_SOCKET_TIMEOUT),
+      clientState(MQTT_DISCONNECTED)
+{
+}
+
+PubSubClient::PubSubClient(Client &client) : PubSubClient()
+{
+  setClient(client);
+}
+
+PubSubClient &PubSubClient::setServer(IPAddress address, uint16_t serverPort)
+{
+  ip = address;
+  domain = nullptr;
+  port = serverPort;
+  return *this;
+}
+
+PubSubClient &PubSubClient::setServer(const char *serverDomain, uint16_t serverPort)
+{
+  domain = serverDomain;
+  port = serverPort;
+  return *this;
+}
+
+PubSubClient &PubSubClient::setCallback(MQTT_CALLBACK_SIGNATURE)
+{
+  this->callback = callback;
+  return *this;
+}
+
+PubSubClient &PubSubClient::setClient(Client &newClient)
+{
+  client = &newClient;
+  return *this;
+}
+
+PubSubClient &PubSubClient::setKeepAlive(uint16_t seconds)
+{
+  keepAlive = seconds;
+  return *this;
+}
+
+PubSubClient &PubSubClient::setSocketTimeout(uint16_t seconds)
+{
+  socketTimeout = seconds;
+  return *this;
+}
+
+bool PubSubClient::setBufferSize(uint16_t size)
+{
+  return size > 0 && size <= sizeof(buffer); // Static buffer on the host
+}
+
+uint16_t PubSubClient::getBufferSize()
+{
+  return sizeof(buffer);
+}
+
+bool PubSubClient::connect(const char *id)
+{
+  return connectWith(id, nullptr, 0, false, nullptr, nullptr, nullptr);
+}
+
+bool PubSubClient::connect(const char *id, const char *user, const char *pass)
+{
+  return connectWith(id, nullptr, 0, false, nullptr, user, pass);
+}
+
+bool PubSubClient::connect(const char *id, const char *willTopic, uint8_t willQos, bool willRetain,
+                           const char *willMessage)
+{
+  return connectWith(id, willTopic, willQos, willRetain, willMessage, nullptr, nullptr);
+}
+
+bool PubSubClient::connectWith(const char *id, const char *willTopic, uint8_t willQos, bool willRetain,
+                               const char *willMessage, const char *user, const char *pass)
+{
+  if (!client)
+  {
+    return false;
+  }
+  if (connected())
+  {
+    return true;
+  }
+
+  int result = domain ? client->connect(domain, port) : client->connect(ip, port);
+  if (result != 1)
+  {
+    clientState = MQTT_CONNECT_FAILED;
+    return false;
+  }
+
+  nextMsgId = 1;
+  uint16_t length = HEADER_SIZE;
+  const uint8_t protocol[] = {0x00, 0x04, 'M', 'Q', 'T', 'T', MQTT_VERSION};
+  memcpy(buffer + length, protocol, sizeof(protocol));
+  length += sizeof(protocol);
+
+  uint8_t flags = 0x02; // Clean session
+  if (willTopic)
+  {
+    flags |= 0x04 | (willQos << 3) | (willRetain ? 0x20 : 0);
+  }
+  if (user)
+  {
+    flags |= 0x80 | (pass ? 0x40 : 0);
+  }
+  buffer[length++] = flags;
+  buffer[length++] = keepAlive >> 8;
+  buffer[length++] = keepAlive & 0xFF;
+
+  bool isFitting = writeString(id, length);
+  if (willTopic)
+  {
+    isFitting = isFitting && writeString(willTopic, length) && writeString(willMessage, length);
+  }
+  if (user)
+  {
+    isFitting = isFitting && writeString(user, length) && (!pass || writeString(pass, length));
+  }
+  if (!isFitting || !write(MQTTCONNECT, length - HEADER_SIZE))
+  {
+    client->stop();
+    clientState = MQTT_CONNECT_FAILED;
+    return false;
+  }
+
+  lastInActivity = lastOutActivity = millis();
+  while (!client->available())
+  {
+    if (millis() - lastInActivity >= socketTimeout * 1000UL)
+    {
+      client->stop();
+      clientState = MQTT_CONNECTION_TIMEOUT;
+      return false;
+    }
+    delay(1);
+  }
+
+  uint32_t packetLength = readPacket();
+  if (packetLength == 4 && buffer[0] == MQTTCONNACK)
+  {
+    if (buffer[3] == 0)
+    {
+      lastInActivity = millis();
+      pingOutstanding = false;
+      clientState = MQTT_CONNECTED;
+      return true;
+    }
+    clientState = buffer[3];
+  }
+  else
+  {
+    clientState = MQTT_CONNECT_FAILED;
+  }
+  client->stop();
+  return false;
+}
+
+void PubSubClient::disconnect()
+{
+  if (client && client->connected())
+  {
+    buffer[0] = MQTTDISCONNECT;
+    buffer[1] = 0;
+    client->write(buffer, 2);
+    client->stop();
+  }
+  clientState = MQTT_DISCONNECTED;
+  lastInActivity = lastOutActivity = millis();
+}
+
+bool PubSubClient::publish(const char *topic, const char *payload)
+{
+  return publish(topic, (const uint8_t *)payload, payload ? strlen(payload) : 0, false);
+}
+
+bool PubSubClient::publish(const char *topic, const char *payload, bool retained)
+{
+  return publish(topic, (const uint8_t *)payload, payload ? strlen(payload) : 0, retained);
+}
+
+bool PubSubClient::publish(const char *topic, const uint8_t *payload, unsigned int length)
+{
+  return publish(topic, payload, length, false);
+}
+
+bool PubSubClient::publish(const char *topic, const uint8_t *payload, unsigned int length, bool retained)
+{
+  if (!connected() || HEADER_SIZE + 2 + strlen(topic) + length > sizeof(buffer))
+  {
+    return false;
+  }
+  uint16_t position = HEADER_SIZE;
+  writeString(topic, position);
+  memcpy(buffer + position, payload, length);
+  position += length;
+  return write(MQTTPUBLISH | (retained ? 1 : 0), position - HEADER_SIZE);
+}
+
+bool PubSubClient::subscribe(const char *topic)
+{
+  return subscribe(topic, 0);
+}
+
+bool PubSubClient::subscribe(const char *topic, uint8_t qos)
+{
+  if (!topic || qos > 1 || HEADER_SIZE + 2 + 2 + strlen(topic) + 1 > sizeof(buffer) || !connected())
+  {
+    return false;
+  }
+  uint16_t position = HEADER_SIZE;
+  nextMsgId = nextMsgId == 0xFFFF ? 1 : nextMsgId + 1;
+  buffer[position++] = nextMsgId >> 8;
+  buffer[position++] = nextMsgId & 0xFF;
+  writeString(topic, position);
+  buffer[position++] = qos;
+  return write(MQTTSUBSCRIBE | MQTTQOS1, position - HEADER_SIZE);
+}
+
+bool PubSubClient::unsubscribe(const char *topic)
+{
+  if (!topic || HEADER_SIZE + 2 + 2 + strlen(topic) > sizeof(buffer) || !connected())
+  {
+    return false;
+  }
+  uint16_t position = HEADER_SIZE;
+  nextMsgId = nextMsgId == 0xFFFF ? 1 : nextMsgId + 1;
+  buffer[position++] = nextMsgId >> 8;
+  buffer[position++] = nextMsgId & 0xFF;
+  writeString(topic, position);
+  return write(MQTTUNSUBSCRIBE | MQTTQOS1, position - HEADER_SIZE);
+}
+
+bool PubSubClient::loop()
+{
+  if (!connected())
+  {
+    return false;
+  }
+
+  uint32_t now = millis();
+  uint32_t keepAliveMs = keepAlive * 1000UL;
+  if (keepAliveMs > 0 && (now - lastInActivity > keepAliveMs || now - lastOutActivity > keepAliveMs))
+  {
+    if (pingOutstanding)
+    {
+      clientState = MQTT_CONNECTION_TIMEOUT;
+      client->stop();
+      return false;
+    }
+    buffer[0] = MQTTPINGREQ;
+    buffer[1] = 0;
+    client->write(buffer, 2);
+    lastOutActivity = lastInActivity = now;
+    pingOutstanding = true;
+  }
+
+  if (!client->available())
+  {
+    return true;
+  }
+
+  uint32_t length = readPacket();
+  if (length == 0)
+  {
+    return true;
+  }
+  lastInActivity = millis();
+  uint8_t type = buffer[0] & 0xF0;
+
+  if (type == MQTTPUBLISH && callback)
+  {
+    // Variable header after the 1..4 length bytes
+    uint8_t lengthBytes = 1;
+    while (lengthBytes < 4 && (buffer[lengthBytes] & 0x80))
+    {
+      lengthBytes++;
+    }
+    uint16_t topicStart = 1 + lengthBytes;
+    uint16_t topicLength = buffer[topicStart] << 8 | buffer[topicStart + 1];
+    uint8_t qos = buffer[0] & MQTTQOS1;
+    uint32_t payloadStart = topicStart + 2 + topicLength + (qos ? 2 : 0);
+    if (payloadStart > length)
+    {
+      return true; // Malformed
+    }
+    uint16_t packetId = qos ? buffer[payloadStart - 2] << 8 | buffer[payloadStart - 1] : 0;
+
+    // Topic moved back over its length bytes to make room for the terminator
+    memmove(buffer + topicStart, buffer + topicStart + 2, topicLength);
+    buffer[topicStart + topicLength] = '\0';
+    callback((char *)buffer + topicStart, buffer + payloadStart, length - payloadStart);
+    if (qos)
+    {
+      uint8_t ack[] = {MQTTPUBACK, 2, (uint8_t)(packetId >> 8), (uint8_t)(packetId & 0xFF)};
+      client->write(ack, sizeof(ack));
+      lastOutActivity = millis();
+    }
+  }
+  else if (type == MQTTPINGREQ)
+  {
+    uint8_t response[] = {MQTTPINGRESP, 0};
+    client->write(response, sizeof(response));
+  }
+  else if (type == MQTTPINGRESP)
+  {
+    pingOutstanding = false;
+  }
+  return true;
+}
+
+bool PubSubClient::connected()
+{
+  if (!client)
+  {
+    return false;
+  }
+  if (client->connected())
+  {
+    return clientState == MQTT_CONNECTED;
+  }
+  if (clientState == MQTT_CONNECTED)
+  {
+    clientState = MQTT_CONNECTION_LOST;
+    client->flush();
+    client->stop();
+  }
+  return false;
+}
+
+int PubSubClient::state()
+{
+  return clientState;
+}
+
+bool PubSubClient::readByte(uint8_t &b)
+{
+  uint32_t start = millis();
+  while (!client->available())
+  {
+    if (millis() - start >= socketTimeout * 1000UL)
+    {
+      return false;
+    }
+    delay(1);
+  }
+  b = (uint8_t)client->read();
+  return true;
+}
+
+uint32_t PubSubClient::readPacket()
+{
+  // Whole packet kept in the buffer, header included; a longer one is read
+  // to its end and dropped
+  uint16_t position = 0;
+  uint8_t b;
+  if (!readByte(b))
+  {
+    return 0;
+  }
+  buffer[position++] = b;
+
+  uint32_t length = 0;
+  uint8_t shift = 0;
+  do
+  {
+    if (position == 5 || !readByte(b))
+    {
+      return 0;
+    }
+    buffer[position++] = b;
+    length |= (uint32_t)(b & 0x7F) << shift;
+    shift += 7;
+  } while (b & 0x80);
+
+  uint32_t total = position + length;
+  for (uint32_t i = 0; i < length; i++)
+  {
+    if (!readByte(b))
+    {
+      return 0;
+    }
+    if (position < sizeof(buffer))
+    {
+      buffer[position++] = b;
+    }
+  }
+  return total <= sizeof(buffer) ? total : 0;
+}
+
+bool PubSubClient::write(uint8_t header, uint16_t length)
+{
+  uint8_t lengthBytes[4];
+  uint8_t count = 0;
+  uint32_t remaining = length;
+  do
+  {
+    uint8_t digit = remaining & 0x7F;
+    remaining >>= 7;
+    lengthBytes[count++] = remaining ? digit | 0x80 : digit;
+  } while (remaining);
+
+  uint16_t start = HEADER_SIZE - 1 - count;
+  buffer[start] = header;
+  memcpy(buffer + start + 1, lengthBytes, count);
+  uint16_t size = 1 + count + length;
+  lastOutActivity = millis();
+  return client->write(buffer + start, size) == size;
+}
+
+bool PubSubClient::writeString(const char *text, uint16_t &position)
+{
+  size_t length = text ? strlen(text) : 0;
+  if (position + 2 + length > sizeof(buffer))
+  {
+    return false;
+  }
+  buffer[position++] = length >> 8;
+  buffer[position++] = length & 0xFF;
+  memcpy(buffer + position, text, length);
+  position += length;
+  return true;
+}
@@ -0,0 +1,111 @@
+#ifndef NATIVE_PUBSUBCLIENT_H
+#define NATIVE_PUBSUBCLIENT_H
+
+// Host stand-in for knolleary/PubSubClient, used by env:native (the
+// network benchmarks build the real library). Same API and the same MQTT
+// 3.1.1 bytes on the Client, so AckTapClient and the QoS1 packets of the
+// outbound queue are exercised as on the board: QoS0 publish, subscribe,
+// keepalive with PINGREQ, one inbound packet per loop().
+
+#include "Arduino.h"
+#include "Client.h"
+#include "IPAddress.h"
+
+#define MQTT_VERSION_3_1_1 4
+#define MQTT_VERSION MQTT_VERSION_3_1_1
+
+#ifndef MQTT_MAX_PACKET_SIZE
+#define MQTT_MAX_PACKET_SIZE 256
+#endif
+#ifndef MQTT_KEEPALIVE
+#define MQTT_KEEPALIVE 15
+#endif
+#ifndef MQTT_SOCKET_TIMEOUT
+#define MQTT_SOCKET_TIMEOUT 15
+#endif
+
+#define MQTT_CONNECTION_TIMEOUT -4
+#define MQTT_CONNECTION_LOST -3
+#define MQTT_CONNECT_FAILED -2
+#define MQTT_DISCONNECTED -1
+#define MQTT_CONNECTED 0
+#define MQTT_CONNECT_BAD_PROTOCOL 1
+#define MQTT_CONNECT_BAD_CLIENT_ID 2
+#define MQTT_CONNECT_UNAVAILABLE 3
+#define MQTT_CONNECT_BAD_CREDENTIALS 4
+#define MQTT_CONNECT_UNAUTHORIZED 5
+
+#define MQTTCONNECT (1 << 4)
+#define MQTTCONNACK (2 << 4)
+#define MQTTPUBLISH (3 << 4)
+#define MQTTPUBACK (4 << 4)
+#define MQTTSUBSCRIBE (8 << 4)
+#define MQTTSUBACK (9 << 4)
+#define MQTTUNSUBSCRIBE (10 << 4)
+#define MQTTUNSUBACK (11 << 4)
+#define MQTTPINGREQ (12 << 4)
+#define MQTTPINGRESP (13 << 4)
+#define MQTTDISCONNECT (14 << 4)
+
+#define MQTTQOS0 (0 << 1)
+#define MQTTQOS1 (1 << 1)
+
+#define MQTT_CALLBACK_SIGNATURE void (*callback)(char *, uint8_t *, unsigned int)
+
+class PubSubClient
+{
+public:
+  PubSubClient();
+  PubSubClient(Client &client);
+
+  PubSubClient &setServer(IPAddress ip, uint16_t port);
+  PubSubClient &setServer(const char *domain, uint16_t port);
+  PubSubClient &setCallback(MQTT_CALLBACK_SIGNATURE);
+  PubSubClient &setClient(Client &client);
+  PubSubClient &setKeepAlive(uint16_t keepAlive);
+  PubSubClient &setSocketTimeout(uint16_t timeout);
+  bool setBufferSize(uint16_t size);
+  uint16_t getBufferSize();
+
+  bool connect(const char *id);
+  bool connect(const char *id, const char *user, const char *pass);
+  bool connect(const char *id, const char *willTopic, uint8_t willQos, bool willRetain, const char *willMessage);
+  void disconnect();
+
+  bool publish(const char *topic, const char *payload);
+  bool publish(const char *topic, const char *payload, bool retained);
+  bool publish(const char *topic, const uint8_t *payload, unsigned int length);
+  bool publish(const char *topic, const uint8_t *payload, unsigned int length, bool retained);
+
+  bool subscribe(const char *topic);
+  bool subscribe(const char *topic, uint8_t qos);
+  bool unsubscribe(const char *topic);
+
+  bool loop();
+  bool connected();
+  int state();
+
+private:
+  bool connectWith(const char *id, const char *willTopic, uint8_t willQos, bool willRetain, const char *willMessage,
+                   const char *user, const char *pass);
+  bool readByte(uint8_t &b);
+  uint32_t readPacket();
+  bool write(uint8_t header, uint16_t length);
+  bool writeString(const char *text, uint16_t &position);
+
+  Client *client;
+  uint8_t buffer[MQTT_MAX_PACKET_SIZE];
+  uint16_t nextMsgId;
+  uint32_t lastOutActivity;
+  uint32_t lastInActivity;
+  bool pingOutstanding;
+  MQTT_CALLBACK_SIGNATURE;
+  IPAddress ip;
+  const char *domain;
+  uint16_t port;
+  uint16_t keepAlive;
+  uint16_t socketTimeout;
+  int clientState;
+};
+
+#endif // NATIVE_PUBSUBCLIENT_H
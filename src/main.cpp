@@ -11,9 +11,26 @@
 #include "logs.hpp"        // Logs
 #include "connect.hpp"     // Funções de ligação
 #include "set_rtc.hpp"     // RTC
+#include "backlog.hpp"     // Registos por enviar
+#include "format.hpp"      // Formatação sem heap
+#include "memstats.hpp"    // Contador de alocações
+#include "memPool.hpp"     // Pools e arena sem heap
+#include "publishPolicy.hpp" // Publicação por exceção
+#include "espUart.hpp"     // UART com DMA para o ESP8266
+#include "commands.hpp"    // Comandos MQTT
+#include "telemetryFile.hpp" // Telemetria binária
+#include "segmentCompressor.hpp" // Compressão de segmentos fechados
+#include "history.hpp"         // Consultas ao histórico de telemetria
+#include "rollup.hpp"          // Agregados por minuto/hora
+#include "sdProbe.hpp"         // Medição do cartão SD no arranque
+#include "bootTimeline.hpp"    // Duração das fases do arranque
+#include "deviceConfig.hpp"    // config.json / config.bin
+#include "stackMonitor.hpp"    // Máximos da pilha (pintura) e heap livre
+#include "alarmEngine.hpp"     // Alarmes por leitura
+#include "coolingControl.hpp"  // Controlo do atuador (histerese/PI)
+#include "buttonInput.hpp"     // Botões por interrupção com debounce
 
 // Variáveis
-char tempStr[100];     // String para dados de temperatura
 char localIpStr[50];   // String para endereço IP local
 char gatewayIpStr[50]; // String para endereço IP do gateway
 char dnsIpStr[50];     // String para endereço IP do DNS
@@ -24,194 +41,646 @@ char pubMsg[100];      // String para mensagens publicadas
 struct configData config_data = {0}; // Inicialização da estrutura de dados de configuração
 extern struct sensorData sensor_data; // Estrutura de dados do sensor de sensorEvent.cpp
 
-// Criar clientes WiFi e MQTT
-WiFiClient wifiClient;
-PubSubClient mqttClient(wifiClient);
-
 // Definição de classes
-HardwareTimer *timer3 = new HardwareTimer(TIM3); // Criar instância HardwareTimer para TIM3
-HardwareSerial Serial1(PA10, PA9);               // Criar instância HardwareSerial para Serial1
+HardwareTimer timer3;           // TIM3, estático (setup() associa o periférico)
+HardwareTimer timer6;           // TIM6, controlo do atuador a ritmo fixo
+HardwareTimer timer7;           // TIM7, debounce dos botões (parado com os botões em repouso)
+DmaSerial espSerial(PA10, PA9);                  // USART1 com DMA para o ESP8266
 
 ExtMEM logs; // Classe de logs
 ExtMEM csv;  // Classe CSV
-ExtMEM asn;  // Classe ASN
 
 sensorEvent sensor; // Classe de eventos do sensor
 
+Backlog backlog; // Registos guardados enquanto a ligação está em baixo
+
+TelemetryFile telemetryFile; // Blocos binários de telemetria
+
+SegmentCompressor segmentCompressor; // Comprime logs/CSV fechados no tempo livre
+
+PublishPolicy publishPolicy; // Só publica alterações acima da banda morta ou no heartbeat
+static_assert(TELEMETRY_QUANTITIES * NUMBER_OF_SENSORS <= PUBLISH_POLICY_MAX_CHANNELS, "Too many publish channels");
+
+AlarmEngine alarms; // Limites, variação e debounce por sensor, avaliados em cada leitura do DHT
+static_assert(NUMBER_OF_SENSORS <= ALARM_MAX_SENSORS, "Too many alarm sensors");
+
+CoolingController cooling;   // Histerese ou PI sobre a média dos sensores
+ControlTiming controlTiming; // Jitter do período de controlo e latência até ao relé
+RelayWindow coolingRelay(CONTROL_PERIOD_US, CONTROL_OUTPUT_WINDOW_MS * 1000, CONTROL_RELAY_MIN_ON_MS * 1000,
+                         CONTROL_RELAY_MIN_OFF_MS * 1000); // Saída proporcional no tempo
+volatile float controlTemperature = NAN; // Última leitura nova, média dos sensores (ISR do TIM3)
+
+ButtonDebouncer buttons; // Flancos da EXTI, nível confirmado pelo TIM7, eventos para o loop()
+static_assert(BUTTON_COUNT <= BUTTON_MAX, "Too many buttons");
+
 LED greenLed; // Classe LED verde
 LED redLed;   // Classe LED vermelho
 
 uint32_t delayMS; // Variável para atraso em milissegundos
+uint32_t appliedInterval = 0; // Intervalo de leitura em uso no TIM3 (ms)
+volatile uint16_t sampleTicks = 1;     // Períodos do TIM3 por leitura (> 1 acima de SAMPLE_TIMER_MAX_MS)
+volatile uint16_t sampleCountdown = 1; // Períodos do TIM3 que faltam até à próxima leitura
+
+struct Reading { // Médias de uma leitura do TIM3, guardadas e enviadas pelo loop()
+    uint32_t ms;
+    float temperatures[NUMBER_OF_SENSORS];
+};
+RingQueue<Reading, READING_QUEUE_SIZE> readings;         // ISR do TIM3 -> loop(): a ISR nunca acede ao SD
+RingQueue<AlarmEvent, ALARM_QUEUE_SIZE> alarmEvents;     // Alarmes avaliados na ISR, publicados no loop()
+
+ScratchArena<TICK_ARENA_SIZE> tickArena; // Texto temporário de cada leitura, fora da pilha
+static_assert(FORMAT_FIXED_MAX + 1 + sizeof(StrBuilder<80>) + alignof(max_align_t) <= TICK_ARENA_SIZE,
+              "TICK_ARENA_SIZE too small for sendTemperature()");
+uint32_t bootAllocations = 0; // Alocações até ao fim do setup(); depois disso o heap não é usado
+
+void logSdProfile(bool isProbed) { // Registar o cartão e o perfil de escrita escolhido
+    static const char *const TIER_NAMES[SD_TIERS] = {"rápido", "médio", "lento"};
+    const SdCardInfo &card = sdProbe.getInfo();
+    const SdProbeResult &result = sdProbe.getResult();
+    const SdProfile &profile = sdProbe.getProfile();
+    StrBuilder<120> line;
+
+    if (!isProbed) {
+        logs.warning("Cartão SD não medido: perfil por omissão");
+        return;
+    }
+    line.append("Cartão SD: MID ").appendUInt(card.manufacturer).append(" OEM ").append(card.oem);
+    line.append(" ").append(card.product).append(" rev ").appendUInt(card.revision >> 4).append('.');
+    line.appendUInt(card.revision & 0x0F).append(", ").appendUInt(card.sizeMB).append(" MB, CSD v");
+    line.appendUInt(card.csdVersion).append(", ").appendUInt(card.maxKbps / 1000).append(" Mbit/s, classe ");
+    line.appendUInt(card.speedClass);
+    logs.info(line.c_str());
+
+    line.clear().append("Medição SD: ").appendUInt(result.sequentialKBps).append(" KB/s sequencial, escrita pequena p50 ");
+    line.appendUInt(result.appendP50Us).append(" us, máx ").appendUInt(result.appendMaxUs).append(" us");
+    logs.info(line.c_str());
+
+    line.clear().append("Perfil SD ").append(TIER_NAMES[profile.tier]).append(": buffer ").appendUInt(profile.bufferSize);
+    line.append(" B, flush ").appendUInt(profile.flushIntervalMs).append(" ms, pré-alocação ");
+    line.appendUInt(profile.preallocBytes).append(" B");
+    logs.info(line.c_str());
+}
+
+void logConfig() { // Registar a origem da configuração, valores recusados e a identificação
+    static const char *const SOURCE_NAMES[] = {"config.bin", "config.json", "config.json criado",
+                                               "config.bin anterior", "valores por omissão"};
+    ConfigSource source = deviceConfig.getSource();
+    const ConfigParser &parser = deviceConfig.getParser();
+    StrBuilder<120> line;
+
+    line.append("Configuração: ").append(SOURCE_NAMES[source]).append(" (").appendUInt(deviceConfig.getLoadUs());
+    line.append(" us)");
+    logs.info(line.c_str());
+
+    if (source != CONFIG_FROM_SNAPSHOT) {
+        if (parser.getError()[0] != '\0') {
+            line.clear().append("config.json inválido, linha ").appendUInt(parser.getLine()).append(": ");
+            line.append(parser.getError());
+            logs.error(line.c_str());
+        } else if (parser.isLegacy()) {
+            logs.warning("config.json no formato antigo (CSV): só identificação");
+        }
+        if (parser.getRejected() + parser.getUnknown() > 0) {
+            line.clear().append("config.json: ").appendUInt(parser.getRejected()).append(" valores recusados, ");
+            line.appendUInt(parser.getUnknown()).append(" chaves desconhecidas (última: ");
+            line.append(parser.getLastRejected()).append(')');
+            logs.warning(line.c_str());
+        }
+    }
+
+    line.clear().append("ASN ").append(config_data.asn).append(", SN ").append(config_data.sn);
+    line.append(", HW ").append(config_data.hw).append(", FW ").append(config_data.fw);
+    logs.info(line.c_str());
+}
+
+bool publishRecord(const TelemetryRecord &record) { // Publicar um registo guardado no backlog (instante;valor)
+    StrBuilder<40> topic;
+    StrBuilder<40> payload;
+
+    topic.append("sensor").appendUInt(record.sensor).append("/temp/backlog");
+    payload.appendUInt(record.timestamp).append(';').appendFixed(record.value / 100.0f, 2);
+    return outbound.offer(topic.c_str(), payload.c_str()); // Só se houver espaço em RAM
+}
+
+uint32_t alarmClock() { // Relógio da latência leitura -> alarme em fila
+    return micros();
+}
+
+void onTemperatureSample(const float *temperatures, uint32_t sampleUs) { // Cada leitura nova do DHT, ainda dentro da ISR
+    float sum = 0;
+    for (int i = 0; i < NUMBER_OF_SENSORS; i++) {
+        alarms.evaluate(i, temperatures[i], sampleUs, alarmClock);
+        sum += temperatures[i];
+    }
+    controlTemperature = sum / NUMBER_OF_SENSORS; // Lida pelo controlo no próximo período do TIM6
+}
+
+void controlTick() { // ISR do TIM6: um período de controlo, com a saída proporcional no tempo
+    uint32_t startUs = micros();
+
+    cooling.setSetpoints(control_data.tempMin, control_data.tempMax);
+    cooling.setStrategy((ControlStrategy)control_data.strategy);
+    if (control_data.emergency) {
+        cooling.track(0, controlTemperature); // Emergência: atuador parado
+    } else if (control_data.mode == MODE_MANUAL) {
+        cooling.track(control_data.manualOutput, controlTemperature); // Ao voltar a automático o PI parte deste valor
+    } else {
+        cooling.update(controlTemperature, CONTROL_PERIOD_US / 1e6f); // Período nominal: resultado determinístico
+    }
+
+    // Relé ligado durante a fração da janela pedida pela saída; na emergência desliga já, sem tempo mínimo
+    if (control_data.emergency) {
+        coolingRelay.stop();
+        digitalWrite(COOLING_PIN, LOW);
+    } else {
+        digitalWrite(COOLING_PIN, coolingRelay.next(cooling.getOutput()) ? HIGH : LOW);
+    }
+    controlTiming.record(startUs, micros());
+}
+
+template <uint8_t BUTTON>
+void onButtonEdge() { // ISR da EXTI: só regista o instante do flanco, o nível é lido pelo TIM7
+    buttons.edge(BUTTON, millis());
+    timer7.resume(); // Sem efeito se já estiver a correr
+}
+static void (*const BUTTON_EDGE_HANDLERS[BUTTON_MAX])() = {onButtonEdge<0>, onButtonEdge<1>, onButtonEdge<2>,
+                                                          onButtonEdge<3>};
+
+void buttonTick() { // ISR do TIM7: nível dos botões estável há BUTTON_DEBOUNCE_DELAY ms, pressões curtas e longas
+    uint8_t pressedMask = 0;
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        pressedMask |= (digitalRead(BUTTON_PINS[i]) == LOW ? 1 : 0) << i;
+    }
+    if (!buttons.tick(millis(), pressedMask)) {
+        // Parar só se nenhum flanco chegou entretanto (a EXTI tem prioridade acima desta ISR)
+        noInterrupts();
+        if (!buttons.isActive()) {
+            timer7.pause();
+        }
+        interrupts();
+    }
+}
+
+void onAlarm(const AlarmEvent &event) { // Na ISR do TIM3: publicado pelo loop() logo a seguir
+    alarmEvents.push(event); // Fila cheia: perdido e contado
+}
+
+void publishAlarm(const AlarmEvent &event) { // Publicar já, retido, sem esperar pela média nem pela banda morta
+    static const char *const KIND_NAMES[ALARM_KINDS] = {"alta", "baixa", "variacao"};
+    StrBuilder<OUTBOUND_TOPIC_SIZE> topic;
+    StrBuilder<OUTBOUND_PAYLOAD_SIZE + 1> payload;
+    uint32_t epoch = IS_RTC_ENABLED ? get_rtc_epoch() : millis() / 1000;
+
+    topic.append(TOPIC_ALARM_PREFIX).appendUInt(event.sensor + 1).append('/').append(KIND_NAMES[event.kind]);
+    payload.append(event.isActive ? '1' : '0').append(';').appendFixed(event.value, 2).append(';').appendUInt(epoch);
+    payload.append(';').appendUInt(micros() - event.sampleUs);
+    outbound.enqueue(topic.c_str(), payload.c_str(), OUTBOUND_QOS1 | OUTBOUND_RETAIN); // Sem ligação fica na fila/SD
+
+    StrBuilder<80> line;
+    line.append("Alarme ").append(KIND_NAMES[event.kind]).append(" sensor ").appendUInt(event.sensor + 1);
+    line.append(event.isActive ? " ativo: " : " desativado: ").appendFixed(event.value, 2);
+    line.append(event.kind == ALARM_RATE ? " C/min" : " C");
+    logs.warning(line.c_str());
+}
+
+void applySampleInterval(uint32_t intervalMs) { // Intervalo de leitura em períodos iguais do TIM3
+    uint16_t ticks = (intervalMs + SAMPLE_TIMER_MAX_MS - 1) / SAMPLE_TIMER_MAX_MS;
+    appliedInterval = intervalMs;
+    noInterrupts();
+    sampleTicks = ticks;
+    sampleCountdown = ticks;
+    interrupts();
+    timer3.setOverflow((uint32_t)((uint64_t)intervalMs * 1000 / ticks), MICROSEC_FORMAT);
+}
+
+void sampleTemperature() { // ISR do TIM3: só lê os sensores, o SD e o MQTT ficam para o loop()
+    stackMonitor.isrEnter(); // Profundidade da pilha só desta ISR
+    sensor.getTemperatureAverage(); // Obter temperatura média dos sensores (alarmes avaliados em cada leitura nova)
+
+    Reading reading;
+    reading.ms = millis();
+    for (int i = 0; i < NUMBER_OF_SENSORS; i++) {
+        reading.temperatures[i] = sensor_data.temperatureAverageSensors[i];
+    }
+    readings.push(reading); // Fila cheia (loop() parado): perdida e contada
+    stackMonitor.isrExit();
+}
+
+void onSampleTimer() { // ISR do TIM3: intervalos longos contados em vários períodos
+    if (--sampleCountdown > 0) {
+        return;
+    }
+    sampleCountdown = sampleTicks;
+    sampleTemperature();
+}
+
+void sendTemperature(const Reading &reading) { // Guardar uma leitura (log, CSV/telemetria, agregados) e enviar para MQTT
+    // Arena reposta a cada leitura: nada da leitura anterior continua em uso
+    tickArena.reset();
+    char *tempStr = (char *)tickArena.allocate(FORMAT_FIXED_MAX + 1, 1); // Temperatura formatada, partilhada por log, CSV e MQTT
+    StrBuilder<80> *lineBuffer = tickArena.create<StrBuilder<80>>();      // Linha de log/CSV construída no local
+    if (!tempStr || !lineBuffer) {
+        return; // Impossível com o static_assert acima
+    }
+    StrBuilder<80> &line = *lineBuffer;
+    const float *temperatures = reading.temperatures;
 
-void sendTemperature() { // Função para ler temperatura e enviar para MQTT (se disponível)
-    sensor.getTemperatureAverage(); // Obter temperatura média dos sensores
-    
     logs.info(""); // Linha em branco
     logs.info("=== LEITURA DE TEMPERATURA ===");
     logs.info(""); // Linha em branco
 
     for (int i = 0; i < NUMBER_OF_SENSORS; i++) {
-        dtostrf(sensor_data.temperatureAverageSensors[i], 2, 2, tempStr);
-        String tempMsg = "Sensor " + String(i + 1) + " temperatura: " + String(tempStr) + "C";
-        logs.debug(tempMsg.c_str());
+        tempStr[formatFixed(tempStr, temperatures[i], 2)] = '\0';
+
+        line.clear().append("Sensor ").appendUInt(i + 1).append(" temperatura: ").append(tempStr).append('C');
+        logs.debug(line.c_str());
         
         // Escrever no CSV
-        String csvLine = String(millis()) + ";" + String(i + 1) + ";OK;" + String(tempStr);
-        csv.data(csvLine.c_str());
-        // logs.info("Dados CSV escritos"); // Sem concatenação complicada
+        if (!IS_TELEMETRY_BINARY) {
+            line.clear().appendUInt(reading.ms).append(';').appendUInt(i + 1).append(";OK;").append(tempStr);
+            csv.data(line.c_str());
+        }
+    }
+
+    // Uma linha por período com todos os sensores
+    if (IS_TELEMETRY_BINARY) {
+        telemetryFile.append(reading.ms, temperatures);
+    }
+
+    // Agregados: fecham o minuto/hora anterior quando a leitura muda de intervalo
+    uint32_t epoch = IS_RTC_ENABLED ? get_rtc_epoch() : millis() / 1000;
+    for (int i = 0; i < NUMBER_OF_SENSORS; i++) {
+        rollups.add(i + 1, temperatures[i], epoch);
     }
     
-    // Enviar para MQTT se disponível
-    if (WiFi.status() == WL_CONNECTED && mqttClient.connected()) {
-        for (int i = 0; i < NUMBER_OF_SENSORS; i++) {
-            dtostrf(sensor_data.temperatureAverageSensors[i], 2, 2, tempStr);
-            String topic = "sensor" + String(i + 1) + "/temp";
-            mqttClient.publish(topic.c_str(), tempStr);
+    // Enviar para MQTT se disponível, senão guardar no backlog
+    bool isOnline = connection.isUp();
+    for (int i = 0; i < NUMBER_OF_SENSORS; i++) {
+        uint8_t channel = TELEMETRY_TEMPERATURE * NUMBER_OF_SENSORS + i;
+        if (!publishPolicy.evaluate(channel, temperatures[i], reading.ms)) {
+            continue; // Sem alteração relevante (ou leitura falhada), nada a enviar
+        }
+
+        tempStr[formatFixed(tempStr, temperatures[i], 2)] = '\0';
+        line.clear().append("sensor").appendUInt(i + 1).append("/temp");
+        if (!isOnline || !outbound.enqueue(line.c_str(), tempStr)) {
+            TelemetryRecord record;
+            record.timestamp = IS_RTC_ENABLED ? epoch : reading.ms; // Época sobrevive ao reboot, millis() não
+            record.sensor = i + 1;
+            record.quantity = TELEMETRY_TEMPERATURE;
+            record.value = (int16_t)lroundf(temperatures[i] * 100);
+            backlog.push(record);
         }
     }
-}
 
-void connectWiFi() { // Função para ligar ao WiFi
-    int attempts = 0;
-    unsigned long startTime = millis();
-    
-    while (WiFi.status() != WL_CONNECTED && attempts < 3 && (millis() - startTime) < 6000) { // Verificar se WiFi está ligado
-        logs.info("A ligar ao WiFi...");
-        WiFi.begin(SERVER_SSID, SERVER_PASSWORD); // Iniciar ligação WiFi
-        attempts++;
-        delay(DELAY_WIFI_CONNECTION);
+    // Repor dados antigos intercalados com os atuais (ritmo limitado)
+    if (isOnline) {
+        backlog.replay(BACKLOG_REPLAY_PER_TICK, publishRecord);
     }
 
-    if (WiFi.status() == WL_CONNECTED) {
-        String localIpMsg = "WiFi ligado: " + WiFi.localIP().toString();
-        logs.info(localIpMsg.c_str());
+    // Linhas da ISR perdidas por o buffer encher antes de o loop() o escrever
+    static uint32_t droppedReported = 0;
+    uint32_t dropped = logs.getDroppedLines() + csv.getDroppedLines();
+    if (dropped != droppedReported) {
+        line.clear().append("Linhas perdidas com o buffer cheio: ").appendUInt(dropped - droppedReported);
+        droppedReported = dropped;
+        logs.warning(line.c_str());
+    }
 
-        String gatewayMsg = "Gateway: " + WiFi.gatewayIP().toString();
-        logs.info(gatewayMsg.c_str());
+    // Leituras e alarmes perdidos com as filas cheias (loop() bloqueado)
+    static uint32_t queueDropsReported = 0;
+    uint32_t queueDrops = readings.getDropped() + alarmEvents.getDropped();
+    if (queueDrops != queueDropsReported) {
+        line.clear().append("Leituras/alarmes perdidos à espera do loop(): ").appendUInt(queueDrops - queueDropsReported);
+        queueDropsReported = queueDrops;
+        logs.warning(line.c_str());
+    }
+}
 
-        String dnsMsg = "DNS: " + WiFi.dnsIP().toString();
-        logs.info(dnsMsg.c_str());
-    } else {
-        logs.warning("Falha na ligação WiFi após 3 tentativas");
+void serviceReadings() { // No loop(): alarmes primeiro, depois as leituras em fila
+    AlarmEvent event;
+    while (alarmEvents.pop(event)) {
+        publishAlarm(event);
+    }
+    Reading reading;
+    while (readings.pop(reading)) {
+        sendTemperature(reading);
     }
 }
 
-void connectMQTT() { // Função para ligar ao broker MQTT
-    if (WiFi.status() != WL_CONNECTED) {
-        logs.warning("Não é possível ligar MQTT - Sem WiFi");
-        return;
+void reportMemory() { // Registar e publicar os máximos da pilha e o heap livre
+    stackMonitor.update();
+    StrBuilder<100> line;
+    StrBuilder<OUTBOUND_PAYLOAD_SIZE + 1> payload;
+
+    line.append("Memória (bytes): pilha máx. ").appendUInt(stackMonitor.getStackHighWater())
+        .append(", ISR ").appendUInt(stackMonitor.getIsrHighWater())
+        .append(", heap livre ").appendUInt(stackMonitor.getHeapFree())
+        .append(", folga ").appendUInt(stackMonitor.getHeadroom());
+    payload.appendUInt(stackMonitor.getStackHighWater()).append(',').appendUInt(stackMonitor.getIsrHighWater())
+        .append(',').appendUInt(stackMonitor.getHeapFree()).append(',').appendUInt(stackMonitor.getHeadroom());
+    logs.info(line.c_str());
+    if (connection.isUp()) {
+        outbound.enqueue(TOPIC_MEMORY, payload.c_str());
     }
-    
-    mqttClient.setServer(SERVER_IP, SERVER_PORT);
+}
 
-    int attempts = 0;
-    while (!mqttClient.connected() && attempts < 3) { // Verificar se cliente MQTT está ligado
-        logs.info("A ligar ao MQTT...");
+void reportControl() { // Registar e publicar a saída do controlo, o jitter do período e a latência
+    noInterrupts(); // Cópia coerente: a ISR do TIM6 atualiza estes valores
+    ControlTimingStats timing = controlTiming.getStats();
+    float output = cooling.getOutput();
+    float temperature = controlTemperature;
+    interrupts();
+
+    uint32_t jitterAvgUs = timing.periods > 1 ? (uint32_t)(timing.jitterSumUs / (timing.periods - 1)) : 0;
+    StrBuilder<120> line;
+    StrBuilder<OUTBOUND_PAYLOAD_SIZE + 1> payload;
+
+    line.append("Controlo: saída ").appendUInt(lroundf(output * 100)).append("%, ").appendFixed(temperature, 2);
+    line.append(" C, jitter ").appendUInt(jitterAvgUs).append('/').appendUInt(timing.jitterMaxUs);
+    line.append(" us, latência máx. ").appendUInt(timing.latencyMaxUs).append(" us, perdidos ").appendUInt(timing.missed);
+    payload.appendUInt(lroundf(output * 100)).append(',').appendFixed(temperature, 2).append(',');
+    payload.appendUInt(timing.jitterMaxUs).append(',').appendUInt(timing.latencyMaxUs).append(',').appendUInt(timing.missed);
+    logs.info(line.c_str());
+    if (connection.isUp()) {
+        outbound.enqueue(TOPIC_CONTROL_STATE, payload.c_str());
+    }
+}
 
-        String clientId = "STM32_SENDER_";
-        clientId += String(random(0xffff), HEX);
+void handleButton(const ButtonEvent &event) { // Ações dos botões, no loop()
+    StrBuilder<80> line;
+    line.append("Botão ").appendUInt(event.button + 1).append(event.type == BUTTON_LONG_PRESS ? " longo" : " curto");
+    line.append(" (").appendUInt(event.durationMs).append(" ms, premido aos ").appendUInt(event.pressedMs).append(" ms)");
+    logs.info(line.c_str());
 
-        if (mqttClient.connect(clientId.c_str())) {
-            logs.info("MQTT ligado!");
-            break;
+    if (event.button == 0 && event.type == BUTTON_SHORT_PRESS) {
+        reportControl(); // Estado do controlo já, sem esperar pelo relatório
+    } else if (event.button == 0) {
+        control_data.emergency = !control_data.emergency; // Como o comando de emergência
+        if (control_data.emergency) {
+            logs.warning("EMERGÊNCIA ativada (botão)");
         } else {
-            String mqttMsgStr = "Falha na ligação MQTT, rc=" + String(mqttClient.state()) + " a tentar novamente em 2 segundos...";
-            logs.error(mqttMsgStr.c_str());
-            attempts++;
-            if (attempts < 3) delay(DELAY_MQTT_CONNECTION);
+            logs.info("Emergência desativada (botão)");
         }
+    } else if (event.type == BUTTON_SHORT_PRESS) {
+        control_data.mode = control_data.mode == MODE_AUTOMATIC ? MODE_MANUAL : MODE_AUTOMATIC;
+        logs.info(control_data.mode == MODE_AUTOMATIC ? "Modo automático" : "Modo manual");
+    } else if (control_data.mode == MODE_MANUAL) {
+        control_data.manualOutput = control_data.manualOutput > 0 ? 0 : 1; // Relé ligado/desligado
+        logs.info(control_data.manualOutput > 0 ? "Atuador ligado (botão)" : "Atuador desligado (botão)");
+    } else {
+        logs.warning("Botão de atuador ignorado em modo automático");
+    }
+}
+
+void reportBoot() { // Registar e publicar a duração de cada fase do arranque
+    StrBuilder<160> line;
+    StrBuilder<OUTBOUND_PAYLOAD_SIZE + 1> payload;
+
+    line.append("Arranque (ms):");
+    for (uint8_t i = 0; i < bootTimeline.getStages(); i++) {
+        line.append(' ').append(bootTimeline.getName(i)).append(' ').appendUInt(bootTimeline.getMs(i));
+        payload.appendUInt(bootTimeline.getMs(i)).append(',');
     }
+    line.append(", total ").appendUInt(bootTimeline.getTotalMs());
+    payload.appendUInt(bootTimeline.getTotalMs());
+    logs.info(line.c_str());
+    outbound.enqueue(TOPIC_BOOT, payload.c_str()); // Sai quando o MQTT ligar
 }
 
 void setup() { // Função de configuração
-    // Série
-    delay(1000); // Atraso inicial
+    // Arranque por fases: relógio, armazenamento, leituras e só depois a rede,
+    // para a primeira leitura ficar guardada ~1 s após uma falha de energia
+    bootTimeline.begin(); // Fase "reset": do reset até aqui
+    stackMonitor.begin(); // Pintar a RAM livre antes de a pilha descer
     Serial.begin(SERIAL_BAUD_RATE);
-    delay(4000);
+
+    // RTC primeiro: as primeiras linhas de log já saem com data/hora
+    bool isRtcOk = initRTC(); // Só acerta a hora se o RTC a perdeu (ou SET_RTC_BOOT)
+    bootTimeline.mark("rtc");
     
     // Inicializar SD ANTES de qualquer log
-    if (logs.initExtMem()) {
+    bool isSdOk = logs.initExtMem();
+    if (isSdOk) {
         Serial.println("[INFO] SD Card inicializado!");
         // Partilhar estado do SD com outras instâncias
         csv.initExtMem();
-        asn.initExtMem();
+    } else {
+        Serial.println("[ERRO] SD Card FALHOU!");
+    }
+
+    // Configuração: config.bin se config.json não mudou, senão uma passagem pelo config.json
+    deviceConfig.load(); // Sem cartão ficam os valores por omissão
+    control_data.sampleIntervalMs = config_data.sampleIntervalMs;
+    control_data.tempMin = config_data.setpointMin;
+    control_data.tempMax = config_data.setpointMax;
+    control_data.strategy = config_data.controlStrategy;
+
+    if (isSdOk) {
+        // Medir o cartão e escolher buffer, flush e pré-alocação antes da primeira escrita
+        bool isProbed = sdProbe.run(control_data.sampleIntervalMs);
+        const SdProfile &sdProfile = sdProbe.getProfile();
+        uint32_t flushIntervalMs = config_data.flushIntervalMs > 0 ? config_data.flushIntervalMs : sdProfile.flushIntervalMs;
+        logs.setProfile(sdProfile.bufferSize, flushIntervalMs);
+        csv.setProfile(sdProfile.bufferSize, flushIntervalMs);
+        telemetryFile.setPreallocation(sdProfile.preallocBytes);
         
         // Agora sim fazer logs
         logs.info("========================================");
         logs.info("   SISTEMA DE ARREFECIMENTO - GRUPO 4");
         logs.info("   STM32L476RG");
         logs.info("========================================");
-    } else {
-        Serial.println("[ERRO] SD Card FALHOU!");
+        logConfig();
+        logSdProfile(isProbed);
     }
+    bootTimeline.mark("sd");
 
     // SD já foi inicializado acima
     logs.initFile("log"); // Inicializar ficheiro de log
+    if (isRtcOk) {
+        logs.info("RTC OK");
+    } else {
+        logs.error("Falha no RTC!");
+    }
     
-    // Inicializar CSV e verificar se funcionou
-    logs.info("A tentar inicializar CSV...");
-    if (csv.initFile("csv")) {
-        logs.info("CSV inicializado com sucesso!");
-        csv.data(CSV_HEADER); // Escrever cabeçalho CSV
-        logs.info("Cabeçalho CSV escrito!");
+    // Inicializar telemetria (binária ou CSV) e verificar se funcionou
+    if (IS_TELEMETRY_BINARY) {
+        if (telemetryFile.init()) {
+            logs.info("Telemetria binária inicializada!");
+            logs.info(telemetryFile.getFilename());
+        } else {
+            logs.error("FALHA ao inicializar telemetria binária!");
+        }
     } else {
-        logs.error("FALHA ao inicializar CSV!");
-        logs.error("Possível problema: SD card não inicializado?");
+        logs.info("A tentar inicializar CSV...");
+        if (csv.initFile("csv")) {
+            logs.info("CSV inicializado com sucesso!");
+            csv.data(CSV_HEADER); // Escrever cabeçalho CSV
+            logs.info("Cabeçalho CSV escrito!");
+        } else {
+            logs.error("FALHA ao inicializar CSV!");
+            logs.error("Possível problema: SD card não inicializado?");
+        }
     }
 
-    asn.readSN(); // Ler número de série do cartão SD
+    // Ficheiros em escrita nunca são comprimidos
+    segmentCompressor.protect(logs.getFilename());
+    segmentCompressor.protect(csv.getFilename());
 
+    if (!rollups.init()) {
+        logs.error("FALHA ao inicializar ficheiro de agregados!");
+    }
+
+    backlog.init(); // Recuperar registos por enviar e cursor de reposição
+    outbound.begin(); // Recuperar mensagens da fila guardadas em SD
+    bootTimeline.mark("ficheiros");
     
+    // Bandas mortas por sensor e grandeza (config.json)
+    for (int q = 0; q < TELEMETRY_QUANTITIES; q++) {
+        for (int i = 0; i < NUMBER_OF_SENSORS; i++) {
+            publishPolicy.setDeadband(q * NUMBER_OF_SENSORS + i, config_data.deadband[q][i]);
+        }
+    }
+    publishPolicy.setHeartbeat(config_data.heartbeatMs);
+
+    // Alarmes por sensor (config.json), avaliados antes da média de cada leitura
+    for (int i = 0; i < NUMBER_OF_SENSORS; i++) {
+        AlarmRule rule = {config_data.alarmHigh[i], config_data.alarmLow[i], config_data.alarmHysteresis[i],
+                          config_data.alarmRate[i], config_data.alarmDebounce[i]};
+        alarms.setRule(i, rule);
+    }
+    alarms.setRateWindow(ALARM_RATE_WINDOW_MS * 1000);
+    alarms.setHandler(onAlarm);
+    sensor.setSampleHandler(onTemperatureSample);
+
+    // Controlo do atuador: ganhos de config.json, relé desligado até à primeira leitura
+    pinMode(COOLING_PIN, OUTPUT);
+    digitalWrite(COOLING_PIN, LOW);
+    cooling.setGains(config_data.controlKp, config_data.controlKi);
+    cooling.setSetpoints(control_data.tempMin, control_data.tempMax);
+    cooling.setStrategy((ControlStrategy)control_data.strategy);
+
     greenLed.init(LED_TEMP_GREEN); // Inicializar LED verde
     greenLed.on();                 // Ligar LED verde
+    sensor.initSensor(); // Inicializar sensor
+    bootTimeline.mark("sensores");
+
+    // Primeira leitura já, sem esperar um período do TIM3
+    sampleTemperature();
+    serviceReadings();
+    bootTimeline.mark("leitura");
     
-    // RTC
-    if (initRTC()) {
-        logs.info("RTC OK");
-        setRTCToCompileTime();
+    // Timer de leituras antes da rede: a ISR continua a amostrar enquanto o ESP arranca (em fila até ao loop())
+    timer3.setup(TIM3);
+    applySampleInterval(control_data.sampleIntervalMs); // Período de config.json desde a primeira leitura
+    timer3.attachInterrupt(onSampleTimer);     // Anexar interrupção de leitura (guardada e enviada no loop())
+    timer3.resume();
+    logs.info("Timer de leituras iniciado!");
+    
+    espSerial.begin(SERIAL_BAUD_RATE); // Inicializar USART1 à taxa por omissão do ESP
+    WiFi.init(espSerial);              // Inicializar WiFi com a porta DMA
+    if (espSerial.negotiateBaud(ESP_UART_BAUD_HIGH, ESP_UART_FLOW_CONTROL)) {
+        logs.info("ESP UART a alta velocidade");
     } else {
-        logs.error("Falha no RTC!");
+        logs.warning("ESP UART mantém 115200");
+    }
+    commands.begin();                  // Índice da tabela de comandos
+    connection.begin();                // WiFi/MQTT avançam em background no loop()
+    bootTimeline.mark("rede");
+
+    // Controlo a ritmo fixo, com prioridade acima das leituras (relé desligado até aqui)
+    controlTiming.begin(CONTROL_PERIOD_US);
+    timer6.setup(TIM6);
+    timer6.setOverflow(CONTROL_PERIOD_US, MICROSEC_FORMAT);
+    timer6.setInterruptPriority(CONTROL_IRQ_PRIORITY, 0);
+    timer6.attachInterrupt(controlTick);
+    timer6.resume();
+
+    // Botões: EXTI em ambos os flancos, TIM7 arranca no primeiro flanco e para em repouso
+    buttons.configure(BUTTON_DEBOUNCE_DELAY, BUTTON_LONG_PRESS_MS);
+    timer7.setup(TIM7);
+    timer7.setOverflow(BUTTON_TICK_US, MICROSEC_FORMAT);
+    timer7.setInterruptPriority(BUTTON_IRQ_PRIORITY, 0);
+    timer7.attachInterrupt(buttonTick);
+    for (uint8_t i = 0; i < BUTTON_COUNT; i++) {
+        pinMode(BUTTON_PINS[i], INPUT_PULLUP);
+        attachInterrupt(digitalPinToInterrupt(BUTTON_PINS[i]), BUTTON_EDGE_HANDLERS[i], CHANGE);
     }
-    
-    Serial1.begin(SERIAL_BAUD_RATE);               // Inicializar Serial1 para comunicação
-    WiFi.init(Serial1);                            // Inicializar WiFi com Serial1
-    connectWiFi();                                 // Ligar ao WiFi
-    mqttClient.setServer(SERVER_IP, SERVER_PORT);  // Definir servidor MQTT
-    connectMQTT();                                 // Ligar ao broker MQTT
     
     logs.info("Sistema pronto!");
-    sensor.initSensor(); // Inicializar sensor
-    
-    // Configuração do timer para MQTT automático (APÓS conexões)
-    timer3->setPrescaleFactor(TIMER3_PRESCALE); // Definir prescaler do timer
-    timer3->setOverflow(TIMER3_OVERFLOW);       // Definiroverflow do timer
-    timer3->attachInterrupt(sendTemperature);   // Anexar interrupção para enviar temperatura
-    timer3->resume();
-    
-    logs.info("Timer de leituras iniciado!");
+    reportBoot();
+
+    bootAllocations = allocationCount();
+    StrBuilder<60> line;
+    line.append("Alocações no arranque: ").appendUInt(bootAllocations);
+    logs.info(line.c_str());
+    reportMemory();
 }
 
 void loop() { // Função de ciclo principal
-    // WiFi/MQTT em background - não bloqueia se falhar
-    if (WiFi.status() != WL_CONNECTED) {
-        // Não tenta reconectar constantemente - só no setup
+    // Regime permanente sem heap (tools/heap_check.py verifica na compilação o que for estático)
+    static uint32_t allocationsReported = 0;
+    uint32_t allocations = allocationCount() - bootAllocations;
+    if (allocations != allocationsReported) {
+        allocationsReported = allocations;
+        StrBuilder<60> line;
+        line.append("Alocações depois do arranque: ").appendUInt(allocations);
+        logs.warning(line.c_str());
     }
-    
-    if (WiFi.status() == WL_CONNECTED && !mqttClient.connected()) {
-        // Só tenta MQTT se WiFi estiver ligado
-        connectMQTT();
+
+    // WiFi/MQTT em background - cada passagem avança a máquina de estados sem bloquear
+    connection.update();
+    serviceReadings();  // Leituras e alarmes da ISR: todo o acesso ao SD é feito fora das interrupções
+    outbound.service(); // Enviar fila QoS1, retransmitir sem PUBACK
+
+    // Intervalo de leitura alterado por comando MQTT
+    if (control_data.sampleIntervalMs != appliedInterval) {
+        applySampleInterval(control_data.sampleIntervalMs);
     }
 
-    if (mqttClient.connected()) {
-        mqttClient.loop();
+    // Escrever as linhas em buffer (setores inteiros) no tempo que falta até à próxima leitura
+    uint32_t idleUs = timer3.getOverflow(MICROSEC_FORMAT) - timer3.getCount(MICROSEC_FORMAT);
+    logs.service(idleUs);
+    idleUs = timer3.getOverflow(MICROSEC_FORMAT) - timer3.getCount(MICROSEC_FORMAT);
+    csv.service(idleUs);
+
+    // Comprimir segmentos fechados só no tempo que falta até à próxima leitura
+    idleUs = timer3.getOverflow(MICROSEC_FORMAT) - timer3.getCount(MICROSEC_FORMAT);
+    segmentCompressor.service(idleUs);
+
+    // Consultas ao histórico (MQTT ou série), um bloco de resposta por passagem
+    history.pollSerial();
+    idleUs = timer3.getOverflow(MICROSEC_FORMAT) - timer3.getCount(MICROSEC_FORMAT);
+    history.service(idleUs);
+
+    // Máximos da pilha e heap livre, para dimensionar a RAM
+    static unsigned long lastMemoryReport = millis();
+    if (millis() - lastMemoryReport >= MEMORY_REPORT_INTERVAL) {
+        lastMemoryReport = millis();
+        reportMemory();
     }
 
-    delay(DELAY_TO_STABILIZE); // Dar tempo para estabilizar
+    // Eventos dos botões já confirmados pelo TIM7 (fila vazia: só uma comparação)
+    ButtonEvent buttonEvent;
+    while (buttons.pop(buttonEvent)) {
+        handleButton(buttonEvent);
+    }
+
+    // Saída do controlo e jitter do período
+    static unsigned long lastControlReport = millis();
+    if (millis() - lastControlReport >= CONTROL_REPORT_INTERVAL) {
+        lastControlReport = millis();
+        reportControl();
+    }
 
-    // Controlo LED baseado na temperatura do sensor 1
-    if (sensor_data.temperatureAverageSensors[0] > THIRTY_DEGREES) {
-        greenLed.blink(); // Piscar LED verde se temperatura exceder 30 graus
+    // LED verde a piscar enquanto houver algum alarme ativo, em qualquer sensor
+    static unsigned long lastBlink = 0;
+    if (alarms.activeCount() > 0) {
+        if (millis() - lastBlink >= LED_BLINK_INTERVAL) {
+            lastBlink = millis();
+            greenLed.toggle();
+        }
     } else {
-        greenLed.on(); // Ligar LED verde se temperatura abaixo de 30 graus
+        greenLed.on(); // Ligar LED verde sem alarmes
     }
 }
\ No newline at end of file
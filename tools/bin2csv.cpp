@@ -0,0 +1,204 @@
+/* Conversion of telemetria<N>.bin back to the temperatura<N>.csv schema
+ * (timestamp;device;status;temperature), one line per sensor per row.
+ * With -e it goes the other way, packing an existing CSV into blocks, so
+ * old cards can be used to measure the size reduction.
+ * Sizes and bytes per sample of both formats are reported on stderr.
+ *
+ * Build (host):
+ *   g++ -O2 -I lib/telemetryBlock -I lib/crc32 tools/bin2csv.cpp lib/telemetryBlock/telemetryBlock.cpp \
+ *       lib/crc32/crc32.cpp -o bin2csv
+ * Usage:
+ *   ./bin2csv telemetria0.bin [out.csv]
+ *   ./bin2csv -e temperatura0.csv out.bin [sensors=4]
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "telemetryBlock.hpp"
+
+static void report(unsigned long samples, unsigned long binBytes, unsigned long csvBytes)
+{
+  if (samples == 0)
+  {
+    fprintf(stderr, "no samples\n");
+    return;
+  }
+  fprintf(stderr, "samples:   %lu\n", samples);
+  fprintf(stderr, "binary:    %lu bytes (%.2f bytes/sample)\n", binBytes, (double)binBytes / samples);
+  fprintf(stderr, "csv:       %lu bytes (%.2f bytes/sample)\n", csvBytes, (double)csvBytes / samples);
+  fprintf(stderr, "reduction: %.1fx\n", (double)csvBytes / binBytes);
+}
+
+static int decode(const char *inPath, const char *outPath)
+{
+  FILE *in = fopen(inPath, "rb");
+  if (!in)
+  {
+    perror(inPath);
+    return 1;
+  }
+  FILE *out = outPath ? fopen(outPath, "w") : stdout;
+  if (!out)
+  {
+    perror(outPath);
+    fclose(in);
+    return 1;
+  }
+
+  // Same line ending as the firmware's println()
+  unsigned long csvBytes = fprintf(out, "timestamp;device;status;temperature\r\n");
+  unsigned long samples = 0;
+  unsigned long blocks = 0;
+  unsigned long invalid = 0;
+
+  uint8_t sector[TELEMETRY_BLOCK_SIZE];
+  TelemetryBlock block;
+  while (fread(sector, 1, sizeof(sector), in) == sizeof(sector))
+  {
+    blocks++;
+    if (!block.load(sector) || block.sequence() != blocks - 1)
+    {
+      invalid++; // Never written, torn by a power loss, or stale data in a preallocated file
+      continue;
+    }
+
+    for (uint8_t row = 0; row < block.rows(); row++)
+    {
+      unsigned long timestamp = block.timestamp(row);
+      for (uint8_t s = 0; s < block.sensors(); s++)
+      {
+        int16_t value = block.value(s, row);
+        if (value == TELEMETRY_MISSING)
+        {
+          csvBytes += fprintf(out, "%lu;%u;ERRO;nan\r\n", timestamp, s + 1);
+        }
+        else
+        {
+          csvBytes += fprintf(out, "%lu;%u;OK;%.2f\r\n", timestamp, s + 1, value / 100.0);
+        }
+        samples++;
+      }
+    }
+  }
+  fclose(in);
+  if (out != stdout)
+  {
+    fclose(out);
+  }
+
+  fprintf(stderr, "blocks:    %lu (%lu invalid)\n", blocks, invalid);
+  report(samples, blocks * TELEMETRY_BLOCK_SIZE, csvBytes);
+  return invalid == blocks && blocks > 0 ? 1 : 0;
+}
+
+static int encode(const char *inPath, const char *outPath, uint8_t sensors)
+{
+  FILE *in = fopen(inPath, "r");
+  if (!in)
+  {
+    perror(inPath);
+    return 1;
+  }
+  FILE *out = fopen(outPath, "wb");
+  if (!out)
+  {
+    perror(outPath);
+    fclose(in);
+    return 1;
+  }
+
+  TelemetryBlock block;
+  uint32_t sequence = 0;
+  block.begin(sequence, sensors);
+
+  int16_t row[TELEMETRY_BLOCK_MAX_SENSORS];
+  bool isRowOpen = false;
+  unsigned long rowTimestamp = 0;
+  unsigned long samples = 0;
+  unsigned long csvBytes = 0;
+  unsigned long blocks = 0;
+
+  // The firmware writes the sensors of one tick on consecutive lines with
+  // the same timestamp; a new timestamp starts a new row
+  char line[128];
+  while (fgets(line, sizeof(line), in))
+  {
+    csvBytes += strlen(line);
+    unsigned long timestamp;
+    unsigned device;
+    char status[8];
+    float value;
+    if (sscanf(line, "%lu;%u;%7[^;];%f", &timestamp, &device, status, &value) != 4 || device == 0 ||
+        device > sensors)
+    {
+      continue; // Header or malformed line
+    }
+
+    if (isRowOpen && timestamp != rowTimestamp)
+    {
+      if (!block.append(rowTimestamp, row))
+      {
+        block.seal();
+        fwrite(block.data(), 1, TELEMETRY_BLOCK_SIZE, out);
+        blocks++;
+        block.begin(++sequence, sensors);
+        block.append(rowTimestamp, row);
+      }
+      isRowOpen = false;
+    }
+    if (!isRowOpen)
+    {
+      for (uint8_t s = 0; s < sensors; s++)
+      {
+        row[s] = TELEMETRY_MISSING;
+      }
+      rowTimestamp = timestamp;
+      isRowOpen = true;
+    }
+    row[device - 1] = (strcmp(status, "OK") != 0 || isnan(value)) ? TELEMETRY_MISSING : (int16_t)lroundf(value * 100);
+    samples++;
+  }
+
+  if (isRowOpen && !block.append(rowTimestamp, row))
+  {
+    block.seal();
+    fwrite(block.data(), 1, TELEMETRY_BLOCK_SIZE, out);
+    blocks++;
+    block.begin(++sequence, sensors);
+    block.append(rowTimestamp, row);
+  }
+  if (block.rows() > 0)
+  {
+    block.seal();
+    fwrite(block.data(), 1, TELEMETRY_BLOCK_SIZE, out);
+    blocks++;
+  }
+  fclose(in);
+  fclose(out);
+
+  fprintf(stderr, "blocks:    %lu\n", blocks);
+  report(samples, blocks * TELEMETRY_BLOCK_SIZE, csvBytes);
+  return 0;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc >= 4 && strcmp(argv[1], "-e") == 0)
+  {
+    int sensors = argc > 4 ? atoi(argv[4]) : 4;
+    if (sensors < 1 || sensors > TELEMETRY_BLOCK_MAX_SENSORS)
+    {
+      fprintf(stderr, "sensors must be 1..%u\n", TELEMETRY_BLOCK_MAX_SENSORS);
+      return 1;
+    }
+    return encode(argv[2], argv[3], (uint8_t)sensors);
+  }
+  if (argc < 2 || argv[1][0] == '-')
+  {
+    fprintf(stderr, "usage: %s file.bin [out.csv]\n       %s -e file.csv out.bin [sensors]\n", argv[0], argv[0]);
+    return 1;
+  }
+  return decode(argv[1], argc > 2 ? argv[2] : nullptr);
+}
@@ -0,0 +1,169 @@
+"""Link-time check that the steady state never reaches the heap.
+
+Builds the static call graph of the firmware from the disassembly (direct
+calls and branches, plus addresses of functions kept in literal pools,
+which covers callbacks such as the TIM3 handler) and walks it from the
+functions that run after setup(): loop(), the timer callbacks (TIM3
+sampling, TIM6 control, TIM7 buttons) and every *_IRQHandler. The build
+fails if an allocator is reachable, and the offending call chain is
+printed.
+
+The walk goes into the C library as well, so newlib paths count like any
+other: mktime() reaches _malloc_r through _tzset_unlocked_r, and
+_dtoa_r (printf %f, strtod) through _Balloc. The firmware keeps them out
+of the steady state (get_rtc_epoch() converts the date itself) rather
+than listing them in tools/heap_allow.txt.
+
+Calls through pointers held in RAM (virtual calls, std::function) are not
+seen; allocationCount() still catches those at run time.
+
+As a PlatformIO extra script (see platformio.ini) it runs after each link.
+Stand-alone:
+    python3 tools/heap_check.py .pio/build/nucleo_l476rg/firmware.elf [--objdump arm-none-eabi-objdump]
+"""
+
+import argparse
+import os
+import re
+import subprocess
+import sys
+from collections import deque
+
+ROOTS = ["loop", "_Z4loopv", "_Z13onSampleTimerv", "_Z11controlTickv", "_Z10buttonTickv"]
+ROOT_PATTERN = re.compile(r"_IRQHandler$")
+
+ALLOCATORS = {
+    "malloc", "calloc", "realloc", "_malloc_r", "_calloc_r", "_realloc_r",
+    "__wrap_malloc", "__wrap_calloc", "__wrap_realloc",
+    "_Znwj", "_Znaj", "_Znwm", "_Znam",  # operator new / new[]
+    "__libc_malloc", "__libc_calloc", "__libc_realloc",  # glibc, for static host builds
+}
+
+# Functions not followed: they reference the allocator only on a path the
+# firmware never takes (one symbol per line, '#' starts a comment)
+ALLOW_FILE = os.path.join(os.path.dirname(os.path.abspath(__file__)), "heap_allow.txt")
+
+FUNCTION = re.compile(r"^([0-9a-f]+) <([^>]+)>:$")
+BRANCH = re.compile(r"\s(?:bl|blx|b|b\.w|b\.n|b[a-z]{2}(?:\.[wn])?|call|callq|jmp|jmpq)\s+([0-9a-f]+) <([^>+]+)(\+0x[0-9a-f]+)?>")
+WORD = re.compile(r"\.word\s+0x([0-9a-f]+)")
+
+
+def load_allowed(path):
+    allowed = set()
+    if os.path.exists(path):
+        with open(path) as f:
+            for line in f:
+                name = line.split("#", 1)[0].strip()
+                if name:
+                    allowed.add(name)
+    return allowed
+
+
+def call_graph(elf, objdump):
+    """Returns {function: set(callees)} from the disassembly."""
+    output = subprocess.run([objdump, "-d", "--no-show-raw-insn", elf], check=True, capture_output=True,
+                            text=True).stdout
+    graph = {}
+    addresses = {}
+    words = {}
+    current = None
+    for line in output.splitlines():
+        match = FUNCTION.match(line)
+        if match:
+            current = match.group(2)
+            addresses[int(match.group(1), 16)] = current
+            graph.setdefault(current, set())
+            words.setdefault(current, set())
+            continue
+        if current is None:
+            continue
+        match = BRANCH.search(line)
+        if match:
+            callee = match.group(2).replace("@plt", "")
+            if callee != current:
+                graph[current].add(callee)
+            continue
+        match = WORD.search(line)
+        if match:
+            words[current].add(int(match.group(1), 16))
+
+    # Function addresses loaded from literal pools (Thumb bit cleared)
+    for function, values in words.items():
+        for value in values:
+            target = addresses.get(value & ~1)
+            if target and target != function:
+                graph[function].add(target)
+    return graph
+
+
+def find_paths(graph, roots, allowed):
+    """Breadth-first walk; returns the shortest chain to each allocator."""
+    parent = {root: None for root in roots}
+    queue = deque(roots)
+    found = {}
+    while queue:
+        function = queue.popleft()
+        if function in ALLOCATORS:
+            chain = []
+            while function is not None:
+                chain.append(function)
+                function = parent[function]
+            found[chain[0]] = list(reversed(chain))
+            continue
+        if function in allowed:
+            continue
+        for callee in sorted(graph.get(function, ())):
+            if callee not in parent:
+                parent[callee] = function
+                queue.append(callee)
+    return found
+
+
+def demangle(names):
+    try:
+        output = subprocess.run(["c++filt"], input="\n".join(names), check=True, capture_output=True,
+                                text=True).stdout
+        return output.splitlines()
+    except (OSError, subprocess.CalledProcessError):
+        return names
+
+
+def check(elf, objdump, extra_roots=()):
+    graph = call_graph(elf, objdump)
+    roots = [name for name in graph if name in ROOTS or ROOT_PATTERN.search(name) or name in extra_roots]
+    if not roots:
+        print("heap_check: no steady-state roots found in %s" % elf)
+        return 1
+
+    found = find_paths(graph, roots, load_allowed(ALLOW_FILE))
+    if not found:
+        print("heap_check: no allocator reachable from %d roots (%d functions)" % (len(roots), len(graph)))
+        return 0
+
+    for allocator, chain in sorted(found.items()):
+        print("heap_check: %s reachable:" % allocator)
+        for depth, name in enumerate(demangle(chain)):
+            print("  %s%s" % ("  " * depth, name))
+    print("heap_check: add a function to tools/heap_allow.txt only if the path above never runs")
+    return 1
+
+
+try:
+    Import("env")  # noqa: F821 - defined when run by PlatformIO
+except NameError:
+    env = None
+
+if env is not None:
+    def post_link(target, source, env):
+        objdump = env.subst("$CC").replace("gcc", "objdump")
+        if check(str(target[0]), objdump) != 0:
+            env.Exit(1)
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", post_link)
+elif __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("elf")
+    parser.add_argument("--objdump", default="arm-none-eabi-objdump")
+    parser.add_argument("--root", action="append", default=[], help="extra function to start from")
+    arguments = parser.parse_args()
+    sys.exit(check(arguments.elf, arguments.objdump, arguments.root))
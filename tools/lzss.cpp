@@ -0,0 +1,191 @@
+/* Host side of the segment compression: decompresses the <name>.lz files
+ * written by the firmware, and compresses files with the same encoder and
+ * the same 512-byte steps, so ratios measured here match the card.
+ * "t" round-trips every file given (e.g. system<N>.log, temperatura<N>.csv
+ * copied from a card) and reports ratio and CPU time per KB.
+ *
+ * Build (host):
+ *   g++ -O2 -I lib/lzss -I lib/crc32 tools/lzss.cpp lib/lzss/lzss.cpp lib/crc32/crc32.cpp -o lzss
+ * Usage:
+ *   ./lzss d system3.log.lz [system3.log]
+ *   ./lzss c system3.log system3.log.lz
+ *   ./lzss t system*.log temperatura*.csv
+ */
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <vector>
+
+#include "crc32.hpp"
+#include "lzss.hpp"
+
+static constexpr size_t CHUNK = 512; // SEGMENT_CHUNK_SIZE on the target
+
+static bool readFile(const char *path, std::vector<uint8_t> &data)
+{
+  FILE *in = fopen(path, "rb");
+  if (!in)
+  {
+    perror(path);
+    return false;
+  }
+  uint8_t buffer[4096];
+  size_t n;
+  data.clear();
+  while ((n = fread(buffer, 1, sizeof(buffer), in)) > 0)
+  {
+    data.insert(data.end(), buffer, buffer + n);
+  }
+  fclose(in);
+  return true;
+}
+
+static bool writeFile(const char *path, const std::vector<uint8_t> &data)
+{
+  FILE *out = path ? fopen(path, "wb") : stdout;
+  if (!out)
+  {
+    perror(path);
+    return false;
+  }
+  bool isWritten = fwrite(data.data(), 1, data.size(), out) == data.size();
+  if (out != stdout)
+  {
+    fclose(out);
+  }
+  return isWritten;
+}
+
+// Same framing as SegmentCompressor: header, then one compress() per chunk
+static std::vector<uint8_t> compress(const std::vector<uint8_t> &data, double *cpuUs)
+{
+  static LzssEncoder encoder; // ~4.7 KB, as on the target
+  std::vector<uint8_t> out(sizeof(LzssFileHeader));
+  uint8_t chunkOut[lzssBound(CHUNK)];
+
+  auto started = std::chrono::steady_clock::now();
+  encoder.begin();
+  size_t offset = 0;
+  do
+  {
+    size_t n = data.size() - offset < CHUNK ? data.size() - offset : CHUNK;
+    bool isFinal = offset + n == data.size();
+    size_t produced = encoder.compress(data.data() + offset, n, isFinal, chunkOut);
+    out.insert(out.end(), chunkOut, chunkOut + produced);
+    offset += n;
+  } while (offset < data.size());
+  *cpuUs = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - started).count();
+
+  LzssFileHeader header;
+  header.magic = LZSS_MAGIC;
+  header.originalSize = data.size();
+  header.crc = crc32(data.data(), data.size());
+  header.window = LZSS_WINDOW;
+  header.reserved = 0;
+  memcpy(out.data(), &header, sizeof(header));
+  return out;
+}
+
+static bool decompress(const std::vector<uint8_t> &file, std::vector<uint8_t> &data, const char *path)
+{
+  LzssFileHeader header;
+  if (file.size() < sizeof(header))
+  {
+    fprintf(stderr, "%s: too short\n", path);
+    return false;
+  }
+  memcpy(&header, file.data(), sizeof(header));
+  if (header.magic != LZSS_MAGIC || header.window != LZSS_WINDOW)
+  {
+    fprintf(stderr, "%s: not a complete .lz file\n", path);
+    return false;
+  }
+
+  data.resize(header.originalSize);
+  size_t n = lzssDecompress(file.data() + sizeof(header), file.size() - sizeof(header), data.data(), data.size());
+  if (n != header.originalSize || crc32(data.data(), n) != header.crc)
+  {
+    fprintf(stderr, "%s: damaged (%zu of %u bytes, CRC %s)\n", path, n, header.originalSize,
+            crc32(data.data(), n) == header.crc ? "ok" : "mismatch");
+    return false;
+  }
+  return true;
+}
+
+static int roundTrip(int count, char **paths)
+{
+  unsigned long totalIn = 0;
+  unsigned long totalOut = 0;
+  double totalUs = 0;
+  int failures = 0;
+
+  printf("%-28s %10s %10s %7s %9s\n", "file", "bytes", "lz", "ratio", "us/KB");
+  for (int i = 0; i < count; i++)
+  {
+    std::vector<uint8_t> data;
+    std::vector<uint8_t> restored;
+    if (!readFile(paths[i], data))
+    {
+      failures++;
+      continue;
+    }
+    double cpuUs;
+    std::vector<uint8_t> packed = compress(data, &cpuUs);
+    bool isOk = decompress(packed, restored, paths[i]) && restored == data;
+    if (!isOk)
+    {
+      failures++;
+    }
+
+    printf("%-28s %10zu %10zu %6.1f%% %9.1f %s\n", paths[i], data.size(), packed.size(),
+           data.empty() ? 0.0 : 100.0 * packed.size() / data.size(),
+           data.empty() ? 0.0 : cpuUs * 1024 / data.size(), isOk ? "" : "FAIL");
+    totalIn += data.size();
+    totalOut += packed.size();
+    totalUs += cpuUs;
+  }
+
+  if (totalIn > 0)
+  {
+    printf("%-28s %10lu %10lu %6.1f%% %9.1f\n", "total", totalIn, totalOut, 100.0 * totalOut / totalIn,
+           totalUs * 1024 / totalIn);
+  }
+  return failures == 0 ? 0 : 1;
+}
+
+int main(int argc, char **argv)
+{
+  if (argc >= 3 && strcmp(argv[1], "t") == 0)
+  {
+    return roundTrip(argc - 2, argv + 2);
+  }
+
+  if (argc >= 4 && strcmp(argv[1], "c") == 0)
+  {
+    std::vector<uint8_t> data;
+    double cpuUs;
+    if (!readFile(argv[2], data))
+    {
+      return 1;
+    }
+    std::vector<uint8_t> packed = compress(data, &cpuUs);
+    fprintf(stderr, "%zu -> %zu bytes\n", data.size(), packed.size());
+    return writeFile(argv[3], packed) ? 0 : 1;
+  }
+
+  if (argc >= 3 && strcmp(argv[1], "d") == 0)
+  {
+    std::vector<uint8_t> file;
+    std::vector<uint8_t> data;
+    if (!readFile(argv[2], file) || !decompress(file, data, argv[2]))
+    {
+      return 1;
+    }
+    return writeFile(argc > 3 ? argv[3] : nullptr, data) ? 0 : 1;
+  }
+
+  fprintf(stderr, "usage: %s d file.lz [out]\n       %s c file out.lz\n       %s t files...\n", argv[0], argv[0],
+          argv[0]);
+  return 1;
+}
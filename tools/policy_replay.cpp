@@ -0,0 +1,70 @@
+/* Replay of a temperatura<N>.csv file through PublishPolicy
+ * Reports how many MQTT messages report-by-exception would have sent
+ * compared to publishing every sample.
+ *
+ * Build (host):
+ *   g++ -O2 -I lib/publishPolicy tools/policy_replay.cpp lib/publishPolicy/publishPolicy.cpp -o policy_replay
+ * Usage:
+ *   ./policy_replay temperatura0.csv [deadband_C=0.25] [heartbeat_s=300]
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "publishPolicy.hpp"
+
+int main(int argc, char **argv)
+{
+  if (argc < 2)
+  {
+    fprintf(stderr, "usage: %s file.csv [deadband_C] [heartbeat_s]\n", argv[0]);
+    return 1;
+  }
+
+  FILE *csv = fopen(argv[1], "r");
+  if (!csv)
+  {
+    perror(argv[1]);
+    return 1;
+  }
+
+  float deadband = argc > 2 ? (float)atof(argv[2]) : 0.25f;
+  uint32_t heartbeat = argc > 3 ? (uint32_t)atol(argv[3]) * 1000 : 300000;
+
+  PublishPolicy policy;
+  for (uint8_t i = 0; i < PUBLISH_POLICY_MAX_CHANNELS; i++)
+  {
+    policy.setDeadband(i, deadband);
+  }
+  policy.setHeartbeat(heartbeat);
+
+  // Schema: timestamp;device;status;temperature
+  char line[128];
+  unsigned long skipped = 0;
+  while (fgets(line, sizeof(line), csv))
+  {
+    unsigned long timestamp;
+    unsigned device;
+    char status[8];
+    float value;
+    if (sscanf(line, "%lu;%u;%7[^;];%f", &timestamp, &device, status, &value) != 4 || device == 0)
+    {
+      skipped++; // Header or malformed line
+      continue;
+    }
+    policy.evaluate((uint8_t)(device - 1), value, (uint32_t)timestamp);
+  }
+  fclose(csv);
+
+  unsigned long samples = policy.evaluated();
+  unsigned long messages = policy.published();
+  printf("samples:   %lu\n", samples);
+  printf("published: %lu\n", messages);
+  printf("skipped:   %lu lines\n", skipped);
+  if (messages > 0)
+  {
+    printf("reduction: %.1fx (%.1f%% of the messages)\n",
+           (double)samples / messages, 100.0 * messages / samples);
+  }
+  return 0;
+}
@@ -0,0 +1,121 @@
+"""Static RAM per module, from the linker map.
+
+Adds up the .data and .bss input sections of the map file by the module
+they came from: a library under lib/ (liblogs.a -> logs), a file of src/,
+the Arduino core or libc. The heap/stack reservation and the RAM regions
+of the linker script are listed at the end.
+
+As a PlatformIO extra script (see platformio.ini) it asks the linker for
+the map and prints the report after each link. Stand-alone:
+    python3 tools/ram_report.py .pio/build/nucleo_l476rg/firmware.map [--top 20]
+"""
+
+import argparse
+import os
+import re
+import sys
+from collections import defaultdict
+
+SECTION = r"(\.(?:data|bss|noinit)(?!\.rel\.ro)\S*|COMMON)"
+ONE_LINE = re.compile(r"^ " + SECTION + r"\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$")
+NAME_ONLY = re.compile(r"^ " + SECTION + r"$")
+CONTINUATION = re.compile(r"^\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\S.*)$")
+HEAP_STACK = re.compile(r"^(\._user_heap_stack)\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)")
+REGION = re.compile(r"^(\w+)\s+0x([0-9a-f]+)\s+0x([0-9a-f]+)\s+(\w*w\w*)$")
+ARCHIVE = re.compile(r"lib([^/()]+)\.a\(")
+
+
+def module_of(path):
+    match = ARCHIVE.search(path)
+    if match:
+        return match.group(1)
+    name = os.path.basename(path)
+    for suffix in (".o", ".cpp", ".c", ".S"):
+        if name.endswith(suffix):
+            name = name[: -len(suffix)]
+    return name
+
+
+def parse(map_path):
+    modules = defaultdict(lambda: [0, 0])  # module -> [data, bss]
+    regions = []
+    reserved = 0
+    is_layout = False
+    pending = None
+    with open(map_path) as f:
+        for line in f:
+            line = line.rstrip("\n")
+            if not is_layout:
+                match = REGION.match(line)
+                if match and match.group(1) != "*default*":
+                    regions.append((match.group(1), int(match.group(3), 16)))
+                is_layout = line.startswith("Linker script and memory map")
+                continue
+
+            match = HEAP_STACK.match(line)
+            if match:
+                reserved += int(match.group(3), 16)
+                continue
+
+            section, size, path = None, 0, None
+            match = ONE_LINE.match(line)
+            if match:
+                section, size, path = match.group(1), int(match.group(3), 16), match.group(4)
+            elif pending:
+                match = CONTINUATION.match(line)
+                if match:
+                    section, size, path = pending, int(match.group(2), 16), match.group(3)
+            pending = None
+            if section is None:
+                match = NAME_ONLY.match(line)
+                pending = match.group(1) if match else None
+                continue
+
+            if size > 0:
+                kind = 0 if section.startswith(".data") else 1
+                modules[module_of(path)][kind] += size
+    return modules, regions, reserved
+
+
+def report(map_path, top=0):
+    modules, regions, reserved = parse(map_path)
+    rows = sorted(modules.items(), key=lambda item: -(item[1][0] + item[1][1]))
+    total = sum(data + bss for data, bss in modules.values())
+
+    print("%-28s %8s %8s %8s %6s" % ("module", ".data", ".bss", "total", "%"))
+    for index, (name, (data, bss)) in enumerate(rows):
+        if top and index >= top:
+            rest = sum(d + b for _, (d, b) in rows[top:])
+            print("%-28s %8s %8s %8d %5.1f%%" % ("(%d more)" % (len(rows) - top), "", "", rest, 100.0 * rest / total))
+            break
+        print("%-28s %8d %8d %8d %5.1f%%" % (name, data, bss, data + bss, 100.0 * (data + bss) / total if total else 0))
+    print("%-28s %8s %8s %8d" % ("static total", "", "", total))
+    if reserved:
+        print("%-28s %8s %8s %8d" % ("heap + stack reserved", "", "", reserved))
+    for name, length in regions:
+        print("%-28s %8s %8s %8d" % ("region " + name, "", "", length))
+    capacity = sum(length for _, length in regions)
+    if capacity:
+        print("RAM used by static data and reservations: %d of %d bytes (%.1f%%)"
+              % (total + reserved, capacity, 100.0 * (total + reserved) / capacity))
+
+
+try:
+    Import("env")  # noqa: F821 - defined when run by PlatformIO
+except NameError:
+    env = None
+
+if env is not None:
+    env.Append(LINKFLAGS=["-Wl,-Map,${BUILD_DIR}/${PROGNAME}.map"])
+
+    def post_link(target, source, env):
+        report(env.subst("${BUILD_DIR}/${PROGNAME}.map"), top=25)
+
+    env.AddPostAction("$BUILD_DIR/${PROGNAME}.elf", post_link)
+elif __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("map")
+    parser.add_argument("--top", type=int, default=0, help="only the N largest modules")
+    arguments = parser.parse_args()
+    report(arguments.map, arguments.top)
+    sys.exit(0)